@@ -274,6 +274,13 @@ public:
 	//   2 => expansion-/swap-level output (label(s), current energy)
 	void setVerbosity(int level) { m_verbosity = level; }
 
+	// Keeps the graph of each alpha-expansion alive between the cycles of expansion(), and only
+	// updates the terms of sites relabeled since its last move, reusing flow and search trees
+	// (dynamic graph cuts, Kohli & Torr, ICCV 2005). Graphs are kept for as many labels as fit
+	// into maxMegabytes, the other labels are rebuilt every move. 0 (default) disables it.
+	// Has no effect with label costs or sparse data costs.
+	void setDynamicExpansion(int maxMegabytes);
+
 protected:
 	struct LabelCost {
 		~LabelCost() { delete [] labels; }
@@ -317,6 +324,11 @@ protected:
 	SiteID *m_numNeighbors;              // holds num of neighbors for each site
 	SiteID  m_numNeighborsTotal;         // holds total num of neighbor relationships
 
+	struct DynamicGraph;
+	DynamicGraph** m_dynamicGraphs;      // graph kept for each label by setDynamicExpansion, 0 if none
+	size_t         m_dynamicBudget;      // bytes available for kept graphs, 0 if disabled
+	size_t         m_dynamicBytes;       // bytes taken by kept graphs
+
 	EnergyType (GCoptimization::*m_giveSmoothEnergyInternal)();
 	SiteID (GCoptimization::*m_queryActiveSitesExpansion)(LabelID, SiteID*);
 	void (GCoptimization::*m_setupDataCostsExpansion)(SiteID,LabelID,EnergyT*,SiteID*);
@@ -325,6 +337,7 @@ protected:
 	void (GCoptimization::*m_setupSmoothCostsSwap)(SiteID,LabelID,LabelID,EnergyT*,SiteID*);
 	void (GCoptimization::*m_applyNewLabeling)(EnergyT*,SiteID*,SiteID,LabelID);
 	void (GCoptimization::*m_updateLabelingDataCosts)();
+	void (GCoptimization::*m_updateDynamicExpansion)(LabelID,DynamicGraph*);
 
 	void (*m_datacostFnDelete)(void* f);
 	void (*m_smoothcostFnDelete)(void* f);
@@ -452,6 +465,7 @@ protected:
 	template <typename SmoothCostT> void setupSmoothCostsSwap(SiteID size,LabelID alpha_label,LabelID beta_label,EnergyT *e,SiteID *activeSites);
 	template <typename DataCostT>   void applyNewLabeling(EnergyT *e,SiteID *activeSites,SiteID size,LabelID alpha_label);
 	template <typename DataCostT>   void updateLabelingDataCosts();
+	template <typename SmoothCostT> void updateDynamicExpansion(LabelID alpha_label,DynamicGraph *g);
 	template <typename UserFunctor> void specializeDataCostFunctor(const UserFunctor f);
 	template <typename UserFunctor> void specializeSmoothCostFunctor(const UserFunctor f);
 
@@ -462,6 +476,9 @@ protected:
 	void addterm1_checked(EnergyT *e,VarID i,EnergyTermType e0,EnergyTermType e1);
 	void addterm1_checked(EnergyT *e,VarID i,EnergyTermType e0,EnergyTermType e1,EnergyTermType w);
 	void addterm2_checked(EnergyT *e,VarID i,VarID j,EnergyTermType e00,EnergyTermType e01,EnergyTermType e10,EnergyTermType e11,EnergyTermType w);
+	// Replaces the pairwise term (old00..old11)*w of an existing arc i->j with (e00..e11)*w in the residual graph
+	void updateterm2_checked(EnergyT *e,EnergyT::arc_id a,VarID i,VarID j,EnergyTermType old00,EnergyTermType old01,EnergyTermType old10,EnergyTermType old11,
+	                         EnergyTermType e00,EnergyTermType e01,EnergyTermType e10,EnergyTermType e11,EnergyTermType w);
 
 	// Returns Smooth Energy of current labeling
 	template <typename SmoothCostT> EnergyType giveSmoothEnergyInternal();
@@ -474,6 +491,9 @@ private:
 	// Peforms one iteration (one pass over all pairs of labels) of expansion/swap algorithm
 	EnergyType oneExpansionIteration();
 	EnergyType oneSwapIteration();
+	// Expansion move on the graph kept for alpha_label; returns false if the graph could not be kept
+	bool alpha_expansion_dynamic(LabelID alpha_label, bool& improved);
+	void clearDynamicGraphs();
 	void printStatus1(const char* extraMsg=0);
 	void printStatus1(int cycle, bool isSwap, gcoclock_t ticks0);
 	void printStatus2(int alpha, int beta, int numVars, gcoclock_t ticks0);
@@ -581,6 +601,14 @@ public:
 	// in the same order as neighborIndexes[i] stores the indexes
 	void setAllNeighbors(SiteID *numNeighbors,SiteID **neighborsIndexes,EnergyTermType **neighborsWeights);
 
+	// Bulk version of setNeighbors() for neighborhoods in compressed sparse row layout:
+	// for each site i, every k in [offsets[i],offsets[i+1]) makes i and neighbors[k] neighbors
+	// with weight weights[k] (1 if weights is NULL). Same result as calling setNeighbors() in
+	// that order, but the neighborhood system is stored in two contiguous arrays instead of
+	// one linked list per site. offsets holds numSites()+1 entries. Can be called only once,
+	// and not together with setNeighbors().
+	void setNeighborsCSR(const SiteID *offsets, const SiteID *neighbors, const EnergyTermType *weights=0);
+
 protected: 
 	virtual void giveNeighborInfo(SiteID site, SiteID *numSites, SiteID **neighbors, EnergyTermType **weights);
 	virtual void finalizeNeighbors();
@@ -596,6 +624,8 @@ private:
 	bool m_needToFinishSettingNeighbors;
 	SiteID **m_neighborsIndexes;
 	EnergyTermType **m_neighborsWeights;
+	SiteID *m_neighborsIndexesCSR;         // contiguous storage behind m_neighborsIndexes, if set by setNeighborsCSR
+	EnergyTermType *m_neighborsWeightsCSR; // contiguous storage behind m_neighborsWeights, if set by setNeighborsCSR
 	bool m_needTodeleteNeighbors;
 };
 
@@ -100,6 +100,9 @@ GCoptimization::GCoptimization(SiteID nSites, LabelID nLabels)
 , m_smoothcostFn(0)
 , m_datacostFn(0)
 , m_numNeighborsTotal(0)
+, m_dynamicGraphs(0)
+, m_dynamicBudget(0)
+, m_dynamicBytes(0)
 , m_queryActiveSitesExpansion(&GCoptimization::queryActiveSitesExpansion<DataCostFnFromArray>)
 , m_setupDataCostsSwap(0)
 , m_setupDataCostsExpansion(0)
@@ -107,6 +110,7 @@ GCoptimization::GCoptimization(SiteID nSites, LabelID nLabels)
 , m_setupSmoothCostsExpansion(0)
 , m_applyNewLabeling(0)
 , m_updateLabelingDataCosts(0)
+, m_updateDynamicExpansion(0)
 , m_giveSmoothEnergyInternal(0)
 , m_solveSpecialCases(&GCoptimization::solveSpecialCases<DataCostFnFromArray>)
 , m_datacostFnDelete(0)
@@ -151,6 +155,7 @@ GCoptimization::~GCoptimization()
 	delete [] m_labelingDataCosts;
 	delete [] m_labelCounts;
 	delete [] m_activeLabelCounts;
+	clearDynamicGraphs();
 
 	if (m_datacostFnDelete) m_datacostFnDelete(m_datacostFn);
 	if (m_smoothcostFnDelete) m_smoothcostFnDelete(m_smoothcostFn);
@@ -252,6 +257,7 @@ void GCoptimization::specializeSmoothCostFunctor(const UserFunctor f) {
 	m_giveSmoothEnergyInternal  = &GCoptimization::giveSmoothEnergyInternal<UserFunctor>;
 	m_setupSmoothCostsExpansion = &GCoptimization::setupSmoothCostsExpansion<UserFunctor>;
 	m_setupSmoothCostsSwap      = &GCoptimization::setupSmoothCostsSwap<UserFunctor>;
+	m_updateDynamicExpansion    = &GCoptimization::updateDynamicExpansion<UserFunctor>;
 }
 
 //-------------------------------------------------------------------
@@ -311,6 +317,43 @@ OLGA_INLINE void GCoptimization::addterm2_checked(EnergyT* e, VarID i, VarID j,
 	e->add_term2(i,j,e00*w,e01*w,e10*w,e11*w);
 }
 
+OLGA_INLINE void GCoptimization::updateterm2_checked(EnergyT *e, EnergyT::arc_id a, VarID i, VarID j, EnergyTermType old00, EnergyTermType old01, EnergyTermType old10, EnergyTermType old11, 
+                                                     EnergyTermType e00, EnergyTermType e01, EnergyTermType e10, EnergyTermType e11, EnergyTermType w)
+{
+	if ( e00 > GCO_MAX_ENERGYTERM || e11 > GCO_MAX_ENERGYTERM || e01 > GCO_MAX_ENERGYTERM || e10 > GCO_MAX_ENERGYTERM )
+		handleError("Smooth cost term was larger than GCO_MAX_ENERGYTERM; danger of integer overflow.");
+	if ( e00+e11 > e01+e10 )
+		handleError("Non-submodular expansion term detected; smooth costs must be a metric for expansion");
+
+	// Same decomposition as Energy::add_term2, but the difference goes onto the residual
+	// capacities of the existing arc a = i->j and its sister, which add_edge created next to it.
+	EnergyTermType d00 = (e00-old00)*w, d01 = (e01-old01)*w, d10 = (e10-old10)*w, d11 = (e11-old11)*w;
+	e->add_tweights(i,d11,d00);
+	EnergyTermType rij = e->get_rcap(a)   + d01 - d00;
+	EnergyTermType rji = e->get_rcap(a+1) + d10 - d11;
+
+	// If the flow on one direction exceeds its new capacity, the excess is moved
+	// to the terminal edges of i and j, which leaves the energy of every cut unchanged.
+	if ( rij < 0 )
+	{
+		e->add_tweights(i,0,rij);
+		e->add_tweights(j,0,-rij);
+		rji += rij;
+		rij = 0;
+	}
+	else if ( rji < 0 )
+	{
+		e->add_tweights(i,0,-rji);
+		e->add_tweights(j,0,rji);
+		rij += rji;
+		rji = 0;
+	}
+	e->set_rcap(a,  rij);
+	e->set_rcap(a+1,rji > 0 ? rji : 0); // rij+rji >= 0 by submodularity, up to rounding
+	e->mark_node(i);
+	e->mark_node(j);
+}
+
 //------------------------------------------------------------------
 
 template <typename DataCostT>
@@ -418,7 +461,7 @@ void GCoptimization::applyNewLabeling(EnergyT *e,SiteID *activeSites,SiteID size
 	DataCostT* dc = (DataCostT*)m_datacostFn;
 	for ( SiteID i = 0; i < size; i++ )
 	{
-		if ( e->get_var(i) == 0 )
+		if ( e->get_var(i) == 0 && m_labeling[activeSites[i]] != alpha_label ) // dynamic graphs hold alpha sites too
 		{
 			SiteID site = activeSites[i];
 			LabelID prev = m_labeling[site];
@@ -442,6 +485,75 @@ void GCoptimization::updateLabelingDataCosts()
 		m_labelingDataCosts[i] = dc->compute(i,m_labeling[i]);
 }
 
+//-----------------------------------------------------------------------------------
+// Expansion graph of one label over all sites, kept between cycles by setDynamicExpansion.
+// Sites that already have the label take part with equal costs for both of their states.
+//
+struct GCoptimization::DynamicGraph
+{
+	DynamicGraph(SiteID numSites, SiteID numEdges)
+	: e(numSites,numEdges,handleError)
+	, labeling(new LabelID[numSites])
+	, labelingDataCosts(new EnergyTermType[numSites])
+	{ }
+	~DynamicGraph() { delete [] labeling; delete [] labelingDataCosts; }
+
+	EnergyT         e;
+	LabelID*        labeling;          // labeling the terms in e were set up for
+	EnergyTermType* labelingDataCosts; // data costs of that labeling
+};
+
+//-----------------------------------------------------------------------------------
+// Updates the terms of the sites relabeled since the last move on g. Edges are visited
+// in the order setupSmoothCostsExpansion added them, i.e. edge k is arc pair 2k,2k+1.
+//
+template <typename SmoothCostT>
+void GCoptimization::updateDynamicExpansion(LabelID alpha_label,DynamicGraph *g)
+{
+	SiteID i,nSite,site,n,nNum,*nPointer;
+	EnergyTermType *weights;
+	SmoothCostT* sc = (SmoothCostT*)m_smoothcostFn;
+	EnergyT* e = &g->e;
+	const LabelID* old = g->labeling;
+
+	// The cost of alpha has not changed, only that of the current label
+	for ( i = 0; i < m_num_sites; i++ )
+		if ( old[i] != m_labeling[i] )
+		{
+			e->add_tweights(i,m_labelingDataCosts[i]-g->labelingDataCosts[i],0);
+			e->mark_node(i);
+		}
+
+	EnergyT::arc_id a = e->get_first_arc();
+	for ( site = m_num_sites - 1; site >= 0; site-- )
+	{
+		giveNeighborInfo(site,&nNum,&nPointer,&weights);
+		for ( n = 0; n < nNum; n++ )
+		{
+			nSite = nPointer[n];
+			if ( nSite >= site )
+				continue;
+			if ( old[site] != m_labeling[site] || old[nSite] != m_labeling[nSite] )
+				updateterm2_checked(e,a,site,nSite,
+				                    sc->compute(site,nSite,alpha_label,alpha_label),
+				                    sc->compute(site,nSite,alpha_label,old[nSite]),
+				                    sc->compute(site,nSite,old[site],alpha_label),
+				                    sc->compute(site,nSite,old[site],old[nSite]),
+				                    sc->compute(site,nSite,alpha_label,alpha_label),
+				                    sc->compute(site,nSite,alpha_label,m_labeling[nSite]),
+				                    sc->compute(site,nSite,m_labeling[site],alpha_label),
+				                    sc->compute(site,nSite,m_labeling[site],m_labeling[nSite]),weights[n]);
+			a += 2;
+		}
+	}
+
+	for ( i = 0; i < m_num_sites; i++ )
+	{
+		g->labeling[i]          = m_labeling[i];
+		g->labelingDataCosts[i] = m_labelingDataCosts[i];
+	}
+}
+
 //-----------------------------------------------------------------------------------
 
 template <typename DataCostT>
@@ -1040,9 +1152,11 @@ GCoptimization::EnergyType GCoptimization::expansion(int max_num_iterations)
 	catch (...)
 	{
 		m_stepsThisCycle = m_stepsThisCycleTotal = 0;
+		clearDynamicGraphs();
 		throw;
 	}
 	m_stepsThisCycle = m_stepsThisCycleTotal = 0; // set so that alpha_expansion() knows it's no inside expansion() if called externally
+	clearDynamicGraphs(); // costs may change before the next call
 	return new_energy;
 }
 
@@ -1209,6 +1323,15 @@ bool GCoptimization::alpha_expansion(LabelID alpha_label)
 		m_labelingInfoDirty = true; // if not inside expansion(), assume data cost function could have changed since last expansion
 	updateLabelingInfo();
 
+	// Graphs are only kept inside expansion(), where the costs cannot change
+	bool improved = false;
+	if ( m_dynamicBudget && m_stepsThisCycleTotal && !m_labelcostsAll && m_updateDynamicExpansion && m_setupSmoothCostsExpansion
+	     && m_queryActiveSitesExpansion != (SiteID (GCoptimization::*)(LabelID,SiteID*))&GCoptimization::queryActiveSitesExpansion<DataCostFnSparse> )
+	{
+		if ( alpha_expansion_dynamic(alpha_label,improved) )
+			return improved;
+	}
+
 	// Determine list of active sites for this expansion move
 	SiteID size = 0;
 	SiteID *activeSites = new SiteID[m_num_sites];
@@ -1263,6 +1386,116 @@ bool GCoptimization::alpha_expansion(LabelID alpha_label)
 
 //-------------------------------------------------------------------
 
+bool GCoptimization::alpha_expansion_dynamic(LabelID alpha_label, bool& improved)
+{
+	gcoclock_t ticks0 = gcoclock();
+	improved = false;
+
+	if ( !m_dynamicGraphs )
+	{
+		m_dynamicGraphs = new DynamicGraph*[m_num_labels];
+		memset(m_dynamicGraphs,0,m_num_labels*sizeof(DynamicGraph*));
+	}
+
+	SiteID size = 0;
+	for ( SiteID i = 0; i < m_num_sites; i++ )
+		if ( m_labeling[i] != alpha_label )
+			size++;
+	if ( size == 0 )  // Nothing to do
+	{
+		printStatus2(alpha_label,-1,size,ticks0);
+		return true;
+	}
+
+	DynamicGraph* g = m_dynamicGraphs[alpha_label];
+	if ( !g )
+	{
+		// Rough footprint: a node has three pointers, three ints and a capacity, an arc three
+		// pointers and a capacity, and the labeling is copied with its data costs.
+		const size_t bytes = (size_t)m_num_sites*(3*sizeof(void*)+3*sizeof(int)+2*sizeof(EnergyTermType)+sizeof(LabelID))
+		                   + (size_t)m_numNeighborsTotal*(3*sizeof(void*)+sizeof(EnergyTermType));
+		if ( m_dynamicBytes + bytes > m_dynamicBudget )
+			return false;
+		m_dynamicBytes += bytes;
+	}
+
+	SiteID *allSites = new SiteID[m_num_sites];
+	try
+	{
+		for ( SiteID i = 0; i < m_num_sites; i++ )
+			allSites[i] = i;
+
+		bool reuse = g != 0;
+		if ( !reuse )
+		{
+			// Build it like a regular expansion graph, with every site active
+			g = m_dynamicGraphs[alpha_label] = new DynamicGraph(m_num_sites,m_numNeighborsTotal/2+1);
+			g->e.add_variable(m_num_sites);
+			memcpy(m_lookupSiteVar,allSites,m_num_sites*sizeof(SiteID));
+			if ( m_setupDataCostsExpansion ) (this->*m_setupDataCostsExpansion)(m_num_sites,alpha_label,&g->e,allSites);
+			(this->*m_setupSmoothCostsExpansion)(m_num_sites,alpha_label,&g->e,allSites);
+			memset(m_lookupSiteVar,-1,m_num_sites*sizeof(SiteID));
+			memcpy(g->labeling,m_labeling,m_num_sites*sizeof(LabelID));
+			memcpy(g->labelingDataCosts,m_labelingDataCosts,m_num_sites*sizeof(EnergyTermType));
+		}
+		else
+			(this->*m_updateDynamicExpansion)(alpha_label,g);
+		checkInterrupt();
+
+		// The flow is the minimum of the binary energy, and the energy of keeping
+		// all labels is found from the residual source capacities of the cut.
+		EnergyType afterExpansionEnergy  = g->e.maxflow(reuse);
+		EnergyType beforeExpansionEnergy = afterExpansionEnergy;
+		SiteID     numChanged            = 0;
+		for ( SiteID i = 0; i < m_num_sites; i++ )
+		{
+			if ( g->e.get_trcap(i) > 0 )
+				beforeExpansionEnergy += g->e.get_trcap(i);
+			if ( m_labeling[i] != alpha_label && g->e.get_var(i) == 0 )
+				numChanged++;
+		}
+		checkInterrupt();
+
+		improved = numChanged && afterExpansionEnergy < beforeExpansionEnergy;
+		if ( improved )
+			(this->*m_applyNewLabeling)(&g->e,allSites,m_num_sites,alpha_label);
+
+		printStatus2(alpha_label,-1,size,ticks0);
+	}
+	catch (...)
+	{
+		memset(m_lookupSiteVar,-1,m_num_sites*sizeof(SiteID));
+		delete [] allSites;
+		throw;
+	}
+	delete [] allSites;
+	return true;
+}
+
+//-------------------------------------------------------------------
+
+void GCoptimization::clearDynamicGraphs()
+{
+	if ( m_dynamicGraphs )
+	{
+		for ( LabelID l = 0; l < m_num_labels; ++l )
+			delete m_dynamicGraphs[l];
+		delete [] m_dynamicGraphs;
+		m_dynamicGraphs = 0;
+	}
+	m_dynamicBytes = 0;
+}
+
+//-------------------------------------------------------------------
+
+void GCoptimization::setDynamicExpansion(int maxMegabytes)
+{
+	clearDynamicGraphs();
+	m_dynamicBudget = maxMegabytes > 0 ? (size_t)maxMegabytes << 20 : 0;
+}
+
+//-------------------------------------------------------------------
+
 GCoptimization::EnergyType GCoptimization::oneExpansionIteration()
 {
 	permuteLabelTable();
@@ -1531,6 +1764,8 @@ GCoptimizationGeneralGraph::GCoptimizationGeneralGraph(SiteID num_sites,LabelID
 	m_neighborsWeights = 0;
 	m_numNeighbors     = 0;
 	m_neighbors        = 0;
+	m_neighborsIndexesCSR = 0;
+	m_neighborsWeightsCSR = 0;
 
 	m_needTodeleteNeighbors        = true;
 	m_needToFinishSettingNeighbors = true;
@@ -1546,7 +1781,7 @@ GCoptimizationGeneralGraph::~GCoptimizationGeneralGraph()
 
 	if ( m_numNeighbors && m_needTodeleteNeighbors )
 	{
-		for ( SiteID i = 0; i < m_num_sites; i++ )
+		for ( SiteID i = 0; i < m_num_sites && !m_neighborsIndexesCSR; i++ )
 		{
 			if (m_numNeighbors[i] != 0 )
 			{
@@ -1558,6 +1793,8 @@ GCoptimizationGeneralGraph::~GCoptimizationGeneralGraph()
 		delete [] m_numNeighbors;
 		delete [] m_neighborsIndexes;
 		delete [] m_neighborsWeights;
+		delete [] m_neighborsIndexesCSR;
+		delete [] m_neighborsWeightsCSR;
 	}
 }
 
@@ -1683,6 +1920,63 @@ void GCoptimizationGeneralGraph::setAllNeighbors(SiteID *numNeighbors,SiteID **n
 	m_neighborsWeights = neighborsWeights;
 }
 
+//------------------------------------------------------------------
+
+void GCoptimizationGeneralGraph::setNeighborsCSR(const SiteID *offsets, const SiteID *neighbors, 
+												 const EnergyTermType *weights)
+{
+	if ( m_needToFinishSettingNeighbors == false || m_neighbors )
+		handleError("Already set up neighborhood system.");
+	m_needToFinishSettingNeighbors = false;
+
+	SiteID site,k,nSite;
+	m_numNeighbors = new SiteID[m_num_sites];
+	memset(m_numNeighbors,0,m_num_sites*sizeof(SiteID));
+	for ( site = 0; site < m_num_sites; site++ )
+	{
+		m_numNeighbors[site] += offsets[site+1] - offsets[site];
+		for ( k = offsets[site]; k < offsets[site+1]; k++ )
+		{
+			assert( neighbors[k] >= 0 && neighbors[k] < m_num_sites );
+			m_numNeighbors[neighbors[k]]++;
+		}
+	}
+
+	m_numNeighborsTotal = 0;
+	for ( site = 0; site < m_num_sites; site++ )
+		m_numNeighborsTotal += m_numNeighbors[site];
+
+	m_neighborsIndexesCSR = new SiteID[m_numNeighborsTotal];
+	m_neighborsWeightsCSR = new EnergyTermType[m_numNeighborsTotal];
+	m_neighborsIndexes    = new SiteID*[m_num_sites];
+	m_neighborsWeights    = new EnergyTermType*[m_num_sites];
+	SiteID *count         = new SiteID[m_num_sites];
+	for ( site = 0, k = 0; site < m_num_sites; k += m_numNeighbors[site++] )
+	{
+		m_neighborsIndexes[site] = m_neighborsIndexesCSR + k;
+		m_neighborsWeights[site] = m_neighborsWeightsCSR + k;
+		count[site] = 0;
+	}
+
+	// Append both directions in call order, then reverse, since setNeighbors() adds to the front
+	for ( site = 0; site < m_num_sites; site++ )
+		for ( k = offsets[site]; k < offsets[site+1]; k++ )
+		{
+			nSite = neighbors[k];
+			const EnergyTermType weight = weights ? weights[k] : 1;
+			m_neighborsIndexes[site][count[site]]    = nSite;
+			m_neighborsWeights[site][count[site]++]  = weight;
+			m_neighborsIndexes[nSite][count[nSite]]   = site;
+			m_neighborsWeights[nSite][count[nSite]++] = weight;
+		}
+	for ( site = 0; site < m_num_sites; site++ )
+	{
+		std::reverse(m_neighborsIndexes[site],m_neighborsIndexes[site]+m_numNeighbors[site]);
+		std::reverse(m_neighborsWeights[site],m_neighborsWeights[site]+m_numNeighbors[site]);
+	}
+	delete [] count;
+}
+
 
 
 //------------------------------------------------------------------
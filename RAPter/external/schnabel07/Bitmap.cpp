@@ -10,10 +10,352 @@
 using namespace MiscLib;
 extern MiscLib::performance_t totalTime_components;
 
+typedef PackedBitmap::WordType WordType;
+
+static inline size_t LowestBit(WordType w)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(w);
+#else
+	size_t i = 0;
+	for(; !(w & 1); w >>= 1)
+		++i;
+	return i;
+#endif
+}
+
+void PackedBitmap::Resize(size_t uextent, size_t vextent)
+{
+	m_uextent = uextent;
+	m_vextent = vextent;
+	m_stride = (uextent + WordBits - 1) / WordBits;
+	m_words.resize(m_stride * vextent);
+	std::fill(m_words.begin(), m_words.end(), WordType(0));
+}
+
+void PackedBitmap::Pack(const MiscLib::Vector< char > &bitmap, size_t uextent,
+	size_t vextent)
+{
+	Resize(uextent, vextent);
+	for(size_t j = 0; j < vextent; ++j)
+	{
+		const char *src = &bitmap[j * uextent];
+		WordType *row = Row(j);
+		for(size_t k = 0, i = 0; k < m_stride; ++k)
+		{
+			WordType w = 0;
+			for(size_t b = 0, iend = std::min(i + WordBits, uextent); i < iend;
+				++i, ++b)
+				w |= WordType(src[i] != 0) << b;
+			row[k] = w;
+		}
+	}
+}
+
+void PackedBitmap::Unpack(MiscLib::Vector< char > *bitmap) const
+{
+	bitmap->resize(m_uextent * m_vextent);
+	for(size_t j = 0; j < m_vextent; ++j)
+	{
+		char *dst = &(*bitmap)[j * m_uextent];
+		const WordType *row = Row(j);
+		for(size_t k = 0, i = 0; k < m_stride; ++k)
+		{
+			const WordType w = row[k];
+			for(size_t b = 0, iend = std::min(i + WordBits, m_uextent); i < iend;
+				++i, ++b)
+				dst[i] = char((w >> b) & 1);
+		}
+	}
+}
+
+// pixel i of dst is pixel i - 1 of src, pixel 0 is pixel uextent - 1 if
+// wrapped, border otherwise
+static void LeftNeighbours(const WordType *src, size_t stride, size_t uextent,
+	bool uwrap, bool border, WordType *dst)
+{
+	WordType carry = 0;
+	for(size_t k = 0; k < stride; ++k)
+	{
+		dst[k] = (src[k] << 1) | carry;
+		carry = src[k] >> (PackedBitmap::WordBits - 1);
+	}
+	if(uextent % PackedBitmap::WordBits)
+		dst[stride - 1] &= (WordType(1) << (uextent % PackedBitmap::WordBits)) - 1;
+	if(uwrap)
+		dst[0] |= (src[(uextent - 1) / PackedBitmap::WordBits]
+			>> ((uextent - 1) % PackedBitmap::WordBits)) & 1;
+	else if(border)
+		dst[0] |= 1;
+}
+
+// pixel i of dst is pixel i + 1 of src, pixel uextent - 1 is pixel 0 if
+// wrapped, border otherwise
+static void RightNeighbours(const WordType *src, size_t stride, size_t uextent,
+	bool uwrap, bool border, WordType *dst)
+{
+	for(size_t k = 0; k < stride; ++k)
+		dst[k] = (src[k] >> 1) | ((k + 1 < stride)?
+			src[k + 1] << (PackedBitmap::WordBits - 1) : WordType(0));
+	if(uwrap || border)
+		dst[(uextent - 1) / PackedBitmap::WordBits] |= (uwrap? src[0] & 1 : 1)
+			<< ((uextent - 1) % PackedBitmap::WordBits);
+}
+
+// rows above and below, NULL outside of the bitmap
+static void VerticalNeighbours(const PackedBitmap &bitmap, size_t j, bool vwrap,
+	const WordType **up, const WordType **down)
+{
+	size_t vextent = bitmap.VExtent();
+	*up = j? bitmap.Row(j - 1) : (vwrap? bitmap.Row(vextent - 1) : NULL);
+	*down = (j + 1 < vextent)? bitmap.Row(j + 1) : (vwrap? bitmap.Row(0) : NULL);
+}
+
+// or (dilate) or and (erode) of each pixel with its left and right neighbours,
+// pixels outside of the bitmap are border
+static void Horizontal(const PackedBitmap &bitmap, bool uwrap, bool dilate,
+	bool border, PackedBitmap *result)
+{
+	size_t stride = bitmap.Stride();
+	MiscLib::Vector< WordType > left(stride), right(stride);
+	result->Resize(bitmap.UExtent(), bitmap.VExtent());
+	for(size_t j = 0; j < bitmap.VExtent(); ++j)
+	{
+		const WordType *row = bitmap.Row(j);
+		LeftNeighbours(row, stride, bitmap.UExtent(), uwrap, border, &left[0]);
+		RightNeighbours(row, stride, bitmap.UExtent(), uwrap, border, &right[0]);
+		WordType *dst = result->Row(j);
+		for(size_t k = 0; k < stride; ++k)
+			dst[k] = dilate? row[k] | left[k] | right[k] : row[k] & left[k] & right[k];
+	}
+}
+
+// or (dilate) or and (erode) of each pixel of horizontal with the pixels above
+// and below in vertical, pixels outside of the bitmap are border
+static void Vertical(const PackedBitmap &horizontal, const PackedBitmap &vertical,
+	bool vwrap, bool dilate, bool border, PackedBitmap *result)
+{
+	size_t stride = horizontal.Stride();
+	result->Resize(horizontal.UExtent(), horizontal.VExtent());
+	for(size_t j = 0; j < horizontal.VExtent(); ++j)
+	{
+		const WordType *row = horizontal.Row(j), *up, *down;
+		VerticalNeighbours(vertical, j, vwrap, &up, &down);
+		WordType *dst = result->Row(j);
+		for(size_t k = 0; k < stride; ++k)
+		{
+			WordType outside = border? ~WordType(0) : WordType(0);
+			WordType u = up? up[k] : outside, d = down? down[k] : outside;
+			dst[k] = dilate? row[k] | u | d : row[k] & u & d;
+		}
+	}
+}
+
+void DilateSquare(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *dilated)
+{
+	PackedBitmap horizontal;
+	Horizontal(bitmap, uwrap, true, false, &horizontal);
+	Vertical(horizontal, horizontal, vwrap, true, false, dilated);
+}
+
+void DilateCross(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *dilated)
+{
+	PackedBitmap horizontal;
+	Horizontal(bitmap, uwrap, true, false, &horizontal);
+	Vertical(horizontal, bitmap, vwrap, true, false, dilated);
+}
+
+void ErodeSquare(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *eroded)
+{
+	PackedBitmap horizontal;
+	// the border is unset, pixels next to it are always eroded
+	Horizontal(bitmap, uwrap, false, false, &horizontal);
+	Vertical(horizontal, horizontal, vwrap, false, false, eroded);
+}
+
+void ErodeCross(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *eroded)
+{
+	PackedBitmap horizontal;
+	// the border is set, unlike ErodeSquare
+	Horizontal(bitmap, uwrap, false, true, &horizontal);
+	Vertical(horizontal, bitmap, vwrap, false, true, eroded);
+}
+
+// a run of set pixels [begin, end) in a row
+struct PixelRun
+{
+	size_t begin, end;
+};
+
+static void RowRuns(const WordType *row, size_t stride,
+	MiscLib::Vector< PixelRun > *runs)
+{
+	size_t open = runs->size();
+	for(size_t k = 0; k < stride; ++k)
+	{
+		WordType w = row[k];
+		WordType prev = k? row[k - 1] >> (PackedBitmap::WordBits - 1) : WordType(0);
+		WordType next = (k + 1 < stride)?
+			row[k + 1] << (PackedBitmap::WordBits - 1) : WordType(0);
+		WordType begins = w & ~((w << 1) | prev), lasts = w & ~((w >> 1) | next);
+		for(; begins; begins &= begins - 1)
+		{
+			PixelRun run;
+			run.begin = k * PackedBitmap::WordBits + LowestBit(begins);
+			runs->push_back(run);
+		}
+		for(; lasts; lasts &= lasts - 1)
+			(*runs)[open++].end = k * PackedBitmap::WordBits + LowestBit(lasts) + 1;
+	}
+}
+
+static size_t FindRun(MiscLib::Vector< size_t > *parent, size_t a)
+{
+	while((*parent)[a] != a)
+		a = (*parent)[a] = (*parent)[(*parent)[a]];
+	return a;
+}
+
+// the smaller run index is the root, so roots are the first runs in raster order
+static void UniteRuns(MiscLib::Vector< size_t > *parent, size_t a, size_t b)
+{
+	a = FindRun(parent, a);
+	b = FindRun(parent, b);
+	if(a < b)
+		(*parent)[b] = a;
+	else
+		(*parent)[a] = b;
+}
+
+// unites the runs [a, aend) of one row with the eight connected runs [b, bend)
+// of another
+static void UniteOverlapping(const MiscLib::Vector< PixelRun > &runs, size_t a,
+	size_t aend, size_t b, size_t bend, MiscLib::Vector< size_t > *parent)
+{
+	while(a < aend && b < bend)
+	{
+		if(runs[b].begin <= runs[a].end && runs[b].end >= runs[a].begin)
+			UniteRuns(parent, a, b);
+		if(runs[a].end < runs[b].end)
+			++a;
+		else
+			++b;
+	}
+}
+
+void Components(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	MiscLib::Vector< int > *componentsImg,
+	MiscLib::Vector< std::pair< int, size_t > > *labels)
+{
+	size_t uextent = bitmap.UExtent(), vextent = bitmap.VExtent();
+	MiscLib::Vector< PixelRun > runs;
+	MiscLib::Vector< size_t > rowBegin(vextent + 1);
+	for(size_t j = 0; j < vextent; ++j)
+	{
+		rowBegin[j] = runs.size();
+		RowRuns(bitmap.Row(j), bitmap.Stride(), &runs);
+	}
+	rowBegin[vextent] = runs.size();
+	MiscLib::Vector< size_t > parent(runs.size());
+	for(size_t i = 0; i < parent.size(); ++i)
+		parent[i] = i;
+
+	// runs containing the first and the last pixel of a row, -1 if unset
+	const size_t none = size_t(-1);
+	MiscLib::Vector< size_t > first(vextent, none), last(vextent, none);
+	for(size_t j = 0; j < vextent; ++j)
+		if(rowBegin[j] != rowBegin[j + 1])
+		{
+			if(runs[rowBegin[j]].begin == 0)
+				first[j] = rowBegin[j];
+			if(runs[rowBegin[j + 1] - 1].end == uextent)
+				last[j] = rowBegin[j + 1] - 1;
+		}
+
+	// the same neighbourhoods as the byte version: the first row is not
+	// wrapped in u, and the first pixel of a row only looks at the end of the
+	// row above, if the pixel above is unset
+	size_t jend = vwrap? vextent - 1 : vextent;
+	for(size_t j = 1; j < jend; ++j)
+	{
+		UniteOverlapping(runs, rowBegin[j], rowBegin[j + 1], rowBegin[j - 1],
+			rowBegin[j], &parent);
+		if(!uwrap)
+			continue;
+		if(first[j] != none && first[j - 1] == none && last[j - 1] != none)
+			UniteRuns(&parent, first[j], last[j - 1]);
+		if(last[j] != none && first[j - 1] != none)
+			UniteRuns(&parent, last[j], first[j - 1]);
+		if(last[j] != none && first[j] != none)
+			UniteRuns(&parent, last[j], first[j]);
+	}
+	if(vwrap) // the last row also looks at the first one
+	{
+		size_t j = vextent - 1;
+		UniteOverlapping(runs, rowBegin[j], rowBegin[j + 1], rowBegin[j - 1],
+			rowBegin[j], &parent);
+		UniteOverlapping(runs, rowBegin[j], rowBegin[j + 1], rowBegin[0],
+			rowBegin[1], &parent);
+		if(uwrap && first[j] != none)
+		{
+			if(last[j - 1] != none)
+				UniteRuns(&parent, first[j], last[j - 1]);
+			if(last[0] != none)
+				UniteRuns(&parent, first[j], last[0]);
+		}
+		if(uwrap && last[j] != none)
+		{
+			if(first[j - 1] != none)
+				UniteRuns(&parent, last[j], first[j - 1]);
+			if(first[j] != none)
+				UniteRuns(&parent, last[j], first[j]);
+			if(first[0] != none)
+				UniteRuns(&parent, last[j], first[0]);
+		}
+	}
+
+	// components are numbered in the order of their first pixel
+	MiscLib::Vector< int > runLabel(runs.size(), 0);
+	labels->clear();
+	labels->push_back(std::make_pair(0, size_t(0)));
+	size_t setPixels = 0;
+	for(size_t r = 0; r < runs.size(); ++r)
+	{
+		size_t root = FindRun(&parent, r);
+		if(!runLabel[root])
+		{
+			runLabel[root] = labels->size();
+			labels->push_back(std::make_pair(int(labels->size()), size_t(0)));
+		}
+		runLabel[r] = runLabel[root];
+		(*labels)[runLabel[r]].second += runs[r].end - runs[r].begin;
+		setPixels += runs[r].end - runs[r].begin;
+	}
+	(*labels)[0].second = uextent * vextent - setPixels;
+
+	componentsImg->resize(uextent * vextent);
+	std::fill(componentsImg->begin(), componentsImg->end(), 0);
+	for(size_t j = 0; j < vextent; ++j)
+		for(size_t r = rowBegin[j]; r < rowBegin[j + 1]; ++r)
+			std::fill(componentsImg->begin() + j * uextent + runs[r].begin,
+				componentsImg->begin() + j * uextent + runs[r].end, runLabel[r]);
+}
+
 void DilateSquare(const MiscLib::Vector< char > &bitmap,
 	size_t uextent, size_t vextent, bool uwrap, bool vwrap,
 	MiscLib::Vector< char > *dilated)
 {
+	if(PackedBitmap::Suits(bitmap, uextent, vextent))
+	{
+		PackedBitmap packed(bitmap, uextent, vextent), result;
+		DilateSquare(packed, uwrap, vwrap, &result);
+		result.Unpack(dilated);
+		return;
+	}
 	// first pixel is special
 	(*dilated)[0] = bitmap[0] || bitmap[1] ||
 		bitmap[uextent] || bitmap[uextent + 1];
@@ -155,6 +497,13 @@ void DilateCross(const MiscLib::Vector< char > &bitmap,
 	size_t uextent, size_t vextent, bool uwrap, bool vwrap,
 	MiscLib::Vector< char > *dilated)
 {
+	if(PackedBitmap::Suits(bitmap, uextent, vextent))
+	{
+		PackedBitmap packed(bitmap, uextent, vextent), result;
+		DilateCross(packed, uwrap, vwrap, &result);
+		result.Unpack(dilated);
+		return;
+	}
 	// first pixel is special
 	(*dilated)[0] = bitmap[0] || bitmap[1] ||
 		bitmap[uextent];
@@ -263,6 +612,13 @@ void ErodeSquare(const MiscLib::Vector< char > &bitmap,
 	size_t uextent, size_t vextent, bool uwrap, bool vwrap,
 	MiscLib::Vector< char > *eroded)
 {
+	if(PackedBitmap::Suits(bitmap, uextent, vextent))
+	{
+		PackedBitmap packed(bitmap, uextent, vextent), result;
+		ErodeSquare(packed, uwrap, vwrap, &result);
+		result.Unpack(eroded);
+		return;
+	}
 	// first pixel is special
 	(*eroded)[0] = /*bitmap[0] && bitmap[1] &&
 		bitmap[uextent] && bitmap[uextent + 1]*/ false;
@@ -460,6 +816,13 @@ void ErodeCross(const MiscLib::Vector< char > &bitmap,
 	size_t uextent, size_t vextent, bool uwrap, bool vwrap,
 	MiscLib::Vector< char > *eroded)
 {
+	if(PackedBitmap::Suits(bitmap, uextent, vextent))
+	{
+		PackedBitmap packed(bitmap, uextent, vextent), result;
+		ErodeCross(packed, uwrap, vwrap, &result);
+		result.Unpack(eroded);
+		return;
+	}
 	// first pixel is special
 	(*eroded)[0] = bitmap[0] && bitmap[1] &&
 		bitmap[uextent];
@@ -635,6 +998,12 @@ void Components(const MiscLib::Vector< char > &bitmap,
 	MiscLib::Vector< int > *componentsImg,
 	MiscLib::Vector< std::pair< int, size_t > > *labels)
 {
+	if(PackedBitmap::Suits(bitmap, uextent, vextent))
+	{
+		Components(PackedBitmap(bitmap, uextent, vextent), uwrap, vwrap,
+			componentsImg, labels);
+		return;
+	}
 	componentsImg->resize(uextent * vextent);
 	MiscLib::Vector< std::pair< int, size_t > > tempLabels;
 	tempLabels.reserve(componentsImg->size() / 2 + 1); // this is the maximum of possible tempLabels
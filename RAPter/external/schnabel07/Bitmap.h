@@ -9,6 +9,40 @@
 #define DLL_LINKAGE
 #endif
 
+// bitmap with one bit per pixel, every row starts at a new 64 bit word
+// the morphology and components below work on whole words and runs of pixels
+// and give the same results as the byte versions
+class DLL_LINKAGE PackedBitmap
+{
+public:
+	typedef unsigned long long WordType;
+	enum { WordBits = 64 };
+
+	PackedBitmap() : m_uextent(0), m_vextent(0), m_stride(0) {}
+	PackedBitmap(const MiscLib::Vector< char > &bitmap, size_t uextent,
+		size_t vextent) { Pack(bitmap, uextent, vextent); }
+	// the byte versions only agree for bitmaps of at least 3x3 pixels, that
+	// have no pre-wrapped rows appended
+	static bool Suits(const MiscLib::Vector< char > &bitmap, size_t uextent,
+		size_t vextent)
+	{ return uextent >= 3 && vextent >= 3 && bitmap.size() == uextent * vextent; }
+	void Resize(size_t uextent, size_t vextent);
+	void Pack(const MiscLib::Vector< char > &bitmap, size_t uextent,
+		size_t vextent);
+	void Unpack(MiscLib::Vector< char > *bitmap) const;
+	size_t UExtent() const { return m_uextent; }
+	size_t VExtent() const { return m_vextent; }
+	size_t Stride() const { return m_stride; }
+	bool Get(size_t u, size_t v) const
+	{ return (Row(v)[u / WordBits] >> (u % WordBits)) & 1; }
+	WordType *Row(size_t v) { return &m_words[v * m_stride]; }
+	const WordType *Row(size_t v) const { return &m_words[v * m_stride]; }
+
+private:
+	size_t m_uextent, m_vextent, m_stride;
+	MiscLib::Vector< WordType > m_words;
+};
+
 DLL_LINKAGE void DilateSquare(const MiscLib::Vector< char > &bitmap, size_t uextent,
 	size_t vextent, bool uwrap, bool vwrap,
 	MiscLib::Vector< char > *dilated);
@@ -30,6 +64,19 @@ DLL_LINKAGE void PreWrappedComponents(const MiscLib::Vector< char > &bitmap, siz
 	MiscLib::Vector< int > *relabelComponentsImg,
 	const MiscLib::Vector< std::pair< int, size_t > > &inLabels,
 	MiscLib::Vector< std::pair< int, size_t > > *labels);
+DLL_LINKAGE void DilateSquare(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *dilated);
+DLL_LINKAGE void DilateCross(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *dilated);
+DLL_LINKAGE void ErodeSquare(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *eroded);
+DLL_LINKAGE void ErodeCross(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	PackedBitmap *eroded);
+// labels runs of pixels with union-find, componentsImg and labels are the
+// same as the ones of the byte version
+DLL_LINKAGE void Components(const PackedBitmap &bitmap, bool uwrap, bool vwrap,
+	MiscLib::Vector< int > *componentsImg,
+	MiscLib::Vector< std::pair< int, size_t > > *labels);
 DLL_LINKAGE int Label(int n[], int size, int *curLabel,
 	MiscLib::Vector< std::pair< int, size_t > > *labels);
 DLL_LINKAGE void AssociateLabel(int a, int b,
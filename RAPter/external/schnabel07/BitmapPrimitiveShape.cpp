@@ -129,22 +129,37 @@ size_t BitmapPrimitiveShape::AllConnectedComponents(const PointCloud &pc, float
 	// do a wrapping by copying pixels
 	PreWrapBitmap(bitmapInfo.bbox, epsilon, bitmapInfo.uextent, bitmapInfo.vextent, &bitmapInfo.bitmap);
 
-	MiscLib::Vector< char > tempBmp(bitmapInfo.bitmap.size()); // temporary bitmap object
 	bool uwrap, vwrap;
 	WrapBitmap(bitmapInfo.bbox, epsilon, &uwrap, &vwrap);
 
-	if (doFiltering)
+	if(PackedBitmap::Suits(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent))
 	{
-		// closing
-		DilateCross(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &tempBmp);
-		ErodeCross(tempBmp, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &bitmapInfo.bitmap);
-		// opening
-		//ErodeCross(bitmap, uextent, vextent, uwrap, vwrap, &tempBmp);
-		//DilateCross(tempBmp, uextent, vextent, uwrap, vwrap, &bitmap);
+		// same as below, but stays packed between the closing and the components
+		PackedBitmap packed(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent), temp;
+		if (doFiltering)
+		{
+			DilateCross(packed, uwrap, vwrap, &temp);
+			ErodeCross(temp, uwrap, vwrap, &packed);
+			packed.Unpack(&bitmapInfo.bitmap);
+		}
+		Components(packed, uwrap, vwrap, &componentsImg, &labels);
 	}
+	else
+	{
+		MiscLib::Vector< char > tempBmp(bitmapInfo.bitmap.size()); // temporary bitmap object
+		if (doFiltering)
+		{
+			// closing
+			DilateCross(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &tempBmp);
+			ErodeCross(tempBmp, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &bitmapInfo.bitmap);
+			// opening
+			//ErodeCross(bitmap, uextent, vextent, uwrap, vwrap, &tempBmp);
+			//DilateCross(tempBmp, uextent, vextent, uwrap, vwrap, &bitmap);
+		}
 
-	Components(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &componentsImg,
-		&labels);
+		Components(bitmapInfo.bitmap, bitmapInfo.uextent, bitmapInfo.vextent, uwrap, vwrap, &componentsImg,
+			&labels);
+	}
 	if(labels.size() <= 1) // found no connected component!
 	{
 		return 0; // associate no points with this shape
@@ -7,6 +7,7 @@
 #include <ctime>
 #include <deque>
 #include <iostream>
+#include <random>
 #include <MiscLib/Random.h>
 #include "Candidate.h"
 #include <MiscLib/Performance.h>
@@ -60,6 +61,207 @@ size_t RansacShapeDetector::StatBucket(float score) const
     return (size_t)std::max(0.f, std::floor((std::log(score) - std::log((float)m_options.m_minSupport)) / std::log(1.21f)) + 1);
 }
 
+/** Draws the candidate samples of Detect from its own generator, so that the draws don't depend on how many
+ *  random numbers the scoring consumed, and replays the draws of an IndexCache until the first shape gets accepted.
+ *  Draws after that continue the same sequence, as if nothing had been replayed.
+ */
+class RansacShapeDetector::SampleSource
+{
+    public:
+        SampleSource( size_t seed, IndexCache *cache )
+            : m_rng( (std::mt19937::result_type)seed )
+            , m_seed( seed )
+            , m_calls( 0 )
+            , m_cache( cache )
+            , m_next( 0 )
+            , m_replayed( false )
+            , m_pristine( true )
+        {}
+
+        size_t operator()()
+        {
+            ++m_calls;
+            return m_rng();
+        }
+
+        //! Picks a sample level according to \p levelProbSum, and draws the samples on it. Returns false, if the draw failed.
+        bool Draw( const RansacShapeDetector             &detector
+                 , const IndexedOctreeType               &oct
+                 , const MiscLib::Vector< double >       &levelProbSum
+                 , const MiscLib::Vector< int >          &shapeIndex
+                 , MiscLib::Vector< size_t >             *samples
+                 , size_t                                *level )
+        {
+            if ( m_pristine && m_cache && m_next < m_cache->m_pool.size() )
+            {
+                const IndexCache::Draw &draw = m_cache->m_pool[ m_next++ ];
+                *samples   = draw.m_samples;
+                *level     = draw.m_nodeLevel;
+                m_calls    = draw.m_rngCalls;
+                m_replayed = true;
+                return samples->size() != 0;
+            }
+            if ( m_replayed )
+            {
+                m_rng.seed( (std::mt19937::result_type)m_seed );
+                m_rng.discard( m_calls );
+                m_replayed = false;
+            }
+
+            size_t sampleLevel = 0;
+            {
+                const double s = double((*this)()) / double(std::mt19937::max());
+                for ( ; sampleLevel < levelProbSum.size() - 1; ++sampleLevel )
+                    if ( levelProbSum[sampleLevel] >= s )
+                        break;
+            }
+
+            const IndexedOctreeType::CellType *node = NULL;
+            const bool ok = detector.DrawSamplesStratified( oct, detector.m_reqSamples, sampleLevel, shapeIndex, samples, &node, *this );
+            *level = ok ? node->Level() : 0;
+
+            if ( m_pristine && m_cache )
+            {
+                m_cache->m_pool.push_back( IndexCache::Draw() );
+                m_cache->m_pool.back().m_nodeLevel = *level;
+                m_cache->m_pool.back().m_rngCalls  = m_calls;
+                if ( ok )
+                    m_cache->m_pool.back().m_samples = *samples;
+            }
+            ++m_next;
+
+            return ok;
+        }
+
+        //! Called, when the first shape got accepted: the draws depend on the shapes from now on.
+        void Diverge() { m_pristine = false; }
+
+    private:
+        std::mt19937    m_rng;
+        size_t          m_seed, m_calls;
+        IndexCache     *m_cache;
+        size_t          m_next;
+        bool            m_replayed, m_pristine;
+};
+
+void RansacShapeDetector::IndexCache::Clear()
+{
+    m_seed = m_reqSamples = m_fingerprint = m_rnPoint = 0;
+    m_points.clear();
+    m_rnState.clear();
+    m_pool.clear();
+}
+
+size_t RansacShapeDetector::IndexCache::Fingerprint( const PointCloud &pc, size_t begin, size_t end )
+{
+    // FNV-1a over the positions and normals in input order, the subsets depend on the order
+    size_t h = 14695981039346656037ULL;
+    for ( size_t i = begin; i != end; ++i )
+    {
+        const unsigned char *bytes[2] = { reinterpret_cast< const unsigned char * >( pc[i].pos   .getValue() )
+                                        , reinterpret_cast< const unsigned char * >( pc[i].normal.getValue() ) };
+        for ( int k = 0; k != 2; ++k )
+            for ( size_t b = 0; b != 3 * sizeof(float); ++b )
+                h = (h ^ bytes[k][b]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+bool RansacShapeDetector::IndexCache::Matches( const PointCloud &pc, size_t begin, size_t end, size_t seed, size_t reqSamples ) const
+{
+    return Valid()
+        && m_seed        == seed
+        && m_reqSamples  == reqSamples
+        && m_points.size() == end - begin
+        && m_fingerprint == Fingerprint( pc, begin, end );
+}
+
+static const char s_indexCacheMagic[8] = { 'S', 'C', 'H', 'N', 'I', 'D', 'X', '1' };
+
+template < typename T >
+static void WritePod( std::ostream &os, const T &v ) { os.write( reinterpret_cast< const char * >( &v ), sizeof(T) ); }
+template < typename T >
+static void ReadPod ( std::istream &is,       T &v ) { is.read ( reinterpret_cast<       char * >( &v ), sizeof(T) ); }
+
+bool RansacShapeDetector::IndexCache::Save( std::ostream &os ) const
+{
+    os.write( s_indexCacheMagic, sizeof(s_indexCacheMagic) );
+    WritePod( os, m_seed );
+    WritePod( os, m_reqSamples );
+    WritePod( os, m_fingerprint );
+    WritePod( os, m_points.size() );
+    for ( size_t i = 0; i != m_points.size(); ++i )
+    {
+        os.write( reinterpret_cast< const char * >( m_points[i].pos   .getValue() ), 3 * sizeof(float) );
+        os.write( reinterpret_cast< const char * >( m_points[i].normal.getValue() ), 3 * sizeof(float) );
+    }
+    WritePod( os, m_rnState.size() );
+    for ( size_t i = 0; i != m_rnState.size(); ++i )
+        WritePod( os, m_rnState[i] );
+    WritePod( os, m_rnPoint );
+    WritePod( os, m_pool.size() );
+    for ( size_t i = 0; i != m_pool.size(); ++i )
+    {
+        WritePod( os, m_pool[i].m_nodeLevel );
+        WritePod( os, m_pool[i].m_rngCalls );
+        WritePod( os, m_pool[i].m_samples.size() );
+        for ( size_t j = 0; j != m_pool[i].m_samples.size(); ++j )
+            WritePod( os, m_pool[i].m_samples[j] );
+    }
+    return bool(os);
+}
+
+bool RansacShapeDetector::IndexCache::Load( std::istream &is )
+{
+    Clear();
+    char magic[ sizeof(s_indexCacheMagic) ];
+    is.read( magic, sizeof(magic) );
+    if ( !is || !std::equal(magic, magic + sizeof(magic), s_indexCacheMagic) )
+        return false;
+
+    size_t n( 0 );
+    ReadPod( is, m_seed );
+    ReadPod( is, m_reqSamples );
+    ReadPod( is, m_fingerprint );
+    ReadPod( is, n );
+    for ( size_t i = 0; i != n && is; ++i )
+    {
+        Point pt;
+        is.read( reinterpret_cast< char * >( static_cast< float * >( pt.pos    ) ), 3 * sizeof(float) );
+        is.read( reinterpret_cast< char * >( static_cast< float * >( pt.normal ) ), 3 * sizeof(float) );
+        m_points.push_back( pt );
+    }
+    ReadPod( is, n );
+    if ( is && n != MiscLib_RN_BUFSIZE )
+        is.setstate( std::ios::failbit );
+    m_rnState.resize( is ? n : 0 );
+    for ( size_t i = 0; i != m_rnState.size(); ++i )
+        ReadPod( is, m_rnState[i] );
+    ReadPod( is, m_rnPoint );
+    ReadPod( is, n );
+    for ( size_t i = 0; i != n && is; ++i )
+    {
+        m_pool.push_back( Draw() );
+        size_t c( 0 );
+        ReadPod( is, m_pool.back().m_nodeLevel );
+        ReadPod( is, m_pool.back().m_rngCalls );
+        ReadPod( is, c );
+        for ( size_t j = 0; j != c && is; ++j )
+        {
+            size_t id;
+            ReadPod( is, id );
+            m_pool.back().m_samples.push_back( id );
+        }
+    }
+
+    if ( !is )
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
 /*
  * Function Detect !!!!
  */
@@ -104,7 +306,8 @@ void RansacShapeDetector::GenerateCandidates(
               size_t                                    *drawnCandidates,
               MiscLib::Vector<std::pair<float,size_t> > *sampleLevelScores,
         float                                           *bestExpectedValue,
-              CandidatesType                            *candidates
+              CandidatesType                            *candidates,
+              SampleSource                              &sampler
         ) const
 {
     size_t genCands = 0;
@@ -116,24 +319,15 @@ void RansacShapeDetector::GenerateCandidates(
 //#       pragma omp for schedule(dynamic, 10) reduction(+:genCands)
         for ( int candIter = 0; candIter < 200; ++candIter )
         {
-            // pick a sample level
-            size_t sampleLevel = 0;
-            {
-                double s = ((double)rand()) / (double)RAND_MAX;
-                for(; sampleLevel < sampleLevelProbSum.size() - 1; ++sampleLevel )
-                    if ( sampleLevelProbSum[sampleLevel] >= s )
-                        break;
-            }
-
-            // draw samples on current sample level in octree
+            // pick a sample level and draw samples on it in the octree
             MiscLib::Vector< size_t > samples;
-            const IndexedOctreeType::CellType *node;
-            if ( !DrawSamplesStratified( globalOctree
-                                         , m_reqSamples
-                                         , sampleLevel
-                                         , scoreVisitorCopy.GetShapeIndex()
-                                         , &samples
-                                         , &node) )
+            size_t                    nodeLevel;
+            if ( !sampler.Draw( *this
+                              , globalOctree
+                              , sampleLevelProbSum
+                              , scoreVisitorCopy.GetShapeIndex()
+                              , &samples
+                              , &nodeLevel) )
                 continue;
             ++genCands;
 
@@ -185,7 +379,7 @@ void RansacShapeDetector::GenerateCandidates(
                 shape->Normal(p,&n);
                 //std::cout << "verified: " << n.print() << std::endl;
 
-                Candidate cand( shape, node->Level() );
+                Candidate cand( shape, nodeLevel );
                 cand.Indices(new MiscLib::RefCounted< MiscLib::Vector< size_t > >);
                 cand.Indices()->Release();
                 shape->Release();
@@ -195,16 +389,16 @@ void RansacShapeDetector::GenerateCandidates(
                 {
 #                   pragma omp critical
                     {
-                        (*sampleLevelScores)[node->Level()].first += cand.ExpectedValue();
-                        ++(*sampleLevelScores)[node->Level()].second;
+                        (*sampleLevelScores)[nodeLevel].first += cand.ExpectedValue();
+                        ++(*sampleLevelScores)[nodeLevel].second;
                     }
                     continue;
                 }
 
 #               pragma omp critical
                 {
-                    (*sampleLevelScores)[node->Level()].first += cand.ExpectedValue();
-                    ++(*sampleLevelScores)[node->Level()].second;
+                    (*sampleLevelScores)[nodeLevel].first += cand.ExpectedValue();
+                    ++(*sampleLevelScores)[nodeLevel].second;
 
                     candidates->push_back( cand );
                     if ( cand.ExpectedValue() > *bestExpectedValue )
@@ -495,6 +689,7 @@ RansacShapeDetector::Detect( PointCloud &pc
                              , MiscLib::Vector< std::pair< RefCountPtr< PrimitiveShape >, size_t > > *shapes
                              , MiscLib::Vector< int > *outShapeIndex
                              , std::vector< MiscLib::Vector< size_t > > *outIndices
+                             , IndexCache *cache
                              )
 {
     float x = abs(2.33f);
@@ -507,8 +702,28 @@ RansacShapeDetector::Detect( PointCloud &pc
     /*
      * Initialization part
      */
-    srand((unsigned int)time(NULL));
-    rn_setseed((size_t)time(NULL));
+    const size_t seed = m_options.m_seed ? m_options.m_seed : (size_t)time(NULL);
+    rn_setseed( seed );
+    rn_point = MiscLib_RN_BUFSIZE; // rn_setseed keeps the position of the last run
+
+    const bool reuse = cache && cache->Matches( pc, beginIdx, endIdx, seed, m_reqSamples );
+    if ( cache && !reuse )
+    {
+        cache->Clear();
+        cache->m_seed        = seed;
+        cache->m_reqSamples  = m_reqSamples;
+        cache->m_fingerprint = IndexCache::Fingerprint( pc, beginIdx, endIdx );
+        cache->m_points.resize( pcSize );
+    }
+    else if ( reuse )
+    {
+        // the subsets are already drawn: restore their order and the generator after drawing them
+        std::copy( cache->m_points.begin(), cache->m_points.end(), pc.begin() + beginIdx );
+        std::copy( cache->m_rnState.begin(), cache->m_rnState.end(), rn_buf );
+        rn_point = cache->m_rnPoint;
+        std::cout << "[" << __func__ << "] reusing the index cache with " << cache->PoolSize() << " samples" << std::endl;
+    }
+    SampleSource sampler( seed, cache );
 
     CandidatesType candidates;
 
@@ -528,8 +743,9 @@ RansacShapeDetector::Detect( PointCloud &pc
         --i;
         size_t subsetSize = pcSize;
         if ( i )
-        {
             subsetSize = subsetSize >> 1;
+        if ( i && !reuse )
+        {
             MiscLib::Vector< size_t > subsetIndices( subsetSize );
             size_t                    bucketSize = pcSize / subsetSize;
             for ( size_t j = 0; j < subsetSize; ++j )
@@ -544,6 +760,9 @@ RansacShapeDetector::Detect( PointCloud &pc
             for ( size_t j = pcSize - 1, i = 0; i < subsetIndices.size(); --j, ++i )
                 std::swap( pc[j + beginIdx], pc[subsetIndices[i]] );
         }
+        // the subsets below are drawn in front of this range, it is final before building its octree
+        if ( cache && !reuse )
+            std::copy( pc.begin() + pcSize - subsetSize + beginIdx, pc.begin() + pcSize + beginIdx, cache->m_points.begin() + pcSize - subsetSize );
         octrees[i] = new ImmediateOctreeType;
         octrees[i]->ContainedData(&pc);
         octrees[i]->DataRange(pcSize - subsetSize + beginIdx,
@@ -554,6 +773,11 @@ RansacShapeDetector::Detect( PointCloud &pc
         pcSize -= subsetSize;
     }
     pcSize = endIdx - beginIdx;
+    if ( cache && !reuse )
+    {
+        cache->m_rnState.assign( rn_buf, rn_buf + MiscLib_RN_BUFSIZE );
+        cache->m_rnPoint = rn_point;
+    }
 
     // construct one global octree
     MiscLib::Vector< size_t > globalOctreeIndices(pcSize);
@@ -642,7 +866,8 @@ RansacShapeDetector::Detect( PointCloud &pc
                                     &drawnCandidates,
                                     &sampleLevelScores,
                                     &bestExpectedValue,
-                                    &candidates );
+                                    &candidates,
+                                    sampler );
 
                 cfp1 = CandidateFailureProbability( bestExpectedValue     , currentSize - numInvalid, drawnCandidates, globalOctTreeMaxNodeDepth );
                 cfp2 = CandidateFailureProbability( m_options.m_minSupport, currentSize - numInvalid, drawnCandidates, globalOctTreeMaxNodeDepth);
@@ -689,6 +914,7 @@ RansacShapeDetector::Detect( PointCloud &pc
                 UpdateLevelWeights(0.5f, sampleLevelScores, &sampleLevelProbability);
             }
             foundCandidate = true;
+            sampler.Diverge();
             if(bestCandidateFailureProbability < failureProbability)
                 failureProbability = bestCandidateFailureProbability;
             std::string candidateDescription;
@@ -987,7 +1213,8 @@ bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
                                                 size_t numSamples, size_t depth,
                                                 const MiscLib::Vector< int > &shapeIndex,
                                                 MiscLib::Vector< size_t > *samples,
-                                                const IndexedOctreeType::CellType **node) const
+                                                const IndexedOctreeType::CellType **node,
+                                                SampleSource &sampler) const
 {
     for(size_t tries = 0; tries < m_maxCandTries; tries++)
     {
@@ -996,7 +1223,7 @@ bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
         size_t first;
         do
         {
-            first = oct.Dereference(rn_rand() % oct.size());
+            first = oct.Dereference(sampler() % oct.size());
         }
         while(shapeIndex[first] != -1);
         samples->push_back(first);
@@ -1013,7 +1240,7 @@ bool RansacShapeDetector::DrawSamplesStratified(const IndexedOctreeType &oct,
             size_t i, iter = 0;
             do
             {
-                i = oct.Dereference(rn_rand() % (*node)->Size()
+                i = oct.Dereference(sampler() % (*node)->Size()
                                     + nodeRange.first);
             }
             while( ( shapeIndex[i] != -1
@@ -5,6 +5,8 @@
 #include <MiscLib/Vector.h>
 #include <MiscLib/NoShrinkVector.h>
 #include <utility>
+#include <vector>
+#include <iosfwd>
 #include "Candidate.h"
 #include <MiscLib/RefCountPtr.h>
 #include "Octree.h"
@@ -29,6 +31,7 @@ class DLL_LINKAGE RansacShapeDetector
 			, m_bitmapEpsilon(0.01f)
 			, m_fitting(LS_FITTING)
 			, m_probability(0.001f)
+			, m_seed(0)
 			{}
             float        m_epsilon;
             float        m_normalThresh;
@@ -36,6 +39,40 @@ class DLL_LINKAGE RansacShapeDetector
             float        m_bitmapEpsilon;
 			enum { NO_FITTING, LS_FITTING } m_fitting;
             float        m_probability;
+            size_t       m_seed;            //!< Seeds all random draws of Detect, 0: seeded by the time
+		};
+
+		/** Spatial index and random samples of a point cloud, that do not depend on the epsilons or the minimum support.
+		 *  A Detect call with an empty cache fills it, later calls on the same points and seed restore it
+		 *  instead of drawing the stratified subsets again, and replay the candidate samples drawn before the first shape got accepted.
+		 *  The results are the same as without the cache.
+		 */
+		class IndexCache
+		{
+			public:
+				IndexCache() : m_seed(0), m_reqSamples(0), m_fingerprint(0), m_rnPoint(0) {}
+				bool   Valid   () const { return m_points.size() != 0; }
+				void   Clear   ();
+				size_t PoolSize() const { return m_pool.size(); }
+				bool   Save    ( std::ostream &os ) const;
+				bool   Load    ( std::istream &is );
+
+			private:
+				friend class RansacShapeDetector;
+				struct Draw
+				{
+					size_t                    m_nodeLevel; //!< Octree level of the sampled cell
+					size_t                    m_rngCalls;  //!< Sample generator calls after this draw
+					MiscLib::Vector< size_t > m_samples;   //!< Empty, if the draw failed
+				};
+				static size_t Fingerprint( const PointCloud &pc, size_t begin, size_t end );
+				bool Matches( const PointCloud &pc, size_t begin, size_t end, size_t seed, size_t reqSamples ) const;
+
+				size_t                    m_seed, m_reqSamples, m_fingerprint;
+				MiscLib::Vector< Point >  m_points;    //!< [begin,end) of the cloud after the subset octrees got built
+				std::vector< size_t >     m_rnState;   //!< MiscLib::rn_buf after the subsets got drawn
+				size_t                    m_rnPoint;
+				std::vector< Draw >       m_pool;
 		};
                         RansacShapeDetector();
                         RansacShapeDetector(const Options &options);
@@ -47,6 +84,7 @@ class DLL_LINKAGE RansacShapeDetector
                                       , MiscLib::Vector<std::pair<MiscLib::RefCountPtr<PrimitiveShape>, size_t> > *shapes
                                       , MiscLib::Vector< int > *outShapeIndex = NULL
                                       , std::vector< MiscLib::Vector< size_t > > *outIndices = NULL
+                                      , IndexCache *cache = NULL
                                       );
         void            AutoAcceptSize(size_t s) { m_autoAcceptSize = s; }
         size_t          AutoAcceptSize() const   { return m_autoAcceptSize; }
@@ -55,13 +93,15 @@ class DLL_LINKAGE RansacShapeDetector
 	private:
         typedef MiscLib::Vector        < PrimitiveShapeConstructor* > ConstructorsType;
         typedef MiscLib::NoShrinkVector< Candidate                  > CandidatesType;
+        class SampleSource;
 
         bool DrawSamplesStratified( const IndexedOctreeType             & oct
                                     , size_t                              numSamples
                                     , size_t                              depth
                                     , MiscLib::Vector< int >       const& shapeIndex
                                     , MiscLib::Vector< size_t >         * samples
-                                    , IndexedOctreeType::CellType const** node ) const;
+                                    , IndexedOctreeType::CellType const** node
+                                    , SampleSource                      & sampler ) const;
 		PrimitiveShape *Fit(bool allowDifferentShapes,
 			const PrimitiveShape &initialShape, const PointCloud &pc,
 			MiscLib::Vector< size_t >::const_iterator begin,
@@ -93,7 +133,8 @@ class DLL_LINKAGE RansacShapeDetector
 			size_t *drawnCandidates,
 			MiscLib::Vector< std::pair< float, size_t > > *sampleLevelScores,
 			float *bestExpectedValue,
-			CandidatesType *candidates) const;
+			CandidatesType *candidates,
+			SampleSource &sampler) const;
 		template< class ScoreVisitorT >
 		bool FindBestCandidate(CandidatesType &candidates,
 			const MiscLib::Vector< ImmediateOctreeType * > &octrees,
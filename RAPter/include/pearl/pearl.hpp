@@ -282,10 +282,12 @@ namespace am
             gc->setSmoothCost( smooth ); // pairwise labelwise
             gc->setLabelCost ( beta   ); // complexity ( number of labels)
 
-            // set neighbourhoods
+            // set neighbourhoods, in one go
             std::vector<float> neighvals; neighvals.reserve( neighs.size() * 15 );
+            std::vector<gco::GCoptimization::SiteID> offsets( 1, 0 ), neighbours; neighbours.reserve( neighs.size() * 15 );
             for ( size_t pid = 0; pid != neighs.size(); ++pid )
-                for ( size_t pid2 = 1; pid2 != neighs[pid].size(); ++pid2 ) // don't count own
+            {
+                for ( size_t pid2 = 1; pid2 < neighs[pid].size(); ++pid2 ) // don't count own
                 {
                     float distsqr  = sqr_dists[pid][pid2] * params.int_mult * params.int_mult;
                     float neighval = std::abs( params.lambdas(2) * exp( -1.f * distsqr / gammasqr) );
@@ -296,9 +298,14 @@ namespace am
                     if ( neighval < 0 )
                         std::cerr << "neighval: " << neighval << std::endl;
 
-                    gc->setNeighbors( pid, neighs[pid][pid2], neighval ); // pairwise - point wise
+                    neighbours.push_back( neighs[pid][pid2] ); // pairwise - point wise
                     neighvals.push_back( neighval );
                 }
+                offsets.push_back( neighbours.size() );
+            }
+            offsets.resize( num_pixels + 1, neighbours.size() );
+            if ( neighbours.size() )
+                gc->setNeighborsCSR( &offsets[0], &neighbours[0], &neighvals[0] );
 
             // debug
             {
@@ -30,10 +30,12 @@ namespace rapter
         _PrimitiveContainerT     primitives;
         PrimitiveMapT            patches;
         RansacParams<Scalar>     params;
+        int                      graphMegabytes = 1024; // expansion graphs kept between cycles
 
         // parse
         {
             bool valid_input = !parseInput<_InnerPrimitiveContainerT,_PclCloudT>( points, pcl_cloud, primitives, patches, params, argc, argv, false );
+            rapter::console::parse_argument( argc, argv, "--graph-mb", graphMegabytes );
 
             if (     !valid_input
                   || (rapter::console::find_switch(argc,argv,"-h"    ))
@@ -43,6 +45,7 @@ namespace rapter
                           << "\t --cloud " << /*cloud_path <<*/ "\n"
                           << "\t -p,--prims " << /*input_prims_path <<*/ "\n"
                           << "\t -sc,--scale " << params.scale << "\n"
+                          << "\t [--graph-mb " << graphMegabytes << "]\t Memory for reusing alpha-expansion graphs between cycles, 0: rebuild every move\n"
                           << "\t Example: ../ransac --assign --scale 0.03 --cloud cloud.ply -p patches.csv"
                           << "\n";
 
@@ -141,12 +144,20 @@ namespace rapter
                                                    );
 
                 std::cout << "[" << __func__ << "]: " << "setting neighbourhood" << std::endl; fflush(stdout);
+                std::vector<gco::GCoptimization::SiteID>         offsets( 1, 0 ), neighbours;
+                std::vector<gco::GCoptimization::EnergyTermType> weights;
                 for ( UPidT pid = 0; pid != neighs.size(); ++pid )
+                {
                     for ( UPidT nid = 0; nid != neighs[pid].size(); ++nid )
                     {
-                        Scalar d = Scalar(100.) * std::max( Scalar(0.), params.scale - sqr_dists[pid][nid]);
-                        gc->setNeighbors( pid, neighs[pid][nid], d );
+                        neighbours.push_back( neighs[pid][nid] );
+                        weights   .push_back( Scalar(100.) * std::max( Scalar(0.), params.scale - sqr_dists[pid][nid]) );
                     }
+                    offsets.push_back( neighbours.size() );
+                }
+                offsets.resize( num_pixels + 1, neighbours.size() );
+                gc->setNeighborsCSR( &offsets[0], neighbours.size() ? &neighbours[0] : NULL, weights.size() ? &weights[0] : NULL );
+                gc->setDynamicExpansion( graphMegabytes );
 
 
                 printf("\nBefore optimization energy is %f",gc->compute_energy()); fflush(stdout);
@@ -119,6 +119,11 @@ namespace rapter
         rapter::console::parse_argument( argc, argv, "--stat-log", statLogPath );
         std::cout << "[" << __func__ << "]: " << "Appending stats to \"" << statLogPath << "\", change with --stat-log" << std::endl;
 
+        std::string meshCacheDir( "" );
+        rapter::console::parse_argument( argc, argv, "--mesh-cache", meshCacheDir );
+        if ( !meshCacheDir.empty() )
+            std::cout << "[" << __func__ << "]: " << "Keeping a parsed copy of the mesh in \"" << meshCacheDir << "\", change with --mesh-cache" << std::endl;
+
         std::string origCloudPath("");
         rapter::console::parse_argument( argc, argv, "--cloud-orig", origCloudPath );
         _PointContainerT origPoints;
@@ -161,7 +166,7 @@ namespace rapter
 
         // parse input mesh
         std::vector<Triangle> triangles;
-        getTrianglesFromObj( triangles, meshPath, minPlaneEdge );
+        getTrianglesFromObj( triangles, meshPath, minPlaneEdge, meshCacheDir );
         std::cout << "have " << triangles.size() << " triangles" << std::endl;
 
         // debug ( add triangles )
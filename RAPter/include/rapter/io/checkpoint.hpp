@@ -0,0 +1,489 @@
+#ifndef RAPTER_CHECKPOINT_HPP
+#define RAPTER_CHECKPOINT_HPP
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <fstream>
+#include <iostream>
+#include "boost/filesystem.hpp"
+#include "rapter/simpleTypes.h"
+#include "rapter/util/containers.hpp" // containers::add
+
+namespace rapter {
+namespace io {
+
+/*! \brief Binary snapshots of long running stages (\ref Solver::solve(), \ref merging::iterativeMerge()).
+ *
+ *         A snapshot is written to "<path>.tmp" and renamed over "<path>" once complete, so "<path>" always holds
+ *         the latest consistent state. Each file starts with a header (magic, version, stage) and ends with the magic again,
+ *         truncated files are rejected on load.
+ */
+namespace checkpoint
+{
+    static const char    MAGIC[8] = { 'R','P','T','R','C','K','P','T' };
+    static const int     VERSION  = 2;
+    static const ULidT   HASH_SEED = 14695981039346656037ul; //!< \brief FNV-1a 64 bit offset basis.
+    enum STAGE { SOLVE = 1, MERGE = 2 };
+
+    template <typename _T> inline void
+    writePod( std::ostream &os, _T const& value ) { os.write( reinterpret_cast<char const*>(&value), sizeof(_T) ); }
+
+    template <typename _T> inline bool
+    readPod( std::istream &is, _T &value ) { is.read( reinterpret_cast<char*>(&value), sizeof(_T) ); return static_cast<bool>(is); }
+
+    inline void
+    writeString( std::ostream &os, std::string const& str )
+    {
+        writePod( os, static_cast<ULidT>(str.size()) );
+        os.write( str.data(), str.size() );
+    }
+
+    inline bool
+    readString( std::istream &is, std::string &str )
+    {
+        ULidT size = 0;
+        if ( !readPod(is, size) ) return false;
+        str.resize( size );
+        if ( size ) is.read( &str[0], size );
+        return static_cast<bool>(is);
+    }
+
+    //! \brief Mixes \p size bytes at \p data into \p hash (FNV-1a), used to fingerprint the inputs a snapshot belongs to.
+    inline void
+    hashBytes( ULidT &hash, void const* data, size_t const size )
+    {
+        unsigned char const* bytes = static_cast<unsigned char const*>( data );
+        for ( size_t i = 0; i != size; ++i )
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ul;
+        }
+    }
+
+    template <typename _T> inline void
+    hashPod( ULidT &hash, _T const& value ) { hashBytes( hash, &value, sizeof(_T) ); }
+
+    //! \brief Mixes the non-zeros of \p mx into \p hash. \tparam _SparseMatrixT Concept: Eigen::SparseMatrix<double>.
+    template <class _SparseMatrixT> inline void
+    hashSparse( ULidT &hash, _SparseMatrixT const& mx )
+    {
+        hashPod( hash, static_cast<ULidT>(mx.rows()) );
+        hashPod( hash, static_cast<ULidT>(mx.cols()) );
+        for ( int k = 0; k < mx.outerSize(); ++k )
+            for ( typename _SparseMatrixT::InnerIterator it(mx, k); it; ++it )
+            {
+                hashPod( hash, static_cast<ULidT>(it.row()) );
+                hashPod( hash, static_cast<ULidT>(it.col()) );
+                hashPod( hash, it.value() );
+            }
+    }
+
+    /*! \brief Fingerprint of a read optimization problem: variables, constraints, their bounds, and the objective and constraint matrices.
+     *  \tparam _OptProblemT Concept: qcqpcpp::OptProblem<double>.
+     */
+    template <class _OptProblemT> inline ULidT
+    hashProblem( _OptProblemT const& problem )
+    {
+        ULidT hash = HASH_SEED;
+        for ( size_t j = 0; j != problem.getVarCount(); ++j )
+        {
+            hashPod( hash, static_cast<int>(problem.getVarType(j)     ) );
+            hashPod( hash, static_cast<int>(problem.getVarBoundType(j)) );
+            hashPod( hash, problem.getVarLowerBound(j) );
+            hashPod( hash, problem.getVarUpperBound(j) );
+        }
+        for ( size_t i = 0; i != problem.getConstraintCount(); ++i )
+        {
+            hashPod( hash, static_cast<int>(problem.getConstraintBoundType(i)) );
+            hashPod( hash, problem.getConstraintLowerBound(i) );
+            hashPod( hash, problem.getConstraintUpperBound(i) );
+        }
+        hashPod   ( hash, problem.getObjectiveBias()             );
+        hashSparse( hash, problem.getLinObjectivesMatrix()       );
+        hashSparse( hash, problem.getQuadraticObjectivesMatrix() );
+        hashSparse( hash, problem.getLinConstraintsMatrix()      );
+        return hash;
+    }
+
+    /*! \brief Fingerprint of the input of a merge: primitives (coefficients, GID, DIR_GID) and points (coordinates, GID).
+     *  \tparam _PrimitiveMapT    Concept: containers::PrimitiveContainer<_PrimitiveT>.
+     *  \tparam _PointContainerT  Concept: std::vector<_PointPrimitiveT>.
+     */
+    template <class _PrimitiveT, class _PointPrimitiveT, class _PrimitiveMapT, class _PointContainerT> inline ULidT
+    hashMergeInput( _PrimitiveMapT const& prims, _PointContainerT const& points )
+    {
+        ULidT hash = HASH_SEED;
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
+            for ( typename _PrimitiveMapT::mapped_type::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+            {
+                hashBytes( hash, it2->coeffs().data(), _PrimitiveT::Dim * sizeof(typename _PrimitiveT::Scalar) );
+                hashPod  ( hash, static_cast<GidT>(it2->getTag(_PrimitiveT::TAGS::GID    )) );
+                hashPod  ( hash, static_cast<DidT>(it2->getTag(_PrimitiveT::TAGS::DIR_GID)) );
+            }
+        for ( typename _PointContainerT::const_iterator it = points.begin(); it != points.end(); ++it )
+        {
+            hashBytes( hash, it->coeffs().data(), _PointPrimitiveT::Dim * sizeof(typename _PointPrimitiveT::Scalar) );
+            hashPod  ( hash, static_cast<GidT>(it->getTag(_PointPrimitiveT::TAGS::GID)) );
+        }
+        return hash;
+    }
+
+    inline void
+    writeHeader( std::ostream &os, int const stage )
+    {
+        os.write( MAGIC, sizeof(MAGIC) );
+        writePod( os, VERSION );
+        writePod( os, stage );
+    }
+
+    inline bool
+    readHeader( std::istream &is, int const stage )
+    {
+        char magic[ sizeof(MAGIC) ];
+        int  version = 0, fileStage = 0;
+        is.read( magic, sizeof(MAGIC) );
+        return is && std::equal( magic, magic + sizeof(MAGIC), MAGIC )
+                  && readPod( is, version   ) && (version   == VERSION)
+                  && readPod( is, fileStage ) && (fileStage == stage  );
+    }
+
+    inline void
+    writeFooter( std::ostream &os ) { os.write( MAGIC, sizeof(MAGIC) ); }
+
+    inline bool
+    readFooter( std::istream &is )
+    {
+        char magic[ sizeof(MAGIC) ];
+        is.read( magic, sizeof(MAGIC) );
+        return is && std::equal( magic, magic + sizeof(MAGIC), MAGIC );
+    }
+
+    //! \brief Replaces \p path by the finished \p tmpPath (rename is atomic on POSIX filesystems).
+    inline int
+    commit( std::string const& tmpPath, std::string const& path )
+    {
+        boost::system::error_code ec;
+        boost::filesystem::rename( tmpPath, path, ec );
+        if ( ec )
+        {
+            std::cerr << "[" << __func__ << "]: " << "could not move " << tmpPath << " to " << path << ": " << ec.message() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    //! \brief Removes a snapshot after the stage finished successfully.
+    inline void
+    remove( std::string const& path )
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove( path, ec );
+    }
+} //...namespace checkpoint
+
+/*! \brief State of \ref Solver::solve() between optimization attempts.
+ *  \tparam _Scalar Concept: double.
+ */
+template <typename _Scalar>
+struct SolverCheckpoint
+{
+    SolverCheckpoint()
+        : varCount( 0 ), constrCount( 0 ), inputHash( 0 )
+        , attempt( 0 ), done( false )
+        , upperBound( std::numeric_limits<_Scalar>::infinity() )
+        , lowerBound( -std::numeric_limits<_Scalar>::infinity() ) {}
+
+    ULidT                varCount;   //!< \brief Variables of the problem the snapshot was taken of.
+    ULidT                constrCount;//!< \brief Constraints of the problem the snapshot was taken of.
+    ULidT                inputHash;  //!< \brief \ref checkpoint::hashProblem() of the problem the snapshot was taken of.
+    int                  attempt;    //!< \brief Attempt that is running (done == false), or that produced the incumbent (done == true).
+    bool                 done;       //!< \brief The incumbent is the final output of the solver.
+    std::string          rngState;   //!< \brief Serialized random engine, state before the starting point of \p attempt was drawn.
+    std::vector<_Scalar> incumbent;  //!< \brief Best solution so far, empty if none.
+    _Scalar              upperBound; //!< \brief Objective value of the incumbent.
+    _Scalar              lowerBound; //!< \brief Best known lower bound ( \ref LagrangianBound ), -inf if not computed.
+
+    //! \brief Records the problem the snapshot belongs to. \tparam _OptProblemT Concept: qcqpcpp::OptProblem<_Scalar>.
+    template <class _OptProblemT> inline void
+    setProblem( _OptProblemT const& problem )
+    {
+        varCount    = problem.getVarCount();
+        constrCount = problem.getConstraintCount();
+        inputHash   = checkpoint::hashProblem( problem );
+    }
+
+    //! \brief True, if the snapshot was taken of \p problem, prints the difference otherwise.
+    template <class _OptProblemT> inline bool
+    matchesProblem( _OptProblemT const& problem ) const
+    {
+        const ULidT hash = checkpoint::hashProblem( problem );
+        if ( (varCount == problem.getVarCount()) && (constrCount == problem.getConstraintCount()) && (inputHash == hash) )
+            return true;
+
+        std::cout << "[" << __func__ << "]: " << "snapshot belongs to a different problem ("
+                  << varCount << " variables, " << constrCount << " constraints, hash " << std::hex << inputHash << std::dec << " vs "
+                  << problem.getVarCount() << ", " << problem.getConstraintCount() << ", " << std::hex << hash << std::dec << ")" << std::endl;
+        return false;
+    }
+}; //...SolverCheckpoint
+
+template <typename _Scalar> inline int
+saveSolverCheckpoint( SolverCheckpoint<_Scalar> const& ckpt, std::string const& path )
+{
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream f( tmpPath.c_str(), std::ios::binary | std::ios::trunc );
+        if ( !f.is_open() )
+        {
+            std::cerr << "[" << __func__ << "]: " << "could not open " << tmpPath << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        checkpoint::writeHeader ( f, checkpoint::SOLVE );
+        checkpoint::writePod    ( f, ckpt.varCount    );
+        checkpoint::writePod    ( f, ckpt.constrCount );
+        checkpoint::writePod    ( f, ckpt.inputHash   );
+        checkpoint::writePod    ( f, ckpt.attempt );
+        checkpoint::writePod    ( f, static_cast<char>(ckpt.done) );
+        checkpoint::writeString ( f, ckpt.rngState );
+        checkpoint::writePod    ( f, ckpt.upperBound );
+        checkpoint::writePod    ( f, ckpt.lowerBound );
+        checkpoint::writePod    ( f, static_cast<ULidT>(ckpt.incumbent.size()) );
+        if ( ckpt.incumbent.size() )
+            f.write( reinterpret_cast<char const*>(ckpt.incumbent.data()), ckpt.incumbent.size() * sizeof(_Scalar) );
+        checkpoint::writeFooter ( f );
+
+        if ( !f )
+            return EXIT_FAILURE;
+    }
+
+    return checkpoint::commit( tmpPath, path );
+} //...saveSolverCheckpoint()
+
+template <typename _Scalar> inline int
+loadSolverCheckpoint( SolverCheckpoint<_Scalar> &ckpt, std::string const& path )
+{
+    std::ifstream f( path.c_str(), std::ios::binary );
+    if ( !f.is_open() || !checkpoint::readHeader(f, checkpoint::SOLVE) )
+        return EXIT_FAILURE;
+
+    SolverCheckpoint<_Scalar> tmp;
+    char  done = 0;
+    ULidT size = 0;
+    bool  ok   = checkpoint::readPod   ( f, tmp.varCount   )
+              && checkpoint::readPod   ( f, tmp.constrCount)
+              && checkpoint::readPod   ( f, tmp.inputHash  )
+              && checkpoint::readPod   ( f, tmp.attempt    )
+              && checkpoint::readPod   ( f, done           )
+              && checkpoint::readString( f, tmp.rngState   )
+              && checkpoint::readPod   ( f, tmp.upperBound )
+              && checkpoint::readPod   ( f, tmp.lowerBound )
+              && checkpoint::readPod   ( f, size           );
+    if ( ok && size )
+    {
+        tmp.incumbent.resize( size );
+        f.read( reinterpret_cast<char*>(tmp.incumbent.data()), size * sizeof(_Scalar) );
+        ok = static_cast<bool>( f );
+    }
+    if ( !ok || !checkpoint::readFooter(f) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "snapshot " << path << " is incomplete, ignoring it" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    tmp.done = done;
+    ckpt     = tmp;
+    return EXIT_SUCCESS;
+} //...loadSolverCheckpoint()
+
+/*! \brief Saves the state of an iterative merge: primitives (coefficients and the tags the merge depends on),
+ *         point associations, and the set of already compared pairs.
+ *  \tparam _PrimitiveT     Concept: PlanePrimitive.
+ *  \tparam _PrimitiveMapT  Concept: containers::PrimitiveContainer<_PrimitiveT>.
+ *  \tparam _ComparedSetT   Concept: merging::ComparedSet<PidT>.
+ *  \param[in] inputPrimCount Primitive count of the merge input, checked on load.
+ *  \param[in] inputHash    \ref checkpoint::hashMergeInput() of the merge input (and its parameters), checked on load.
+ *  \param[in] iteration    Number of finished merge iterations.
+ */
+template <class _PrimitiveT, class _PointPrimitiveT, class _PrimitiveMapT, class _PointContainerT, class _ComparedSetT>
+inline int
+saveMergeCheckpoint( std::string         const& path
+                   , ULidT               const  inputPrimCount
+                   , ULidT               const  inputHash
+                   , LidT                const  iteration
+                   , _PrimitiveMapT      const& prims
+                   , _PointContainerT    const& points
+                   , _ComparedSetT       const& compared )
+{
+    typedef typename _PrimitiveT::Scalar Scalar;
+
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream f( tmpPath.c_str(), std::ios::binary | std::ios::trunc );
+        if ( !f.is_open() )
+        {
+            std::cerr << "[" << __func__ << "]: " << "could not open " << tmpPath << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        checkpoint::writeHeader( f, checkpoint::MERGE );
+        checkpoint::writePod   ( f, inputPrimCount );
+        checkpoint::writePod   ( f, static_cast<ULidT>(points.size()) );
+        checkpoint::writePod   ( f, inputHash );
+        checkpoint::writePod   ( f, iteration );
+
+        // compared pairs
+        checkpoint::writePod( f, static_cast<ULidT>(compared.getMaxId()) );
+        checkpoint::writePod( f, static_cast<ULidT>(compared.getHits())  );
+        checkpoint::writePod( f, static_cast<ULidT>(compared.size())     );
+        for ( typename _ComparedSetT::const_iterator it = compared.begin(); it != compared.end(); ++it )
+        {
+            checkpoint::writePod( f, static_cast<ULidT>(it->first ) );
+            checkpoint::writePod( f, static_cast<ULidT>(it->second) );
+        }
+
+        // primitives
+        ULidT primCount = 0;
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
+            primCount += it->second.size();
+        checkpoint::writePod( f, primCount );
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
+            for ( typename _PrimitiveMapT::mapped_type::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+            {
+                checkpoint::writePod( f, static_cast<GidT>(it->first) );
+                f.write( reinterpret_cast<char const*>(it2->coeffs().data()), _PrimitiveT::Dim * sizeof(Scalar) );
+                checkpoint::writePod( f, static_cast<GidT  >(it2->getTag(_PrimitiveT::TAGS::GID             )) );
+                checkpoint::writePod( f, static_cast<DidT  >(it2->getTag(_PrimitiveT::TAGS::DIR_GID         )) );
+                checkpoint::writePod( f, static_cast<char  >(it2->getTag(_PrimitiveT::TAGS::STATUS          )) );
+                checkpoint::writePod( f, static_cast<Scalar>(it2->getTag(_PrimitiveT::TAGS::GEN_ANGLE       )) );
+                checkpoint::writePod( f, static_cast<GidT  >(it2->getTag(_PrimitiveT::USER_TAGS::USER_ID4   )) );
+            }
+
+        // associations
+        checkpoint::writePod( f, static_cast<ULidT>(points.size()) );
+        for ( typename _PointContainerT::const_iterator it = points.begin(); it != points.end(); ++it )
+            checkpoint::writePod( f, static_cast<GidT>(it->getTag(_PointPrimitiveT::TAGS::GID)) );
+
+        checkpoint::writeFooter( f );
+        if ( !f )
+            return EXIT_FAILURE;
+    }
+
+    return checkpoint::commit( tmpPath, path );
+} //...saveMergeCheckpoint()
+
+/*! \brief Restores a snapshot written by \ref saveMergeCheckpoint(). Outputs are only changed on success.
+ *         Snapshots of a different input (primitive count, point count or hash) are ignored.
+ *  \param[in]     inputPrimCount Primitive count of the merge input.
+ *  \param[in]     inputHash      \ref checkpoint::hashMergeInput() of the merge input (and its parameters).
+ *  \param[out]    iteration Number of merge iterations finished, when the snapshot was taken.
+ *  \param[out]    prims     Primitives to continue merging from.
+ *  \param[in,out] points    Points to restore GID tags of. Has to be the same cloud as the snapshot was taken with.
+ *  \param[out]    compared  Pairs compared and not merged so far.
+ */
+template <class _PrimitiveT, class _PointPrimitiveT, class _PrimitiveMapT, class _PointContainerT, class _ComparedSetT>
+inline int
+loadMergeCheckpoint( std::string         const& path
+                   , ULidT               const  inputPrimCount
+                   , ULidT               const  inputHash
+                   , LidT                     & iteration
+                   , _PrimitiveMapT           & prims
+                   , _PointContainerT         & points
+                   , _ComparedSetT            & compared )
+{
+    typedef typename _PrimitiveT::Scalar        Scalar;
+    typedef typename _PrimitiveT::VectorType    VectorType;
+
+    std::ifstream f( path.c_str(), std::ios::binary );
+    if ( !f.is_open() || !checkpoint::readHeader(f, checkpoint::MERGE) )
+        return EXIT_FAILURE;
+
+    LidT            tmpIteration = 0;
+    _PrimitiveMapT  tmpPrims;
+    _ComparedSetT   tmpCompared;
+    std::vector<GidT> gids;
+
+    ULidT fileInputPrimCount = 0, filePointCount = 0, fileInputHash = 0;
+    if ( !checkpoint::readPod(f, fileInputPrimCount) || !checkpoint::readPod(f, filePointCount) || !checkpoint::readPod(f, fileInputHash) )
+        return EXIT_FAILURE;
+    if ( (fileInputPrimCount != inputPrimCount) || (filePointCount != points.size()) || (fileInputHash != inputHash) )
+    {
+        std::cout << "[" << __func__ << "]: " << "snapshot " << path << " belongs to a different input ("
+                  << fileInputPrimCount << " primitives, " << filePointCount << " points, hash " << std::hex << fileInputHash << " vs "
+                  << inputPrimCount << ", " << points.size() << ", " << inputHash << std::dec << "), ignoring it" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ULidT maxId = 0, hits = 0, count = 0;
+    bool ok = checkpoint::readPod( f, tmpIteration )
+           && checkpoint::readPod( f, maxId        )
+           && checkpoint::readPod( f, hits         )
+           && checkpoint::readPod( f, count        );
+    for ( ULidT i = 0; ok && (i != count); ++i )
+    {
+        ULidT first = 0, second = 0;
+        ok = checkpoint::readPod( f, first ) && checkpoint::readPod( f, second );
+        typename _ComparedSetT::ElementT pair( first, second );
+        tmpCompared.insert( pair );
+    }
+    tmpCompared.getMaxId() = maxId;
+    tmpCompared.setHits( hits );
+
+    ok = ok && checkpoint::readPod( f, count );
+    for ( ULidT i = 0; ok && (i != count); ++i )
+    {
+        GidT        key = 0, gid = 0, uid4 = 0;
+        DidT        did = 0;
+        char        status = 0;
+        Scalar      genAngle = 0;
+        VectorType  coeffs;
+
+        ok = checkpoint::readPod( f, key );
+        f.read( reinterpret_cast<char*>(coeffs.data()), _PrimitiveT::Dim * sizeof(Scalar) );
+        ok = ok && f
+                && checkpoint::readPod( f, gid      )
+                && checkpoint::readPod( f, did      )
+                && checkpoint::readPod( f, status   )
+                && checkpoint::readPod( f, genAngle )
+                && checkpoint::readPod( f, uid4     );
+        if ( !ok ) break;
+
+        _PrimitiveT prim( coeffs );
+        prim.setTag( _PrimitiveT::TAGS::GID           , gid      );
+        prim.setTag( _PrimitiveT::TAGS::DIR_GID       , did      );
+        prim.setTag( _PrimitiveT::TAGS::STATUS        , status   );
+        prim.setTag( _PrimitiveT::TAGS::GEN_ANGLE     , genAngle );
+        prim.setTag( _PrimitiveT::USER_TAGS::USER_ID4 , uid4     );
+        containers::add( tmpPrims, key, prim );
+    }
+
+    ok = ok && checkpoint::readPod( f, count );
+    if ( ok && (count != points.size()) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "snapshot " << path << " was taken with " << count << " points, not " << points.size() << ", ignoring it" << std::endl;
+        return EXIT_FAILURE;
+    }
+    gids.resize( count );
+    for ( ULidT i = 0; ok && (i != count); ++i )
+        ok = checkpoint::readPod( f, gids[i] );
+
+    if ( !ok || !checkpoint::readFooter(f) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "snapshot " << path << " is incomplete, ignoring it" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for ( size_t pid = 0; pid != points.size(); ++pid )
+        points[pid].setTag( _PointPrimitiveT::TAGS::GID, gids[pid] );
+    iteration = tmpIteration;
+    prims     = tmpPrims;
+    compared  = tmpCompared;
+
+    return EXIT_SUCCESS;
+} //...loadMergeCheckpoint()
+
+} //...namespace io
+} //...namespace rapter
+
+#endif // RAPTER_CHECKPOINT_HPP
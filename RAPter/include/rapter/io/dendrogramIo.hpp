@@ -0,0 +1,113 @@
+#ifndef RAPTER_DENDROGRAMIO_HPP
+#define RAPTER_DENDROGRAMIO_HPP
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include "rapter/optimization/segmentation.h" // segmentation::Dendrogram
+#include "rapter/io/checkpoint.hpp"           // writePod, readPod
+
+namespace rapter {
+namespace io {
+
+namespace dendrogram
+{
+    static const char MAGIC[8] = { 'R','P','T','R','D','N','D','R' };
+}
+
+/*! \brief Writes the merge history of \ref Segmentation::agglomerate() to a binary file.
+ *  \param[in] dendrogram   Merge history.
+ *  \param[in] path         Output path.
+ *  \return                 EXIT_SUCCESS, if the file could be written.
+ */
+template <typename _Scalar> inline int
+writeDendrogram( segmentation::Dendrogram<_Scalar> const& dendrogram, std::string const& path )
+{
+    typedef typename segmentation::Dendrogram<_Scalar>::Merge MergeT;
+
+    std::ofstream f( path.c_str(), std::ios::binary );
+    if ( !f.is_open() )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    f.write( dendrogram::MAGIC, sizeof(dendrogram::MAGIC) );
+    checkpoint::writePod( f, static_cast<int>(sizeof(_Scalar)) );
+    checkpoint::writePod( f, dendrogram.leafCount );
+    checkpoint::writePod( f, static_cast<LidT>(dendrogram.merges.size()) );
+    for ( typename std::vector<MergeT>::const_iterator it = dendrogram.merges.begin(); it != dendrogram.merges.end(); ++it )
+    {
+        checkpoint::writePod( f, it->left   );
+        checkpoint::writePod( f, it->right  );
+        checkpoint::writePod( f, it->height );
+        checkpoint::writePod( f, it->size   );
+    }
+    f.write( dendrogram::MAGIC, sizeof(dendrogram::MAGIC) );
+
+    if ( !f )
+    {
+        std::cerr << "[" << __func__ << "]: " << "error writing " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "[" << __func__ << "]: " << "wrote " << dendrogram.merges.size() << " merges to " << path << std::endl;
+    return EXIT_SUCCESS;
+} //...writeDendrogram()
+
+/*! \brief Reads a dendrogram written by \ref writeDendrogram().
+ *  \return EXIT_FAILURE, if the file is missing, truncated or was written with a different scalar type.
+ */
+template <typename _Scalar> inline int
+readDendrogram( segmentation::Dendrogram<_Scalar> &dendrogram, std::string const& path )
+{
+    typedef typename segmentation::Dendrogram<_Scalar>::Merge MergeT;
+
+    std::ifstream f( path.c_str(), std::ios::binary );
+    if ( !f.is_open() )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    char magic[ sizeof(dendrogram::MAGIC) ];
+    int  scalarSize = 0;
+    LidT mergeCount = 0;
+    f.read( magic, sizeof(magic) );
+    bool valid =    f && std::equal( magic, magic + sizeof(magic), dendrogram::MAGIC )
+                 && checkpoint::readPod( f, scalarSize ) && (scalarSize == static_cast<int>(sizeof(_Scalar)))
+                 && checkpoint::readPod( f, dendrogram.leafCount )
+                 && checkpoint::readPod( f, mergeCount )
+                 && (mergeCount >= 0) && (mergeCount < std::max(dendrogram.leafCount, LidT(1)));
+
+    if ( valid )
+    {
+        dendrogram.merges.resize( mergeCount );
+        for ( typename std::vector<MergeT>::iterator it = dendrogram.merges.begin(); valid && (it != dendrogram.merges.end()); ++it )
+        {
+            const LidT node = dendrogram.leafCount + (it - dendrogram.merges.begin());
+            valid =    checkpoint::readPod( f, it->left   )
+                    && checkpoint::readPod( f, it->right  )
+                    && checkpoint::readPod( f, it->height )
+                    && checkpoint::readPod( f, it->size   )
+                    && (it->left  >= 0) && (it->left  < node)
+                    && (it->right >= 0) && (it->right < node);
+        }
+        f.read( magic, sizeof(magic) );
+        valid = valid && f && std::equal( magic, magic + sizeof(magic), dendrogram::MAGIC );
+    }
+
+    if ( !valid )
+    {
+        std::cerr << "[" << __func__ << "]: " << path << " is not a valid dendrogram" << std::endl;
+        dendrogram = segmentation::Dendrogram<_Scalar>();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+} //...readDendrogram()
+
+} //...namespace io
+} //...namespace rapter
+
+#endif // RAPTER_DENDROGRAMIO_HPP
@@ -17,6 +17,7 @@
 #include "rapter/util/pclUtil.h"
 #include "rapter/util/impl/pclUtil.hpp"
 #include "rapter/util/containers.hpp"
+#include "rapter/io/primitiveStore.hpp"      // savePrimitiveStore, readPrimitiveStore
 
 
 namespace rapter
@@ -27,7 +28,7 @@ namespace rapter
         //typedef          pcl::PointCloud<PclPointT> PclCloudT;
         //typedef typename PclCloudT::Ptr             PclCloudPtrT;
 
-        //! \brief Dumps primitives with GID and DIR_GID to disk.
+        //! \brief Dumps primitives with GID and DIR_GID to disk. Writes a binary \ref primitiveStore instead, if \p out_file_name ends with ".rprim".
         //! \tparam PrimitiveT Concept: PrimitiveContainerT::value_type::value_type aka rapter::LinePrimitive2.
         //! \tparam PrimitiveContainerT Concept: vector< vector< rapter::LinePrimitive2 > >.
         template <class PrimitiveT, class _inner_const_iterator, class PrimitiveContainerT> inline int
@@ -41,6 +42,9 @@ namespace rapter
             //const int Dim = PrimitiveT::Dim;
             typedef typename PrimitiveT::VectorType VectorType;
 
+            if ( primitiveStore::isStorePath(out_file_name) )
+                return savePrimitiveStore<PrimitiveT,_inner_const_iterator>( primitives, out_file_name, verbose );
+
             // out_lines
             std::string parent_path = boost::filesystem::path(out_file_name).parent_path().string();
             if ( !parent_path.empty() )
@@ -79,7 +83,7 @@ namespace rapter
             return EXIT_SUCCESS;
         }
 
-        //! \brief Reads primitives with their GIDs and dir_GIDs from file.
+        //! \brief Reads primitives with their GIDs and dir_GIDs from file. Reads a binary \ref primitiveStore instead, if \p path ends with ".rprim".
         //! \tparam PatchT Concept: vector< \ref rapter::LinePrimitive2 >.
         template <
                    class       PrimitiveT          /*= typename PrimitiveContainerT::value_type::value_type*/
@@ -98,6 +102,9 @@ namespace rapter
             //typedef typename PrimitiveContainerT::value_type PatchT;
             typedef std::map<GidT, PatchT>                    PatchMap; // <GID, vector<primitives> >
 
+            if ( primitiveStore::isStorePath(path) )
+                return readPrimitiveStore<PrimitiveT,PatchT>( lines, path, patches );
+
             // open file
             std::ifstream file( path.c_str() );
             if ( !file.is_open() )
@@ -0,0 +1,669 @@
+#ifndef RAPTER_MESHIO_HPP
+#define RAPTER_MESHIO_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>   // istringstream
+#include <cctype>    // tolower
+#include <cstring>   // memchr, memcpy
+#include <cmath>     // pow
+#include <algorithm> // equal, reverse
+#include "omp.h"
+#include "boost/filesystem.hpp"
+#ifndef _WIN32
+#   include <fcntl.h>    // open
+#   include <unistd.h>   // close
+#   include <sys/mman.h> // mmap
+#   include <sys/stat.h> // fstat
+#endif
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h"   // LidT
+#include "rapter/io/checkpoint.hpp" // writePod, readPod
+
+namespace rapter {
+namespace io {
+
+/*! \brief Triangle mesh in flat arrays, as read by \ref readMesh().
+ *  \tparam _Scalar Concept: float.
+ */
+template <typename _Scalar>
+struct TriangleMesh
+{
+        typedef _Scalar                                             Scalar;
+        typedef Eigen::Map< const Eigen::Matrix<_Scalar,3,1> >      ConstVertexMap;
+
+        inline LidT getVertexCount()   const { return vertices.size() / 3; }
+        inline LidT getTriangleCount() const { return indices.size()  / 3; }
+
+        //! \brief Position of vertex \p vertexId.
+        inline ConstVertexMap getVertex( LidT const vertexId ) const { return ConstVertexMap( &vertices[3 * vertexId] ); }
+        //! \brief Position of corner \p corner (0..2) of triangle \p triangleId.
+        inline ConstVertexMap getCorner( LidT const triangleId, int const corner ) const { return getVertex( indices[3 * triangleId + corner] ); }
+
+        std::vector<_Scalar> vertices; //!< \brief x0, y0, z0, x1, y1, ...
+        std::vector<LidT>    indices;  //!< \brief Three vertex ids per triangle, polygons are fan-triangulated.
+}; //...struct TriangleMesh
+
+namespace mesh
+{
+    static const char MAGIC[8] = { 'R','P','T','R','M','E','S','H' };
+    static const int  CACHE_VERSION = 2; //!< \brief Layout of the cache, bump on any change of it, or of what the parser outputs.
+
+    //! \brief Read-only view of a whole file. Memory-mapped, where available, read to memory otherwise.
+    class MappedFile
+    {
+        public:
+            MappedFile() : _data( NULL ), _size( 0 ), _mapped( false ) {}
+            ~MappedFile() { this->close(); }
+
+            inline bool open( std::string const& path )
+            {
+                this->close();
+#ifndef _WIN32
+                const int fd = ::open( path.c_str(), O_RDONLY );
+                if ( fd < 0 )
+                    return false;
+                struct stat info;
+                if ( (fstat(fd, &info) == 0) && (info.st_size > 0) )
+                {
+                    void *data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                    if ( data != MAP_FAILED )
+                    {
+                        madvise( data, info.st_size, MADV_SEQUENTIAL );
+                        _data   = static_cast<const char*>( data );
+                        _size   = info.st_size;
+                        _mapped = true;
+                    }
+                }
+                ::close( fd );
+                if ( _mapped )
+                    return true;
+#endif
+                std::ifstream f( path.c_str(), std::ios::binary | std::ios::ate );
+                if ( !f.is_open() )
+                    return false;
+                _buffer.resize( static_cast<size_t>(f.tellg()) );
+                f.seekg( 0 );
+                if ( _buffer.size() )
+                    f.read( &_buffer[0], _buffer.size() );
+                _data = _buffer.size() ? &_buffer[0] : NULL;
+                _size = _buffer.size();
+                return static_cast<bool>( f );
+            } //...open()
+
+            inline void close()
+            {
+#ifndef _WIN32
+                if ( _mapped )
+                    munmap( const_cast<char*>(_data), _size );
+#endif
+                _data   = NULL;
+                _size   = 0;
+                _mapped = false;
+                std::vector<char>().swap( _buffer );
+            } //...close()
+
+            inline const char* begin() const { return _data; }
+            inline const char* end  () const { return _data + _size; }
+            inline size_t      size () const { return _size; }
+
+        protected:
+            const char*         _data;
+            size_t              _size;
+            bool                _mapped;
+            std::vector<char>   _buffer; //!< \brief Storage, if not mapped.
+
+        private:
+            MappedFile( MappedFile const& );
+            MappedFile& operator=( MappedFile const& );
+    }; //...class MappedFile
+
+    inline const char* skipSpaces( const char* p, const char* end )
+    {
+        while ( (p != end) && ((*p == ' ') || (*p == '\t') || (*p == '\r')) ) ++p;
+        return p;
+    }
+
+    //! \brief Start of the line after the one containing \p p, or \p end.
+    inline const char* nextLine( const char* p, const char* end )
+    {
+        const char* eol = static_cast<const char*>( memchr(p, '\n', end - p) );
+        return eol ? eol + 1 : end;
+    }
+
+    inline bool isLineEnd( const char* p, const char* end ) { return (p == end) || (*p == '\n') || (*p == '#'); }
+
+    //! \brief Parses a decimal number with optional exponent at \p p, and advances \p p. No locale, no null terminator needed.
+    template <typename _Scalar>
+    inline bool parseScalar( const char* &p, const char* end, _Scalar &value )
+    {
+        p = skipSpaces( p, end );
+        const bool negative = (p != end) && (*p == '-');
+        if ( (p != end) && ((*p == '-') || (*p == '+')) ) ++p;
+
+        double mantissa = 0.;
+        int    digits   = 0, exponent = 0;
+        for ( ; (p != end) && (*p >= '0') && (*p <= '9'); ++p, ++digits )
+            mantissa = mantissa * 10. + (*p - '0');
+        if ( (p != end) && (*p == '.') )
+            for ( ++p; (p != end) && (*p >= '0') && (*p <= '9'); ++p, ++digits, --exponent )
+                mantissa = mantissa * 10. + (*p - '0');
+        if ( !digits )
+            return false;
+
+        if ( (p != end) && ((*p == 'e') || (*p == 'E')) )
+        {
+            ++p;
+            const bool negativeExp = (p != end) && (*p == '-');
+            if ( (p != end) && ((*p == '-') || (*p == '+')) ) ++p;
+            int e = 0;
+            for ( ; (p != end) && (*p >= '0') && (*p <= '9'); ++p )
+                e = e * 10 + (*p - '0');
+            exponent += negativeExp ? -e : e;
+        }
+
+        value = static_cast<_Scalar>( (negative ? -mantissa : mantissa) * (exponent ? std::pow(10., exponent) : 1.) );
+        return true;
+    } //...parseScalar()
+
+    //! \brief Parses a signed integer at \p p, and advances \p p.
+    inline bool parseInteger( const char* &p, const char* end, long &value )
+    {
+        p = skipSpaces( p, end );
+        const bool negative = (p != end) && (*p == '-');
+        if ( (p != end) && ((*p == '-') || (*p == '+')) ) ++p;
+
+        const char* start = p;
+        value = 0;
+        for ( ; (p != end) && (*p >= '0') && (*p <= '9'); ++p )
+            value = value * 10 + (*p - '0');
+        if ( negative )
+            value = -value;
+        return p != start;
+    } //...parseInteger()
+
+    //! \brief Reads a face corner "v", "v/vt", "v//vn" or "v/vt/vn", and returns the vertex index only.
+    inline bool parseObjCorner( const char* &p, const char* end, long &value )
+    {
+        if ( !parseInteger(p, end, value) )
+            return false;
+        while ( (p != end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n') ) ++p;
+        return true;
+    } //...parseObjCorner()
+
+    /*! \brief Parses the "v" and "f" lines of an OBJ file in parallel chunks.
+     *         The first pass counts vertices and triangles per chunk, so that the second pass can write to its own range of the output,
+     *         and resolve relative (negative) face indices.
+     */
+    template <typename _Scalar>
+    inline int parseObj( TriangleMesh<_Scalar> &mesh, const char* begin, const char* end )
+    {
+        const int chunkCount = std::max( 1, omp_get_max_threads() * 4 );
+        const size_t size    = end - begin;
+
+        // chunks start at line starts
+        std::vector<const char*> bounds( chunkCount + 1, end );
+        bounds[0] = begin;
+        for ( int c = 1; c < chunkCount; ++c )
+            bounds[c] = std::max( bounds[c-1], nextLine(begin + size / chunkCount * c, end) );
+
+        // (1) count
+        std::vector<LidT> vertexStart( chunkCount + 1, 0 ), triangleStart( chunkCount + 1, 0 );
+#       pragma omp parallel for schedule(dynamic)
+        for ( int c = 0; c < chunkCount; ++c )
+            for ( const char* line = bounds[c]; line < bounds[c+1]; line = nextLine(line, bounds[c+1]) )
+            {
+                const char* p = skipSpaces( line, bounds[c+1] );
+                if ( (bounds[c+1] - p < 2) || ((p[1] != ' ') && (p[1] != '\t')) )
+                    continue;
+                if ( p[0] == 'v' )
+                    ++vertexStart[c+1];
+                else if ( p[0] == 'f' )
+                {
+                    ++p;
+                    long corner, corners = 0;
+                    while ( !isLineEnd(p = skipSpaces(p, bounds[c+1]), bounds[c+1]) && parseObjCorner(p, bounds[c+1], corner) )
+                        ++corners;
+                    if ( corners > 2 )
+                        triangleStart[c+1] += corners - 2;
+                }
+            }
+        for ( int c = 0; c != chunkCount; ++c )
+        {
+            vertexStart  [c+1] += vertexStart  [c];
+            triangleStart[c+1] += triangleStart[c];
+        }
+
+        const LidT vertexCount = vertexStart.back();
+        mesh.vertices.resize( 3 * vertexCount );
+        mesh.indices .resize( 3 * triangleStart.back() );
+
+        // (2) fill
+        LidT errCount = 0;
+#       pragma omp parallel for schedule(dynamic) reduction(+:errCount)
+        for ( int c = 0; c < chunkCount; ++c )
+        {
+            LidT vertexId = vertexStart[c], triangleId = triangleStart[c];
+            std::vector<LidT> corners;
+            for ( const char* line = bounds[c]; line < bounds[c+1]; line = nextLine(line, bounds[c+1]) )
+            {
+                const char* p = skipSpaces( line, bounds[c+1] );
+                if ( (bounds[c+1] - p < 2) || ((p[1] != ' ') && (p[1] != '\t')) )
+                    continue;
+                if ( p[0] == 'v' )
+                {
+                    ++p;
+                    for ( int d = 0; d != 3; ++d )
+                        if ( !parseScalar(p, bounds[c+1], mesh.vertices[3 * vertexId + d]) )
+                            ++errCount;
+                    ++vertexId;
+                }
+                else if ( p[0] == 'f' )
+                {
+                    ++p;
+                    long corner;
+                    corners.clear();
+                    while ( !isLineEnd(p = skipSpaces(p, bounds[c+1]), bounds[c+1]) && parseObjCorner(p, bounds[c+1], corner) )
+                    {
+                        // 1-based, or relative to the vertices read so far
+                        const LidT id = (corner > 0) ? corner - 1 : vertexId + corner;
+                        if ( (id < 0) || (id >= vertexCount) )
+                            ++errCount;
+                        corners.push_back( id );
+                    }
+                    for ( size_t k = 2; k < corners.size(); ++k, ++triangleId )
+                    {
+                        mesh.indices[3 * triangleId    ] = corners[0];
+                        mesh.indices[3 * triangleId + 1] = corners[k-1];
+                        mesh.indices[3 * triangleId + 2] = corners[k];
+                    }
+                }
+            }
+        } //...for chunks
+
+        if ( errCount )
+        {
+            std::cerr << "[" << __func__ << "]: " << errCount << " malformed vertex coordinates or face indices out of range" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } //...parseObj()
+
+    //! \brief Size of a PLY scalar type in bytes, 0 if unknown.
+    inline int plyTypeSize( std::string const& type )
+    {
+        if ( type == "char"  || type == "uchar"  || type == "int8"  || type == "uint8"   ) return 1;
+        if ( type == "short" || type == "ushort" || type == "int16" || type == "uint16"  ) return 2;
+        if ( type == "int"   || type == "uint"   || type == "int32" || type == "uint32"
+          || type == "float" || type == "float32"                                        ) return 4;
+        if ( type == "double"|| type == "float64"                                        ) return 8;
+        return 0;
+    } //...plyTypeSize()
+
+    //! \brief Reads a binary PLY scalar of \p type at \p p.
+    inline double plyRead( const char* p, std::string const& type, bool const swap )
+    {
+        char bytes[8];
+        const int size = plyTypeSize( type );
+        memcpy( bytes, p, size );
+        if ( swap )
+            std::reverse( bytes, bytes + size );
+
+        if ( type == "char"   || type == "int8"    ) { signed char    v; memcpy(&v, bytes, 1); return v; }
+        if ( type == "uchar"  || type == "uint8"   ) { unsigned char  v; memcpy(&v, bytes, 1); return v; }
+        if ( type == "short"  || type == "int16"   ) { short          v; memcpy(&v, bytes, 2); return v; }
+        if ( type == "ushort" || type == "uint16"  ) { unsigned short v; memcpy(&v, bytes, 2); return v; }
+        if ( type == "int"    || type == "int32"   ) { int            v; memcpy(&v, bytes, 4); return v; }
+        if ( type == "uint"   || type == "uint32"  ) { unsigned int   v; memcpy(&v, bytes, 4); return v; }
+        if ( type == "float"  || type == "float32" ) { float          v; memcpy(&v, bytes, 4); return v; }
+        double v; memcpy( &v, bytes, 8 ); return v;
+    } //...plyRead()
+
+    struct PlyProperty
+    {
+        std::string name, type;
+        std::string countType; //!< \brief Empty, if not a list.
+    };
+
+    struct PlyElement
+    {
+        std::string              name;
+        LidT                     count;
+        std::vector<PlyProperty> properties;
+    };
+
+    /*! \brief Parses "vertex" x,y,z and "face" vertex_indices of an ASCII or binary PLY file.
+     *         Vertices are parsed in parallel, faces sequentially, since their size varies.
+     */
+    template <typename _Scalar>
+    inline int parsePly( TriangleMesh<_Scalar> &mesh, const char* begin, const char* end )
+    {
+        // header
+        std::vector<PlyElement> elements;
+        std::string format;
+        const char* p = begin;
+        for ( ; p < end; )
+        {
+            const char* lineEnd = nextLine( p, end );
+            std::string line( p, lineEnd );
+            p = lineEnd;
+            while ( line.size() && ((line[line.size()-1] == '\n') || (line[line.size()-1] == '\r')) )
+                line.erase( line.size() - 1 );
+
+            std::istringstream is( line );
+            std::string keyword;
+            is >> keyword;
+            if ( keyword == "format" )
+                is >> format;
+            else if ( keyword == "element" )
+            {
+                elements.push_back( PlyElement() );
+                is >> elements.back().name >> elements.back().count;
+            }
+            else if ( keyword == "property" && elements.size() )
+            {
+                PlyProperty property;
+                is >> property.type;
+                if ( property.type == "list" )
+                    is >> property.countType >> property.type;
+                is >> property.name;
+                elements.back().properties.push_back( property );
+            }
+            else if ( keyword == "end_header" )
+                break;
+        }
+
+        const bool ascii     = (format == "ascii");
+        const bool bigEndian = (format == "binary_big_endian");
+        if ( !ascii && !bigEndian && (format != "binary_little_endian") )
+        {
+            std::cerr << "[" << __func__ << "]: " << "unknown ply format \"" << format << "\"" << std::endl;
+            return EXIT_FAILURE;
+        }
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        const bool swapBytes = !ascii && !bigEndian;
+#else
+        const bool swapBytes = bigEndian;
+#endif
+
+        for ( size_t e = 0; e != elements.size(); ++e )
+        {
+            PlyElement const& element = elements[e];
+            const bool isVertex = (element.name == "vertex");
+            const bool isFace   = (element.name == "face");
+
+            // property ids and offsets
+            int coordIds[3] = { -1, -1, -1 }, listId = -1, stride = 0;
+            std::vector<int> offsets;
+            for ( size_t k = 0; k != element.properties.size(); ++k )
+            {
+                PlyProperty const& property = element.properties[k];
+                offsets.push_back( stride );
+                if      ( property.name == "x" ) coordIds[0] = k;
+                else if ( property.name == "y" ) coordIds[1] = k;
+                else if ( property.name == "z" ) coordIds[2] = k;
+                if ( property.countType.size() )
+                {
+                    if ( (property.name == "vertex_indices") || (property.name == "vertex_index") )
+                        listId = k;
+                    stride = -1;
+                }
+                else if ( stride >= 0 )
+                    stride += plyTypeSize( property.type );
+            }
+
+            if ( isVertex )
+            {
+                if ( (coordIds[0] < 0) || (coordIds[1] < 0) || (coordIds[2] < 0) || (!ascii && stride <= 0) )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "vertices need x, y, z, and no lists" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                mesh.vertices.resize( 3 * element.count );
+
+                std::vector<const char*> lines;
+                if ( ascii )
+                {
+                    lines.resize( element.count );
+                    for ( LidT v = 0; v != element.count; ++v, p = nextLine(p, end) )
+                        lines[v] = p;
+                }
+                else if ( p + stride * element.count > end )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "file too short for " << element.count << " vertices" << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                LidT errCount = 0;
+#               pragma omp parallel for reduction(+:errCount)
+                for ( LidT v = 0; v < element.count; ++v )
+                {
+                    if ( ascii )
+                    {
+                        const char* q = lines[v];
+                        const char* lineEnd = nextLine( q, end );
+                        _Scalar values[3];
+                        for ( int k = 0; k <= std::max(coordIds[0], std::max(coordIds[1], coordIds[2])); ++k )
+                        {
+                            _Scalar value;
+                            if ( !parseScalar(q, lineEnd, value) ) { ++errCount; break; }
+                            for ( int d = 0; d != 3; ++d )
+                                if ( coordIds[d] == k )
+                                    values[d] = value;
+                        }
+                        for ( int d = 0; d != 3; ++d )
+                            mesh.vertices[3 * v + d] = values[d];
+                    }
+                    else
+                        for ( int d = 0; d != 3; ++d )
+                            mesh.vertices[3 * v + d] = plyRead( p + stride * v + offsets[coordIds[d]], element.properties[coordIds[d]].type, swapBytes );
+                }
+                if ( errCount )
+                {
+                    std::cerr << "[" << __func__ << "]: " << errCount << " malformed vertex lines" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                if ( !ascii )
+                    p += stride * element.count;
+            }
+            else if ( isFace || ascii || (stride < 0) )
+            {
+                if ( isFace )
+                    mesh.indices.reserve( 3 * element.count );
+
+                std::vector<LidT> corners;
+                for ( LidT f = 0; f != element.count; ++f )
+                {
+                    const char* lineEnd = ascii ? nextLine( p, end ) : end;
+                    for ( size_t k = 0; k != element.properties.size(); ++k )
+                    {
+                        PlyProperty const& property = element.properties[k];
+                        long count = 1;
+                        if ( property.countType.size() )
+                        {
+                            if ( ascii ) { if ( !parseInteger(p, lineEnd, count) ) return EXIT_FAILURE; }
+                            else         { if ( p + plyTypeSize(property.countType) > end ) return EXIT_FAILURE;
+                                           count = static_cast<long>( plyRead(p, property.countType, swapBytes) ); p += plyTypeSize( property.countType ); }
+                        }
+
+                        corners.clear();
+                        for ( long i = 0; i < count; ++i )
+                        {
+                            double value;
+                            if ( ascii ) { if ( !parseScalar(p, lineEnd, value) ) return EXIT_FAILURE; }
+                            else         { if ( p + plyTypeSize(property.type) > end ) return EXIT_FAILURE;
+                                           value = plyRead( p, property.type, swapBytes ); p += plyTypeSize( property.type ); }
+                            if ( isFace && (static_cast<int>(k) == listId) )
+                                corners.push_back( static_cast<LidT>(value) );
+                        }
+
+                        for ( size_t c = 2; c < corners.size(); ++c )
+                        {
+                            mesh.indices.push_back( corners[0]   );
+                            mesh.indices.push_back( corners[c-1] );
+                            mesh.indices.push_back( corners[c]   );
+                        }
+                    }
+                    if ( ascii )
+                        p = lineEnd;
+                }
+            }
+            else
+                p += stride * element.count; // other fixed size binary element
+        } //...for elements
+
+        const LidT vertexCount = mesh.getVertexCount();
+        for ( size_t i = 0; i != mesh.indices.size(); ++i )
+            if ( (mesh.indices[i] < 0) || (mesh.indices[i] >= vertexCount) )
+            {
+                std::cerr << "[" << __func__ << "]: " << "face index " << mesh.indices[i] << " out of range" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    } //...parsePly()
+
+    /*! \brief Content hash of \p file. Fixed size blocks are hashed in parallel and combined in order,
+     *         so the hash doesn't depend on the thread count.
+     */
+    inline ULidT hashFile( MappedFile const& file )
+    {
+        const size_t blockSize  = size_t(1) << 20;
+        const LidT   blockCount = (file.size() + blockSize - 1) / blockSize;
+        std::vector<ULidT> blockHashes( blockCount, checkpoint::HASH_SEED );
+#       pragma omp parallel for
+        for ( LidT b = 0; b < blockCount; ++b )
+            checkpoint::hashBytes( blockHashes[b], file.begin() + b * blockSize, std::min(blockSize, file.size() - b * blockSize) );
+
+        ULidT hash = checkpoint::HASH_SEED;
+        checkpoint::hashPod( hash, static_cast<ULidT>(file.size()) );
+        for ( LidT b = 0; b != blockCount; ++b )
+            checkpoint::hashPod( hash, blockHashes[b] );
+        return hash;
+    } //...hashFile()
+
+    //! \brief Binary copy of a parsed mesh, stamped with the format version, and the size and \ref hashFile() of the source file.
+    template <typename _Scalar>
+    inline int writeCache( TriangleMesh<_Scalar> const& mesh, std::string const& path, ULidT const sourceSize, ULidT const sourceHash )
+    {
+        std::ofstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() )
+            return EXIT_FAILURE;
+
+        f.write( MAGIC, sizeof(MAGIC) );
+        checkpoint::writePod( f, CACHE_VERSION );
+        checkpoint::writePod( f, static_cast<int>(sizeof(_Scalar)) );
+        checkpoint::writePod( f, static_cast<int>(sizeof(LidT)) );
+        checkpoint::writePod( f, sourceSize );
+        checkpoint::writePod( f, sourceHash );
+        checkpoint::writePod( f, static_cast<ULidT>(mesh.vertices.size()) );
+        checkpoint::writePod( f, static_cast<ULidT>(mesh.indices .size()) );
+        if ( mesh.vertices.size() ) f.write( reinterpret_cast<char const*>(&mesh.vertices[0]), mesh.vertices.size() * sizeof(_Scalar) );
+        if ( mesh.indices .size() ) f.write( reinterpret_cast<char const*>(&mesh.indices [0]), mesh.indices .size() * sizeof(LidT)    );
+        f.write( MAGIC, sizeof(MAGIC) );
+
+        return f ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...writeCache()
+
+    //! \return EXIT_FAILURE, if the cache is missing, truncated, of another version or scalar type, or was written from a source of different size or content.
+    template <typename _Scalar>
+    inline int readCache( TriangleMesh<_Scalar> &mesh, std::string const& path, ULidT const sourceSize, ULidT const sourceHash )
+    {
+        std::ifstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() )
+            return EXIT_FAILURE;
+
+        char  magic[ sizeof(MAGIC) ];
+        int   version     = 0, scalarSize = 0, indexSize = 0;
+        ULidT cachedSize  = 0, cachedHash = 0, vertexCount = 0, indexCount = 0;
+        f.read( magic, sizeof(magic) );
+        bool valid =    f && std::equal( magic, magic + sizeof(magic), MAGIC )
+                     && checkpoint::readPod( f, version    ) && (version    == CACHE_VERSION)
+                     && checkpoint::readPod( f, scalarSize ) && (scalarSize == static_cast<int>(sizeof(_Scalar)))
+                     && checkpoint::readPod( f, indexSize  ) && (indexSize  == static_cast<int>(sizeof(LidT)))
+                     && checkpoint::readPod( f, cachedSize ) && (cachedSize == sourceSize)
+                     && checkpoint::readPod( f, cachedHash ) && (cachedHash == sourceHash)
+                     && checkpoint::readPod( f, vertexCount )
+                     && checkpoint::readPod( f, indexCount  );
+        if ( !valid )
+            return EXIT_FAILURE;
+
+        mesh.vertices.resize( vertexCount );
+        mesh.indices .resize( indexCount  );
+        if ( vertexCount ) f.read( reinterpret_cast<char*>(&mesh.vertices[0]), vertexCount * sizeof(_Scalar) );
+        if ( indexCount  ) f.read( reinterpret_cast<char*>(&mesh.indices [0]), indexCount  * sizeof(LidT)    );
+        f.read( magic, sizeof(magic) );
+
+        return ( f && std::equal(magic, magic + sizeof(magic), MAGIC) ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...readCache()
+} //...namespace mesh
+
+/*! \brief Reads a triangle mesh from an OBJ or PLY file (ASCII or binary) into flat arrays.
+ *         The file is memory-mapped and parsed in parallel chunks. Polygons are fan-triangulated, normals and texture coordinates are ignored.
+ *  \param[out] mesh       Vertices and triangle indices.
+ *  \param[in]  path       Mesh path, the format is decided by the extension.
+ *  \param[in]  cacheDir   Folder of the parsed copy "<cacheDir>/<mesh file name>.cache", empty: no cache.
+ *                         The copy is used, if it has the current format version and was written from a file of the same size and content hash,
+ *                         and is (re)written otherwise. The mesh's folder is never written to, unless it is \p cacheDir.
+ *  \return                EXIT_SUCCESS, if the mesh could be read.
+ */
+template <typename _Scalar> inline int
+readMesh( TriangleMesh<_Scalar> &mesh, std::string const& path, std::string const& cacheDir = "" )
+{
+    mesh.vertices.clear();
+    mesh.indices .clear();
+
+    std::string extension = boost::filesystem::path( path ).extension().string();
+    std::transform( extension.begin(), extension.end(), extension.begin(), ::tolower );
+
+    mesh::MappedFile file;
+    if ( !boost::filesystem::exists(path) || !file.open(path) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not read " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const bool        useCache   = !cacheDir.empty();
+    const ULidT       sourceSize = file.size();
+    const ULidT       sourceHash = useCache ? mesh::hashFile( file ) : 0;
+    const std::string cachePath  = useCache ? (boost::filesystem::path(cacheDir) / (boost::filesystem::path(path).filename().string() + ".cache")).string() : "";
+    if ( useCache && boost::filesystem::exists(cachePath) && (mesh::readCache(mesh, cachePath, sourceSize, sourceHash) == EXIT_SUCCESS) )
+    {
+        std::cout << "[" << __func__ << "]: " << "read " << mesh.getTriangleCount() << " triangles from " << cachePath << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    int err = EXIT_SUCCESS;
+    if      ( extension == ".obj" ) err = mesh::parseObj( mesh, file.begin(), file.end() );
+    else if ( extension == ".ply" ) err = mesh::parsePly( mesh, file.begin(), file.end() );
+    else
+    {
+        std::cerr << "[" << __func__ << "]: " << "unknown mesh format " << extension << ", need .obj or .ply" << std::endl;
+        err = EXIT_FAILURE;
+    }
+
+    if ( err != EXIT_SUCCESS )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not parse " << path << std::endl;
+        return err;
+    }
+
+    std::cout << "[" << __func__ << "]: " << "read " << mesh.getVertexCount() << " vertices, " << mesh.getTriangleCount() << " triangles from " << path << std::endl;
+
+    if ( useCache )
+    {
+        boost::system::error_code ec;
+        boost::filesystem::create_directories( cacheDir, ec );
+        if ( mesh::writeCache(mesh, cachePath, sourceSize, sourceHash) != EXIT_SUCCESS )
+            std::cerr << "[" << __func__ << "]: " << "could not write cache " << cachePath << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+} //...readMesh()
+
+} //...namespace io
+} //...namespace rapter
+
+#endif // RAPTER_MESHIO_HPP
@@ -0,0 +1,144 @@
+#ifndef RAPTER_POLYGONIO_HPP
+#define RAPTER_POLYGONIO_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include "boost/filesystem.hpp"
+#include "rapter/processing/polygonize.h" // PlanarPolygon
+
+namespace rapter {
+namespace io {
+
+/*! \brief Streams planar polygons to a Wavefront OBJ file, one object and one n-gon face per polygon.
+ *  \param[in] polygons Polygons in their local frames. Empty ones are skipped.
+ *  \param[in] path     Output path.
+ *  \return             EXIT_SUCCESS, if the file could be written.
+ */
+template <typename _Scalar> inline int
+writePolygonsObj( std::vector< processing::PlanarPolygon<_Scalar> > const& polygons, std::string const& path )
+{
+    typedef processing::PlanarPolygon<_Scalar> PolygonT;
+
+    std::ofstream f( path.c_str() );
+    if ( !f.is_open() )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    f << "# rapter planar polygons\n";
+    LidT offset = 1; // obj indices are 1-based
+    for ( typename std::vector<PolygonT>::const_iterator it = polygons.begin(); it != polygons.end(); ++it )
+    {
+        if ( it->empty() )
+            continue;
+
+        f << "o plane_" << it->gid << "_" << it->did << "\n";
+        for ( typename PolygonT::VerticesT::const_iterator vIt = it->vertices.begin(); vIt != it->vertices.end(); ++vIt )
+        {
+            const typename PolygonT::Vertex3 p = it->toWorld( *vIt );
+            f << "v " << p(0) << " " << p(1) << " " << p(2) << "\n";
+        }
+
+        f << "f";
+        for ( LidT i = 0; i != static_cast<LidT>(it->vertices.size()); ++i )
+            f << " " << offset + i;
+        f << "\n";
+
+        offset += it->vertices.size();
+    } //...for polygons
+
+    f.close();
+    std::cout << "[" << __func__ << "]: " << "wrote " << path << std::endl;
+
+    return EXIT_SUCCESS;
+} //...writePolygonsObj()
+
+/*! \brief Streams planar polygons to an ascii PLY file with an n-gon face list and per-face gid/did properties.
+ *  \param[in] polygons Polygons in their local frames. Empty ones are skipped.
+ *  \param[in] path     Output path.
+ *  \return             EXIT_SUCCESS, if the file could be written.
+ */
+template <typename _Scalar> inline int
+writePolygonsPly( std::vector< processing::PlanarPolygon<_Scalar> > const& polygons, std::string const& path )
+{
+    typedef processing::PlanarPolygon<_Scalar> PolygonT;
+
+    std::ofstream f( path.c_str() );
+    if ( !f.is_open() )
+    {
+        std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // header needs counts
+    LidT vertexCount = 0, faceCount = 0;
+    for ( typename std::vector<PolygonT>::const_iterator it = polygons.begin(); it != polygons.end(); ++it )
+    {
+        if ( it->empty() )
+            continue;
+        vertexCount += it->vertices.size();
+        ++faceCount;
+    }
+
+    f << "ply\n"
+      << "format ascii 1.0\n"
+      << "comment rapter planar polygons\n"
+      << "element vertex " << vertexCount << "\n"
+      << "property float x\n"
+      << "property float y\n"
+      << "property float z\n"
+      << "element face " << faceCount << "\n"
+      << "property list int int vertex_indices\n"
+      << "property int gid\n"
+      << "property int did\n"
+      << "end_header\n";
+
+    for ( typename std::vector<PolygonT>::const_iterator it = polygons.begin(); it != polygons.end(); ++it )
+    {
+        if ( it->empty() )
+            continue;
+
+        for ( typename PolygonT::VerticesT::const_iterator vIt = it->vertices.begin(); vIt != it->vertices.end(); ++vIt )
+        {
+            const typename PolygonT::Vertex3 p = it->toWorld( *vIt );
+            f << p(0) << " " << p(1) << " " << p(2) << "\n";
+        }
+    }
+
+    LidT offset = 0;
+    for ( typename std::vector<PolygonT>::const_iterator it = polygons.begin(); it != polygons.end(); ++it )
+    {
+        if ( it->empty() )
+            continue;
+
+        f << it->vertices.size();
+        for ( LidT i = 0; i != static_cast<LidT>(it->vertices.size()); ++i )
+            f << " " << offset + i;
+        f << " " << it->gid << " " << it->did << "\n";
+
+        offset += it->vertices.size();
+    }
+
+    f.close();
+    std::cout << "[" << __func__ << "]: " << "wrote " << path << std::endl;
+
+    return EXIT_SUCCESS;
+} //...writePolygonsPly()
+
+//! \brief Writes PLY, if \p path ends with ".ply", OBJ otherwise.
+template <typename _Scalar> inline int
+writePolygons( std::vector< processing::PlanarPolygon<_Scalar> > const& polygons, std::string const& path )
+{
+    if ( !boost::filesystem::path(path).extension().string().compare(".ply") )
+        return writePolygonsPly( polygons, path );
+    else
+        return writePolygonsObj( polygons, path );
+} //...writePolygons()
+
+} //...namespace io
+} //...namespace rapter
+
+#endif // RAPTER_POLYGONIO_HPP
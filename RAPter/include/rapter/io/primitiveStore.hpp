@@ -0,0 +1,452 @@
+#ifndef RAPTER_PRIMITIVESTORE_HPP
+#define RAPTER_PRIMITIVESTORE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>   // memcpy
+#include <algorithm> // equal, sort
+#include "boost/filesystem.hpp"
+#include "rapter/simpleTypes.h"     // GidT, DidT, ULidT
+#include "rapter/io/checkpoint.hpp" // writePod, readPod
+#include "rapter/io/meshIo.hpp"     // mesh::MappedFile
+#include "rapter/util/containers.hpp" // valueOf
+
+namespace rapter {
+namespace io {
+
+/*! \brief Binary primitive container, the compact alternative of the primitive csv files (see \ref savePrimitives(), \ref readPrimitives()).
+ *
+ *         Layout:
+ *          - header: MAGIC, sizeof(Scalar), Dim,
+ *          - fixed size records: Dim coefficients, GID, DIR_GID, STATUS, GEN_ANGLE,
+ *          - index footer: record count, (GID, DIR_GID, record) sorted by GID, record ids sorted by DIR_GID,
+ *          - trailer: offset of the footer, MAGIC.
+ *
+ *         Records are found by record id without reading anything else, and by GID or DIR_GID by a binary search in the mapped footer.
+ *         The coefficients are stored as they are in memory, so reading a store gives the primitives that were saved.
+ *         \ref savePrimitiveStore() writes the records in container order, so the same container always gives the same file,
+ *         and a store read by \ref readPrimitiveStore() (one patch per GID, increasing GID) is saved to the same file again.
+ */
+namespace primitiveStore
+{
+    static const char MAGIC[8] = { 'R','P','T','R','P','R','I','M' };
+
+    //! \brief Footer entry of a record.
+    struct IndexEntry
+    {
+        GidT  gid;
+        DidT  did;
+        ULidT record;
+    };
+
+    inline size_t headerSize () { return sizeof(MAGIC) + 2 * sizeof(int); }
+    inline size_t trailerSize() { return sizeof(ULidT) + sizeof(MAGIC); }
+
+    //! \brief Coefficients, GID, DIR_GID, STATUS and GEN_ANGLE.
+    template <class _PrimitiveT>
+    inline size_t recordSize() { return (_PrimitiveT::Dim + 1) * sizeof(typename _PrimitiveT::Scalar) + sizeof(GidT) + sizeof(DidT) + sizeof(int); }
+
+    //! \brief True, if \p path has the store's extension, used by \ref readPrimitives() and \ref savePrimitives() to pick the format.
+    inline bool isStorePath( std::string const& path ) { return boost::filesystem::path(path).extension().string() == ".rprim"; }
+
+    template <typename _T>
+    inline _T readAt( const char* p ) { _T value; std::memcpy( &value, p, sizeof(_T) ); return value; }
+
+    template <typename _T>
+    inline char* writeAt( char* p, _T const& value ) { std::memcpy( p, &value, sizeof(_T) ); return p + sizeof(_T); }
+
+    /*! \brief Appends primitives to a store. Records are written as they come, the index footer on \ref close().
+     *
+     *         \ref append() can be called from several threads, each record is packed by its caller and only the write is serialized,
+     *         so records land in the order the threads get there. For a fixed order, \ref pack() records in parallel and
+     *         \ref appendPacked() the buffers from one thread.
+     *         Reopening a store with \p append = true drops its footer and keeps its records, so stages can add to a store without rewriting it.
+     *  \tparam _PrimitiveT Concept: \ref rapter::LinePrimitive2, \ref rapter::PlanePrimitive.
+     */
+    template <class _PrimitiveT>
+    class Writer
+    {
+        public:
+            typedef typename _PrimitiveT::Scalar Scalar;
+
+            Writer() : _footerWritten( true ) {}
+            ~Writer() { this->close(); }
+
+            //! \return EXIT_FAILURE, if the file can't be opened, or \p append is set and it's not a store of the same primitive type.
+            inline int open( std::string const& path, bool const append = false )
+            {
+                this->close();
+                _index.clear();
+
+                std::string parent_path = boost::filesystem::path(path).parent_path().string();
+                if ( !parent_path.empty() && !boost::filesystem::exists(parent_path) )
+                    boost::filesystem::create_directory( boost::filesystem::path(parent_path) );
+
+                if ( append && boost::filesystem::exists(path) )
+                {
+                    ULidT footerOffset = 0;
+                    {
+                        std::ifstream f( path.c_str(), std::ios::binary );
+                        if ( !readHeader(f) || !readIndex(f, _index, footerOffset) )
+                        {
+                            std::cerr << "[" << __func__ << "]: " << path << " is not a valid primitive store" << std::endl;
+                            return EXIT_FAILURE;
+                        }
+                    }
+                    boost::filesystem::resize_file( path, footerOffset );
+                    _file.open( path.c_str(), std::ios::binary | std::ios::in | std::ios::out );
+                    _file.seekp( 0, std::ios::end );
+                }
+                else
+                {
+                    _file.open( path.c_str(), std::ios::binary | std::ios::trunc );
+                    _file.write( MAGIC, sizeof(MAGIC) );
+                    checkpoint::writePod( _file, static_cast<int>(sizeof(Scalar)) );
+                    checkpoint::writePod( _file, static_cast<int>(_PrimitiveT::Dim) );
+                }
+
+                if ( !_file.is_open() || !_file )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "could not open " << path << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                _footerWritten = false;
+                return EXIT_SUCCESS;
+            } //...open()
+
+            //! \brief Encodes \p prim as a record at the end of \p records. Doesn't touch the store, can run on any thread.
+            static inline void pack( _PrimitiveT const& prim, std::vector<char> &records )
+            {
+                const size_t offset = records.size();
+                records.resize( offset + recordSize<_PrimitiveT>() );
+                char *p = &records[ offset ];
+                for ( int d = 0; d != _PrimitiveT::Dim; ++d )
+                    p = writeAt( p, prim.coeffs()(d) );
+                p = writeAt( p, static_cast<GidT>(prim.getTag(_PrimitiveT::TAGS::GID    )) );
+                p = writeAt( p, static_cast<DidT>(prim.getTag(_PrimitiveT::TAGS::DIR_GID)) );
+                p = writeAt( p, static_cast<int>(prim.getTag(_PrimitiveT::TAGS::STATUS)) );
+                p = writeAt( p, prim.getTag(_PrimitiveT::TAGS::GEN_ANGLE) );
+            } //...pack()
+
+            //! \brief Thread-safe. Writes records encoded by \ref pack() in their buffer order. \return Record id of the first one.
+            inline ULidT appendPacked( std::vector<char> const& records )
+            {
+                const ULidT count   = records.size() / recordSize<_PrimitiveT>();
+                const size_t gidPos = _PrimitiveT::Dim * sizeof(Scalar);
+                ULidT id = 0;
+#               pragma omp critical (PRIMSTORE_APPEND)
+                {
+                    id = _index.size();
+                    if ( count )
+                        _file.write( records.data(), count * recordSize<_PrimitiveT>() );
+                    for ( ULidT i = 0; i != count; ++i )
+                    {
+                        const char *p = records.data() + i * recordSize<_PrimitiveT>() + gidPos;
+                        const IndexEntry entry = { readAt<GidT>(p), readAt<DidT>(p + sizeof(GidT)), id + i };
+                        _index.push_back( entry );
+                    }
+                }
+                return id;
+            } //...appendPacked()
+
+            //! \brief Thread-safe. \return Record id of \p prim.
+            inline ULidT append( _PrimitiveT const& prim )
+            {
+                std::vector<char> record;
+                pack( prim, record );
+                return this->appendPacked( record );
+            } //...append()
+
+            //! \brief Writes the index footer. Called by the destructor, if not called before.
+            inline int close()
+            {
+                if ( _footerWritten )
+                    return EXIT_SUCCESS;
+                _footerWritten = true;
+
+                const ULidT footerOffset = static_cast<ULidT>( _file.tellp() );
+
+                // by gid, then by did
+                std::sort( _index.begin(), _index.end(), []( IndexEntry const& a, IndexEntry const& b )
+                           { return (a.gid < b.gid) || ((a.gid == b.gid) && (a.record < b.record)); } );
+                std::vector<ULidT> byDid( _index.size() );
+                for ( size_t i = 0; i != _index.size(); ++i )
+                    byDid[i] = i;
+                std::sort( byDid.begin(), byDid.end(), [this]( ULidT const a, ULidT const b )
+                           { return (_index[a].did < _index[b].did) || ((_index[a].did == _index[b].did) && (_index[a].record < _index[b].record)); } );
+                for ( size_t i = 0; i != byDid.size(); ++i )
+                    byDid[i] = _index[ byDid[i] ].record;
+
+                checkpoint::writePod( _file, static_cast<ULidT>(_index.size()) );
+                for ( size_t i = 0; i != _index.size(); ++i )
+                {
+                    checkpoint::writePod( _file, _index[i].gid    );
+                    checkpoint::writePod( _file, _index[i].did    );
+                    checkpoint::writePod( _file, _index[i].record );
+                }
+                for ( size_t i = 0; i != byDid.size(); ++i )
+                    checkpoint::writePod( _file, byDid[i] );
+                checkpoint::writePod( _file, footerOffset );
+                _file.write( MAGIC, sizeof(MAGIC) );
+
+                const bool ok = static_cast<bool>( _file );
+                _file.close();
+                _index.clear();
+                return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+            } //...close()
+
+            //! \return Number of records written so far.
+            inline ULidT size() const { return _index.size(); }
+
+            //! \brief Checks the header against \p _PrimitiveT.
+            static inline bool readHeader( std::istream &f )
+            {
+                char magic[ sizeof(MAGIC) ];
+                int  scalarSize = 0, dim = 0;
+                f.read( magic, sizeof(magic) );
+                return    f && std::equal( magic, magic + sizeof(magic), MAGIC )
+                       && checkpoint::readPod( f, scalarSize ) && (scalarSize == static_cast<int>(sizeof(Scalar)))
+                       && checkpoint::readPod( f, dim        ) && (dim        == static_cast<int>(_PrimitiveT::Dim));
+            } //...readHeader()
+
+            //! \brief Reads the footer of a closed store through a stream.
+            static inline bool readIndex( std::istream &f, std::vector<IndexEntry> &index, ULidT &footerOffset )
+            {
+                char  magic[ sizeof(MAGIC) ];
+                ULidT count = 0;
+                f.seekg( -static_cast<std::streamoff>(trailerSize()), std::ios::end );
+                if ( !checkpoint::readPod(f, footerOffset) )
+                    return false;
+                f.read( magic, sizeof(magic) );
+                if ( !f || !std::equal(magic, magic + sizeof(magic), MAGIC) )
+                    return false;
+
+                f.seekg( footerOffset );
+                if ( !checkpoint::readPod(f, count) || (footerOffset != headerSize() + count * recordSize<_PrimitiveT>()) )
+                    return false;
+                index.resize( count );
+                for ( ULidT i = 0; i != count; ++i )
+                {
+                    checkpoint::readPod( f, index[i].gid    );
+                    checkpoint::readPod( f, index[i].did    );
+                    checkpoint::readPod( f, index[i].record );
+                }
+                return static_cast<bool>( f );
+            } //...readIndex()
+
+        protected:
+            std::ofstream           _file;
+            std::vector<IndexEntry> _index;         //!< \brief Entry of each appended record, in record order until \ref close().
+            bool                    _footerWritten;
+
+        private:
+            Writer( Writer const& );
+            Writer& operator=( Writer const& );
+    }; //...class Writer
+
+    /*! \brief Memory-mapped, read-only view of a closed store.
+     *         Nothing is parsed on \ref open() apart from the header and trailer, primitives are decoded on request.
+     *  \tparam _PrimitiveT Concept: \ref rapter::LinePrimitive2, \ref rapter::PlanePrimitive.
+     */
+    template <class _PrimitiveT>
+    class Reader
+    {
+        public:
+            typedef typename _PrimitiveT::Scalar Scalar;
+
+            Reader() : _count( 0 ), _index( NULL ), _byDid( NULL ) {}
+
+            //! \return EXIT_FAILURE, if \p path is not a closed store of \p _PrimitiveT.
+            inline int open( std::string const& path )
+            {
+                _count = 0; _index = _byDid = NULL;
+                if ( !_file.open(path) )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "could not open " << path << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                const char *begin = _file.begin();
+                const size_t size = _file.size();
+                bool valid =    (size >= headerSize() + sizeof(ULidT) + trailerSize())
+                             && std::equal( MAGIC, MAGIC + sizeof(MAGIC), begin )
+                             && (readAt<int>(begin + sizeof(MAGIC)              ) == static_cast<int>(sizeof(Scalar)))
+                             && (readAt<int>(begin + sizeof(MAGIC) + sizeof(int)) == static_cast<int>(_PrimitiveT::Dim))
+                             && std::equal( MAGIC, MAGIC + sizeof(MAGIC), _file.end() - sizeof(MAGIC) );
+                if ( valid )
+                {
+                    const ULidT footerOffset = readAt<ULidT>( _file.end() - trailerSize() );
+                    _count = (footerOffset + sizeof(ULidT) <= size) ? readAt<ULidT>( begin + footerOffset ) : 0;
+                    valid =    (footerOffset == headerSize() + _count * recordSize<_PrimitiveT>())
+                            && (size == footerOffset + sizeof(ULidT) + _count * (sizeof(IndexEntry) + sizeof(ULidT)) + trailerSize());
+                    _index = begin + footerOffset + sizeof(ULidT);
+                    _byDid = _index + _count * sizeof(IndexEntry);
+                }
+
+                if ( !valid )
+                {
+                    std::cerr << "[" << __func__ << "]: " << path << " is not a valid primitive store" << std::endl;
+                    _file.close();
+                    _count = 0; _index = _byDid = NULL;
+                    return EXIT_FAILURE;
+                }
+
+                return EXIT_SUCCESS;
+            } //...open()
+
+            //! \return Number of records.
+            inline ULidT size() const { return _count; }
+
+            //! \brief Decodes record \p record, with its tags.
+            inline _PrimitiveT get( ULidT const record ) const
+            {
+                const char *p = _file.begin() + headerSize() + record * recordSize<_PrimitiveT>();
+                Eigen::Matrix<Scalar,_PrimitiveT::Dim,1> coeffs;
+                for ( int d = 0; d != _PrimitiveT::Dim; ++d, p += sizeof(Scalar) )
+                    coeffs(d) = readAt<Scalar>( p );
+
+                _PrimitiveT prim( coeffs );
+                prim.setTag( _PrimitiveT::TAGS::GID      , readAt<GidT>(p) ); p += sizeof(GidT);
+                prim.setTag( _PrimitiveT::TAGS::DIR_GID  , readAt<DidT>(p) ); p += sizeof(DidT);
+                prim.setTag( _PrimitiveT::TAGS::STATUS   , static_cast<char>(readAt<int>(p)) ); p += sizeof(int);
+                prim.setTag( _PrimitiveT::TAGS::GEN_ANGLE, readAt<Scalar>(p) );
+                return prim;
+            } //...get()
+
+            //! \brief Footer entry \p i, in GID order.
+            inline IndexEntry entry( ULidT const i ) const { return readAt<IndexEntry>( _index + i * sizeof(IndexEntry) ); }
+
+            //! \brief Appends the primitives of group \p gid to \p prims in record order. \return Number of primitives found.
+            template <class _PatchT>
+            inline ULidT findGid( GidT const gid, _PatchT &prims ) const
+            {
+                // first entry with gid >= gid
+                ULidT lo = 0, hi = _count;
+                while ( lo < hi )
+                {
+                    const ULidT mid = lo + (hi - lo) / 2;
+                    if ( this->entry(mid).gid < gid ) lo = mid + 1;
+                    else                              hi = mid;
+                }
+
+                ULidT found = 0;
+                for ( ; (lo != _count) && (this->entry(lo).gid == gid); ++lo, ++found )
+                    prims.push_back( this->get(this->entry(lo).record) );
+                return found;
+            } //...findGid()
+
+            //! \brief Appends the primitives with direction \p did to \p prims in record order. \return Number of primitives found.
+            template <class _PatchT>
+            inline ULidT findDid( DidT const did, _PatchT &prims ) const
+            {
+                ULidT lo = 0, hi = _count;
+                while ( lo < hi )
+                {
+                    const ULidT mid = lo + (hi - lo) / 2;
+                    if ( this->_didAt(mid) < did ) lo = mid + 1;
+                    else                           hi = mid;
+                }
+
+                ULidT found = 0;
+                for ( ; (lo != _count) && (this->_didAt(lo) == did); ++lo, ++found )
+                    prims.push_back( this->get(readAt<ULidT>(_byDid + lo * sizeof(ULidT))) );
+                return found;
+            } //...findDid()
+
+        protected:
+            //! \brief DIR_GID of the \p i-th record in DIR_GID order.
+            inline DidT _didAt( ULidT const i ) const
+            {
+                const char *p = _file.begin() + headerSize() + readAt<ULidT>(_byDid + i * sizeof(ULidT)) * recordSize<_PrimitiveT>()
+                              + _PrimitiveT::Dim * sizeof(Scalar) + sizeof(GidT);
+                return readAt<DidT>( p );
+            } //..._didAt()
+
+            mesh::MappedFile    _file;
+            ULidT               _count;
+            const char*         _index; //!< \brief Footer entries sorted by GID.
+            const char*         _byDid; //!< \brief Record ids sorted by DIR_GID.
+    }; //...class Reader
+} //...namespace primitiveStore
+
+/*! \brief Binary counterpart of \ref savePrimitives(). Groups are packed in parallel, and written in container order.
+ *  \tparam PrimitiveT Concept: PrimitiveContainerT::value_type::value_type aka rapter::LinePrimitive2.
+ *  \tparam PrimitiveContainerT Concept: vector< vector< rapter::LinePrimitive2 > >.
+ */
+template <class PrimitiveT, class _inner_const_iterator, class PrimitiveContainerT> inline int
+savePrimitiveStore( PrimitiveContainerT const& primitives, std::string const& path, bool verbose = false )
+{
+    typedef typename PrimitiveContainerT::const_iterator outer_const_iterator;
+
+    primitiveStore::Writer<PrimitiveT> writer;
+    if ( EXIT_SUCCESS != writer.open(path) )
+        return EXIT_FAILURE;
+
+    std::vector<outer_const_iterator> groups;
+    for ( outer_const_iterator gid_it = primitives.begin(); gid_it != primitives.end(); ++gid_it )
+        groups.push_back( gid_it );
+
+    std::vector< std::vector<char> > packed( groups.size() );
+#   pragma omp parallel for schedule(dynamic,16)
+    for ( LidT i = 0; i < LidT(groups.size()); ++i )
+    {
+        _inner_const_iterator lid_end_it = containers::valueOf<PrimitiveT>(groups[i]).end();
+        for ( _inner_const_iterator lid_it = containers::valueOf<PrimitiveT>(groups[i]).begin(); lid_it != lid_end_it; ++lid_it )
+            primitiveStore::Writer<PrimitiveT>::pack( *lid_it, packed[i] );
+    }
+
+    for ( size_t i = 0; i != packed.size(); ++i )
+    {
+        writer.appendPacked( packed[i] );
+        std::vector<char>().swap( packed[i] );
+    }
+
+    if ( EXIT_SUCCESS != writer.close() )
+        return EXIT_FAILURE;
+    if ( verbose ) std::cout << "[" << __func__ << "]: " << "saved " << path << std::endl;
+
+    return EXIT_SUCCESS;
+} //...savePrimitiveStore()
+
+/*! \brief Binary counterpart of \ref readPrimitives(), fills the same container shape: one patch per GID in increasing GID order.
+ *  \tparam PatchT Concept: vector< \ref rapter::LinePrimitive2 >.
+ */
+template <class PrimitiveT, class PatchT, class PrimitiveContainerT>
+inline int readPrimitiveStore( PrimitiveContainerT &lines, std::string const& path, std::map<GidT, typename PrimitiveContainerT::value_type> *patches = NULL )
+{
+    primitiveStore::Reader<PrimitiveT> reader;
+    if ( EXIT_SUCCESS != reader.open(path) )
+        return EXIT_FAILURE;
+
+    // group boundaries in the gid ordered footer
+    std::vector<ULidT> starts;
+    for ( ULidT i = 0; i != reader.size(); ++i )
+        if ( !i || (reader.entry(i).gid != reader.entry(i-1).gid) )
+            starts.push_back( i );
+    starts.push_back( reader.size() );
+
+    std::vector<PatchT> tmp( starts.size() - 1 );
+#   pragma omp parallel for schedule(dynamic,16)
+    for ( LidT g = 0; g < LidT(tmp.size()); ++g )
+        for ( ULidT i = starts[g]; i != starts[g+1]; ++i )
+            tmp[g].push_back( reader.get(reader.entry(i).record) );
+
+    for ( size_t g = 0; g != tmp.size(); ++g )
+    {
+        if ( patches )
+            (*patches)[ reader.entry(starts[g]).gid ] = tmp[g];
+        lines.push_back( PatchT() );
+        lines.back().insert( lines.back().end(), tmp[g].begin(), tmp[g].end() );
+    }
+
+    return EXIT_SUCCESS;
+} //...readPrimitiveStore()
+
+} //...namespace io
+} //...namespace rapter
+
+#endif // RAPTER_PRIMITIVESTORE_HPP
@@ -3,6 +3,8 @@
 
 #include <fstream>
 #include <string>
+#include <cstdarg>   // va_list
+#include <cstdio>    // vsnprintf, fwrite
 #include "rapter/util/containers.hpp"
 #include "rapter/processing/util.hpp"
 #include "rapter/util/util.hpp"
@@ -242,6 +244,278 @@ namespace io
         std::cout << command.str() << std::endl;
     }
 
+    namespace vector_export
+    {
+        //! \brief Output formats of \ref drawVector().
+        enum FORMAT { SVG = 0, PDF = 1 };
+
+        //! \brief Page units of \ref drawPs() per scene unit (see \ref drawCircle()), its --radius is given in these.
+        static const float PS_UNITS = 200.f;
+
+        //! \brief Maps the xy-plane of the scene to the page, y grows upwards in PDF and downwards in SVG.
+        struct Canvas
+        {
+                Canvas() : minX( 0.f ), minY( 0.f ), factor( 1.f ), width( 0.f ), height( 0.f ), margin( 10.f ), format( SVG ) {}
+
+                inline Eigen::Vector2f toPage( Eigen::Vector2f const& p ) const
+                {
+                    const float x = margin + (p(0) - minX) * factor,
+                                y = margin + (p(1) - minY) * factor;
+                    return Eigen::Vector2f( x, (format == SVG) ? (height - y) : y );
+                }
+
+                float minX, minY, factor, width, height, margin;
+                FORMAT format;
+        }; //...Canvas
+
+        //! \brief printf to the end of \p out.
+        inline void appendf( std::string &out, char const* format, ... )
+        {
+            char buffer[256];
+            va_list args;
+            va_start( args, format );
+            const int length = vsnprintf( buffer, sizeof(buffer), format, args );
+            va_end( args );
+            if ( length > 0 )
+                out.append( buffer, std::min(length, static_cast<int>(sizeof(buffer)) - 1) );
+        }
+
+        //! \brief Opens a group of filled dots of \p colour (0..255).
+        inline void beginDots( std::string &out, Canvas const& canvas, Eigen::Vector3f const& colour )
+        {
+            if ( canvas.format == SVG ) appendf( out, "<g fill=\"#%02x%02x%02x\">\n", int(colour(0)), int(colour(1)), int(colour(2)) );
+            else                        appendf( out, "%.3f %.3f %.3f rg\n", colour(0)/255.f, colour(1)/255.f, colour(2)/255.f );
+        }
+
+        //! \brief A dot of \p radius page units. PDF has no circles, so squares are drawn there.
+        inline void appendDot( std::string &out, Canvas const& canvas, Eigen::Vector2f const& pos, float const radius )
+        {
+            const Eigen::Vector2f p = canvas.toPage( pos );
+            if ( canvas.format == SVG ) appendf( out, "<circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\"/>\n", p(0), p(1), radius );
+            else                        appendf( out, "%.2f %.2f %.2f %.2f re\n", p(0) - radius, p(1) - radius, 2.f * radius, 2.f * radius );
+        }
+
+        inline void endDots( std::string &out, Canvas const& canvas )
+        {
+            if ( canvas.format == SVG ) out += "</g>\n";
+            else                        out += "f\n";
+        }
+
+        //! \brief Polyline through \p corners, closed if there are more than two.
+        template <class _ExtremaT>
+        inline void appendPolyline( std::string &out, Canvas const& canvas, _ExtremaT const& corners, Eigen::Vector3f const& colour, float const width )
+        {
+            if ( canvas.format == SVG )
+            {
+                out += (corners.size() > 2) ? "<polygon points=\"" : "<polyline points=\"";
+                for ( size_t i = 0; i != corners.size(); ++i )
+                {
+                    const Eigen::Vector2f p = canvas.toPage( corners[i].template head<2>().template cast<float>() );
+                    appendf( out, "%.2f,%.2f ", p(0), p(1) );
+                }
+                appendf( out, "\" fill=\"none\" stroke=\"#%02x%02x%02x\" stroke-width=\"%.2f\"/>\n", int(colour(0)), int(colour(1)), int(colour(2)), width );
+            }
+            else
+            {
+                appendf( out, "%.3f %.3f %.3f RG %.2f w\n", colour(0)/255.f, colour(1)/255.f, colour(2)/255.f, width );
+                for ( size_t i = 0; i != corners.size(); ++i )
+                {
+                    const Eigen::Vector2f p = canvas.toPage( corners[i].template head<2>().template cast<float>() );
+                    appendf( out, "%.2f %.2f %s\n", p(0), p(1), i ? "l" : "m" );
+                }
+                out += (corners.size() > 2) ? "h S\n" : "S\n";
+            }
+        }
+
+        //! \brief "P<did>-><gid>" at \p pos, 6 units high.
+        inline void appendLabel( std::string &out, Canvas const& canvas, Eigen::Vector2f const& pos, GidT const gid, DidT const did )
+        {
+            const Eigen::Vector2f p = canvas.toPage( pos );
+            if ( canvas.format == SVG ) appendf( out, "<text x=\"%.2f\" y=\"%.2f\" font-family=\"Times\" font-size=\"6\">P%ld-&gt;%ld</text>\n", p(0) + 1.f, p(1), did, gid );
+            else                        appendf( out, "BT /F1 6 Tf 0 g %.2f %.2f Td (P%ld->%ld) Tj ET\n", p(0) + 1.f, p(1), did, gid );
+        }
+    } //...ns vector_export
+
+    /*! \brief Draws the points and the extents of the primitives to a single SVG or PDF file, viewed from the top (xy-plane) for 3D scenes.
+     *
+     *         Every patch and every primitive is written to its own buffer in parallel, and the buffers are written to the file in order,
+     *         so the output is the same for any thread count. Points are decimated per patch by taking every k-th point.
+     *         The file is written in binary mode, the PDF cross-reference table needs exact byte offsets.
+     *
+     *  \param[in] path              Output path, PDF if it ends with ".pdf", SVG otherwise.
+     *  \param[in] scale             Inlier distance for \ref getExtent().
+     *  \param[in] writeNames        Label the primitives by "P<did>-><gid>".
+     *  \param[in] colourCloud       Colour the points by the direction of their patch, black otherwise.
+     *  \param[in] dids              If not empty, only primitives with these direction ids are drawn.
+     *  \param[in] maxPointsPerPatch Upper limit on the drawn points of a patch, 0: all points.
+     *  \param[in] radius            Point radius in \ref drawPs() page units (scene units x PS_UNITS), so the same --radius gives the same dots
+     *                               relative to the scene. Scaled to this page, whose longer side is 1000 units.
+     *  \return EXIT_SUCCESS, or EXIT_FAILURE, if the file could not be written.
+     */
+    template <class _PrimitiveMapT, class _PointContainerT>
+    inline int drawVector( _PrimitiveMapT          const& prims
+                         , _PointContainerT        const& points
+                         , std::string             const& path
+                         , float                   const  scale
+                         , bool                    const  writeNames        = false
+                         , bool                    const  colourCloud       = false
+                         , std::vector<DidT>       const* dids              = NULL
+                         , LidT                    const  maxPointsPerPatch = 0
+                         , float                   const  radius            = .1f
+                         )
+    {
+        using namespace vector_export;
+        typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
+        typedef typename _PointContainerT::value_type            PointPrimitiveT;
+
+        Canvas canvas;
+        canvas.format = ( path.size() > 4 && path.compare(path.size() - 4, 4, ".pdf") == 0 ) ? PDF : SVG;
+
+        GidPidVectorMap populations; // populations[patch_id] = all points with GID==patch_id
+        processing::getPopulations( populations, points );
+
+        std::map< DidT, Eigen::Vector3f> colourMap;
+        getColours( colourMap, prims );
+
+        // primitives to draw, in container order
+        std::vector< PrimitiveT const* > drawn;
+        std::vector< PidVector  const* > drawnPopulations;
+        std::vector< Eigen::Vector3f   > drawnColours;
+        const PidVector empty;
+        for ( typename containers::PrimitiveContainer<PrimitiveT>::ConstIterator it(prims); it.hasNext(); it.step() )
+        {
+            if ( it->getTag(PrimitiveT::TAGS::STATUS) == PrimitiveT::STATUS_VALUES::SMALL ) continue;
+            if ( dids && dids->size() && std::find(dids->begin(), dids->end(), it.getDid()) == dids->end() ) continue;
+
+            typename GidPidVectorMap::const_iterator popIt = populations.find( it.getGid() );
+            drawn           .push_back( &(*it) );
+            drawnPopulations.push_back( (popIt != populations.end()) ? &(popIt->second) : &empty );
+            drawnColours    .push_back( colourMap[it.getDid()] );
+        }
+
+        // page
+        {
+            Eigen::Vector2f minPt( Eigen::Vector2f::Constant(std::numeric_limits<float>::max()) ), maxPt( -minPt );
+            for ( UPidT pid = 0; pid != points.size(); ++pid )
+            {
+                minPt = minPt.cwiseMin( points[pid].template pos().template head<2>() );
+                maxPt = maxPt.cwiseMax( points[pid].template pos().template head<2>() );
+            }
+            if ( !points.size() )
+                minPt = maxPt = Eigen::Vector2f::Zero();
+            const Eigen::Vector2f size = (maxPt - minPt).cwiseMax( Eigen::Vector2f::Constant(1.e-6f) );
+            canvas.minX   = minPt(0) - scale;
+            canvas.minY   = minPt(1) - scale;
+            canvas.factor = 1000.f / (std::max(size(0), size(1)) + 2.f * scale);
+            canvas.width  = (size(0) + 2.f * scale) * canvas.factor + 2.f * canvas.margin;
+            canvas.height = (size(1) + 2.f * scale) * canvas.factor + 2.f * canvas.margin;
+        }
+        const float pageRadius = radius / PS_UNITS * canvas.factor;
+
+        // one chunk per patch of points, then one per primitive
+        std::vector< typename GidPidVectorMap::const_iterator > patchIts;
+        for ( typename GidPidVectorMap::const_iterator it = populations.begin(); it != populations.end(); ++it )
+            patchIts.push_back( it );
+        const LidT patchCount = patchIts.size();
+        const LidT chunkCount = patchCount + drawn.size();
+        std::vector< std::string > chunks( chunkCount );
+
+#       pragma omp parallel for schedule(dynamic)
+        for ( LidT chunkId = 0; chunkId < chunkCount; ++chunkId )
+        {
+            std::string &out = chunks[ chunkId ];
+            if ( chunkId < patchCount )
+            {
+                PidVector const& population = patchIts[chunkId]->second;
+                Eigen::Vector3f colour( Eigen::Vector3f::Zero() );
+                if ( colourCloud )
+                {
+                    typename _PrimitiveMapT::const_iterator primIt = prims.find( patchIts[chunkId]->first );
+                    if ( primIt != prims.end() && primIt->second.size() )
+                    {
+                        typename std::map<DidT,Eigen::Vector3f>::const_iterator colourIt = colourMap.find( primIt->second[0].getTag(PrimitiveT::TAGS::DIR_GID) );
+                        if ( colourIt != colourMap.end() )
+                            colour = colourIt->second;
+                    }
+                }
+
+                const size_t step = ( maxPointsPerPatch > 0 && population.size() > size_t(maxPointsPerPatch) )
+                                    ? (population.size() + maxPointsPerPatch - 1) / maxPointsPerPatch : 1;
+                out.reserve( population.size() / step * 48 + 32 );
+                beginDots( out, canvas, colour );
+                for ( size_t i = 0; i < population.size(); i += step )
+                    appendDot( out, canvas, points[ population[i] ].template pos().template head<2>(), pageRadius );
+                endDots( out, canvas );
+            }
+            else
+            {
+                const LidT primId = chunkId - patchCount;
+                typename PrimitiveT::ExtremaT extrema;
+                drawn[primId]->template getExtent<PointPrimitiveT>( extrema, points, scale, drawnPopulations[primId] );
+                if ( extrema.size() < 2 )
+                    continue;
+
+                appendPolyline( out, canvas, extrema, drawnColours[primId], 1.f );
+                if ( writeNames )
+                    appendLabel( out, canvas, ((extrema[0] + extrema[1]) / 2.f).template head<2>().template cast<float>()
+                               , drawn[primId]->getTag(PrimitiveT::TAGS::GID), drawn[primId]->getTag(PrimitiveT::TAGS::DIR_GID) );
+            }
+        } //...for chunks
+
+        FILE *fp = fopen( path.c_str(), "wb" );
+        if ( !fp )
+        {
+            std::cerr << "[" << __func__ << "]: " << "could not open " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        size_t contentLength = 0;
+        for ( LidT chunkId = 0; chunkId != chunkCount; ++chunkId )
+            contentLength += chunks[chunkId].size();
+
+        std::string head, tail;
+        std::vector<size_t> offsets; // PDF object offsets
+        if ( canvas.format == SVG )
+        {
+            appendf( head, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.0f\" height=\"%.0f\" viewBox=\"0 0 %.2f %.2f\">\n"
+                   , canvas.width, canvas.height, canvas.width, canvas.height );
+            tail = "</svg>\n";
+        }
+        else
+        {
+            head = "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n";
+            offsets.push_back( head.size() ); head += "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n";
+            offsets.push_back( head.size() ); head += "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n";
+            offsets.push_back( head.size() ); appendf( head, "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] /Contents 4 0 R /Resources << /Font << /F1 5 0 R >> >> >>\nendobj\n", canvas.width, canvas.height );
+            offsets.push_back( head.size() ); appendf( head, "4 0 obj\n<< /Length %lu >>\nstream\n", static_cast<unsigned long>(contentLength) );
+
+            const size_t streamEnd = head.size() + contentLength;
+            tail = "\nendstream\nendobj\n";
+            offsets.push_back( streamEnd + tail.size() ); tail += "5 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Times-Roman >>\nendobj\n";
+
+            const size_t xref = streamEnd + tail.size();
+            appendf( tail, "xref\n0 %lu\n0000000000 65535 f \n", static_cast<unsigned long>(offsets.size() + 1) );
+            for ( size_t i = 0; i != offsets.size(); ++i )
+                appendf( tail, "%010lu 00000 n \n", static_cast<unsigned long>(offsets[i]) );
+            appendf( tail, "trailer\n<< /Size %lu /Root 1 0 R >>\nstartxref\n%lu\n%%%%EOF\n", static_cast<unsigned long>(offsets.size() + 1), static_cast<unsigned long>(xref) );
+        }
+
+        bool ok = fwrite( head.data(), 1, head.size(), fp ) == head.size();
+        for ( LidT chunkId = 0; chunkId != chunkCount && ok; ++chunkId )
+            ok = fwrite( chunks[chunkId].data(), 1, chunks[chunkId].size(), fp ) == chunks[chunkId].size();
+        ok = ok && ( fwrite( tail.data(), 1, tail.size(), fp ) == tail.size() );
+        ok = ( fclose(fp) == 0 ) && ok;
+
+        if ( !ok )
+        {
+            std::cerr << "[" << __func__ << "]: " << "writing " << path << " failed" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "[" << __func__ << "]: " << "wrote " << drawn.size() << " primitives and " << patchCount << " patches to " << path << std::endl;
+        return EXIT_SUCCESS;
+    } //...drawVector()
+
     template <class _PrimitiveMapT, class _PointContainerT, typename _Scalar>
     inline void drawNew( std::ofstream &f, _PrimitiveMapT & prims, _PointContainerT const& points, _Scalar pw = 0.f, std::vector<DidT>* allowedDids = NULL )
     {
@@ -4,7 +4,7 @@
 namespace rapter
 {
     template <class _TrianglesContainer, typename Scalar>
-    int getTrianglesFromObj( _TrianglesContainer & triangles, std::string const& meshPath, Scalar minPlaneEdge = 1. );
+    int getTrianglesFromObj( _TrianglesContainer & triangles, std::string const& meshPath, Scalar minPlaneEdge = 1., std::string const& cacheDir = "" );
 }
 
 
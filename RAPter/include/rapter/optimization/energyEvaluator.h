@@ -0,0 +1,100 @@
+#ifndef RAPTER_ENERGYEVALUATOR_H
+#define RAPTER_ENERGYEVALUATOR_H
+
+#include <vector>
+#include <iostream>
+#include "Eigen/Sparse"
+#include "rapter/simpleTypes.h" // LidT
+
+namespace rapter {
+
+    /*! \brief Evaluates the energy \f$ E(x) = x^T q_o + x^T Q_o x + c \f$ of a formulated problem, broken down to data, pairwise and complexity terms.
+     *
+     *         The complexity term is \f$ w_2 \sum_i x_i \f$, the data term is the rest of the linear objective.
+     *         \f$ Q_o \f$ is stored symmetrised as an adjacency list, so that after \ref setSolution() the energy change of
+     *         setting, flipping or swapping variables is O(1) to query (O(degree) for a swap), and O(degree) to apply.
+     *         This is the inner loop for local search, rounding and solution diagnostics.
+     *  \tparam _Scalar Concept: double, the precision of \ref qcqpcpp::OptProblem.
+     */
+    template <typename _Scalar>
+    class EnergyEvaluator
+    {
+        public:
+            typedef _Scalar                                      Scalar;
+            typedef Eigen::SparseMatrix<_Scalar,Eigen::RowMajor> SparseMatrix;
+            typedef std::vector<_Scalar>                         SolutionT;
+
+            //! \brief Energy terms. Unweighted values are the terms divided by the problem weights.
+            struct Breakdown
+            {
+                    Breakdown() : data( 0 ), pairwise( 0 ), complexity( 0 ), bias( 0 ) {}
+
+                    inline _Scalar total() const { return data + pairwise + complexity + bias; }
+
+                    inline Breakdown& operator+=( Breakdown const& other ) { data += other.data; pairwise += other.pairwise; complexity += other.complexity; bias += other.bias; return *this; }
+
+                    _Scalar data, pairwise, complexity, bias;
+            }; //...Breakdown
+
+            /*! \brief Builds the evaluator from the objective matrices.
+             *  \param[in] qo                Linear objective, a column vector. Contains data and complexity costs.
+             *  \param[in] Qo                Quadratic objective, need not be symmetric.
+             *  \param[in] complexityWeight  Complexity cost per selected variable, \p weights(2) in \ref ProblemSetupParams.
+             *  \param[in] bias              Constant objective offset.
+             */
+            EnergyEvaluator( SparseMatrix const& qo, SparseMatrix const& Qo, _Scalar const complexityWeight, _Scalar const bias = _Scalar(0.) );
+
+            /*! \brief Builds the evaluator from a formulated problem.
+             *  \tparam _OptProblemT Concept: \ref qcqpcpp::OptProblem.
+             */
+            template <class _OptProblemT>
+            EnergyEvaluator( _OptProblemT const& problem, _Scalar const complexityWeight );
+
+            inline LidT getVarCount() const { return _q.size(); }
+
+            //! \brief Energy of \p x, O(#variables + #pairwise terms).
+            inline Breakdown evaluate( SolutionT const& x ) const;
+
+            //! \brief Stores \p x as the current solution, and caches the pairwise field of each variable.
+            inline void setSolution( SolutionT const& x );
+            inline SolutionT const& getSolution()  const { return _x; }
+            inline Breakdown const& getEnergy()    const { return _energy; }
+
+            //! \brief Energy change of setting variable \p i to \p value in the current solution, O(1).
+            inline Breakdown deltaSet ( LidT const i, _Scalar const value ) const;
+            //! \brief Energy change of flipping binary variable \p i in the current solution, O(1).
+            inline Breakdown deltaFlip( LidT const i ) const { return deltaSet( i, _Scalar(1.) - _x[i] ); }
+            //! \brief Energy change of exchanging the values of variables \p i and \p j in the current solution, O(degree).
+            inline Breakdown deltaSwap( LidT const i, LidT const j ) const;
+
+            //! \brief Sets variable \p i to \p value, and updates the current energy, O(degree).
+            inline void applySet ( LidT const i, _Scalar const value );
+            inline void applyFlip( LidT const i ) { applySet( i, _Scalar(1.) - _x[i] ); }
+            inline void applySwap( LidT const i, LidT const j );
+
+            //! \brief Prints \p e in the format of \ref Solver::checkSolution.
+            inline void print( Breakdown const& e, Eigen::Matrix<_Scalar,3,1> const& weights, std::ostream &os = std::cout ) const;
+
+        protected:
+            typedef std::pair<LidT,_Scalar> NeighbourT; //!< \brief < variable id, coefficient of x_i * x_j >
+
+            inline void     _init( SparseMatrix const& Qo );
+            inline _Scalar  _coupling( LidT const i, LidT const j ) const;
+
+            std::vector<_Scalar>        _q;          //!< \brief Linear objective, data plus complexity.
+            std::vector<_Scalar>        _diag;       //!< \brief Diagonal of Qo.
+            std::vector<LidT>           _adjStart;   //!< \brief CSR offsets into _adj, one past the end at the back.
+            std::vector<NeighbourT>     _adj;        //!< \brief Off-diagonal couplings ( Qo(i,j) + Qo(j,i) ), sorted by id per variable.
+            _Scalar                     _complexity;
+            _Scalar                     _bias;
+
+            SolutionT                   _x;          //!< \brief Current solution.
+            std::vector<_Scalar>        _field;      //!< \brief Sum of couplings to the current solution for each variable.
+            Breakdown                   _energy;     //!< \brief Energy of the current solution.
+    }; //...class EnergyEvaluator
+
+} //...namespace rapter
+
+#include "rapter/optimization/impl/energyEvaluator.hpp"
+
+#endif // RAPTER_ENERGYEVALUATOR_H
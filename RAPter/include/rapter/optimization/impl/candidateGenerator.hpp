@@ -25,77 +25,72 @@ namespace rapter
 {
     namespace cgen
     {
-        template <typename _PrimitiveT, typename _PrimitiveContainerT>
-        struct FilterChosenFunctor
+        /*! \brief Ranks promoted patches by the expected utility of their candidates, so that \ref CandidateGenerator::generate() can spend a variable budget on the best ones first.
+         *
+         *         utility = population * (1 + support) / (1 + residual / scale), where
+         *         population is the number of points assigned to the patch,
+         *         residual is their mean distance from the patch primitive, and
+         *         support is the number of senders (large primitives), whose direction the patch could receive at one of the desired angles.
+         *  \param[out] ranks      Promoted patches descending by utility, ties broken by <gid,lid>.
+         *  \param[in]  promoted   Patches promoted in this iteration, <gid,lid> indexes into \p inPrims.
+         */
+        template <class _PrimitivePrimitiveAngleFunctorT, class _PrimitiveT, typename _Scalar, class _PrimitiveContainerT, class _PointContainerT, class _PopulationsT>
+        inline void rankPromoted( std::vector< std::pair<_Scalar,GidLid> >       & ranks
+                                , std::set<GidLid>                          const& promoted
+                                , _PrimitiveContainerT                      const& inPrims
+                                , _PointContainerT                          const& points
+                                , _PopulationsT                             const& populations
+                                , AnglesT                                   const& angles
+                                , _Scalar                                   const  angle_limit
+                                , _Scalar                                   const  scale
+                                , bool                                      const  allowPromoted )
         {
-            typedef std::pair<GidT,LidT> GidLid;
-
-            inline FilterChosenFunctor( _PrimitiveContainerT &out_prims, std::set<GidLid> const& chosen, std::set<GidLid> const& promoted )
-                : _out_prims( out_prims )
-                , _chosen( chosen )
-                , _promoted( promoted )
-            {
-                if ( out_prims.size() )
-                    std::cerr << "[" << __func__ << "]: " << "out_prims not empty...it was assumed to be empty..." << std::endl;
-            }
-
-            inline LidT eval( _PrimitiveT const& prim, LidT lid )
+            ranks.clear();
+            ranks.reserve( promoted.size() );
+            for ( auto pit = promoted.begin(); pit != promoted.end(); ++pit )
             {
-                const GidT gid = prim.getTag(_PrimitiveT::TAGS::GID);
-                //const GidLid gidLid( gid, lid );
+                _PrimitiveT const& prim0 = inPrims.at( pit->first ).at( pit->second );
 
-                // all promoted, and their derivatives fail here, since they have it set to the original lid
-                bool keep   = prim.getTag(_PrimitiveT::USER_ID1) == _PrimitiveT::TAG_UNSET;
-                bool demote = false; // flipped to true, if unchoosen promoted patch, that needs to be demoted to small, and put into output
-                if ( !keep )
+                // population and fit residual
+                _Scalar residual( 0. );
+                LidT    population = 0;
+                auto const popIt = populations.find( pit->first );
+                if ( popIt != populations.end() && popIt->second.size() )
                 {
-                    // receiver needs to be chosen, if receiver was promoted
-                    keep |= _chosen.find( GidLid(gid,prim.getTag(_PrimitiveT::USER_ID1)) ) != _chosen.end();
-
-                    if ( !keep )
-                    {
-                        // the original patch was promoted, and not chosen, so we need to demote it, and put it back
-//                        std::cout << "skip: gid:" << prim.getTag(_PrimitiveT::TAGS::GID) << ", lid: " << lid
-//                                  << ", tag1: " << prim.getTag(_PrimitiveT::USER_ID1)
-//                                  << ", active: " << prim.getTag(_PrimitiveT::TAGS::STATUS)
-//                                  << std::endl;
-                        if ( lid == prim.getTag(_PrimitiveT::USER_ID1) ) // this is the original promoted patch
-                        {
-                            demote = true;
-                            keep = true;
-                        }
-                    }
-//                    else
-//                        std::cout << "KEEP: gid:" << prim.getTag(_PrimitiveT::TAGS::GID) << ", lid: " << lid << ", tag1: " << prim.getTag(_PrimitiveT::USER_ID1) << std::endl;
-
-                    if ( prim.getTag(_PrimitiveT::TAGS::STATUS) != _PrimitiveT::STATUS_VALUES::UNSET )
-                        std::cout << "[" << __func__ << "]: " << "status should not be " << prim.getTag(_PrimitiveT::TAGS::STATUS) << ", it should be UNSET" << std::endl;
+                    population = popIt->second.size();
+                    for ( auto pidIt = popIt->second.begin(); pidIt != popIt->second.end(); ++pidIt )
+                        residual += prim0.getDistance( points[*pidIt].template pos() );
+                    residual /= _Scalar( population );
                 }
 
-                //bool patch_promoted = std::find_if( _promoted.begin(), _promoted.end(), [&gid](GidLid const& e){return e.first == gid;} ) != _promoted.end();
-                //bool patch_chosen = std::find_if( _chosen.begin(), _chosen.end(), [&gid](GidLid const& e){return e.first == gid;} ) != _chosen.end();
-
-                //if ( !patch_promoted || patch_chosen ) // add, if not promoted, or if promoted and chosen
-                if ( keep )
+                // direction support
+                LidT support = 0;
+                for ( auto outerIt = inPrims.begin(); outerIt != inPrims.end(); ++outerIt )
                 {
-                    _PrimitiveT &added = containers::add( _out_prims, gid, prim );
-                    if ( demote )
-                        added.setTag( _PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::SMALL );
-
-                    return notSMALL( added );
+                    LidT lid1 = 0;
+                    for ( auto innerIt = outerIt->second.begin(); innerIt != outerIt->second.end(); ++innerIt, ++lid1 )
+                    {
+                        if ( isSMALL((*innerIt)) || (GidLid(outerIt->first,lid1) == *pit) )
+                            continue;
+                        if ( !allowPromoted && isPROMOTED(outerIt->first,lid1) )
+                            continue;
+                        if ( _PrimitivePrimitiveAngleFunctorT::template eval<_Scalar>(prim0, *innerIt, angles) < angle_limit )
+                            ++support;
+                    }
                 }
 
-                return 0;
-            }
+                ranks.push_back( std::pair<_Scalar,GidLid>( _Scalar(population) * _Scalar(1 + support) / (_Scalar(1.) + residual / scale), *pit ) );
+            } //...for promoted
 
-            _PrimitiveContainerT &_out_prims;
-            std::set<GidLid> const &_chosen, &_promoted;
-        };
-    }
+            std::sort( ranks.begin(), ranks.end(), []( std::pair<_Scalar,GidLid> const& a, std::pair<_Scalar,GidLid> const& b )
+                                                   { return (a.first > b.first) || ((a.first == b.first) && (a.second < b.second)); } );
+        } //...rankPromoted()
+    } //...ns cgen
 
     template <class _PrimitiveT, class _PrimitiveContainerT, class _GeneratedT, class _CopiedT, class _PromotedT>
     inline bool output( _PrimitiveT & cand, _PrimitiveContainerT &out_prims, _GeneratedT &generated, _CopiedT &copied, LidT &nlines
-                      , _PromotedT const& promoted, GidT const gid, LidT const lid0, int const closest_angle_id, typename _PrimitiveT::Scalar const genAngle )
+                      , _PromotedT const& promoted, GidT const gid, LidT const lid0, int const closest_angle_id, typename _PrimitiveT::Scalar const genAngle
+                      , LidT const varLimit = 0 )
     {
         typedef typename _PrimitiveT::Scalar Scalar;
 
@@ -119,6 +114,10 @@ namespace rapter
             } //...if same dId
         } //...for all prims in this patch (gId)
 
+        // no budget left for a new candidate
+        if ( (varLimit > 0) && (nlines >= varLimit) )
+            return false;
+
         // This is a new candidate, make sure formulate knows that
         cand.setTag( _PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::UNSET );
         // Make sure variable scheduling can find this candidate based on lid0
@@ -158,6 +157,7 @@ namespace rapter
      *  \param[in/out] generated        Records, how many extra candidates the input primitive generated in the output.
      *  \param[in/out] nLines           Keeps track of overall output size.
      *  \param[in/out] aliases          Keeps track of diretion ids and their assigned generator angles. If not set, not enabled. NULL is used at the second phase, when aliases are added.
+     *  \param[in]     varLimit         Nothing is added, once nLines reached this. Default: 0, meaning no limit.
      */
     template < class _PrimitivePrimitiveAngleFunctorT, class _AliasesT
              , class _PrimitiveT, typename _Scalar, class _AnglesT, class _PromotedT
@@ -182,10 +182,14 @@ namespace rapter
                            , _AliasesT               * aliases
                            , bool               const  tripletSafe  = false
                            , bool               const  verbose      = false
+                           , LidT               const  varLimit     = 0
                            )
     {
         typedef typename _PointContainerT::value_type PointPrimitiveT;
 
+        if ( (varLimit > 0) && (nLines >= varLimit) )
+            return false;
+
         const GidT gid0     = prim0.getTag( _PrimitiveT::TAGS::GID );
         const GidT gid1     = prim1.getTag( _PrimitiveT::TAGS::GID );
         const DidT dir_gid0 = prim0.getTag( _PrimitiveT::TAGS::DIR_GID );
@@ -389,7 +393,7 @@ namespace rapter
         if ( doOutput )
         {
             if ( generators.size() > 1 ) { throw new CandidateGeneratorException("[addCandidate] generators.size > 1, are you sure about this?"); }
-            added0 = output( cand0, out_prims, generated, copied, nLines, promoted, gid0, lid0, closest_angle_id0, generators.size() ? generators[0] : _PrimitiveT::GEN_ANGLE_VALUES::UNSET );
+            added0 = output( cand0, out_prims, generated, copied, nLines, promoted, gid0, lid0, closest_angle_id0, generators.size() ? generators[0] : _PrimitiveT::GEN_ANGLE_VALUES::UNSET, varLimit );
             if ( gid0 == 50 || gid1 == 50 )
                 std::cout << "adding at " << gid0 << "," << dir_gid0 << " from " << gid1  << ", " << dir_gid1 << std::endl;
         }
@@ -492,7 +496,6 @@ namespace rapter
         typedef typename InnerContainerT::const_iterator                   inner_const_iterator;
         typedef typename InnerContainerT::iterator                         inner_iterator;
         typedef          std::map< GidLid, LidT >                          GeneratedMapT;
-        typedef          std::pair<std::pair<GidT,LidT>,unsigned long>     GeneratedEntryT;
         typedef          containers::PrimitiveContainer<_PrimitiveT>       PrimitiveMapT; //!< Iterable by single loop using PrimitiveMapT::Iterator
 
         // cache, so that it can be turned off
@@ -529,6 +532,7 @@ namespace rapter
         // upgrade primitives to large, and copy large primitives to output
         // added on 21/09/2014 by Aron
         std::set<GidLid> promoted; // Contains primitives, that were small, but now are large (active)
+        std::map<GidLid,LidT> promotedOut; // position of the promoted primitives' copies in outPrims[gid]
         const _Scalar smallThresh = smallThreshMult * scale;
         {
             Eigen::Matrix<_Scalar,Eigen::Dynamic,1> spatialSignif(1,1); // cache variable
@@ -598,6 +602,7 @@ namespace rapter
                         {
                             ++generated[ GidLid(gid,lid) ]; // receiver
                             added.setTag( _PrimitiveT::USER_ID1, lid ); // make sure, we can withdraw this later
+                            promotedOut[ GidLid(gid,lid) ] = outPrims[gid].size() - 1;
                         }
 
                         // update output count
@@ -708,48 +713,160 @@ namespace rapter
         // _________ (3) generation _________
         if ( verbose ) { std::cout << "[" << __func__ << "]: " << "generate start" << std::endl; fflush(stdout); }
 
+        // With a variable limit, candidates at actives are generated first, since they can't be withdrawn (3.1).
+        // Aliases found among the actives, and their copies at actives are kept whatever the budget, so they count towards the actives as well.
+        // Promoted patches then receive their candidates in the order of their expected utility, until the budget is used up (3.2).
+        // If the actives reach the limit on their own, the state is rolled back, and everything is generated without limit, as it used to be.
+        const bool       budgeted    = var_limit > 0;
+        bool             activesOnly = budgeted;
+        bool             overBudget  = false;
+        std::set<GidLid> admitted; // promoted patches that fit into the budget
+        std::set<GidLid> demoted;  // promoted patches that did not fit into the budget
+        int              ret         = EXIT_SUCCESS;
+
+        // rollback state for overBudget
+        _PrimitiveContainerT                outPrimsIn;
+        std::map< GidT, std::set<DidAid> >  copiedIn;
+        GeneratedMapT                       generatedIn;
+        AliasesT<_PrimitiveT,_Scalar>       aliasesIn;
+        std::map<DidT,AnglesT>              allowedAnglesIn;
+        const LidT                          nlinesIn = nlines;
+        if ( budgeted )
+        {
+            outPrimsIn      = outPrims;
+            copiedIn        = copied;
+            generatedIn     = generated;
+            aliasesIn       = aliases;
+            allowedAnglesIn = allowedAngles;
+        }
+
         DidT maxDid = 0; // collects currently existing maximum cluster id (!small, active, all!)
 
         GidT gid0, gid1, dir_gid0, dir_gid1, lid0, lid1;
         gid0 = gid1 = dir_gid0 = dir_gid1 = _PrimitiveT::TAG_UNSET; // group tags cached
-        for ( outer_const_iterator outer_it0  = inPrims.begin(); outer_it0 != inPrims.end(); ++outer_it0 )
+
+        // aliases: [did][angle] = AliasT( gid, lid, prim )
+        std::set< std::pair<DidT,_Scalar> >            processedAliases; // aliases already emitted, or skipped for lack of budget
+        std::vector< std::pair<_PrimitiveT,LidT> >     emittedAliases;   // alias primitives with their new did, and the lid of their receiver
+
+        // Adds the alias as a new direction at its receiver, and allows its generator angle. limit: 0 means no limit. \return false, if there was no budget.
+        auto emitAlias = [&]( typename AliasesT<_PrimitiveT,_Scalar>::mapped_type::value_type const& angleAlias, LidT const limit, _PrimitiveT &prim0 ) -> bool
+        {
+            if ( (limit > 0) && (nlines >= limit) )
+                return false;
+
+            // copy original primitive
+            prim0 = *( angleAlias.second._prim );
+            const DidT did = ++maxDid;
+            prim0.setTag( _PrimitiveT::TAGS::DIR_GID, did );
+            const GidT gid0 = angleAlias.second._gid;
+            const LidT lid0 = angleAlias.second._lid;
+
+            if ( !output( prim0, outPrims, generated, copied, nlines, promoted, gid0, lid0, 0, prim0.getTag(_PrimitiveT::TAGS::GEN_ANGLE)) )
+            {
+                std::cerr << "Alias could not be added" << std::endl;
+                throw new CandidateGeneratorException("Alias could not be added");
+            } //...if could not output
+            else
+                if ( verbose ) std::cout << "\nAdded alias to " << angleAlias.second._prim->getTag(_PrimitiveT::TAGS::DIR_GID)
+                          << " as " << outPrims[gid0].back().toString()
+                          << " <" << outPrims[gid0].back().getTag( _PrimitiveT::TAGS::GID ) << ","
+                          << outPrims[gid0].back().getTag( _PrimitiveT::TAGS::DIR_GID ) << ">"
+                          << std::endl;
+
+            // record allowed alias
+            AnglesT tmpGenerators( {angleAlias.first} );
+            angles::appendAnglesFromGenerators( /*        out: */ allowedAngles[ did ]
+                                              , /* generators: */ tmpGenerators
+                                              , /*   no_paral: */ false
+                                              , /*    verbose: */ false
+                                              , /*      inRad: */ true );
+            return true;
+        }; //...emitAlias()
+
+        // Copies the alias prim0 to all compatible receivers given allowedAngles.
+        // anyReceiver: all receivers, otherwise only actives and admitted promoted patches. limit: 0 means no limit.
+        auto copyAlias = [&]( _PrimitiveT const& prim0, LidT const lid0, bool const anyReceiver, LidT const limit )
         {
-            gid0 = -2; // -1 is unset, -2 is unread
-            lid0 =  0;
-            for ( inner_const_iterator inner_it0  = (*outer_it0).second.begin(); inner_it0 != (*outer_it0).second.end(); ++inner_it0, ++lid0 )
+            for ( outer_const_iterator outer_it  = inPrims.begin(); outer_it != inPrims.end(); ++outer_it )
             {
-                // cache outer primitive
-                _PrimitiveT const& prim0 = *inner_it0;
-                dir_gid0                 = prim0.getTag( _PrimitiveT::TAGS::DIR_GID );
+                LidT lid1 = 0;
+                for ( inner_const_iterator inner_it = (*outer_it).second.begin(); inner_it != (*outer_it).second.end(); ++inner_it, ++lid1 )
+                {
+                    // cache outer primitive
+                    _PrimitiveT const& prim1 = *inner_it;
 
-                if ( dir_gid0 > maxDid ) maxDid = dir_gid0; // small, active, uninited!
+                    if ( !anyReceiver && isPROMOTED(outer_it->first,lid1) && (admitted.find(GidLid(outer_it->first,lid1)) == admitted.end()) )
+                        continue;
 
-                // cache group id of patch at first member
-                     if ( gid0 == -2               )  gid0 = prim0.getTag( _PrimitiveT::TAGS::GID ); // store gid of first member in patch
-                else if ( gid0 != outer_it0->first )  std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID..." << std::endl;
+                    addCandidate<_PrimitivePrimitiveAngleFunctorT,AliasesT<_PrimitiveT,_Scalar> >(
+                        prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
+                        allowedAngles, copied, generated, nlines, outPrims, points, scale, nullptr, tripletSafe, verbose, limit );
+                } //...inner for
+            } //...outer for
+        }; //...copyAlias()
 
-                for ( outer_const_iterator outer_it1  = outer_it0; outer_it1 != inPrims.end(); ++outer_it1 )
+        // Emits the aliases, that were not emitted yet, and copies them to actives (and admitted promoted patches). limit: 0 means no limit.
+        auto emitNewAliases = [&]( LidT const limit )
+        {
+            for ( auto aliasIt = aliases.begin(); aliasIt != aliases.end(); ++aliasIt )
+                for ( auto angleIt = aliasIt->second.begin(); angleIt != aliasIt->second.end(); ++angleIt )
                 {
-                    gid1 = -2; // -1 is unset, -2 is unread
-                    lid1 = 0;
-                    for ( inner_const_iterator inner_it1  = (outer_it0 == outer_it1) ? ++inner_const_iterator( inner_it0 )
-                                                                                     : (*outer_it1).second.begin();
-                                               inner_it1 != (*outer_it1).second.end();
-                                             ++inner_it1, ++lid1 )
+                    if ( !processedAliases.insert( std::make_pair(aliasIt->first, angleIt->first) ).second )
+                        continue;
+
+                    _PrimitiveT prim0;
+                    if ( emitAlias(*angleIt, limit, prim0) )
                     {
-                        // cache inner primitive
-                        _PrimitiveT const& prim1 = containers::valueOf<_PrimitiveT>( inner_it1 );
+                        copyAlias( prim0, angleIt->second._lid, /* anyReceiver: */ false, limit );
+                        emittedAliases.push_back( std::make_pair(prim0, LidT(angleIt->second._lid)) );
+                    }
+                }
+        }; //...emitNewAliases()
 
-                        // cache group id of patch at first member
-                             if ( gid1 == -2               )    gid1 = prim1.getTag( _PrimitiveT::TAGS::GID );
-                        else if ( gid1 != outer_it1->first )    std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID in inner loop..." << std::endl;
+        for ( bool pass = true; pass; )
+        {
+            pass = false;
+            for ( outer_const_iterator outer_it0  = inPrims.begin(); outer_it0 != inPrims.end(); ++outer_it0 )
+            {
+                gid0 = -2; // -1 is unset, -2 is unread
+                lid0 =  0;
+                for ( inner_const_iterator inner_it0  = (*outer_it0).second.begin(); inner_it0 != (*outer_it0).second.end(); ++inner_it0, ++lid0 )
+                {
+                    // cache outer primitive
+                    _PrimitiveT const& prim0 = *inner_it0;
+                    dir_gid0                 = prim0.getTag( _PrimitiveT::TAGS::DIR_GID );
 
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-                                    prim0, prim1, lid0, lid1, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-                                    prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
+                    if ( dir_gid0 > maxDid ) maxDid = dir_gid0; // small, active, uninited!
+
+                    // cache group id of patch at first member
+                         if ( gid0 == -2               )  gid0 = prim0.getTag( _PrimitiveT::TAGS::GID ); // store gid of first member in patch
+                    else if ( gid0 != outer_it0->first )  std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID..." << std::endl;
+
+                    for ( outer_const_iterator outer_it1  = outer_it0; outer_it1 != inPrims.end(); ++outer_it1 )
+                    {
+                        gid1 = -2; // -1 is unset, -2 is unread
+                        lid1 = 0;
+                        for ( inner_const_iterator inner_it1  = (outer_it0 == outer_it1) ? ++inner_const_iterator( inner_it0 )
+                                                                                         : (*outer_it1).second.begin();
+                                                   inner_it1 != (*outer_it1).second.end();
+                                                 ++inner_it1, ++lid1 )
+                        {
+                            // cache inner primitive
+                            _PrimitiveT const& prim1 = containers::valueOf<_PrimitiveT>( inner_it1 );
+
+                            // cache group id of patch at first member
+                                 if ( gid1 == -2               )    gid1 = prim1.getTag( _PrimitiveT::TAGS::GID );
+                            else if ( gid1 != outer_it1->first )    std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID in inner loop..." << std::endl;
+
+                            if ( !activesOnly || notPROMOTED(gid0,lid0) )
+                                addCandidate<_PrimitivePrimitiveAngleFunctorT>(
+                                            prim0, prim1, lid0, lid1, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
+                                            allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
+                            if ( !activesOnly || notPROMOTED(gid1,lid1) )
+                                addCandidate<_PrimitivePrimitiveAngleFunctorT>(
+                                            prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
+                                            allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
 
 //#warning "wasteful 19/4/2015"
 
@@ -761,148 +878,143 @@ namespace rapter
 //                                    prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, tmpAngles, angle_gens_in_rad, promoted,
 //                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
 
-                    } //...for l3
-                } //...for l2
-            } //...for l1
-        } //...for l0
-        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "generate end" << std::endl; fflush(stdout); }
+                        } //...for l3
+                    } //...for l2
+                } //...for l1
+            } //...for l0
 
-        // ___________ (4) ALIASES _______________
-        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "alias start" << std::endl; fflush(stdout); }
+            if ( !activesOnly )
+                break;
 
-        // [did][angle] = AliasT( gid, lid, prim )
-        for ( auto aliasIt = aliases.begin(); aliasIt != aliases.end(); ++aliasIt )
-        {
-            // first: dir_gid
-            // second: std::map<angle, AliasT>
-            for ( auto angleIt = aliasIt->second.begin(); angleIt != aliasIt->second.end(); ++angleIt )
+            // (3.1) aliases of the actives, kept at actives without limit
+            emitNewAliases( 0 );
+
+            // don't limit, if the actives alone were exceeding the limit...
+            const LidT activeCount = nlines - LidT(promoted.size()); // promoted patches' own copies are not fixed
+            if ( activeCount >= var_limit )
             {
-                // first: angle
-                // second: AliasT
+                std::cerr << "[" << __func__ << "]: " << "!!!!!!!! ALL " << nlines << " ACTIVE or ACTIVEs " << activeCount << " > " << var_limit << " var_limit, cannot limit vars! !!!!!!! Increase --small-thresh-mult please." << std::endl;
+                outPrims      = outPrimsIn;
+                copied        = copiedIn;
+                generated     = generatedIn;
+                aliases       = aliasesIn;
+                allowedAngles = allowedAnglesIn;
+                nlines        = nlinesIn;
+                maxDid        = 0;
+                processedAliases.clear();
+                emittedAliases  .clear();
+                activesOnly   = false;
+                overBudget    = true;
+                pass          = true;
+            }
+        } //...for pass
 
-                // copy original primitive
-                _PrimitiveT prim0 = *( angleIt->second._prim );
-                const DidT did = ++maxDid;
-                prim0.setTag( _PrimitiveT::TAGS::DIR_GID, did );
-                const GidT gid0 = angleIt->second._gid;
-                const LidT lid0 = angleIt->second._lid;
+        // (3.2) promoted receivers within the budget
+        if ( overBudget )
+        {
+            ret = -1;
+            // demote!
+            LidT demotedCount = 0;
+            for ( auto pit = promoted.begin(); pit != promoted.end(); ++pit )
+            {
+                _PrimitiveT &prim = inPrims.at( (*pit).first  )
+                                           .at( (*pit).second );
 
-                if ( !output( prim0, outPrims, generated, copied, nlines, promoted, gid0, lid0, 0, prim0.getTag(_PrimitiveT::TAGS::GEN_ANGLE)) )
-                {
-                    std::cerr << "Alias could not be added" << std::endl;
-                    throw new CandidateGeneratorException("Alias could not be added");
-                } //...if could not output
+                if ( prim.getTag(_PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::ACTIVE )
+                    std::cerr << "demoting active " << prim.getTag(_PrimitiveT::TAGS::GID) << "(gid) ????" << std::endl;
                 else
-                    if ( verbose ) std::cout << "\nAdded alias to " << angleIt->second._prim->getTag(_PrimitiveT::TAGS::DIR_GID)
-                              << " as " << outPrims[gid0].back().toString()
-                              << " <" << outPrims[gid0].back().getTag( _PrimitiveT::TAGS::GID ) << ","
-                              << outPrims[gid0].back().getTag( _PrimitiveT::TAGS::DIR_GID ) << ">"
-                              << std::endl;
-
-                // record allowed alias
-                AnglesT tmpGenerators( {angleIt->first} );
-                angles::appendAnglesFromGenerators( /*        out: */ allowedAngles[ did ]
-                                                  , /* generators: */ tmpGenerators
-                                                  , /*   no_paral: */ false
-                                                  , /*    verbose: */ false
-                                                  , /*      inRad: */ true );
-
-                // add all allowed copies
-                for ( outer_const_iterator outer_it  = inPrims.begin(); outer_it != inPrims.end(); ++outer_it )
-                {
-                    lid1 =  0;
-                    for ( inner_const_iterator inner_it = (*outer_it).second.begin(); inner_it != (*outer_it).second.end(); ++inner_it, ++lid1 )
-                    {
-                        // cache outer primitive
-                        _PrimitiveT const& prim1 = *inner_it;
-
-                        // copy prim0 (the alias) to all compatible receivers given allowedAngles.
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT,AliasesT<_PrimitiveT,_Scalar> >(
-                            prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                            allowedAngles, copied, generated, nlines, outPrims, points, scale, nullptr, tripletSafe, verbose );
-
-                    } //...inner for
-                } //...outer for
-            } //...for all angles
-        } //...for all aliases
-        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "alias end" << std::endl; fflush(stdout); }
+                    ++demotedCount;
 
-        // ___________ (5) LIMIT VARIABLES _______________
-        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "limit vars start" << std::endl; fflush(stdout); }
-        int ret = EXIT_SUCCESS;
-        if ( (var_limit > 0) && (nlines > var_limit) )
+                prim.setTag(_PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::SMALL);
+            }
+            std::cout << "[" << __func__ << "]: " << "demoted " << demotedCount << " primitives" << std::endl;
+        }
+        else if ( budgeted )
         {
-            LidT active_count = nlines; // records how many variables actives generated among themselves, these we cannot filter
+            // variables of actives and their candidates and aliases, these we cannot withdraw
+            const LidT fixedCount = nlines - promoted.size();
+            std::vector< std::pair<_Scalar,GidLid> > ranks;
+            cgen::rankPromoted<_PrimitivePrimitiveAngleFunctorT,_PrimitiveT>( ranks, promoted, inPrims, points, populations, angles, angle_limit, scale, allowPromoted );
 
-            // (1) sort promoted patches descending based on how many variables they generated
-            // in: generated, containing < <gid,lid> , generated count> entries for promoted locations only (no actives)
-            // out: ranks, containing a sorted list of generated
-            std::vector< GeneratedEntryT > ranks;
-            for ( auto it = generated.begin(); it != generated.end(); ++it )
-            {
-                // in_lines[it.first.first][it.first.second].getTag( _PrimitiveT::TAGS::STATUS ) )
-                //if ( promoted.find( GidLid(it->first) ) != promoted.end() )
+            // withdraw all promoted copies, and readmit them by rank, as long as there is budget
+            for ( auto pit = promoted.begin(); pit != promoted.end(); ++pit )
+                outPrims.at( pit->first ).at( promotedOut.at(*pit) ).setTag( _PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::SMALL );
+            nlines = fixedCount;
 
-                ranks.push_back( *it );
-                active_count -= it->second;
+            for ( size_t rank = 0; rank != ranks.size(); ++rank )
+            {
+                const GidLid receiver = ranks[rank].second;
+                if ( nlines >= var_limit )
+                {
+                    demoted.insert( receiver );
+                    continue;
+                }
 
-                // was promoted
-                // std::cout << "[" << __func__ << "]: " << "promoted[" << it->first.first << "," << it->first.second << "] generated " << it->second << std::endl;
-            }
+                outPrims.at( receiver.first ).at( promotedOut.at(receiver) ).setTag( _PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::UNSET );
+                admitted.insert( receiver );
+                ++nlines;
 
-            // don't do this, if the actives alone were exceeding the limit...
-            if ( active_count >= var_limit )
-            {
-                std::cerr << "[" << __func__ << "]: " << "!!!!!!!! ALL " << nlines << " ACTIVE or ACTIVEs " << active_count << " > " << var_limit << " var_limit, cannot limit vars! !!!!!!! Increase --small-thresh-mult please." << std::endl;
-                ret = -1;
-                // demote!
-                LidT demoted = 0;
-                for ( auto pit = promoted.begin(); pit != promoted.end(); ++pit )
+                // candidates from all senders
+                _PrimitiveT const& prim0 = inPrims.at( receiver.first ).at( receiver.second );
+                for ( outer_const_iterator outer_it1 = inPrims.begin(); (outer_it1 != inPrims.end()) && (nlines < var_limit); ++outer_it1 )
                 {
-                    _PrimitiveT &prim = inPrims.at( (*pit).first  )
-                                               .at( (*pit).second );
+                    lid1 = 0;
+                    for ( inner_const_iterator inner_it1 = (*outer_it1).second.begin(); (inner_it1 != (*outer_it1).second.end()) && (nlines < var_limit); ++inner_it1, ++lid1 )
+                    {
+                        if ( GidLid(outer_it1->first,lid1) == receiver )
+                            continue;
 
-                    if ( prim.getTag(_PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::ACTIVE )
-                        std::cerr << "demoting active " << prim.getTag(_PrimitiveT::TAGS::GID) << "(gid) ????" << std::endl;
-                    else
-                        ++demoted;
+                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
+                                    prim0, *inner_it1, receiver.second, lid1, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
+                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose, var_limit );
+                    } //...for senders
+                } //...for sender patches
+
+                // copies of the aliases so far
+                for ( size_t i = 0; (i != emittedAliases.size()) && (nlines < var_limit); ++i )
+                    addCandidate<_PrimitivePrimitiveAngleFunctorT,AliasesT<_PrimitiveT,_Scalar> >(
+                                prim0, emittedAliases[i].first, receiver.second, emittedAliases[i].second, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
+                                allowedAngles, copied, generated, nlines, outPrims, points, scale, nullptr, tripletSafe, verbose, var_limit );
+
+                // aliases found by this receiver, they and their copies count against the budget
+                emitNewAliases( var_limit );
+            } //...for ranks
+
+            // return remaining variable count
+            ret = demoted.size();
+            if ( !promoted.empty() )
+                std::cout << "[" << __func__ << "]: " << "kept " << admitted.size() << "/" << promoted.size() << " promoted patches within var_limit " << var_limit << std::endl;
+        } //...if budgeted
+        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "generate end" << std::endl; fflush(stdout); }
 
-                    prim.setTag(_PrimitiveT::TAGS::STATUS, _PrimitiveT::STATUS_VALUES::SMALL);
-                }
-                std::cout << "[" << __func__ << "]: " << "demoted " << demoted << " primitives" << std::endl;
-            }
-            else
+        // ___________ (4) ALIASES _______________
+        // With a budget, aliases were emitted with the patches that found them in (3.1) and (3.2).
+        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "alias start" << std::endl; fflush(stdout); }
+        if ( !budgeted || overBudget )
+        {
+            // [did][angle] = AliasT( gid, lid, prim )
+            for ( auto aliasIt = aliases.begin(); aliasIt != aliases.end(); ++aliasIt )
             {
-                // sort descending:
-                std::sort( ranks.begin(), ranks.end(), [](GeneratedMapT::value_type const& a, GeneratedMapT::value_type const& b){ return a.second > b.second;} );
-
-                // (2) Select entries, that get to stay promoted
-                // in: ranks, containing a descending list of variable counts
-                // out: chosen, a list of promoted locations, that should stay promoted in out_prims, others should be demoted back
-                //std::cout << "[" << __func__ << "]: " << "var_limit: " << var_limit << ", active: " << active_count << ", nlines: " << nlines << std::endl;
-                std::set< GidLid > chosen;
+                // first: dir_gid
+                // second: std::map<angle, AliasT>
+                for ( auto angleIt = aliasIt->second.begin(); angleIt != aliasIt->second.end(); ++angleIt )
                 {
-                    LidT vars = active_count;
-                    for ( ULidT i = 0; i != ranks.size(); ++i )
-                    {
-                        vars += ranks[i].second;
-                        if ( vars <= var_limit )
-                        {
-                            chosen.insert( ranks[i].first );
-                        }
-                    }
-                }
+                    // first: angle
+                    // second: AliasT
+                    _PrimitiveT prim0;
+                    emitAlias( *angleIt, /* limit: */ 0, prim0 );
+
+                    // add all allowed copies
+                    copyAlias( prim0, angleIt->second._lid, /* anyReceiver: */ true, /* limit: */ 0 );
+                } //...for all angles
+            } //...for all aliases
+        } //...if not budgeted
+        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "alias end" << std::endl; fflush(stdout); }
 
-                // (3) Filter out_prims based on chosen
-                //
-                auto tmp = outPrims; outPrims.clear();
-                cgen::FilterChosenFunctor<_PrimitiveT, _PrimitiveContainerT> functor( outPrims, chosen, promoted );
-                nlines = processing::filterPrimitives<_PrimitiveT, InnerContainerT>( tmp, functor );
-                // return remaining variable count
-                ret = ranks.size() - chosen.size();
-            } // if too many actives already
-        } // filter
-        if ( verbose ) { std::cout << "[" << __func__ << "]: " << "limit vars end" << std::endl; fflush(stdout); }
+        // ___________ (5) LIMIT VARIABLES _______________
+        // The budget was enforced during generation in (3.1) and (3.2), only report here.
+        if ( budgeted && (ret != -1) && (nlines > var_limit) )
+            std::cerr << "[" << __func__ << "]: " << "generated " << nlines << " > " << var_limit << " var_limit variables, should not happen" << std::endl;
 
         // ___________ (6) Make sure allowed angles stick _______________
         if ( verbose ) { std::cout << "[" << __func__ << "]: " << "allowed start" << std::endl; fflush(stdout); }
@@ -0,0 +1,182 @@
+#ifndef RAPTER_ENERGYEVALUATOR_HPP
+#define RAPTER_ENERGYEVALUATOR_HPP
+
+#include <algorithm>                             // sort, lower_bound
+#include <iomanip>                               // setprecision
+#include <limits>
+#include "rapter/optimization/energyEvaluator.h"
+
+namespace rapter {
+
+template <typename _Scalar>
+EnergyEvaluator<_Scalar>::EnergyEvaluator( SparseMatrix const& qo, SparseMatrix const& Qo, _Scalar const complexityWeight, _Scalar const bias )
+    : _q( std::max(qo.rows(),Qo.rows()), _Scalar(0.) ), _complexity( complexityWeight ), _bias( bias )
+{
+    for ( int row = 0; row < qo.outerSize(); ++row )
+        for ( typename SparseMatrix::InnerIterator it(qo,row); it; ++it )
+            _q[ it.row() ] += it.value();
+
+    this->_init( Qo );
+} //...EnergyEvaluator()
+
+template <typename _Scalar>
+template <class _OptProblemT>
+EnergyEvaluator<_Scalar>::EnergyEvaluator( _OptProblemT const& problem, _Scalar const complexityWeight )
+    : _q( problem.getVarCount(), _Scalar(0.) ), _complexity( complexityWeight ), _bias( problem.getObjectiveBias() )
+{
+    for ( size_t j = 0; j != problem.getLinObjectives().size() && j != _q.size(); ++j )
+        _q[j] = problem.getLinObjectives()[j];
+
+    this->_init( problem.getQuadraticObjectivesMatrix().template cast<_Scalar>() );
+} //...EnergyEvaluator()
+
+//! \brief Splits \p Qo to diagonal and symmetrised off-diagonal entries, and stores the latter in CSR order.
+template <typename _Scalar> inline void
+EnergyEvaluator<_Scalar>::_init( SparseMatrix const& Qo )
+{
+    const LidT N = _q.size();
+    _diag.assign( N, _Scalar(0.) );
+
+    // both (i,j) and (j,i) are listed under the smaller and the larger id
+    std::vector< std::vector<NeighbourT> > lists( N );
+    for ( int row = 0; row < Qo.outerSize(); ++row )
+        for ( typename SparseMatrix::InnerIterator it(Qo,row); it; ++it )
+        {
+            if ( it.value() == _Scalar(0.) )
+                continue;
+            if ( it.row() == it.col() )
+                _diag[ it.row() ] += it.value();
+            else
+            {
+                lists[ it.row() ].push_back( NeighbourT(it.col(), it.value()) );
+                lists[ it.col() ].push_back( NeighbourT(it.row(), it.value()) );
+            }
+        }
+
+    // merge duplicates
+    _adjStart.assign( N + 1, 0 );
+    _adj.clear();
+    for ( LidT i = 0; i != N; ++i )
+    {
+        std::sort( lists[i].begin(), lists[i].end() );
+        for ( size_t k = 0; k != lists[i].size(); ++k )
+        {
+            if ( _adj.size() > size_t(_adjStart[i]) && _adj.back().first == lists[i][k].first )
+                _adj.back().second += lists[i][k].second;
+            else
+                _adj.push_back( lists[i][k] );
+        }
+        _adjStart[i+1] = _adj.size();
+    }
+
+    this->setSolution( SolutionT(N, _Scalar(0.)) );
+} //..._init()
+
+template <typename _Scalar> inline typename EnergyEvaluator<_Scalar>::Breakdown
+EnergyEvaluator<_Scalar>::evaluate( SolutionT const& x ) const
+{
+    Breakdown e;
+    e.bias = _bias;
+    for ( LidT i = 0; i != LidT(_q.size()); ++i )
+    {
+        if ( x[i] == _Scalar(0.) )
+            continue;
+
+        e.data       += x[i] * (_q[i] - _complexity);
+        e.complexity += x[i] * _complexity;
+        e.pairwise   += x[i] * x[i] * _diag[i];
+        // each pair once
+        for ( LidT k = _adjStart[i]; k != _adjStart[i+1]; ++k )
+            if ( _adj[k].first > i )
+                e.pairwise += x[i] * x[ _adj[k].first ] * _adj[k].second;
+    }
+
+    return e;
+} //...evaluate()
+
+template <typename _Scalar> inline void
+EnergyEvaluator<_Scalar>::setSolution( SolutionT const& x )
+{
+    _x = x;
+    _x.resize( _q.size(), _Scalar(0.) );
+
+    _field.assign( _q.size(), _Scalar(0.) );
+    for ( LidT i = 0; i != LidT(_q.size()); ++i )
+        for ( LidT k = _adjStart[i]; k != _adjStart[i+1]; ++k )
+            _field[i] += _adj[k].second * _x[ _adj[k].first ];
+
+    _energy = this->evaluate( _x );
+} //...setSolution()
+
+template <typename _Scalar> inline typename EnergyEvaluator<_Scalar>::Breakdown
+EnergyEvaluator<_Scalar>::deltaSet( LidT const i, _Scalar const value ) const
+{
+    const _Scalar dv = value - _x[i];
+
+    Breakdown d;
+    d.data       = dv * (_q[i] - _complexity);
+    d.complexity = dv * _complexity;
+    d.pairwise   = (value * value - _x[i] * _x[i]) * _diag[i] + dv * _field[i];
+
+    return d;
+} //...deltaSet()
+
+template <typename _Scalar> inline typename EnergyEvaluator<_Scalar>::Breakdown
+EnergyEvaluator<_Scalar>::deltaSwap( LidT const i, LidT const j ) const
+{
+    if ( i == j || _x[i] == _x[j] )
+        return Breakdown();
+
+    // the single deltas both assume the other variable unchanged
+    Breakdown d = this->deltaSet( i, _x[j] );
+    d += this->deltaSet( j, _x[i] );
+    d.pairwise += this->_coupling( i, j ) * (_x[j] - _x[i]) * (_x[i] - _x[j]);
+
+    return d;
+} //...deltaSwap()
+
+template <typename _Scalar> inline void
+EnergyEvaluator<_Scalar>::applySet( LidT const i, _Scalar const value )
+{
+    const _Scalar dv = value - _x[i];
+    if ( dv == _Scalar(0.) )
+        return;
+
+    _energy += this->deltaSet( i, value );
+    for ( LidT k = _adjStart[i]; k != _adjStart[i+1]; ++k )
+        _field[ _adj[k].first ] += _adj[k].second * dv;
+    _x[i] = value;
+} //...applySet()
+
+template <typename _Scalar> inline void
+EnergyEvaluator<_Scalar>::applySwap( LidT const i, LidT const j )
+{
+    const _Scalar xi = _x[i];
+    this->applySet( i, _x[j] );
+    this->applySet( j, xi    );
+} //...applySwap()
+
+//! \brief Coefficient of x_i * x_j in the energy, binary search in the neighbours of \p i.
+template <typename _Scalar> inline _Scalar
+EnergyEvaluator<_Scalar>::_coupling( LidT const i, LidT const j ) const
+{
+    typename std::vector<NeighbourT>::const_iterator it = std::lower_bound( _adj.begin() + _adjStart[i], _adj.begin() + _adjStart[i+1], NeighbourT(j, -std::numeric_limits<_Scalar>::max()) );
+    return (it != _adj.begin() + _adjStart[i+1] && it->first == j) ? it->second : _Scalar(0.);
+} //..._coupling()
+
+template <typename _Scalar> inline void
+EnergyEvaluator<_Scalar>::print( Breakdown const& e, Eigen::Matrix<_Scalar,3,1> const& weights, std::ostream &os ) const
+{
+    os << std::setprecision(9) << e.data << " (data) + " << e.pairwise << " (pw) + " << e.complexity << " (cmplx)";
+    if ( e.bias != _Scalar(0.) )
+        os << " + " << e.bias << " (bias)";
+    os << " = " << e.total() << " = "
+       <<          weights(0) << " * " << e.data       / weights(0)
+       << " + " << weights(1) << " * " << e.pairwise   / weights(1)
+       << " + " << weights(2) << " * " << e.complexity / weights(2)
+       << std::endl;
+} //...print()
+
+} //...namespace rapter
+
+#endif // RAPTER_ENERGYEVALUATOR_HPP
@@ -0,0 +1,253 @@
+#ifndef RAPTER_LOWERBOUND_HPP
+#define RAPTER_LOWERBOUND_HPP
+
+#include <cmath>
+#include <set>
+#include <map>
+#include <iostream>
+#include "rapter/optimization/lowerBound.h"
+#include "rapter/optimization/energyEvaluator.h" // EnergyEvaluator
+
+namespace rapter {
+
+template <typename _Scalar>
+template <class _OptProblemT>
+LagrangianBound<_Scalar>::LagrangianBound( _OptProblemT const& problem )
+    : _lin( problem.getVarCount(), _Scalar(0.) ), _bias( problem.getObjectiveBias() ), _allOnes( std::numeric_limits<_Scalar>::infinity() ), _rowStart( 1, 0 ), _droppedRows( 0 ), _valid( true )
+{
+    typedef typename _OptProblemT::SparseMatrix SparseMatrix;
+    const LidT N = problem.getVarCount();
+
+    for ( LidT j = 0; j != N; ++j )
+        if ( problem.getVarLowerBound(j) != 0. || problem.getVarUpperBound(j) != 1. )
+        {
+            std::cerr << "[" << __func__ << "]: " << "variable " << j << " is not in [0,1], no bound" << std::endl;
+            _valid = false;
+            return;
+        }
+
+    // objective
+    for ( size_t j = 0; j != problem.getLinObjectives().size() && LidT(j) != N; ++j )
+        _lin[j] = problem.getLinObjectives()[j];
+    {
+        const SparseMatrix Qo = problem.getQuadraticObjectivesMatrix();
+        for ( int row = 0; row < Qo.outerSize(); ++row )
+            for ( typename SparseMatrix::InnerIterator it(Qo,row); it; ++it )
+            {
+                if      ( it.row() == it.col()  ) _lin[ it.row() ] += it.value(); // x_i^2 == x_i
+                else if ( it.value() < 0.       ) _lin[ it.row() ] += it.value(); // w x_i x_j >= w x_i, if w < 0
+            }
+    }
+
+    {
+        EnergyEvaluator<_Scalar> evaluator( problem, _Scalar(0.) );
+        _allOnes = evaluator.evaluate( std::vector<_Scalar>(N, _Scalar(1.)) ).total();
+    }
+
+    // constraints
+    const SparseMatrix A = problem.getLinConstraintsMatrix();
+    std::map< LidT, std::set<LidT> > hubMembers; // direction variable -> variables implying it
+    std::vector<LidT>                hubOf( N, -1 );
+    for ( LidT r = 0; r != LidT(problem.getConstraintCount()); ++r )
+    {
+        const _Scalar lower = problem.getConstraintLowerBound( r );
+        std::vector<EntryT> entries;
+        bool allPositive = true, allNegative = true;
+        if ( r < A.outerSize() )
+            for ( typename SparseMatrix::InnerIterator it(A,r); it; ++it )
+            {
+                if ( it.value() == 0. ) continue;
+                entries.push_back( EntryT(it.col(), it.value()) );
+                allPositive &= it.value() > 0.;
+                allNegative &= it.value() < 0.;
+            }
+
+        const bool quadratic = (problem.getQuadraticConstraints().size() > size_t(r)) && problem.getQuadraticConstraints(r).size();
+        if ( !quadratic && allPositive && entries.size() && lower > 0. && lower < problem.getINF() )
+        {
+            // covering row
+            _rowEntries.insert( _rowEntries.end(), entries.begin(), entries.end() );
+            _rowStart.push_back( _rowEntries.size() );
+            _rhs.push_back( lower );
+            continue;
+        }
+
+        if ( quadratic && allNegative && lower == 0. )
+        {
+            // direction row: every quadratic entry pairs a member with the same direction variable
+            std::set<LidT> members;
+            for ( size_t k = 0; k != entries.size(); ++k )
+                members.insert( entries[k].first );
+
+            LidT hub = -1;
+            bool isDirectionRow = true;
+            for ( typename _OptProblemT::SparseEntries::const_iterator it = problem.getQuadraticConstraints(r).begin(); it != problem.getQuadraticConstraints(r).end() && isDirectionRow; ++it )
+            {
+                const LidT other = members.count( it->row() ) ? it->col() : it->row();
+                const LidT mem   = members.count( it->row() ) ? it->row() : it->col();
+                isDirectionRow  &= members.count( mem ) && !members.count( other ) && it->value() > 0. && (hub < 0 || hub == other);
+                hub = other;
+            }
+
+            if ( isDirectionRow && hub >= 0 )
+            {
+                hubMembers[ hub ].insert( members.begin(), members.end() );
+                continue;
+            }
+        }
+
+        ++_droppedRows;
+    } //...for constraints
+
+    // a variable implies at most one direction, and directions don't imply others, dropping the rest relaxes
+    for ( typename std::map< LidT, std::set<LidT> >::const_iterator it = hubMembers.begin(); it != hubMembers.end(); ++it )
+    {
+        _hubs.push_back( it->first );
+        hubOf[ it->first ] = it->first;
+    }
+    _members.resize( _hubs.size() );
+    for ( size_t h = 0; h != _hubs.size(); ++h )
+    {
+        const std::set<LidT> &members = hubMembers[ _hubs[h] ];
+        for ( std::set<LidT>::const_iterator it = members.begin(); it != members.end(); ++it )
+            if ( hubOf[*it] < 0 )
+            {
+                hubOf[*it] = _hubs[h];
+                _members[h].push_back( *it );
+            }
+    }
+    for ( LidT j = 0; j != N; ++j )
+        if ( hubOf[j] < 0 )
+            _free.push_back( j );
+
+    // transpose of covering rows
+    _colRows.resize( N );
+    for ( LidT k = 0; k != LidT(_rowEntries.size()); ++k )
+        _colRows[ _rowEntries[k].first ].push_back( k );
+
+    _lambdas.assign( _rhs.size(), _Scalar(0.) );
+} //...LagrangianBound()
+
+template <typename _Scalar> inline _Scalar
+LagrangianBound<_Scalar>::evaluate( std::vector<_Scalar> const& lambdas, std::vector<_Scalar> *subgradient ) const
+{
+    const LidT N = _lin.size();
+
+    // row of each covering entry
+    std::vector<LidT> entryRow( _rowEntries.size() );
+    for ( LidT r = 0; r != LidT(_rhs.size()); ++r )
+        for ( LidT k = _rowStart[r]; k != _rowStart[r+1]; ++k )
+            entryRow[k] = r;
+
+    // reduced costs
+    std::vector<_Scalar> reduced( N );
+#   pragma omp parallel for
+    for ( LidT j = 0; j < N; ++j )
+    {
+        reduced[j] = _lin[j];
+        for ( size_t k = 0; k != _colRows[j].size(); ++k )
+            reduced[j] -= lambdas[ entryRow[_colRows[j][k]] ] * _rowEntries[ _colRows[j][k] ].second;
+    }
+
+    // open a direction, if it pays off with its profitable members
+    std::vector<char> chosen( N, 0 );
+    _Scalar value( _bias );
+#   pragma omp parallel for schedule(dynamic) reduction(+:value)
+    for ( LidT h = 0; h < LidT(_hubs.size()); ++h )
+    {
+        _Scalar open = reduced[ _hubs[h] ];
+        for ( size_t k = 0; k != _members[h].size(); ++k )
+            open += std::min( _Scalar(0.), reduced[ _members[h][k] ] );
+        if ( open < _Scalar(0.) )
+        {
+            value += open;
+            chosen[ _hubs[h] ] = 1;
+            for ( size_t k = 0; k != _members[h].size(); ++k )
+                chosen[ _members[h][k] ] = reduced[ _members[h][k] ] < _Scalar(0.);
+        }
+    }
+
+    for ( size_t k = 0; k != _free.size(); ++k )
+        if ( reduced[ _free[k] ] < _Scalar(0.) )
+        {
+            value += reduced[ _free[k] ];
+            chosen[ _free[k] ] = 1;
+        }
+
+    for ( LidT r = 0; r != LidT(_rhs.size()); ++r )
+        value += lambdas[r] * _rhs[r];
+
+    // b_r - A(r,:) x
+    if ( subgradient )
+    {
+        subgradient->resize( _rhs.size() );
+        for ( LidT r = 0; r != LidT(_rhs.size()); ++r )
+        {
+            (*subgradient)[r] = _rhs[r];
+            for ( LidT k = _rowStart[r]; k != _rowStart[r+1]; ++k )
+                if ( chosen[ _rowEntries[k].first ] )
+                    (*subgradient)[r] -= _rowEntries[k].second;
+        }
+    }
+
+    return value;
+} //...evaluate()
+
+template <typename _Scalar> inline _Scalar
+LagrangianBound<_Scalar>::compute( int const maxIterations, _Scalar const upperBound )
+{
+    if ( !_valid )
+        return -std::numeric_limits<_Scalar>::infinity();
+
+    const _Scalar target = std::isfinite( upperBound ) ? upperBound : _allOnes;
+
+    std::vector<_Scalar> lambdas( _lambdas ), subgradient;
+    _Scalar best  = this->evaluate( lambdas, &subgradient );
+    _Scalar theta = _Scalar( 2. );
+    int     stall = 0;
+    for ( int it = 0; it < maxIterations; ++it )
+    {
+        _Scalar sqrNorm( 0. );
+        for ( size_t r = 0; r != subgradient.size(); ++r )
+            if ( lambdas[r] > _Scalar(0.) || subgradient[r] > _Scalar(0.) ) // projected
+                sqrNorm += subgradient[r] * subgradient[r];
+        if ( sqrNorm == _Scalar(0.) )
+            break; // x is feasible for the covering rows, and complementary
+
+        // Polyak step towards the upper bound
+        const _Scalar step = theta * std::max( target - best, std::abs(target) * _Scalar(1e-6) + _Scalar(1e-9) ) / sqrNorm;
+        for ( size_t r = 0; r != lambdas.size(); ++r )
+            lambdas[r] = std::max( _Scalar(0.), lambdas[r] + step * subgradient[r] );
+
+        const _Scalar value = this->evaluate( lambdas, &subgradient );
+        if ( value > best )
+        {
+            best     = value;
+            _lambdas = lambdas;
+            stall    = 0;
+        }
+        else if ( ++stall == 10 )
+        {
+            theta /= _Scalar( 2. );
+            stall  = 0;
+        }
+
+        if ( theta < _Scalar(1e-4) || best >= target )
+            break;
+    }
+
+    return best;
+} //...compute()
+
+template <typename _Scalar> inline _Scalar
+LagrangianBound<_Scalar>::relativeGap( _Scalar const upperBound, _Scalar const lowerBound )
+{
+    if ( !std::isfinite(upperBound) || !std::isfinite(lowerBound) )
+        return std::numeric_limits<_Scalar>::infinity();
+
+    return (upperBound - lowerBound) / std::max( std::abs(upperBound), std::numeric_limits<_Scalar>::epsilon() );
+} //...relativeGap()
+
+} //...namespace rapter
+
+#endif // RAPTER_LOWERBOUND_HPP
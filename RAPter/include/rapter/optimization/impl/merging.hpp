@@ -12,7 +12,9 @@
 #include "rapter/parameters.h"
 //#include "rapter/visualization/visualization.h"
 #include "rapter/io/io.h"
+#include "rapter/io/checkpoint.hpp"            // saveMergeCheckpoint()
 #include "rapter/processing/util.hpp"          //getPopulations()
+#include "rapter/processing/extentIndex.hpp"   // ExtentIndex
 #include "rapter/processing/impl/angleUtil.hpp" // appendAngles...
 #include "rapter/optimization/patchDistanceFunctors.h" // RepresentativeSqrPatchPatchDistanceFunctorT
 #include "rapter/util/util.hpp"
@@ -327,8 +329,11 @@ namespace merging
             /*! \brief Get maximum vertex id, this is changed from outside, not the "seen type"
              */
             inline _ULongT& getMaxId() { return _maxId; }
+            inline _ULongT  getMaxId() const { return _maxId; }
             inline void incHits() { _hits++; }
-            inline ULidT getHits() { return _hits; }
+            inline ULidT getHits() const { return _hits; }
+            //! \brief Used, when restored from a checkpoint.
+            inline void setHits( ULidT const hits ) { _hits = hits; }
 
         protected:
             _ULongT _maxId;
@@ -375,9 +380,43 @@ namespace merging
             it->setTag( _PrimitiveT::USER_TAGS::USER_ID4, compared.getMaxId()++ );
         }
 
+        // fingerprint of the input and the parameters, snapshots of anything else are ignored
+        ULidT inputPrimCount = 0;
+        for ( typename _PrimitiveMapT::const_iterator it = prims_map.begin(); it != prims_map.end(); ++it )
+            inputPrimCount += it->second.size();
+        ULidT inputHash = io::checkpoint::hashMergeInput<_PrimitiveT,_PointPrimitiveT>( prims_map, points );
+        io::checkpoint::hashPod( inputHash, params.scale                  );
+        io::checkpoint::hashPod( inputHash, params.angle_limit            );
+        io::checkpoint::hashPod( inputHash, params.parallel_limit         );
+        io::checkpoint::hashPod( inputHash, params.spatial_threshold_mult );
+        io::checkpoint::hashPod( inputHash, params.patch_dist_limit_mult  );
+        io::checkpoint::hashPod( inputHash, params.patch_spatial_weight   );
+        io::checkpoint::hashPod( inputHash, params.do_adopt               );
+        io::checkpoint::hashPod( inputHash, params.is3D                   );
+
+        // resume
+        LidT iteration = 0;
+        if ( params.resume && !params.checkpoint_path.empty() )
+        {
+            if ( EXIT_SUCCESS == io::loadMergeCheckpoint<_PrimitiveT,_PointPrimitiveT>( params.checkpoint_path, inputPrimCount, inputHash, iteration, prims_map_copy, points, compared ) )
+                std::cout << "[" << __func__ << "]: " << "resuming from " << params.checkpoint_path << " after iteration " << iteration << std::endl;
+            else
+                std::cout << "[" << __func__ << "]: " << "no consistent snapshot at " << params.checkpoint_path << ", starting from scratch" << std::endl;
+        } //...resume
+
         _PrimitiveMapT *in  = &prims_map_copy,
                        *out = &out_prims;
 
+        // snapshot of the latest input after each finished iteration
+        auto checkpoint = [&]()
+        {
+            ++iteration;
+            if ( params.checkpoint_path.empty() || (params.checkpoint_every <= 0) || (iteration % params.checkpoint_every) )
+                return;
+            if ( EXIT_SUCCESS != io::saveMergeCheckpoint<_PrimitiveT,_PointPrimitiveT>( params.checkpoint_path, inputPrimCount, inputHash, iteration, *in, points, compared ) )
+                std::cerr << "[" << __func__ << "]: " << "could not write snapshot " << params.checkpoint_path << std::endl;
+        };
+
         //some test here, nothing really worked.
         // The idea was to try to generate the right functor to merge either lines or planes
         //auto decideMergeFunct = params.is3D ? DecideMergePlaneFunctor() : DecideMergeLineFunctor();
@@ -397,6 +436,7 @@ namespace merging
                 _PrimitiveMapT* tmp = out;
                 out = in;
                 in  = tmp;
+                checkpoint();
             } //...while
         } //...3D
         else
@@ -408,6 +448,7 @@ namespace merging
                 _PrimitiveMapT* tmp = out;
                 out = in;
                 in  = tmp;
+                checkpoint();
             } //...while
         } //...else2D
 
@@ -600,6 +641,14 @@ Merging::mergeCli( int argc, char** argv )
 
         rapter::console::parse_argument( argc, argv, "--partition", sizeLimit );
 
+        // checkpointing
+        params.checkpoint_path = prims_path + ".ckpt";
+        rapter::console::parse_argument( argc, argv, "--checkpoint", params.checkpoint_path );
+        rapter::console::parse_argument( argc, argv, "--checkpoint-every", params.checkpoint_every );
+        if ( rapter::console::find_switch(argc,argv,"--no-checkpoint") )
+            params.checkpoint_path.clear();
+        params.resume = rapter::console::find_switch( argc, argv, "--resume" );
+
         if ( !valid_input || pcl::console::find_switch(argc,argv,"--help") || pcl::console::find_switch(argc,argv,"-h") )
         {
             std::cerr << "[" << __func__ << "]: " << "--scale, --prims are compulsory, --cloud needs to exist" << std::endl;
@@ -615,6 +664,10 @@ Merging::mergeCli( int argc, char** argv )
                       << "\t[--thresh-mult " << params.spatial_threshold_mult << "]\n"
                       << "\t[--no-paral]\n"
                       << "\t[--partition " << sizeLimit << "\t split scene into chunks ]\n"
+                      << "\t[--checkpoint " << params.checkpoint_path << "]\t snapshot path, removed after success\n"
+                      << "\t[--checkpoint-every " << params.checkpoint_every << "]\t snapshot after every n-th merge iteration\n"
+                      << "\t[--no-checkpoint]\n"
+                      << "\t[--resume]\t continue from the snapshot, if it exists\n"
                       << std::endl;
 
             return EXIT_FAILURE;
@@ -684,8 +737,13 @@ Merging::mergeCli( int argc, char** argv )
                 ( /* out: */ out_prims, points, /* in: */ prims_map, params );
     else
     {
+        // partitions are merged in parallel, snapshots are only taken for a single merge
+        MergeParams<_Scalar> partitionParams = params;
+        partitionParams.checkpoint_path.clear();
+        partitionParams.resume = false;
+
         merging::MergePartition<PrimitiveMapT, _PointContainerT> outPartition;
-        partition( outPartition, prims_map, points, params, sizeLimit );
+        partition( outPartition, prims_map, points, partitionParams, sizeLimit );
         out_prims = outPartition.getPrimitives();
         points = outPartition.getPoints();
     }
@@ -711,6 +769,10 @@ Merging::mergeCli( int argc, char** argv )
         std::cout << "wrote " << ss.str() << std::endl;
     }
 
+    // outputs are safe, snapshot is not needed anymore
+    if ( !params.checkpoint_path.empty() )
+        io::checkpoint::remove( params.checkpoint_path );
+
     std::cout << "stopped mergeSameDirGids" << std::endl; fflush(stdout);
     return EXIT_SUCCESS;
 }//...Merging::mergeCli()
@@ -749,22 +811,37 @@ int Merging::adoptPoints( _PointContainerT          & points
     typedef          Eigen::Matrix<_Scalar,3,1>             Position;
 
     typedef           std::vector< Position         >       ExtremaT;
-    //typedef           std::map   < int, ExtremaT>              LidExtremaT;
-    typedef           std::pair  < GidT   , LidT    >       GidLid;
-    typedef           std::map   < GidLid, ExtremaT >       GidLidExtremaT;
+    typedef           std::pair  < GidT   , LidT    >       GidLidT;
 
     int err = EXIT_SUCCESS;
 
     bool changed = false;
     int haCount = 0, orphanReCount = 0;
 
+    // Large primitives, in container (gid, lid) order. Their index in this list is their id in the spatial index,
+    // so candidates come back in the order the primitives used to be scanned in, and ties are broken the same way.
+    std::vector< GidLidT >              bigPrims;
+    std::vector< _PrimitiveT const* >   bigPrimPtrs;
+    for ( outer_const_iterator it1 = prims.begin(); it1 != prims.end(); ++it1 )
+    {
+        LidT lid = 0; // primitive linear index in patch
+        for ( _inner_const_iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2, ++lid )
+            if ( (*it2).getTag(_PrimitiveT::TAGS::STATUS) != _PrimitiveT::STATUS_VALUES::SMALL )
+            {
+                bigPrims   .push_back( GidLidT((*it2).getTag(_PrimitiveT::TAGS::GID), lid) );
+                bigPrimPtrs.push_back( &(*it2) );
+            }
+    }
+
+    // try to find if at least one of the primitive of the group is big
+    // if is not the case, we can potentially re-assign
+    auto isBigPatch = [] (const _PrimitiveT& prim) { return prim.getTag(_PrimitiveT::TAGS::STATUS) != _PrimitiveT::STATUS_VALUES::SMALL; };
+
     // Loop over all points, and select orphans
     do
     {
         changed = false;
 
-        _PointPrimitiveDistanceFunctor distFunctor;
-
         // Populations
         GidPidVectorMap populations; // populations[gid] == std::vector<int> {pid0,pid1,...}
         if ( EXIT_SUCCESS == err )
@@ -773,82 +850,91 @@ int Merging::adoptPoints( _PointContainerT          & points
             CHECK( err, "getPopulations" );
         }
 
-        // cache extrema
-        GidLidExtremaT extremaMap;
+        // extrema of the large primitives, they only depend on the populations of this round
+        std::vector< ExtremaT > extrema( bigPrims.size() );
+#       pragma omp parallel for schedule(dynamic)
+        for ( LidT k = 0; k < LidT(bigPrims.size()); ++k )
+        {
+            GidPidVectorMap::const_iterator popIt = populations.find( bigPrims[k].first );
+            bigPrimPtrs[k]->template setExtentOutdated(); // we want to recalculate to be sure, points might have been reassigned
+            bigPrimPtrs[k]->template getExtent<_PointPrimitiveT>
+                    ( extrema[k]
+                    , points
+                    , scale
+                    , (popIt != populations.end() && popIt->second.size()) ? &(popIt->second) : NULL );
+        }
+
+        // only primitives with a box closer than scale can explain a point (the box is grown a little, to absorb rounding of the distance functors)
+        processing::ExtentIndex<_Scalar> extentIndex( scale );
+        for ( size_t k = 0; k != extrema.size(); ++k )
+            extentIndex.insert( k, extrema[k], scale * _Scalar(1.e-3) );
 
-        std::cout << "Orphan re-assigned ";
+        // orphans: the patch they are assigned to does not exist, is empty, or has no big primitive
+        std::vector< PidT >     orphans;
+        std::vector< Position > orphanPositions;
         for ( size_t pIdId = 0; pIdId != points.size(); ++pIdId )
         {
-            //const PidT pId       = points[pIdId].getTag(_PointPrimitiveT::TAGS::PID);
             const GidT pointGId = points[pIdId].getTag(_PointPrimitiveT::TAGS::GID);
             typename _PrimitiveContainerT::const_iterator it = prims.find( pointGId );
 
-            // try to find if at least one of the primitive of the group is big
-            // if is not the case, we can potentially re-assign
-            auto isBigPatch = [] (const _PrimitiveT& prim) { return prim.getTag(_PrimitiveT::TAGS::STATUS) != _PrimitiveT::STATUS_VALUES::SMALL; };
-
             if (    ( it == prims.end()                            )    // the patch this point is assigned to does not exist
                  || ( !containers::valueOf<_PrimitiveT>(it).size() )    // the patch this point is assigned to is empty (no primitives in it)
                  || ( std::find_if((*it).second.begin(), (*it).second.end(), isBigPatch) == (*it).second.end()) // there is no big patch in the group
                )  // the patch this point is assigned to is too small
             {
+                orphans        .push_back( pIdId );
+                orphanPositions.push_back( points[pIdId].pos() );
+            }
+        }
+
+        std::vector< std::vector<LidT> > candidates;
+        extentIndex.queryPoints( orphanPositions, scale, candidates );
+
+        // the closest explaining primitive of each orphan, independent of the others
+        std::vector< GidT > minGids( orphans.size(), -1 );
+#       pragma omp parallel for schedule(dynamic,64) reduction(+:haCount)
+        for ( LidT o = 0; o < LidT(orphans.size()); ++o )
+        {
+            _PointPrimitiveDistanceFunctor distFunctor;
+            _Scalar  minDist = std::numeric_limits<_Scalar>::max();
+            GidT     minGid  = -1;
+            Position const& pos = orphanPositions[o];
 
-                // We here have an orphan, so we need to iterate over all primitives and get the closest distance < scale
-                _Scalar  minDist = std::numeric_limits<_Scalar>::max();
-                GidT     minGid  = -1;
-                Position pos     = points[pIdId].pos();
+            for ( size_t c = 0; c != candidates[o].size(); ++c )
+            {
+                const LidT k = candidates[o][c];
+                _Scalar dist = distFunctor.eval( extrema[k], *bigPrimPtrs[k], pos );
 
-                // now loop over all primitives to get the closest for
-                for ( outer_const_iterator it1 = prims.begin(); it1 != prims.end(); ++it1 )
+                // store minimum distance
+                if ( dist < minDist )
                 {
-                    LidT lid = 0; // primitive linear index in patch
-                    for ( _inner_const_iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2, ++lid )
+                    if ( bigPrimPtrs[k]->getDistance(pos) < scale ) // added by Aron on 8/1/2015
                     {
-                        const GidT gid = (*it2).getTag(_PrimitiveT::TAGS::GID);
-
-                        // if large patch found
-                        if ( (*it2).getTag(_PrimitiveT::TAGS::STATUS) != _PrimitiveT::STATUS_VALUES::SMALL)
-                        {
-                            if ( extremaMap.find(GidLid(gid,lid)) == extremaMap.end() )
-                            {
-                                it2->template setExtentOutdated(); // we want to recalculate to be sure, points might have been reassigned
-                                err = it2->template getExtent<_PointPrimitiveT>
-                                        ( extremaMap[ GidLid(gid,lid) ]
-                                        , points
-                                        , scale
-                                        , populations[gid].size() ? &(populations[gid]) : NULL );
-                            }
-
-                            _Scalar dist = distFunctor.eval( extremaMap[ GidLid(gid,lid) ], *it2, pos );
-
-                            // store minimum distance
-                            if ( dist < minDist )
-                            {
-                                if ( it2->getDistance(pos) < scale ) // added by Aron on 8/1/2015
-                                {
-                                    minDist = dist;
-                                    minGid  = gid;
-                                }
-                                else
-                                    ++haCount;
-                            }
-                        }
+                        minDist = dist;
+                        minGid  = bigPrims[k].first;
                     }
+                    else
+                        ++haCount;
                 }
+            }
 
-                //std::cout << "Process orphan.... " << minDist << std::endl;
-                if ( (minDist < scale) && (minDist >= _Scalar(0.)) )
-                {
-                    // reassign point
-                    points[pIdId].setTag( _PointPrimitiveT::TAGS::GID, minGid );
-                    ++orphanReCount;
-                    if ( !(orphanReCount % 1000) )
-                        std::cout << orphanReCount << " points, ";
-                    //std::cout << pid << " " << minGid << ", ";
-                    changed = true;
-                }
-            } //...if reassign point
-        }//...for all points
+            if ( (minDist < scale) && (minDist >= _Scalar(0.)) )
+                minGids[o] = minGid;
+        }
+
+        std::cout << "Orphan re-assigned ";
+        for ( size_t o = 0; o != orphans.size(); ++o )
+        {
+            if ( minGids[o] == -1 )
+                continue;
+
+            // reassign point
+            points[ orphans[o] ].setTag( _PointPrimitiveT::TAGS::GID, minGids[o] );
+            ++orphanReCount;
+            if ( !(orphanReCount % 1000) )
+                std::cout << orphanReCount << " points, ";
+            changed = true;
+        }
     } while (changed);
     std::cout << std::endl;
 
@@ -891,11 +977,6 @@ int Merging::mergeSameDirGids( _PrimitiveContainerT               & out_primitiv
     typedef typename _PrimitiveContainerT::iterator            outer_iterator;
     typedef typename _InnerPrimitiveContainerT::iterator       inner_iterator;
     typedef           std::vector<Eigen::Matrix<_Scalar,3,1> > ExtremaT;
-    typedef           std::map   < LidT, ExtremaT>             LidExtremaT;
-    typedef           std::map   < GidT, LidExtremaT >         GidLidExtremaT;
-    typedef           std::pair  < GidT, // map key
-                                   LidT> // linear index in the array associated to the key
-                      GidLid;
     typedef typename _ComparedUidsT::ElementT UidPairT;
 
     // Store the primitives that have been matched and must be ignored
@@ -915,11 +996,15 @@ int Merging::mergeSameDirGids( _PrimitiveContainerT               & out_primitiv
         CHECK( err, "getPopulations" );
     }
 
-    // Extrema
+    // Population index: one entry per patch, looked up read-only below
+    typedef std::pair< GidT, LidT > PrimKeyT; // < gid, linear index in the array associated to the key >
+    std::vector< PrimKeyT > prims;            // non-small primitives, in container (gid, lid) order
+
+    // Tags, ids and small patches
     UidT uid = 0; DidT maxDirGId = 0;
-    GidLidExtremaT extrema; // <gid,lid> -> vector<x0, x1, ...>
     if ( EXIT_SUCCESS == err )
     {
+        std::set< GidT > patchGids;
         // for all patches
         for ( outer_iterator outer_it  = primitives.begin();
                                   (outer_it != primitives.end()); // we now handle error
@@ -932,7 +1017,6 @@ int Merging::mergeSameDirGids( _PrimitiveContainerT               & out_primitiv
                                        (inner_it != containers::valueOf<_PrimitiveT>(outer_it).end());// we now handle error
                                       ++inner_it, ++lid )
             {
-                //primitives.at(gid0).at(lid0).setTag(_PrimitiveT::USER_ID1, uid);
                 inner_it->setTag( _PrimitiveT::USER_ID1, ++uid );
                 maxDirGId = std::max( maxDirGId
                                     , static_cast<DidT>( inner_it->getTag(_PrimitiveT::TAGS::DIR_GID) )
@@ -950,214 +1034,173 @@ int Merging::mergeSameDirGids( _PrimitiveContainerT               & out_primitiv
                 {
                     gid = inner_it->getTag( _PrimitiveT::TAGS::GID );
                     // sanity check
-                    if ( extrema.find(gid) != extrema.end() )   std::cerr << "[" << __func__ << "]: " << "GID not unique for patch...:-S" << std::endl;
+                    if ( !patchGids.insert(gid).second )   std::cerr << "[" << __func__ << "]: " << "GID not unique for patch...:-S" << std::endl;
                 }
 
-                if ( populations[gid].size() )
-                {
-                    err = inner_it->template getExtent<_PointPrimitiveT>
-                                                               ( extrema[gid][lid]
+                prims.push_back( PrimKeyT(gid, lid) );
+            } //...for primitives
+        } //...for patches
+    } //...tags
+
+    // Extrema, in one parallel pass over the population index
+    std::vector< ExtremaT > extrema( prims.size() );
+    {
+        std::vector< int > extentErrs( prims.size(), EXIT_SUCCESS );
+        std::vector< PidVector const* > pops( prims.size(), static_cast<PidVector const*>(NULL) );
+        for ( size_t k = 0; k != prims.size(); ++k )
+        {
+            GidPidVectorMap::const_iterator pop_it = populations.find( prims[k].first );
+            if ( pop_it != populations.end() && pop_it->second.size() )
+                pops[k] = &(pop_it->second);
+        }
+
+#       pragma omp parallel for schedule(dynamic)
+        for ( LidT k = 0; k < LidT(prims.size()); ++k )
+        {
+            if ( pops[k] )
+                extentErrs[k] = primitives.at( prims[k].first ).at( prims[k].second ).template getExtent<_PointPrimitiveT>
+                                                               ( extrema[k]
                                                                , points
                                                                , scale
-                                                               , &(populations[gid])
+                                                               , pops[k]
                                                                );
-                }
-                else
-                    err = EXIT_FAILURE;
-
-                if ( err != EXIT_SUCCESS )
-                {
-                    std::cerr << "Issue when computing extent of ("
-                              << primitives.at(gid).at(lid).getTag(_PrimitiveT::TAGS::GID )     << ","
-                              << primitives.at(gid).at(lid).getTag(_PrimitiveT::TAGS::DIR_GID ) << ")"
-                              << std::endl
-                              << "Ignored later... " << std::endl;
+            else
+                extentErrs[k] = EXIT_FAILURE;
+        }
 
-                    ignoreList.insert(gid);
-                }
-            } //...for primitives
-        } //...for patches
+        for ( size_t k = 0; k != prims.size(); ++k )
+        {
+            if ( extentErrs[k] != EXIT_SUCCESS )
+            {
+                std::cerr << "Issue when computing extent of ("
+                          << primitives.at(prims[k].first).at(prims[k].second).getTag(_PrimitiveT::TAGS::GID )     << ","
+                          << primitives.at(prims[k].first).at(prims[k].second).getTag(_PrimitiveT::TAGS::DIR_GID ) << ")"
+                          << std::endl
+                          << "Ignored later... " << std::endl;
+
+                ignoreList.insert( prims[k].first );
+                err = extentErrs[k];
+            }
+        }
 
         CHECK( err, "calcExtrema" )
     } //...getExtrema
 
-
-    typedef typename GidLidExtremaT::const_iterator GidIt;
-    typedef typename LidExtremaT::const_iterator    PrimIt;
-
-#if 0
-    // add a local uid attribute to primitives to be able to recognize them later
-    DidT altMaxDirGid = 0;
-    for ( GidIt gid_it = extrema.cbegin(); gid_it != extrema.cend(); ++gid_it )
+    // Spatial index over the extrema boxes.
+    // Both decide functors need an endpoint of one patch within sqrt(3)*scale of the other,
+    // so looking twice the scale around each box never misses a merge.
+    std::vector< std::vector<LidT> > overlaps; // overlaps[k]: candidates after k, increasing
     {
-        const GidT gid0 = gid_it->first;
-        for ( PrimIt prim_it = gid_it->second.cbegin(); prim_it != gid_it->second.cend(); ++prim_it, uid++ )
-        {
-            const GidT lid0 = std::distance<typename LidExtremaT::const_iterator>( gid_it ->second.cbegin(), prim_it );
-            primitives.at(gid0).at(lid0).setTag(_PrimitiveT::USER_ID1, uid);
-            altMaxDirGid = std::max( altMaxDirGid, static_cast<DidT>(primitives.at(gid0).at(lid0).getTag(_PrimitiveT::TAGS::DIR_GID)) );
-        }
-    }
+        processing::ExtentIndex<_Scalar> extentIndex( _Scalar(2.) * scale );
+        std::vector< LidT > indexed;
+        for ( size_t k = 0; k != prims.size(); ++k )
+            if ( ignoreList.find(prims[k].first) == ignoreList.end() && extentIndex.insert(k, extrema[k]) )
+                indexed.push_back( k );
 
+        std::vector< std::vector<LidT> > neighs;
+        extentIndex.queryNeighbours( indexed, _Scalar(2.) * scale, neighs );
+
+        overlaps.resize( prims.size() );
+        for ( size_t i = 0; i != indexed.size(); ++i )
+            overlaps[ indexed[i] ].assign( std::upper_bound(neighs[i].begin(), neighs[i].end(), indexed[i]), neighs[i].end() );
+    } //...spatial index
 
-    // estimate the maximum direction id, to be able to give new ids to refit primitives
-    DidT max_dir_gid = 0;
-    for ( outer_const_iterator outer_it  = primitives.begin(); (outer_it != primitives.end()); ++outer_it )
-        for ( inner_const_iterator inner_it  = containers::valueOf<_PrimitiveT>(outer_it).begin();
-                                   (inner_it != containers::valueOf<_PrimitiveT>(outer_it).end());
-                                  ++inner_it )
-        {
-            max_dir_gid = std::max( max_dir_gid, static_cast<DidT>((*inner_it).getTag(_PrimitiveT::TAGS::DIR_GID)) );
-        }
-#endif
     std::cout << "[" << __func__ << "]: " << "max_dir_gid: " << maxDirGId << std::endl;
 
-    // Here are two first loops to iterate over the map entries, and for each of them over the
-    // linear array containing primitives (we call them ref. primitive in the following).
-    //
-    // For each of these ref. primitives, we check for merging candidates. They can be in:
-    //   - the same map entry, after the ref. primitive in the linear Primitive array
-    //   - the next map entries, any index
+    // Here are two loops to iterate over the reference primitives in (gid, lid) order, and for each of
+    // them over its spatially overlapping candidates, that come after the reference in the same order.
     //
     // For each couple ref/candidate, we check if we can merge. If yes, we do it and then invalidate
     // both the ref and the candidate to prevent to merge them with other primitives. Indeed, the
     // merging process can potentially remove the primitives, or at least change their properties.
-    // Primitives are invalidated by storing them as key in the ignoreList structure.
-    //
-    // After processing, the ignoreList contains any candidate described by a GidLid gl:
-    //   ignoreList [gl];
+    // Primitives are invalidated by storing their gid in the ignoreList structure.
     //
     // The output buffer is initialized with the input. All merging operations will remove
     // old primitives and replace them by merged one.
     out_primitives = primitives;
 
-    //bool merged = false;
-
     // Reference traversal
-    for ( GidIt gid_it = extrema.cbegin(); gid_it != extrema.cend(); ++gid_it )
+    for ( size_t k0 = 0; k0 != prims.size(); ++k0 )
     {
-        const GidT gid0 = gid_it->first;
+        const GidT gid0 = prims[k0].first;
+        const LidT lid0 = prims[k0].second;
 
-        for ( PrimIt prim_it = gid_it->second.cbegin(); prim_it != gid_it->second.cend(); ++prim_it )
-        {
-            // linear id of the reference
-            const LidT lid0 = std::distance<typename LidExtremaT::const_iterator>( gid_it ->second.cbegin(), prim_it );
+        // check if this primitives has not been merged previously
+        if (ignoreList.find(gid0) != ignoreList.end()) continue;
 
-            // Reference primitive key, used to check if it has not been merged previously
-            GidLid refGidLid (gid0, lid0);
+        // reference primitive
+        const _PrimitiveT& prim0 = primitives.at(gid0).at(lid0);
 
-            // check if this primitives has not been merged previously
-            if (ignoreList.find(gid0) != ignoreList.end()) continue;
+        // Candidates traversal, stops as soon as the reference got merged
+        for ( size_t c = 0; c != overlaps[k0].size(); ++c )
+        {
+            const LidT k1   = overlaps[k0][c];
+            const GidT gid1 = prims[k1].first;
+            const LidT lid1 = prims[k1].second;
+
+            // calling continue is sufficient to jump to the next primitive after and merge,
+            // plus here check that a previous merge has not been recorded
+            if (ignoreList.find(gid1) != ignoreList.end()) continue;
 
-            // reference primitive
-            const _PrimitiveT& prim0 = primitives.at(gid0).at(lid0);
+            const _PrimitiveT& prim1 = primitives.at(gid1).at(lid1);
 
-            // is the reference valid, i.e. no merge occured
-            bool is0Valid = true;
+            PidT uid40 = prim0.getTag( _PrimitiveT::USER_TAGS::USER_ID4 ),
+                 uid41 = prim1.getTag( _PrimitiveT::USER_TAGS::USER_ID4 );
 
+            UidPairT uid4Pair;
+            if ( uid40 > uid41 ) uid4Pair = UidPairT(uid41,uid40);
+            else                 uid4Pair = UidPairT(uid40,uid41);
 
-            // Candidates traversal
-            // This loop and the nested one check if the ref primitive is still valid for comparison,
-            // i.e. no merge occured.
-            // This construction prevent to use two successive break commands (this loop and the nested one)
-            for ( GidIt gid_it1 = gid_it; is0Valid && gid_it1 != extrema.cend(); ++gid_it1 )
+            if ( comparedUids.find( uid4Pair ) != comparedUids.end() )
             {
+                comparedUids.incHits();
+                continue;
+            }
 
-                GidT gid1 = gid_it1->first;
+            if (primitiveDecideMergeFunct.eval( extrema[k0],  // extrema 0
+                                                prim0,        // prim 0
+                                                extrema[k1],  // extrema 1
+                                                prim1,        // prim 1
+                                                scale))
+            {
+                // record this to detect unmerged primitives later and invalidate both primitives
+                ignoreList.insert(gid0);
+                ignoreList.insert(gid1);
 
-                // Given the ref. primitive, we check for merging candidates. They can be in:
-                //   - the same map entry, after the ref. primitive in the linear Primitive array
-                //   - the next map entries, any index
-                for ( PrimIt prim_it1 = (gid_it1 == gid_it) ? ++PrimIt(prim_it) :       // for the same map entry, after the ref. primitive
-                                                              gid_it1->second.cbegin(); // for the next map entries, any index
-                      is0Valid && prim_it1 != gid_it1->second.cend();
-                      ++prim_it1 )
+                if (    ( prim0.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL )
+                     || ( prim1.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL ) )
                 {
+                    std::cout << "[" << __func__ << "]: " << "crap, small patches are merged..." << std::endl; fflush(stdout);
+                    throw new std::runtime_error("asdf");
+                }
 
-                    const LidT lid1 = std::distance<typename LidExtremaT::const_iterator>( gid_it1->second.cbegin(), prim_it1 );
-
-                    // resume of the candidate primitive, used to record the matching operation for later and
-                    // detect previous merge operations
-                    GidLid candGidLid (gid1, lid1);
-
-                    // Here we don't need to define
-                    // bool is1Valid,
-                    // calling continue is sufficient to jump to the next primitive after and merge,
-                    // plus here check that a previous merge has not been recorded
-                    if (ignoreList.find(gid1) != ignoreList.end()) continue;
-
-                    const _PrimitiveT& prim1 = primitives.at(gid1).at(lid1);
-
-                    PidT uid40 = prim0.getTag( _PrimitiveT::USER_TAGS::USER_ID4 ),
-                         uid41 = prim1.getTag( _PrimitiveT::USER_TAGS::USER_ID4 );
-
-                    UidPairT uid4Pair;
-                    if ( uid40 > uid41 ) uid4Pair = UidPairT(uid41,uid40);
-                    else                 uid4Pair = UidPairT(uid40,uid41);
-
-                    if ( comparedUids.find( uid4Pair ) != comparedUids.end() )
-                    {
-                        comparedUids.incHits();
-                        continue;
-                    }
+                merging::merge( out_primitives,     // [out] Container storing merged primitives
+                                prim0,              // [in]  First primitive (can be invalidated during the call)
+                                populations[gid0],  // [in]  First primitive population (point ids)
+                                prim1,              // [in]  Second primitive
+                                populations[gid1],  // [in]  Second primitive population (point ids)
+                                points,             // [in]  Point cloud
+                                scale,              // [in]  Working scale (for refit)
+                                maxDirGId,          // [in,out] maximum direction id
+                                comparedUids.getMaxId() // [in,out] maximum new unique id
+                               );
 
+                comparedUids.eraseAny( uid4Pair );
 
-                    if (primitiveDecideMergeFunct.eval( prim_it->second,  // extrema 0
-                                                        prim0,            // prim 0
-                                                        prim_it1->second, // extrema 1
-                                                        prim1,            // prim 1
-                                                        scale))
-                    {
-                        //std::cout << " YES" << std::endl;
-
-                        // record this to detect unmerged primitives later and invalidate both primitives
-                        ignoreList.insert(gid0);
-                        ignoreList.insert(gid1);
-
-                        if (    ( prim0.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL )
-                             || ( prim1.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL ) )
-                        {
-                            std::cout << "[" << __func__ << "]: " << "crap, small patches are merged..." << std::endl; fflush(stdout);
-                            throw new std::runtime_error("asdf");
-                        }
-
-                        merging::merge( out_primitives,     // [out] Container storing merged primitives
-                                        prim0,              // [in]  First primitive (can be invalidated during the call)
-                                        populations[gid0],  // [in]  First primitive population (point ids)
-                                        prim1,              // [in]  Second primitive
-                                        populations[gid1],  // [in]  Second primitive population (point ids)
-                                        points,             // [in]  Point cloud
-                                        scale,              // [in]  Working scale (for refit)
-                                        maxDirGId,          // [in,out] maximum direction id
-                                        comparedUids.getMaxId() // [in,out] maximum new unique id
-                                       );
-
-                        //merged = true;
-
-                        is0Valid = false;
-
-                        //comparedUids.erase( uid4Pair );
-                        comparedUids.eraseAny( uid4Pair );
-
-                        continue;  // jump to the next couple ref/candidate primitive
-                    }
-                    else
-                    {
-
-                        auto uidPairIt = comparedUids.find( uid4Pair );
-                        if ( uidPairIt != comparedUids.end() )
-                        {
-                            std::cout << "this shouldn't happen, why are we rechecking this pair: " << uid40 << "," << uid41 << std::endl;
-                        }
-
-                        comparedUids.insert( uid4Pair );
-                    }
-                    //else
-                    //    std::cout << " NO" << std::endl;
+                break;  // the reference is invalid now, jump to the next one
+            }
+            else
+            {
+                auto uidPairIt = comparedUids.find( uid4Pair );
+                if ( uidPairIt != comparedUids.end() )
+                {
+                    std::cout << "this shouldn't happen, why are we rechecking this pair: " << uid40 << "," << uid41 << std::endl;
                 }
+
+                comparedUids.insert( uid4Pair );
             }
-        }
-    }
+        } //...for candidates
+    } //...for references
 
     //typedef typename _PrimitiveContainerT::mapped_type::iterator inner_iterator;
 
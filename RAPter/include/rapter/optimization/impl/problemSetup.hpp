@@ -5,6 +5,7 @@
 #include <vector>
 #include <map>
 #include <set> // edgelist
+#include <algorithm>                              // sort
 #include "Eigen/Dense"
 
 #if RAPTER_USE_PCL
@@ -14,8 +15,10 @@
 #include "qcqpcpp/optProblem.h"                   // OptProblem
 
 #include "rapter/optimization/energyFunctors.h" // AbstractPrimitivePrimitiveEnergyFunctor,
+#include "rapter/optimization/energyEvaluator.h" // EnergyEvaluator
 #include "rapter/parameters.h"                  // ProblemSetupParams
 #include "rapter/processing/util.hpp"           // getPopulation()
+#include "rapter/processing/grid2D.hpp"         // Grid2D
 #include "rapter/processing/impl/angleUtil.hpp" // appendAngle...
 #include "rapter/io/io.h"                       // readPrimitives(), readPoints()
 #include "rapter/util/pclUtil.h"                // PclCloudPtrT
@@ -294,21 +297,16 @@ ProblemSetup::formulateCli( int    argc
         }
         else
         {
-            problemSetup::OptProblemT::VectorX x( problem.getVarCount(), 1 );
-            x.setOnes();
-            Scalar dataPlusCmplx = (x.transpose() * problem.getLinObjectivesMatrix()).coeff(0);
-            Scalar complexityC   = x.sum() * params.weights(2);
-            Scalar dataC         = dataPlusCmplx - complexityC;
-            Scalar pairwiseC     = (x.transpose() * problem.getQuadraticObjectivesMatrix() * x );
-            std::cout << "E = " << dataC + pairwiseC + complexityC << " = "
-                      << dataC << " (data) + " << pairwiseC << "(pw) + " << complexityC << " (cmplx)"
-                      << " = "
-                      << params.weights(0) << " * " << dataC / params.weights(0)
-                      << " + " << params.weights(1) << " * " << pairwiseC / params.weights(1)
-                      << " + " << params.weights(2) << " * " << complexityC / params.weights(2)
-                      << std::endl;
+            EnergyEvaluator<problemSetup::OptProblemT::Scalar> evaluator( problem, params.weights(2) );
+            const EnergyEvaluator<problemSetup::OptProblemT::Scalar>::Breakdown e = evaluator.evaluate( std::vector<problemSetup::OptProblemT::Scalar>(problem.getVarCount(), 1.) );
+            const Scalar dataC       = e.data;
+            const Scalar pairwiseC   = e.pairwise;
+            const Scalar complexityC = e.complexity;
+            std::cout << "E = ";
+            evaluator.print( e, params.weights.template cast<problemSetup::OptProblemT::Scalar>() );
             std::ofstream fenergy( parent_path + "/" + energy_path, std::ofstream::out | std::ofstream::app );
-            fenergy << dataC + pairwiseC + complexityC << "," << dataC << "," << pairwiseC << "," << complexityC << std::endl;
+            // same columns as the solver's rows (E,gap,data,pw,complexity), there is no bound to take a gap to here
+            fenergy << dataC + pairwiseC + complexityC << ",," << dataC << "," << pairwiseC << "," << complexityC << std::endl;
             fenergy.close();
         }
     } //...dump
@@ -599,12 +597,13 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                 break;
 
             case ProblemSetupParams<_Scalar>::CONSTR_MODE::POINT_WISE:
-                std::cerr << "[" << __func__ << "]: " << "POINT_WISE not used" << std::endl;
-                throw new std::runtime_error("POINT_WISE not used");
+                err = problemSetup::everyPointNeedsPatchConstraint<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
+                        ( problem, prims, points, lids_varids, weights, scale, verbose );
                 break;
+
             case ProblemSetupParams<_Scalar>::CONSTR_MODE::HYBRID:
-                std::cerr << "[" << __func__ << "]: " << "HYBRID not used" << std::endl;
-                throw new std::runtime_error("HYBRID not used");
+                err = problemSetup::largePatchesNeedDirectionConstraint<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
+                        ( problem, prims, points, lids_varids, weights, scale, patch_pop_limit, verbose );
                 break;
         } //...switch constr_mode
 
@@ -636,11 +635,13 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                 break;
 
             case ProblemSetupParams<_Scalar>::DATA_COST_MODE::BAND_BASED:
+                err = problemSetup::bandBasedDataCost<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
+                        ( problem, prims, points, lids_varids, weights, scale, verbose );
+                break;
+
             default:
-//                err = problemSetup::bandBasedDataCost<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
-//                        ( problem, prims, points, lids_varids, weights, scale );
-                std::cerr << "::BAND_BASED not implemented" << std::endl;
-                throw new std::runtime_error("::BAND_BASED not implemented");
+                std::cerr << "[" << __func__ << "]: " << "unknown data cost mode " << (int)data_cost_mode << std::endl;
+                err = EXIT_FAILURE;
                 break;
         } //...switch data_cost_mode
     } //...unary cost
@@ -681,6 +682,17 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
         {
             if ( verbose ) {  std::cout << "[" << __func__ << "]: " << "spatial start..." << std::endl; fflush(stdout); }
 
+            // Same direction pairs cost 0, and are not added. OptProblem sums duplicate entries, so both halves of a pair end up in one coefficient.
+            // The counters count ordered (visiting, visited) hits, so a pair seen from both sides counts twice.
+            LidT spatialHits = 0, sameDirPairs = 0;
+
+            // candidates of each patch, so that only the neighbouring patches' candidates are visited, instead of all of them
+            std::map< GidT, std::vector<IntPair> > gidLids;
+            for ( size_t lid = 0; lid != prims.size(); ++lid )
+                for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
+                    if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) != _PrimitiveT::STATUS_VALUES::SMALL )
+                        gidLids[ prims[lid][lid1].getTag(_PrimitiveT::TAGS::GID) ].push_back( IntPair(lid,lid1) );
+
 #           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS)
             for ( size_t lid = 0; lid < prims.size(); ++lid )
             {
@@ -696,28 +708,26 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                     // extremas key
                     LidLid lidLid1( lid, lid1 );
 
-                    for ( size_t lidOth = 0; lidOth != prims.size(); ++lidOth )
+                    ProximityMapT::const_iterator gidNeighsIt = proximities.find( gid );
+                    if ( gidNeighsIt == proximities.end() )
+                        continue;
+
+                    for ( std::set<GidT>::const_iterator neighIt = gidNeighsIt->second.begin(); neighIt != gidNeighsIt->second.end(); ++neighIt )
                     {
-                        for ( size_t lid1Oth = 0; lid1Oth != prims[lidOth].size(); ++lid1Oth )
+                        typename std::map< GidT, std::vector<IntPair> >::const_iterator othIt = gidLids.find( *neighIt );
+                        if ( othIt == gidLids.end() )
+                            continue;
+
+                        for ( size_t oth = 0; oth != othIt->second.size(); ++oth )
                         {
+                            const size_t lidOth  = othIt->second[oth].first;
+                            const size_t lid1Oth = othIt->second[oth].second;
                             _PrimitiveT const& prim1 = prims[lidOth][lid1Oth];
 
-                            if ( prim1.getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
-                                continue;
-
-                            // skip same line, that's always zero
-                            if ( (lid == lidOth) && (lid1 == lid1Oth) ) continue;
-
                             const GidT gIdOther = prim1.getTag( _PrimitiveT::TAGS::GID );
                             const DidT dIdOther = prim1.getTag( _PrimitiveT::TAGS::DIR_GID );
 
-                            ProximityMapT::const_iterator gidNeighsIt = proximities.find( gid );
-                            if (    /*( did != dIdOther )
-                                 && */( gid != gIdOther ) // we don't want to pollute problem with unnecessary edges
-                                 && (    (gidNeighsIt                        != proximities.end()        )
-                                      && (gidNeighsIt->second.find(gIdOther) != gidNeighsIt->second.end())
-                                    )
-                               )
+                            if ( gid != gIdOther ) // we don't want to pollute problem with unnecessary edges
                             {
 //                                std::cout << "adding spatw " << halfSpatialWeightCoeff << " to "
 //                                          << lid << ", " << lid1 << " - "
@@ -728,7 +738,12 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
 #                               pragma omp critical (PS_PROBLEM)
                                 {
                                     if ( did != dIdOther )
+                                    {
                                         problem.addQObjective( varId0, varId1, halfSpatialWeightCoeff ); // /2, since it's going to be added both ways Aron 6/1/2015
+                                        ++spatialHits;
+                                    }
+                                    else
+                                        ++sameDirPairs;
 #if 0
                                     else { // encourage parallel added by Aron 19/4/2015
 #warning "Temporary Tweak"
@@ -741,11 +756,14 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
 #endif
                                 }
                             }
-                        } // ... olid1
-                    } // ... olid
+                        } // ... oth
+                    } // ... neighIt
                 } // ... lid1
             } // ... lid
 
+            std::cout << "[" << __func__ << "]: " << "spatial terms: " << spatialHits << " added of " << spatialHits + sameDirPairs
+                      << " ordered hits (" << sameDirPairs << " same direction)" << std::endl;
+
             if ( clusterMode )
             {
                 throw new std::runtime_error("turn off clusterMode!");
@@ -930,6 +948,30 @@ namespace problemSetup {
 
     //____________________________________________Constraints__________________________________________________
 
+    //! \brief Adds \f$ 1 \le \sum_{j \in varIds} x_j \f$ to \p problem, if no constraint on the same variables was added before.
+    //! \param[in]     varIds      Sorted variable ids of the constraint, its signature.
+    //! \param[in,out] signatures  Signatures of the constraints added so far.
+    //! \param[in,out] coeffs      Zero initialized line of A of size problem.getVarCount(), reset to zero on return.
+    //! \return                    True, if the constraint was unique and got added.
+    template <class _OptProblemT>
+    static inline bool
+    addUniqueCoverConstraint( _OptProblemT              & problem
+                            , std::vector<LidT>    const& varIds
+                            , CoverSignatures           & signatures
+                            , std::vector<double>       & coeffs )
+    {
+        if ( !varIds.size() || !signatures.insert(varIds).second )
+            return false;
+
+        for ( size_t i = 0; i != varIds.size(); ++i )
+            coeffs[ varIds[i] ] = 1.;
+        problem.addLinConstraint( _OptProblemT::BOUND::GREATER_EQ, 1, problem.getINF(), coeffs ); // 1 <= A( lid, : ) * X <= INF
+        for ( size_t i = 0; i != varIds.size(); ++i )
+            coeffs[ varIds[i] ] = 0.;
+
+        return true;
+    } //...addUniqueCoverConstraint()
+
     //! \brief              Adds constraints to \p problem so, that each patch (prims[i] that have the same _PrimitiveT::TAGS::GID) has at least one member j (prims[i][j]) selected.
     //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
     template < class _PointPrimitiveDistanceFunctor
@@ -949,54 +991,262 @@ namespace problemSetup {
                                       , _AssocT              const& lids_varids
                                       , _WeightsT            const& /*weights*/
                                       , _Scalar              const  /*scale*/
-                                      , bool                 const  verbose     /* = false */ )
+                                      , bool                 const  verbose     /* = false */
+                                      , std::vector<char>    const* patchMask   /* = NULL */
+                                      , CoverSignatures           * signatures  /* = NULL */ )
     {
         typedef typename _AssocT::key_type IntPair;
 
         int err = EXIT_SUCCESS;
 
         // one direction / patch needs to be choosen
-        std::vector< double              > coeffs ( problem.getVarCount(), 0 ); // constraint coefficient line in A
-        std::set   < std::vector<double> > uniqueA;                             // to ensure unique constraints
+        std::vector< double > coeffs ( problem.getVarCount(), 0 ); // constraint coefficient line in A
+        CoverSignatures       ownSignatures;                       // to ensure unique constraints
+        if ( !signatures )
+            signatures = &ownSignatures;
+
         // for all patches
+        std::vector<LidT> varIds;
         for ( size_t lid = 0; lid != prims.size(); ++lid )
         {
-            bool non_zero_line = false;
-
-            // init row to 0
-            std::fill( coeffs.begin(), coeffs.end(), 0 );
+            if ( patchMask && !(*patchMask)[lid] )
+                continue;
 
             // add 1 for each direction patch -> at least one direction has to be chosen for this patch
+            varIds.clear();
             for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
             {
                 if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
                     continue;
 
-                if ( verbose && (lid1 == 0) ) std::cout << "[" << __func__ << "]: " << "Constraining " << prims[lid][lid1].getTag( _PrimitiveT::TAGS::GID ) << " to choose one of ";
-                coeffs[ /* varid: */ lids_varids.at(IntPair(lid,lid1)) ] = 1.0;
-                non_zero_line = true;
+                if ( verbose && !varIds.size() ) std::cout << "[" << __func__ << "]: " << "Constraining " << prims[lid][lid1].getTag( _PrimitiveT::TAGS::GID ) << " to choose one of ";
+                varIds.push_back( /* varid: */ lids_varids.at(IntPair(lid,lid1)) );
                 if ( verbose ) std::cout << prims[lid][lid1].getTag( _PrimitiveT::TAGS::DIR_GID ) << ", ";
             }
-            if ( verbose )std::cout << " directions";
 
-            if ( non_zero_line )
+            if ( varIds.size() )
             {
+                std::sort( varIds.begin(), varIds.end() );
                 // unique insertion
-                unsigned prev_size = uniqueA.size(); // store prev set size to check for unique insert
-                uniqueA.insert( coeffs );            // insert into set
-                if ( uniqueA.size() > prev_size )    // if line was unique, add to problem
-                {
-                    problem.addLinConstraint( _OptProblemT::BOUND::GREATER_EQ, 1, problem.getINF(), coeffs ); // 1 <= A( lid, : ) * X <= INF
-                    if  ( verbose )     std::cout << " ADDED\n";
-                }
-                else
-                    if ( verbose )          std::cout << " IGNORED\n";
+                const bool added = addUniqueCoverConstraint( problem, varIds, *signatures, coeffs );
+                if ( verbose ) std::cout << " directions" << (added ? " ADDED\n" : " IGNORED\n");
             }
         } // ... for each patch
 
         return err;
     } // ...everyPatchNeedsDirectionConstraint
 
+    //! \brief              Adds constraints to \p problem so, that each point has at least one candidate selected, that explains it.
+    //!                     A candidate explains a point, if the point is within \p scale of its finite extent, regardless of the point's patch.
+    //!                     Points explained by the same candidates share one constraint, so the constraint count grows with the number of distinct point neighbourhoods, not with the number of points.
+    //!                     Points that no candidate explains are not constrained.
+    //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+    //! \param[in] pointMask  Constrains only the points with a non-zero entry, all points if NULL.
+    //! \param[in,out] signatures Signatures of the constraints already in \p problem, to skip duplicates across calls. Can be NULL.
+    template < class _PointPrimitiveDistanceFunctor
+             , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+             , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+             , typename _Scalar
+             , class _OptProblemT
+             , class _PrimitiveContainerT
+             , class _PointContainerT
+             , class _AssocT
+             , class _WeightsT
+             >
+    static inline int
+    everyPointNeedsPatchConstraint( _OptProblemT              & problem
+                                  , _PrimitiveContainerT const& prims
+                                  , _PointContainerT     const& points
+                                  , _AssocT              const& lids_varids
+                                  , _WeightsT            const& /*weights*/
+                                  , _Scalar              const  scale
+                                  , bool                 const  verbose     /* = false */
+                                  , std::vector<char>    const* pointMask   /* = NULL */
+                                  , CoverSignatures           * signatures  /* = NULL */ )
+    {
+        typedef typename _AssocT::key_type          IntPair;
+        typedef typename _PrimitiveT::Position      Position;
+
+        const LidT pointCount = points.size();
+
+        // extents are estimated from the patch
+        GidPidVectorMap populations;
+        processing::getPopulations( populations, points );
+
+        // spatial index: flat grid for 2D scenes, kd-tree otherwise, the order of the neighbours does not matter
+        processing::Grid2D<_Scalar> grid( /* sorted: */ false );
+        const bool use2D = (_PrimitiveT::EmbedSpaceDim == 2) && grid.setInputPoints( points, _Scalar(2.) * scale );
+        typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+        if ( !use2D )
+        {
+            pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+            ann_cloud->resize( points.size() );
+#           pragma omp parallel for
+            for ( LidT pid = 0; pid < pointCount; ++pid )
+                ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
+
+            tree.reset( new pcl::search::KdTree<pcl::PointXYZ>( /* sorted: */ false ) );
+            tree->setInputCloud( ann_cloud );
+        }
+
+        // flatten candidates, so that the threads share the work evenly
+        std::vector< IntPair > candidates;
+        for ( size_t lid = 0; lid != prims.size(); ++lid )
+            for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
+                if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) != _PrimitiveT::STATUS_VALUES::SMALL )
+                    candidates.push_back( IntPair(lid,lid1) );
+
+        // points explained by each candidate
+        std::vector< std::vector<PidT> > explained( candidates.size() );
+#       pragma omp parallel for schedule(dynamic)
+        for ( size_t cid = 0; cid < candidates.size(); ++cid )
+        {
+            _PrimitiveT const& prim = prims[ candidates[cid].first ][ candidates[cid].second ];
+            GidPidVectorMap::const_iterator popIt = populations.find( prim.getTag(_PrimitiveT::TAGS::GID) );
+
+            typename _PrimitiveT::ExtremaT extrema;
+            int err = prim.template getExtent<_PointPrimitiveT>
+                    ( extrema
+                    , points
+                    , scale
+                    , (popIt != populations.end() && popIt->second.size()) ? &(popIt->second) : NULL );
+            if ( (err != EXIT_SUCCESS) || !extrema.size() )
+                continue;
+
+            // the band is inside the ball around the extrema
+            Position centroid( Position::Zero() );
+            for ( size_t i = 0; i != extrema.size(); ++i )
+                centroid += extrema[i];
+            centroid /= _Scalar( extrema.size() );
+            _Scalar radius( 0. );
+            for ( size_t i = 0; i != extrema.size(); ++i )
+                radius = std::max( radius, (extrema[i] - centroid).norm() );
+            radius += scale;
+
+            pcl::PointXYZ query;
+            query.getVector3fMap() = centroid.template cast<float>();
+            std::vector<int>   neighs;
+            std::vector<float> sqrDists;
+            if ( use2D ) grid .radiusSearch( query, radius, neighs, sqrDists );
+            else         tree->radiusSearch( query, radius, neighs, sqrDists );
+
+            // the infinite distance is a lower bound of the finite one
+            for ( size_t i = 0; i != neighs.size(); ++i )
+            {
+                if ( pointMask && !(*pointMask)[ neighs[i] ] )
+                    continue;
+                if ( std::abs(prim.getDistance( points[ neighs[i] ].template pos() )) > scale )
+                    continue;
+                if ( prim.getFiniteDistance( extrema, points[ neighs[i] ].template pos() ) <= scale )
+                    explained[cid].push_back( neighs[i] );
+            }
+        } //...for candidates
+
+        // transpose to the candidates of each point, in CSR order
+        std::vector<LidT> pointStart( pointCount + 1, 0 );
+        for ( size_t cid = 0; cid != explained.size(); ++cid )
+            for ( size_t i = 0; i != explained[cid].size(); ++i )
+                ++pointStart[ explained[cid][i] + 1 ];
+        for ( LidT pid = 0; pid != pointCount; ++pid )
+            pointStart[pid+1] += pointStart[pid];
+
+        std::vector<LidT> pointVarIds( pointStart.back() );
+        {
+            std::vector<LidT> fill( pointStart.begin(), pointStart.end() - 1 );
+            for ( size_t cid = 0; cid != explained.size(); ++cid )
+            {
+                const LidT varId = lids_varids.at( candidates[cid] );
+                for ( size_t i = 0; i != explained[cid].size(); ++i )
+                    pointVarIds[ fill[explained[cid][i]]++ ] = varId;
+            }
+        }
+
+        // one constraint per unique signature
+        std::vector<double> coeffs( problem.getVarCount(), 0 );
+        CoverSignatures     ownSignatures;
+        if ( !signatures )
+            signatures = &ownSignatures;
+
+        LidT constrainedCount = 0, uncoveredCount = 0, addedCount = 0;
+        std::vector<LidT> varIds;
+        for ( LidT pid = 0; pid != pointCount; ++pid )
+        {
+            if ( pointMask && !(*pointMask)[pid] )
+                continue;
+            ++constrainedCount;
+
+            if ( pointStart[pid] == pointStart[pid+1] )
+            {
+                ++uncoveredCount;
+                continue;
+            }
+
+            varIds.assign( pointVarIds.begin() + pointStart[pid], pointVarIds.begin() + pointStart[pid+1] );
+            std::sort( varIds.begin(), varIds.end() );
+            addedCount += addUniqueCoverConstraint( problem, varIds, *signatures, coeffs );
+        }
+
+        if ( verbose || uncoveredCount )
+            std::cout << "[" << __func__ << "]: " << "added " << addedCount << " constraints for " << constrainedCount << " points"
+                      << ", " << uncoveredCount << " points are not explained by any candidate" << std::endl;
+
+        return EXIT_SUCCESS;
+    } // ...everyPointNeedsPatchConstraint
+
+    //! \brief              Adds \ref everyPatchNeedsDirectionConstraint for the patches with at least \p patchPopLimit points,
+    //!                     and \ref everyPointNeedsPatchConstraint for the points of the smaller ones.
+    //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+    template < class _PointPrimitiveDistanceFunctor
+             , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+             , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+             , typename _Scalar
+             , class _OptProblemT
+             , class _PrimitiveContainerT
+             , class _PointContainerT
+             , class _AssocT
+             , class _WeightsT
+             >
+    static inline int
+    largePatchesNeedDirectionConstraint( _OptProblemT              & problem
+                                       , _PrimitiveContainerT const& prims
+                                       , _PointContainerT     const& points
+                                       , _AssocT              const& lids_varids
+                                       , _WeightsT            const& weights
+                                       , _Scalar              const  scale
+                                       , int                  const  patchPopLimit
+                                       , bool                 const  verbose     /* = false */ )
+    {
+        GidPidVectorMap populations;
+        processing::getPopulations( populations, points );
+
+        std::vector<char> largePatches( prims.size(), 0 ),
+                          smallPoints ( points.size(), 0 );
+        for ( size_t lid = 0; lid != prims.size(); ++lid )
+        {
+            if ( !prims[lid].size() )
+                continue;
+
+            GidPidVectorMap::const_iterator popIt = populations.find( prims[lid][0].getTag(_PrimitiveT::TAGS::GID) );
+            if ( popIt == populations.end() )
+                continue;
+
+            if ( LidT(popIt->second.size()) >= patchPopLimit )
+                largePatches[lid] = 1;
+            else
+                for ( size_t i = 0; i != popIt->second.size(); ++i )
+                    smallPoints[ popIt->second[i] ] = 1;
+        }
+
+        CoverSignatures signatures;
+        int err = everyPatchNeedsDirectionConstraint<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
+                    ( problem, prims, points, lids_varids, weights, scale, verbose, &largePatches, &signatures );
+        if ( EXIT_SUCCESS == err )
+            err = everyPointNeedsPatchConstraint<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
+                    ( problem, prims, points, lids_varids, weights, scale, verbose, &smallPoints, &signatures );
+
+        return err;
+    } // ...largePatchesNeedDirectionConstraint
+
     //____________________________________________DataCosts____________________________________________
 
     //! \brief Adds unary costs to problem based on point to primitive associations.
@@ -1077,8 +1327,9 @@ namespace problemSetup {
 
                 // point count for normalization
                 unsigned cnt = 0;
-                // data-cost coefficient (output)
-                _Scalar unary_i = _Scalar(0);
+                // data-cost coefficient (output), summed in accumulation precision over the whole population
+                typedef typename _PrimitiveT::AccumScalar AccumScalar;
+                AccumScalar unary_i( 0. );
                 // for each point, check if assigned to main patch (TODO: move assignment test to earlier, it's indep of lid1)
                 for ( size_t pid = 0; pid != points.size(); ++pid )
                 {
@@ -1100,13 +1351,13 @@ namespace problemSetup {
 
                             dist = 2.; // we don't want an empty primitive
                         }
-                        unary_i += dist * dist; //changed on 18/09/14
+                        unary_i += AccumScalar(dist) * AccumScalar(dist); //changed on 18/09/14
                         ++cnt;              // normalizer
                     }
                 } // for points
 
                 // average data cost
-                _Scalar coeff = cnt ? /* unary: */ weights(0) * unary_i / _Scalar(cnt)
+                _Scalar coeff = cnt ? /* unary: */ weights(0) * _Scalar( unary_i / cnt )
                                     : /* unary: */ weights(0) * _Scalar(2);            // add large weight, if no points assigned
 //                std::cout << "coeff(" << gid
 //                          << ","
@@ -1161,6 +1412,146 @@ namespace problemSetup {
         return EXIT_SUCCESS;
     } //...associationBasedDataCost
 
+    //! \brief Adds unary costs to problem based on the points in a band around each finite candidate. The points are gathered through a spatial index, candidates are evaluated in parallel.
+    //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+    template < class _PointPrimitiveDistanceFunctor
+             , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+             , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+             , typename _Scalar
+             , class _OptProblemT
+             , class _PrimitiveContainerT
+             , class _PointContainerT
+             , class _AssocT
+             , class _WeightsT
+             >
+    static inline int
+    bandBasedDataCost( _OptProblemT              & problem
+                     , _PrimitiveContainerT const& prims
+                     , _PointContainerT     const& points
+                     , _AssocT              const& lids_varids
+                     , _WeightsT            const& weights
+                     , _Scalar              const  scale
+                     , bool                 const  verbose )
+    {
+        typedef typename _AssocT::key_type          IntPair;
+        typedef typename _PrimitiveT::AccumScalar   AccumScalar;
+        typedef typename _PrimitiveT::Position      Position;
+
+        // points farther than this from the finite primitive are outliers, and cost band^2 each
+        const _Scalar band    = scale;
+        const _Scalar sqrBand = band * band;
+
+        // extents are still estimated from the patch
+        GidPidVectorMap populations;
+        processing::getPopulations( populations, points );
+
+        // spatial index: flat grid for 2D scenes, kd-tree otherwise, the order of the neighbours does not matter
+        processing::Grid2D<_Scalar> grid( /* sorted: */ false );
+        const bool use2D = (_PrimitiveT::EmbedSpaceDim == 2) && grid.setInputPoints( points, _Scalar(2.) * band );
+        typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+        if ( !use2D )
+        {
+            pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+            ann_cloud->resize( points.size() );
+#           pragma omp parallel for
+            for ( size_t pid = 0; pid < points.size(); ++pid )
+                ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
+
+            tree.reset( new pcl::search::KdTree<pcl::PointXYZ>( /* sorted: */ false ) );
+            tree->setInputCloud( ann_cloud );
+        }
+
+        // flatten candidates, so that the threads share the work evenly
+        std::vector< IntPair > candidates;
+        for ( size_t lid = 0; lid != prims.size(); ++lid )
+            for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
+                if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) != _PrimitiveT::STATUS_VALUES::SMALL )
+                    candidates.push_back( IntPair(lid,lid1) );
+
+        std::vector<_Scalar> coeffs( candidates.size() );
+        LidT inBandSum = 0;
+#       pragma omp parallel for schedule(dynamic) reduction(+:inBandSum)
+        for ( size_t cid = 0; cid < candidates.size(); ++cid )
+        {
+            _PrimitiveT const& prim = prims[ candidates[cid].first ][ candidates[cid].second ];
+            const GidT         gid  = prim.getTag( _PrimitiveT::TAGS::GID );
+            GidPidVectorMap::const_iterator popIt = populations.find( gid );
+
+            typename _PrimitiveT::ExtremaT extrema;
+            int err = prim.template getExtent<_PointPrimitiveT>
+                    ( extrema
+                    , points
+                    , scale
+                    , (popIt != populations.end() && popIt->second.size()) ? &(popIt->second) : NULL );
+
+            AccumScalar unary_i( 0. );
+            LidT        cnt    ( 0  );
+            if ( (err == EXIT_SUCCESS) && extrema.size() )
+            {
+                // the band is inside the ball around the extrema
+                Position centroid( Position::Zero() );
+                for ( size_t i = 0; i != extrema.size(); ++i )
+                    centroid += extrema[i];
+                centroid /= _Scalar( extrema.size() );
+                _Scalar radius( 0. );
+                for ( size_t i = 0; i != extrema.size(); ++i )
+                    radius = std::max( radius, (extrema[i] - centroid).norm() );
+                radius += band;
+
+                pcl::PointXYZ query;
+                query.getVector3fMap() = centroid.template cast<float>();
+                std::vector<int>   neighs;
+                std::vector<float> sqrDists;
+                if ( use2D ) grid .radiusSearch( query, radius, neighs, sqrDists );
+                else         tree->radiusSearch( query, radius, neighs, sqrDists );
+
+                // inliers from anywhere in the cloud, the infinite distance is a lower bound of the finite one
+                for ( size_t i = 0; i != neighs.size(); ++i )
+                {
+                    if ( std::abs(prim.getDistance( points[ neighs[i] ].template pos() )) > band )
+                        continue;
+                    const _Scalar dist = prim.getFiniteDistance( extrema, points[ neighs[i] ].template pos() );
+                    if ( dist <= band )
+                    {
+                        unary_i += AccumScalar(dist) * AccumScalar(dist);
+                        ++cnt;
+                    }
+                }
+                inBandSum += cnt;
+
+                // own points that the candidate does not explain
+                if ( popIt != populations.end() )
+                    for ( size_t i = 0; i != popIt->second.size(); ++i )
+                    {
+                        if (    std::abs(prim.getDistance( points[ popIt->second[i] ].template pos() )) > band
+                             || prim.getFiniteDistance( extrema, points[ popIt->second[i] ].template pos() ) > band )
+                        {
+                            unary_i += AccumScalar( sqrBand );
+                            ++cnt;
+                        }
+                    }
+            }
+
+            // average data cost, large weight, if no points in band
+            coeffs[cid] = cnt ? /* unary: */ weights(0) * _Scalar( unary_i / cnt )
+                              : /* unary: */ weights(0) * _Scalar(2);
+
+            // complexity cost:
+            coeffs[cid] += weights(2);
+        } //...for candidates
+
+        // add to problem in a fixed order
+        for ( size_t cid = 0; cid != candidates.size(); ++cid )
+            problem.addLinObjective( /* var_id: */ lids_varids.at( candidates[cid] )
+                                   , /*  value: */ coeffs[cid] );
+
+        if ( verbose )
+            std::cout << "[" << __func__ << "]: " << "band data cost for " << candidates.size() << " candidates, "
+                      << (candidates.size() ? inBandSum / LidT(candidates.size()) : 0) << " points in band on average" << std::endl;
+
+        return EXIT_SUCCESS;
+    } //...bandBasedDataCost
+
 
 } //...namespace ProblemSetup
 } //...namespace rapter
@@ -3,7 +3,10 @@
 
 //#include "rapter/optimization/segmentation.h"
 
+#include <map>
 #include <vector>
+#include <cmath>     // atan2, M_PI
+#include <algorithm> // sort, count
 
 #include "omp.h"
 #include "boost/filesystem.hpp"
@@ -17,11 +20,14 @@
 #include "rapter/parameters.h"                          // CandidateGeneratorParams
 #include "rapter/util/containers.hpp"                   // add( map, gid, primitive), add( vector, gid, primitive )
 #include "rapter/processing/util.hpp"                   // getNeighbourIndices
+#include "rapter/processing/grid2D.hpp"                 // Grid2D
+#include "rapter/processing/orientation.hpp"            // orientConsistently
 #include "rapter/processing/impl/angleUtil.hpp"         // appendAngles
 #include "rapter/util/diskUtil.hpp"                     // saveBackup
 #include "rapter/io/io.h"                               // readPoints
 #include "rapter/optimization/patchDistanceFunctors.h"  // RepresentativeSqrPatchPatchDistanceFunctorT
 #include "rapter/util/impl/pclUtil.hpp"                 // smartgeometry::
+#include "rapter/io/dendrogramIo.hpp"                   // writeDendrogram, readDendrogram
 
 
 #include <chrono>
@@ -50,7 +56,8 @@ int
 Segmentation::orientPoints( _PointContainerT          &points
                           , _Scalar             const  scale
                           , int                 const  nn_K
-                          , int                 const  verbose )
+                          , int                 const  verbose
+                          , bool                const  consistent )
 {
     typedef pcl::PointCloud<pcl::PointXYZ>        CloudXYZ;
 
@@ -62,6 +69,7 @@ Segmentation::orientPoints( _PointContainerT          &points
     // (1) local fit lines from pcl cloud
     std::vector<_PrimitiveT> fit_lines;
     std::vector<PidT       > point_ids;
+    std::vector< std::vector<int> > neighs;
     {
         if ( verbose ) std::cout << "[" << __func__ << "]: " << "calling fit local" << std::endl;
         fitLocal( /* [out]       lines: */ fit_lines
@@ -71,7 +79,8 @@ Segmentation::orientPoints( _PointContainerT          &points
                , /*         nn_radius: */ scale
                , /*       soft_radius: */ true
                , /* [out]     mapping: */ &point_ids
-               , verbose ); // contains point id for fit_line
+               , verbose                    // contains point id for fit_line
+               , /* [out]      neighs: */ consistent ? &neighs : NULL );
 
         // copy line direction into point
         for ( UPidT pid_id = 0; pid_id != point_ids.size(); ++pid_id )
@@ -81,6 +90,14 @@ Segmentation::orientPoints( _PointContainerT          &points
         }
     } // ... (1) local fit
 
+    // (2) consistent signs over the same neighbourhood graph
+    if ( consistent )
+    {
+        LidT flips = 0;
+        const LidT islands = processing::orientConsistently<_Scalar>( points, neighs, &flips );
+        std::cout << "[" << __func__ << "]: " << "flipped " << flips << " of " << points.size() << " directions, " << islands << " orientation islands" << std::endl;
+    } // ... (2) orientation
+
     return EXIT_SUCCESS;
 } //...Segmentation::orientPoints()
 
@@ -98,6 +115,7 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
                        , bool                   const  soft_radius
                        , std::vector<PidT>            * point_ids
                        , int                    const  verbose
+                       , std::vector< std::vector<int> > *neighbourhoods
                        )
 {
     using std::vector;
@@ -111,14 +129,26 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
     if ( verbose ) std::cout << "[" << __func__ << "]: " << "starting neighbourhood queries";
     std::vector< std::vector<int   > > neighs;
     std::vector< std::vector<Scalar> > sqr_dists;
-    processing::getNeighbourhoodIndices( /*   [out] neighbours: */ neighs
-                                       , /* [in]  pointCloud: */ cloud
-                                       , /* [in]     indices: */ indices
-                                       , /* [out]  sqr_dists: */ &sqr_dists
-                                       , /* [in]        nn_K: */ K              // 15
-                                       , /* [in]      radius: */ radius         // 0.02f
-                                       , /* [in] soft_radius: */ soft_radius    // true
-                                       );
+    processing::Grid2D<Scalar> grid;
+    if ( (PrimitiveT::EmbedSpaceDim == 2) && grid.setInputCloud(cloud, radius) )
+        processing::getNeighbourhoodIndices( /*   [out] neighbours: */ neighs
+                                           , /* [in]      search: */ grid
+                                           , /* [in]  pointCloud: */ cloud
+                                           , /* [in]     indices: */ indices
+                                           , /* [out]  sqr_dists: */ &sqr_dists
+                                           , /* [in]        nn_K: */ K
+                                           , /* [in]      radius: */ radius
+                                           , /* [in] soft_radius: */ soft_radius
+                                           );
+    else
+        processing::getNeighbourhoodIndices( /*   [out] neighbours: */ neighs
+                                           , /* [in]  pointCloud: */ cloud
+                                           , /* [in]     indices: */ indices
+                                           , /* [out]  sqr_dists: */ &sqr_dists
+                                           , /* [in]        nn_K: */ K              // 15
+                                           , /* [in]      radius: */ radius         // 0.02f
+                                           , /* [in] soft_radius: */ soft_radius    // true
+                                           );
     if ( verbose ) std::cout << "ok...\n";
 
     // only use, if more then 2 data-points
@@ -211,6 +241,10 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
               << skipped << "/" << neighs.size() << ": " << skipped / static_cast<float>(neighs.size()) * 100.f << "% of points did not produce primitives, so the primitive count is:"
               << primitives.size() << " = " << primitives.size() / static_cast<float>(neighs.size()) *100.f << "%" << std::endl;
 
+    // hand the neighbourhood graph on, e.g. to orient the fits
+    if ( neighbourhoods )
+        neighbourhoods->swap( neighs );
+
     return EXIT_SUCCESS;
 } // ...Segment::propose()
 
@@ -225,6 +259,9 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
  * \param[in]  angles                    Desired angles to use for groupings.
  * \param[in]  patchPatchDistanceFunctor #regionGrow() uses the thresholds encoded to group points. The evalSpatial() function is used to assign orphan points.
  * \param[in]  nn_K                      Number of nearest neighbour points looked for in #regionGrow().
+ * \param[in]  dendrogram                Optional output of #agglomerate(). If given, the patches are cut from it instead of running #regionGrow().
+ * \param[in]  cutThreshold              Linkage threshold to cut \p dendrogram at.
+ * \param[in]  houghVotes                2D only. If positive, #houghGroup() groups the points, and the patches are refit in position only along their seeded directions.
  */
 
 template < class       _PrimitiveT
@@ -241,6 +278,9 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
                       , int                               const  nn_K
                       , int                               const  verbose
                       , size_t                            const patchPopLimit
+                      , segmentation::Dendrogram<_Scalar> const* dendrogram
+                      , _Scalar                           const  cutThreshold
+                      , LidT                              const  houghVotes
                       )
 {
     typedef segmentation::Patch<_Scalar,_PrimitiveT> PatchT;
@@ -252,7 +292,27 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
     std::cout << "[" << __func__ << "]: " << "PatchPatchDistance by " << patchPatchDistanceFunctor.toString() << std::endl;
 
     // (1) group
-    PatchesT groups;
+    PatchesT          groups;
+    std::vector<DidT> dirGids; // direction seeds from hough
+    if ( houghVotes > 0 )
+    {
+        if ( _PrimitiveT::EmbedSpaceDim != 2 )
+        {
+            std::cerr << "[" << __func__ << "]: " << "hough grouping is only implemented for 2D" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        int err = houghGroup<_PrimitiveT>( points, groups, dirGids, scale, patchPatchDistanceFunctor, houghVotes, PointPrimitiveT::TAGS::GID, verbose );
+        if ( err != EXIT_SUCCESS )
+            return err;
+    }
+    else if ( dendrogram )
+    {
+        int err = cutDendrogram<_PrimitiveT>( points, groups, *dendrogram, cutThreshold, PointPrimitiveT::TAGS::GID );
+        if ( err != EXIT_SUCCESS )
+            return err;
+    }
+    else
     {
         regionGrow<_PrimitiveT>
                   ( /* [in,out]  points/pointsWGIDTag: */ points
@@ -291,17 +351,21 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
                                                             , /*             indices: */ &(populations[gid])
                                                             , /*    refit iter count: */ 2                   // fit and refit twice
                                                             , /*    start from input: */ &(groups[gid].getRepresentative())  // use to calculate initial weights
-                                                            , /* refit position only: */ false
+                                                            , /* refit position only: */ dirGids.size() > gid  // keep the family direction of hough lines
                                                             , /*               debug: */ false  );
             if ( err != EXIT_SUCCESS )
+            {
                 std::cerr << "fitlinprim err " << err << ",";
+                if ( dirGids.size() > gid )
+                    toAdd = groups[gid].getRepresentative();
+            }
 
             // LINE
 #           pragma omp critical( ADD_PATCHES )
             {
                 containers::add( patches, gid, toAdd/*groups[gid].getRepresentative()*/ )
                         .setTag( _PrimitiveT::TAGS::GID    , gid )
-                        .setTag( _PrimitiveT::TAGS::DIR_GID, gid );
+                        .setTag( _PrimitiveT::TAGS::DIR_GID, (dirGids.size() > gid) ? dirGids[gid] : gid );
             }
         }
         else if ( _PrimitiveT::EmbedSpaceDim == 3)
@@ -394,6 +458,7 @@ Segmentation::regionGrow( _PointContainerT                       & points
     std::cout << "[" << __func__ << "]: " << "running with " << patchPatchDistanceFunctor.toString() << std::endl;
     std::cout << "[" << __func__ << "]: " << "running at " << patchPatchDistanceFunctor.getSpatialThreshold() << " spatial threshold" << std::endl;
     std::cout << "[" << __func__ << "]: " << "running at " << patchPatchDistanceFunctor.getAngularThreshold() << " radius threshold" << std::endl;
+    const _Scalar cosAngularThreshold = std::cos( std::min(patchPatchDistanceFunctor.getAngularThreshold(), _Scalar(M_PI_2)) );
 
     typedef typename _PatchesT::value_type   PatchT;
     typedef          std::vector<PatchT>     Patches;
@@ -411,21 +476,33 @@ Segmentation::regionGrow( _PointContainerT                       & points
     std::cout << "[" << __func__ << "]: " << "finished deque" << std::endl; fflush(stdout);
     std::random_shuffle( seeds.begin(), seeds.end() );
 
+    const _Scalar       max_dist            = patchPatchDistanceFunctor.getSpatialThreshold();// * _Scalar(3.5); // longest axis of ellipse)
+
+    // 2D scenes: flat grid instead of the kd-tree, same neighbours in the same order
+    processing::Grid2D<_Scalar> grid;
+    const bool use2D = (_PrimitiveT::EmbedSpaceDim == 2) && grid.setInputPoints( points, max_dist );
+
     // prebulid ann cloud
-    std::cout << "[" << __func__ << "]: " << "starting create ann cloud" << std::endl; fflush(stdout);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+    typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+    if ( !use2D )
     {
-        ann_cloud->resize( points.size() );
-#       pragma omp parallel for
-        for ( size_t pid = 0; pid < points.size(); ++pid )
-            ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
-    }
-    std::cout << "[" << __func__ << "]: " << "finished create ann cloud" << std::endl; fflush(stdout);
+        std::cout << "[" << __func__ << "]: " << "starting create ann cloud" << std::endl; fflush(stdout);
+        pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+        {
+            ann_cloud->resize( points.size() );
+#           pragma omp parallel for
+            for ( size_t pid = 0; pid < points.size(); ++pid )
+                ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
+        }
+        std::cout << "[" << __func__ << "]: " << "finished create ann cloud" << std::endl; fflush(stdout);
 
-    std::cout << "[" << __func__ << "]: " << "starting create ann TREE" << std::endl; fflush(stdout);
-    typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree( new pcl::search::KdTree<pcl::PointXYZ> );
-    tree->setInputCloud( ann_cloud );
-    std::cout << "[" << __func__ << "]: " << "finished create ann TREE" << std::endl; fflush(stdout);
+        std::cout << "[" << __func__ << "]: " << "starting create ann TREE" << std::endl; fflush(stdout);
+        tree.reset( new pcl::search::KdTree<pcl::PointXYZ> );
+        tree->setInputCloud( ann_cloud );
+        std::cout << "[" << __func__ << "]: " << "finished create ann TREE" << std::endl; fflush(stdout);
+    }
+    else
+        std::cout << "[" << __func__ << "]: " << "using 2D grid" << std::endl;
 
     //Patches patches; patches.reserve( std::max(1.5*sqrt(points.size()),10.) );
     std::vector< Patches > patchesVector( RAPTER_MAX_OMP_THREADS );
@@ -439,8 +516,6 @@ Segmentation::regionGrow( _PointContainerT                       & points
 //    std::vector<bool> assigned( points.size(), false );
 //    std::vector<bool> visited( points.size(), false );
 
-    const _Scalar       max_dist            = patchPatchDistanceFunctor.getSpatialThreshold();// * _Scalar(3.5); // longest axis of ellipse)
-
     unsigned step_count = 0; // for logging
     //int tid; //omp thread_id
     TIC
@@ -537,7 +612,8 @@ Segmentation::regionGrow( _PointContainerT                       & points
 #pragma omp critical (RG_KDTREE)
             {
                 searchPoint.getVector3fMap() = points[ pid ].template pos();
-                /*found_points_count = */ tree->radiusSearch( searchPoint, max_dist, neighs, sqr_dists, 0);
+                if ( use2D )    grid .radiusSearch( searchPoint, max_dist, neighs, sqr_dists, 0 );
+                else            /*found_points_count = */ tree->radiusSearch( searchPoint, max_dist, neighs, sqr_dists, 0);
             }
 
             for ( size_t pid_id = 1; pid_id < neighs.size(); ++pid_id )
@@ -554,16 +630,14 @@ Segmentation::regionGrow( _PointContainerT                       & points
                     if ( quit ) continue;
                 }
 
-                _Scalar ang_diff( 0. );
+                Eigen::Matrix<_Scalar,3,1> reprDir;
 #               pragma omp critical (RG_PVID)
                 {
-                    ang_diff = rapter::angleInRad( patchesVector[patchesVectorId[seed]].back().template dir(), points[pid2].template dir() );
+                    reprDir = patchesVector[patchesVectorId[seed]].back().template dir();
                 }
-                // map 90..180 to 0..90:
-                if ( ang_diff > M_PI_2 )    ang_diff = M_PI - ang_diff;
 
-                // location from point, but direction is the representative's
-                if (     (ang_diff > patchPatchDistanceFunctor.getAngularThreshold())
+                // location from point, but direction is the representative's. The angle is mapped 90..180 to 0..90, a cosine test does the same without atan2.
+                if (     !isAngleWithin( reprDir, points[pid2].template dir(), cosAngularThreshold )
                      //|| ((points[pid].template pos() - points[pid2].template pos()).norm() > max_dist)
                          ) // original condition
                     continue;
@@ -632,7 +706,8 @@ Segmentation::regionGrow( _PointContainerT                       & points
         {
             pcl::PointXYZ       searchPoint;
             searchPoint.getVector3fMap() = points[ pid ].template pos();
-            tree->radiusSearch( searchPoint, 0., neighs, sqr_dists, nn_K );
+            if ( use2D )    grid .radiusSearch( searchPoint, 0., neighs, sqr_dists, nn_K );
+            else            tree->radiusSearch( searchPoint, 0., neighs, sqr_dists, nn_K );
         }
         for ( size_t pid_id = 0; pid_id != neighs.size(); ++pid_id )
             if ( points[neighs[pid_id]].getTag( _PointPrimitiveT::TAGS::GID ) != _PointPrimitiveT::LONG_VALUES::UNSET )
@@ -649,6 +724,638 @@ Segmentation::regionGrow( _PointContainerT                       & points
     return EXIT_SUCCESS;
 } // ...Segmentation::regionGrow()
 
+namespace segmentation
+{
+    //! \brief Closest point pair of two adjacent clusters in \ref Segmentation::agglomerate(), seen from the owner of the entry.
+    template <typename _Scalar>
+    struct Contact
+    {
+        PidT    own;    //!< \brief Point in the owner cluster.
+        PidT    other;  //!< \brief Point in the neighbouring cluster.
+        _Scalar dist;   //!< \brief Distance of the two points.
+
+        inline Contact reversed() const { Contact c = { other, own, dist }; return c; }
+    };
+
+    //! \brief Returns \p patch with its direction flipped, if it points away from \p reference.
+    template <class _PatchT> inline _PatchT
+    alignedTo( _PatchT const& patch, _PatchT const& reference )
+    {
+        if ( patch.dir().dot(reference.dir()) >= typename _PatchT::Scalar(0.) )
+            return patch;
+
+        _PatchT flipped( patch );
+        flipped.getRepresentative() = typename _PatchT::PrimitiveT( patch.pos(), -patch.dir() );
+        return flipped;
+    }
+} //...ns segmentation
+
+/*  \brief Agglomerative clustering of oriented points by the nearest-neighbour-chain algorithm over the sparse radius graph of the points.
+ *         The linkage of two adjacent clusters is \p patchPatchDistanceFunctor evaluated on their closest point pair, carrying the aligned representative directions.
+ *         That is single linkage in space (like #regionGrow()), and representative linkage in angle.
+ *         Records the full merge history in \p dendrogram.
+ */
+template < class       _PrimitiveT
+         , class       _PointContainerT
+         , class       _PatchPatchDistanceFunctorT
+         , typename    _Scalar
+         , class       _PointPrimitiveT> int
+Segmentation::agglomerate( segmentation::Dendrogram<_Scalar>      & dendrogram
+                         , _PointContainerT                  const& points
+                         , _PatchPatchDistanceFunctorT       const& patchPatchDistanceFunctor
+                         , int                               const  nn_K
+                         , bool                              const  verbose
+                         )
+{
+    typedef segmentation::Patch<_Scalar,_PrimitiveT>            PatchT;
+    typedef typename segmentation::Dendrogram<_Scalar>::Merge   MergeT;
+    typedef segmentation::Contact<_Scalar>                      ContactT;
+    typedef std::map<LidT, ContactT>                            ContactsT; // neighbouring cluster => closest point pair
+    typedef Eigen::Matrix<_Scalar,3,1>                          Direction;
+
+    const LidT N = points.size();
+    std::cout << "[" << __func__ << "]: " << "running with " << patchPatchDistanceFunctor.toString() << " on " << N << " points" << std::endl;
+
+    dendrogram.leafCount = N;
+    dendrogram.merges.clear();
+    dendrogram.merges.reserve( N ? N - 1 : 0 );
+    if ( !N )
+        return EXIT_SUCCESS;
+
+    TIC
+    // (1) adjacency graph from radius neighbourhoods
+    std::vector<ContactsT> adjacency( N );
+    {
+        pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+        ann_cloud->resize( N );
+#       pragma omp parallel for
+        for ( LidT pid = 0; pid < N; ++pid )
+            ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
+
+        const _Scalar max_dist = patchPatchDistanceFunctor.getSpatialThreshold();
+
+        processing::Grid2D<_Scalar> grid;
+        const bool use2D = (_PrimitiveT::EmbedSpaceDim == 2) && grid.setInputCloud( ann_cloud, max_dist );
+
+        typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree;
+        if ( !use2D )
+        {
+            tree.reset( new pcl::search::KdTree<pcl::PointXYZ> );
+            tree->setInputCloud( ann_cloud );
+        }
+
+        std::vector< std::vector<int  > > neighs   ( N );
+        std::vector< std::vector<float> > sqr_dists( N );
+#       pragma omp parallel for
+        for ( LidT pid = 0; pid < N; ++pid )
+            if ( use2D )    grid .radiusSearch( ann_cloud->at(pid), max_dist, neighs[pid], sqr_dists[pid], nn_K + 1 ); // +1: self
+            else            tree->radiusSearch( ann_cloud->at(pid), max_dist, neighs[pid], sqr_dists[pid], nn_K + 1 );
+
+        for ( LidT pid = 0; pid != N; ++pid )
+            for ( size_t i = 0; i != neighs[pid].size(); ++i )
+            {
+                const LidT pid2 = neighs[pid][i];
+                if ( pid2 == pid ) continue;
+
+                const ContactT contact = { pid, pid2, std::sqrt(_Scalar(sqr_dists[pid][i])) };
+                adjacency[ pid  ][ pid2 ] = contact;
+                adjacency[ pid2 ][ pid  ] = contact.reversed();
+            }
+    }
+    if ( verbose ) TOC( "[agglomerate] adjacency", 1 )
+
+    // (2) singleton clusters
+    std::vector<PatchT> clusters( N );
+    std::vector<LidT>   nodeIds ( N );
+    for ( LidT pid = 0; pid != N; ++pid )
+    {
+        clusters[pid] = PatchT( segmentation::PidLid(pid,-1) );
+        clusters[pid].update( points );
+        nodeIds [pid] = pid;
+    }
+
+    // linkage of cluster a to its neighbour: functor on the closest point pair with the (aligned) representative directions
+    auto linkage = [&clusters, &points, &patchPatchDistanceFunctor]( LidT const a, LidT const b, ContactT const& contact )
+    {
+        Direction dir1 = clusters[b].dir();
+        if ( dir1.dot(clusters[a].dir()) < _Scalar(0.) )
+            dir1 = -dir1;
+
+        PatchT proxy0, proxy1;
+        proxy0.getRepresentative() = _PrimitiveT( points[contact.own  ].template pos(), clusters[a].dir() );
+        proxy1.getRepresentative() = _PrimitiveT( points[contact.other].template pos(), dir1              );
+        return patchPatchDistanceFunctor.template eval<_PointPrimitiveT>( proxy0, proxy1, points, NULL );
+    };
+    auto height = [&dendrogram]( LidT const node )
+    {
+        return node < dendrogram.leafCount ? _Scalar(0.) : dendrogram.merges[ node - dendrogram.leafCount ].height;
+    };
+    // keeps the closer contact, if the key exists already
+    auto addContact = []( ContactsT &contacts, LidT const key, ContactT const& contact )
+    {
+        typename ContactsT::iterator it = contacts.find( key );
+        if ( it == contacts.end() )
+            contacts.insert( std::make_pair(key, contact) );
+        else if ( contact.dist < it->second.dist )
+            it->second = contact;
+    };
+
+    // (3) nearest-neighbour-chain
+    RETIC
+    std::vector<LidT> chain;
+    std::vector<char> inChain( N, 0 );
+    LidT              nextSeed = 0;
+    while ( true )
+    {
+        if ( chain.empty() )
+        {
+            // clusters without neighbours are roots
+            while ( (nextSeed < N) && adjacency[nextSeed].empty() ) ++nextSeed;
+            if ( nextSeed == N )
+                break;
+            chain.push_back( nextSeed );
+            inChain[ nextSeed ] = 1;
+        }
+
+        const LidT top  = chain.back();
+        const LidT prev = chain.size() > 1 ? chain[ chain.size() - 2 ] : -1;
+
+        // nearest neighbour of top, ties are resolved in favour of prev, so that the chain distances strictly decrease
+        LidT    nn     = prev;
+        _Scalar nnDist = prev >= 0 ? linkage( top, prev, adjacency[top].at(prev) ) : std::numeric_limits<_Scalar>::max();
+        for ( typename ContactsT::const_iterator it = adjacency[top].begin(); it != adjacency[top].end(); ++it )
+        {
+            if ( it->first == prev ) continue;
+            const _Scalar dist = linkage( top, it->first, it->second );
+            if ( (nn < 0) || (dist < nnDist) )
+            {
+                nn     = it->first;
+                nnDist = dist;
+            }
+        }
+
+        if ( nn < 0 ) // isolated, nothing to merge with
+        {
+            chain.pop_back();
+            inChain[ top ] = 0;
+            continue;
+        }
+
+        if ( nn != prev )
+        {
+            // the linkage is not reducible, a merge might have brought nn closer than it was, when it was pushed: restart from top
+            if ( inChain[nn] )
+            {
+                for ( size_t i = 0; i + 1 < chain.size(); ++i )
+                    inChain[ chain[i] ] = 0;
+                chain.assign( 1, top );
+            }
+            chain.push_back( nn );
+            inChain[ nn ] = 1;
+            continue;
+        }
+
+        // reciprocal nearest neighbours: merge the smaller adjacency into the larger
+        chain.pop_back(); chain.pop_back();
+        inChain[ top ] = inChain[ prev ] = 0;
+
+        const LidT survivor = adjacency[top].size() >= adjacency[prev].size() ? top  : prev;
+        const LidT other    = survivor == top                                  ? prev : top;
+
+        MergeT merge;
+        merge.left   = nodeIds[ top  ];
+        merge.right  = nodeIds[ prev ];
+        merge.height = std::max( nnDist, std::max(height(merge.left), height(merge.right)) );
+        merge.size   = clusters[top].getSize() + clusters[prev].getSize();
+        dendrogram.merges.push_back( merge );
+
+        const PatchT aligned = segmentation::alignedTo( clusters[other], clusters[survivor] );
+        clusters[ survivor ].update( aligned.getRepresentative(), _Scalar(aligned.getSize()) );
+        nodeIds [ survivor ] = dendrogram.leafCount + dendrogram.merges.size() - 1;
+
+        for ( typename ContactsT::const_iterator it = adjacency[other].begin(); it != adjacency[other].end(); ++it )
+        {
+            if ( it->first == survivor ) continue;
+            adjacency[ it->first ].erase( other );
+            addContact( adjacency[ it->first ], survivor , it->second.reversed() );
+            addContact( adjacency[ survivor  ], it->first, it->second            );
+        }
+        adjacency[ survivor ].erase( other );
+        ContactsT().swap( adjacency[other] );
+        clusters[ other ] = PatchT();
+
+        if ( verbose && !(dendrogram.merges.size() % 100000) )
+        {
+            std::cout << "[" << __func__ << "]: " << dendrogram.merges.size() << " merges" << std::endl;
+        }
+    } //...while chain
+
+    TOC( "[agglomerate] nn-chain", 1 )
+    std::cout << "[" << __func__ << "]: " << "recorded " << dendrogram.merges.size() << " merges for " << N << " points, "
+              << N - dendrogram.merges.size() << " roots" << std::endl;
+
+    return EXIT_SUCCESS;
+} // ...Segmentation::agglomerate()
+
+template < class       _PrimitiveT
+         , class       _PointContainerT
+         , class       _PatchesT
+         , typename    _Scalar
+         , class       _PointPrimitiveT> int
+Segmentation::cutDendrogram( _PointContainerT                       & points
+                           , _PatchesT                              & groups_arg
+                           , segmentation::Dendrogram<_Scalar> const& dendrogram
+                           , _Scalar                           const  threshold
+                           , GidT                              const  gid_tag_name )
+{
+    typedef typename _PatchesT::value_type PatchT;
+
+    if ( dendrogram.leafCount != static_cast<LidT>(points.size()) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "dendrogram has " << dendrogram.leafCount << " leaves, but there are " << points.size() << " points" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<LidT> labels;
+    const LidT groupCount = dendrogram.cut( labels, threshold );
+
+    // representatives with directions aligned to the first point of the patch
+    const LidT offset = groups_arg.size();
+    groups_arg.resize( offset + groupCount );
+    for ( UPidT pid = 0; pid != points.size(); ++pid )
+    {
+        PatchT &patch = groups_arg[ offset + labels[pid] ];
+        patch.push_back( segmentation::PidLid(pid,-1) );
+        if ( patch.size() == 1 )
+            patch.update( points );
+        else if ( patch.dir().dot(points[pid].template dir()) < _Scalar(0.) )
+            patch.updateWithPoint( _PointPrimitiveT(points[pid].template pos(), -points[pid].template dir()) );
+        else
+            patch.updateWithPoint( points[pid] );
+
+        points[pid].setTag( gid_tag_name, offset + labels[pid] );
+    }
+
+    std::cout << "[" << __func__ << "]: " << "cut at " << threshold << ": " << groupCount << " patches" << std::endl;
+
+    return EXIT_SUCCESS;
+} // ...Segmentation::cutDendrogram()
+
+namespace segmentation
+{
+    //! \brief A line voted for in \ref Segmentation::houghGroup(), \f$ n(\theta) \cdot p = \rho \f$ with \f$ n(\theta) = (-\sin\theta, \cos\theta) \f$.
+    template <typename _Scalar>
+    struct HoughLine
+    {
+            HoughLine( _Scalar theta, _Scalar rho, LidT votes )
+                : theta( theta ), rho( rho ), votes( votes ), family( -1 ) {}
+
+            inline Eigen::Matrix<_Scalar,3,1> dir   () const { return Eigen::Matrix<_Scalar,3,1>(  std::cos(theta), std::sin(theta), _Scalar(0.) ); }
+            inline Eigen::Matrix<_Scalar,3,1> normal() const { return Eigen::Matrix<_Scalar,3,1>( -std::sin(theta), std::cos(theta), _Scalar(0.) ); }
+
+            _Scalar theta, rho;
+            LidT    votes;
+            LidT    family;     //!< \brief Index of the direction family.
+    }; //...struct HoughLine
+
+    //! \brief Angle between unoriented directions, in [0,pi/2].
+    template <typename _Scalar, class _VectorT, class _VectorBT>
+    inline _Scalar houghAngle( _VectorT const& dir0, _VectorBT const& dir1 )
+    {
+        const _Scalar angle = angleInRad( dir0, dir1 );
+        return std::min( angle, _Scalar(M_PI) - angle );
+    } //...houghAngle()
+
+    //! \brief Theta in [0,pi) of the unoriented 2D direction \p dir.
+    template <typename _Scalar, class _VectorT>
+    inline _Scalar houghTheta( _VectorT const& dir )
+    {
+        _Scalar theta = std::atan2( dir(1), dir(0) );
+        if ( theta <  _Scalar(0.)  ) theta += _Scalar(M_PI);
+        if ( theta >= _Scalar(M_PI)) theta -= _Scalar(M_PI);
+        return theta;
+    } //...houghTheta()
+} //...namespace segmentation
+
+template < class       _PrimitiveT
+         , class       _PointContainerT
+         , class       _PatchPatchDistanceFunctorT
+         , class       _PatchesT
+         , typename    _Scalar
+         , class       _PointPrimitiveT> int
+Segmentation::houghGroup( _PointContainerT                 & points
+                        , _PatchesT                        & groups_arg
+                        , std::vector<DidT>                & dirGids
+                        , _Scalar                     const  scale
+                        , _PatchPatchDistanceFunctorT const& patchPatchDistanceFunctor
+                        , LidT                        const  minVotes
+                        , GidT                        const  gid_tag_name
+                        , bool                        const  verbose
+                        )
+{
+    typedef typename _PatchesT::value_type          PatchT;
+    typedef segmentation::HoughLine<_Scalar>        HoughLineT;
+    typedef Eigen::Matrix<_Scalar,3,1>              Vector3;
+
+    const _Scalar angleLimit = patchPatchDistanceFunctor.getAngularThreshold();
+    const _Scalar gapLimit   = patchPatchDistanceFunctor.getSpatialThreshold();
+    const LidT    N          = points.size();
+    if ( !N )
+        return EXIT_SUCCESS;
+    if ( (angleLimit <= _Scalar(0.)) || (scale <= _Scalar(0.)) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "need positive angle limit and scale, got " << angleLimit << ", " << scale << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TIC
+    // (1) parameter space point of each point
+    std::vector<_Scalar> thetas( N ), rhos( N );
+#   pragma omp parallel for
+    for ( LidT pid = 0; pid < N; ++pid )
+    {
+        thetas[pid] = segmentation::houghTheta<_Scalar>( points[pid].template dir() );
+        rhos  [pid] = HoughLineT( thetas[pid], 0, 0 ).normal().dot( points[pid].template pos() );
+    }
+    _Scalar maxRho( 0. );
+    for ( LidT pid = 0; pid != N; ++pid )
+        maxRho = std::max( maxRho, std::abs(rhos[pid]) );
+
+    // symmetric rho bins, so that theta wraps around to pi with mirrored rho
+    const int  thetaBins = std::max( 1, static_cast<int>(std::ceil(_Scalar(M_PI) / angleLimit)) );
+    const LidT rhoHalf   = static_cast<LidT>( std::ceil(maxRho / scale) );
+    const LidT rhoBins   = 2 * rhoHalf + 1;
+    const LidT binCount  = thetaBins * rhoBins;
+    const _Scalar thetaStep = _Scalar(M_PI) / thetaBins;
+    if ( binCount > (LidT(1) << 28) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "accumulator too large: " << thetaBins << " x " << rhoBins << ", increase --scale" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<LidT> pointBins( N );
+    for ( LidT pid = 0; pid != N; ++pid )
+    {
+        const int  tb = std::min( thetaBins - 1, static_cast<int>(thetas[pid] / thetaStep) );
+        const LidT rb = static_cast<LidT>( std::floor(rhos[pid] / scale + _Scalar(.5)) ) + rhoHalf;
+        pointBins[pid] = tb * rhoBins + rb;
+    }
+
+    // (2) vote, one accumulator per thread
+    std::vector<LidT> votes( binCount, 0 );
+#   pragma omp parallel
+    {
+        std::vector<LidT> localVotes( binCount, 0 );
+#       pragma omp for nowait
+        for ( LidT pid = 0; pid < N; ++pid )
+            ++localVotes[ pointBins[pid] ];
+#       pragma omp critical (HOUGH_VOTES)
+        for ( LidT bin = 0; bin != binCount; ++bin )
+            votes[bin] += localVotes[bin];
+    }
+
+    // points of each bin, counting sort
+    std::vector<LidT> binStart( binCount + 1, 0 ), binPoints( N );
+    for ( LidT bin = 0; bin != binCount; ++bin )
+        binStart[bin+1] = binStart[bin] + votes[bin];
+    {
+        std::vector<LidT> fill( binStart.begin(), binStart.end() - 1 );
+        for ( LidT pid = 0; pid != N; ++pid )
+            binPoints[ fill[pointBins[pid]]++ ] = pid;
+    }
+
+    // 3x3 neighbour of a bin, theta wraps with mirrored rho, -1 if outside or visited already
+    struct Neighbour
+    {
+        static inline LidT get( LidT const bin, int const dt, int const dr, int const thetaBins, LidT const rhoBins )
+        {
+            if ( dt && (thetaBins < 3) )
+                return -1;
+            int  tb = bin / rhoBins + dt;
+            LidT rb = bin % rhoBins;
+            if ( tb < 0 || tb >= thetaBins )
+            {
+                tb  = (tb + thetaBins) % thetaBins;
+                rb  = rhoBins - 1 - rb;
+                rb -= dr;
+            }
+            else
+                rb += dr;
+            return ( (rb < 0) || (rb >= rhoBins) ) ? -1 : tb * rhoBins + rb;
+        }
+    };
+
+    // (3) peaks of the summed votes
+    std::vector<LidT> sums( binCount, 0 );
+#   pragma omp parallel for
+    for ( LidT bin = 0; bin < binCount; ++bin )
+    {
+        if ( !votes[bin] )
+            continue;
+        for ( int dt = -1; dt <= 1; ++dt )
+            for ( int dr = -1; dr <= 1; ++dr )
+            {
+                const LidT neigh = Neighbour::get( bin, dt, dr, thetaBins, rhoBins );
+                if ( neigh >= 0 )
+                    sums[bin] += votes[neigh];
+            }
+    }
+
+    std::vector<HoughLineT> lines;
+    for ( LidT bin = 0; bin != binCount; ++bin )
+    {
+        if ( !votes[bin] || sums[bin] < minVotes )
+            continue;
+
+        // strict local maximum, ties broken by bin id
+        bool isPeak = true;
+        for ( int dt = -1; dt <= 1 && isPeak; ++dt )
+            for ( int dr = -1; dr <= 1 && isPeak; ++dr )
+            {
+                const LidT neigh = Neighbour::get( bin, dt, dr, thetaBins, rhoBins );
+                if ( neigh >= 0 && neigh != bin )
+                    isPeak = (sums[neigh] < sums[bin]) || ((sums[neigh] == sums[bin]) && (bin < neigh));
+            }
+        if ( !isPeak )
+            continue;
+
+        // refit to the voters: mean aligned direction, then mean offset
+        const Vector3 peakDir = HoughLineT( (bin / rhoBins + _Scalar(.5)) * thetaStep, 0, 0 ).dir();
+        Vector3 dir( Vector3::Zero() );
+        for ( int dt = -1; dt <= 1; ++dt )
+            for ( int dr = -1; dr <= 1; ++dr )
+            {
+                const LidT neigh = Neighbour::get( bin, dt, dr, thetaBins, rhoBins );
+                if ( neigh < 0 ) continue;
+                for ( LidT k = binStart[neigh]; k != binStart[neigh+1]; ++k )
+                {
+                    const Vector3 pointDir = points[ binPoints[k] ].template dir();
+                    dir += (pointDir.dot(peakDir) < _Scalar(0.)) ? Vector3(-pointDir) : pointDir;
+                }
+            }
+        HoughLineT line( segmentation::houghTheta<_Scalar>(dir), 0, sums[bin] );
+
+        const _Scalar peakRho = (bin % rhoBins - rhoHalf) * scale * (peakDir.dot(line.dir()) < _Scalar(0.) ? _Scalar(-1.) : _Scalar(1.));
+        _Scalar rhoSum( 0. ); LidT rhoCount( 0 );
+        for ( int dt = -1; dt <= 1; ++dt )
+            for ( int dr = -1; dr <= 1; ++dr )
+            {
+                const LidT neigh = Neighbour::get( bin, dt, dr, thetaBins, rhoBins );
+                if ( neigh < 0 ) continue;
+                for ( LidT k = binStart[neigh]; k != binStart[neigh+1]; ++k )
+                {
+                    const _Scalar rho = line.normal().dot( points[ binPoints[k] ].template pos() );
+                    if ( std::abs(rho - peakRho) <= _Scalar(1.5) * scale )
+                    {
+                        rhoSum += rho;
+                        ++rhoCount;
+                    }
+                }
+            }
+        line.rho = rhoCount ? rhoSum / rhoCount : peakRho;
+        lines.push_back( line );
+    } //...for bins
+
+    // (4) assign each point to the closest line within the thresholds, only lines in neighbouring theta bins can be close enough
+    std::vector< std::vector<LidT> > thetaBinLines( thetaBins );
+    for ( LidT l = 0; l != static_cast<LidT>(lines.size()); ++l )
+        thetaBinLines[ std::min(thetaBins - 1, static_cast<int>(lines[l].theta / thetaStep)) ].push_back( l );
+
+    std::vector<LidT> pointLines( N, -1 );
+#   pragma omp parallel for
+    for ( LidT pid = 0; pid < N; ++pid )
+    {
+        const int tb   = pointBins[pid] / rhoBins;
+        _Scalar   best = _Scalar( 1. );
+        for ( int dt = -1; dt <= 1; ++dt )
+        {
+            if ( thetaBins < 3 && dt != 0 ) continue;
+            const std::vector<LidT> &candidates = thetaBinLines[ (tb + dt + thetaBins) % thetaBins ];
+            for ( size_t c = 0; c != candidates.size(); ++c )
+            {
+                const HoughLineT &line = lines[ candidates[c] ];
+                const _Scalar dist  = std::abs( line.normal().dot(points[pid].template pos()) - line.rho ) / scale;
+                const _Scalar angle = segmentation::houghAngle<_Scalar>( line.dir(), Vector3(points[pid].template dir()) ) / angleLimit;
+                const _Scalar value = std::max( dist, angle );
+                if ( value <= best )
+                {
+                    best            = value;
+                    pointLines[pid] = candidates[c];
+                }
+            }
+        }
+
+        // badly oriented points (corners, crossings) join the closest line by distance only
+        if ( pointLines[pid] < 0 )
+            for ( LidT l = 0; l != static_cast<LidT>(lines.size()); ++l )
+            {
+                const _Scalar dist = std::abs( lines[l].normal().dot(points[pid].template pos()) - lines[l].rho ) / scale;
+                if ( dist <= best )
+                {
+                    best            = dist;
+                    pointLines[pid] = l;
+                }
+            }
+    }
+
+    // (5) families of parallel lines, strongest lines first
+    std::vector<LidT> order( lines.size() );
+    for ( LidT l = 0; l != static_cast<LidT>(lines.size()); ++l )
+        order[l] = l;
+    std::sort( order.begin(), order.end(), [&lines]( LidT a, LidT b ) { return lines[a].votes > lines[b].votes; } );
+
+    std::vector<Vector3> familyDirs;
+    for ( size_t o = 0; o != order.size(); ++o )
+    {
+        HoughLineT &line = lines[ order[o] ];
+        for ( size_t f = 0; f != familyDirs.size() && line.family < 0; ++f )
+            if ( segmentation::houghAngle<_Scalar>(familyDirs[f], line.dir()) < angleLimit )
+                line.family = f;
+        if ( line.family < 0 )
+        {
+            line.family = familyDirs.size();
+            familyDirs.push_back( line.dir() );
+        }
+    }
+
+    // vote weighted direction of each family
+    std::vector<Vector3> familySums( familyDirs.size(), Vector3::Zero() );
+    for ( size_t l = 0; l != lines.size(); ++l )
+    {
+        const Vector3 dir = lines[l].dir();
+        familySums[ lines[l].family ] += ((dir.dot(familyDirs[lines[l].family]) < _Scalar(0.)) ? Vector3(-dir) : dir) * lines[l].votes;
+    }
+    for ( size_t f = 0; f != familyDirs.size(); ++f )
+        familyDirs[f] = familySums[f].normalized();
+
+    // (6) split lines to patches at gaps
+    std::vector< std::vector<LidT> > linePoints( lines.size() );
+    for ( LidT pid = 0; pid != N; ++pid )
+        if ( pointLines[pid] >= 0 )
+            linePoints[ pointLines[pid] ].push_back( pid );
+
+    const GidT offset = groups_arg.size();
+    while ( static_cast<GidT>(dirGids.size()) < offset )
+        dirGids.push_back( dirGids.size() );
+    dirGids.resize( offset );
+    std::vector<DidT> familyGids( familyDirs.size(), -1 );
+    std::vector<char> grouped( N, 0 );
+    for ( size_t o = 0; o != order.size(); ++o )
+    {
+        const LidT     l    = order[o];
+        const Vector3  dir  = familyDirs[ lines[l].family ];
+        std::vector< std::pair<_Scalar,LidT> > along( linePoints[l].size() );
+        for ( size_t k = 0; k != linePoints[l].size(); ++k )
+            along[k] = std::make_pair( dir.dot(points[linePoints[l][k]].template pos()), linePoints[l][k] );
+        std::sort( along.begin(), along.end() );
+
+        for ( size_t start = 0, end = 0; start < along.size(); start = end )
+        {
+            for ( end = start + 1; end != along.size() && (along[end].first - along[end-1].first) <= gapLimit; ++end ) ;
+            if ( end - start < 2 )
+                continue;
+
+            PatchT patch;
+            for ( size_t k = start; k != end; ++k )
+            {
+                patch.push_back( segmentation::PidLid(along[k].second, -1) );
+                points[ along[k].second ].setTag( gid_tag_name, groups_arg.size() );
+                grouped[ along[k].second ] = 1;
+            }
+            patch.update( points );
+            patch.getRepresentative() = _PrimitiveT( patch.pos(), dir );
+
+            DidT &familyGid = familyGids[ lines[l].family ];
+            if ( familyGid < 0 )
+                familyGid = groups_arg.size();
+            dirGids.push_back( familyGid );
+            groups_arg.push_back( patch );
+        }
+    } //...for lines
+
+    // leftovers
+    for ( LidT pid = 0; pid != N; ++pid )
+        if ( !grouped[pid] )
+        {
+            points[pid].setTag( gid_tag_name, groups_arg.size() );
+            dirGids.push_back( groups_arg.size() );
+            groups_arg.push_back( PatchT(segmentation::PidLid(pid, -1)) );
+            groups_arg.back().update( points );
+        }
+
+    std::cout << "[" << __func__ << "]: " << thetaBins << "x" << rhoBins << " bins, " << lines.size() << " lines in " << familyDirs.size() << " directions, "
+              << groups_arg.size() - offset << " patches ("
+              << std::count( grouped.begin(), grouped.end(), 0 ) << " points left alone)" << std::endl;
+    if ( verbose )
+    {
+        for ( size_t l = 0; l != lines.size(); ++l )
+            std::cout << "\tline " << l << ": theta " << lines[l].theta << ", rho " << lines[l].rho << ", votes " << lines[l].votes << ", family " << lines[l].family << std::endl;
+        TOC( "hough", 1 )
+    }
+
+    return EXIT_SUCCESS;
+} // ...Segmentation::houghGroup()
+
 /*  \brief                  Step 1. Generates primitives from a cloud. Reads "cloud.ply" and saves "candidates.txt".
  *  \param argc             Contains --cloud cloud.ply, and --scale scale.
  *  \param argv             Contains --cloud cloud.ply, and --scale scale.
@@ -673,6 +1380,12 @@ Segmentation::segmentCli( int    argc
     std::string                 mode_string             = "representative_sqr";
     std::vector<std::string>    mode_opts               = { "representative_sqr" };
     bool                        verbose                 = false;
+    bool                        agglomerative           = false;
+    std::string                 dendrogram_path         = "";
+    bool                        from_dendrogram         = false;
+    _Scalar                     cut_threshold           = _Scalar( 1. );
+    int                         hough_votes             = 0;
+    bool                        orient_consistently     = false;
 
     // parse input
     if ( err == EXIT_SUCCESS )
@@ -710,6 +1423,14 @@ Segmentation::segmentCli( int    argc
 
         pcl::console::parse_argument( argc, argv, "--patch-pop-limit", generatorParams.patch_population_limit );
 
+        agglomerative   = pcl::console::find_switch( argc, argv, "--agglomerative" );
+        from_dendrogram = pcl::console::parse_argument( argc, argv, "--from-dendrogram", dendrogram_path ) >= 0;
+        if ( !from_dendrogram )
+            pcl::console::parse_argument( argc, argv, "--dendrogram", dendrogram_path );
+        pcl::console::parse_argument( argc, argv, "--cut", cut_threshold );
+        pcl::console::parse_argument( argc, argv, "--hough", hough_votes );
+        orient_consistently = pcl::console::find_switch( argc, argv, "--orient" );
+
         // print usage
         {
             std::cerr << "[" << __func__ << "]: " << "Usage:\t " << argv[0] << " --segment \n";
@@ -727,6 +1448,12 @@ Segmentation::segmentCli( int    argc
             std::cerr << "\t [--angle-gens "; for(size_t i=0;i!=angle_gens.size();++i)std::cerr<<angle_gens[i];std::cerr<<"]\n";
             std::cerr << "\t [--no-paral]\n";
             std::cerr << "\t [--pop-limit " << generatorParams.patch_population_limit << "]\t Filters patches smaller than this.\n";
+            std::cerr << "\t [--agglomerative]\t Nearest-neighbour-chain clustering instead of region growing, saves the dendrogram.\n";
+            std::cerr << "\t [--dendrogram <cloud_dir>/dendrogram.bin]\t Where --agglomerative saves the dendrogram.\n";
+            std::cerr << "\t [--from-dendrogram path]\t Cut the patches from a saved dendrogram, no neighbourhood queries.\n";
+            std::cerr << "\t [--cut " << cut_threshold << "]\t Linkage threshold of the dendrogram cut, 1: --angle-limit and --dist-limit-mult.\n";
+            std::cerr << "\t [--hough " << hough_votes << "]\t 2D: group by line voting instead of region growing, peaks need this many votes. Parallel patches share directions.\n";
+            std::cerr << "\t [--orient]\t Propagate a consistent sign over the local fit directions of unoriented clouds.\n";
             std::cerr << "\t [-v, --verbose]\n";
             std::cerr << std::endl;
 
@@ -734,11 +1461,23 @@ Segmentation::segmentCli( int    argc
                 return EXIT_FAILURE;
         }
 
+        if ( (hough_votes > 0) && (agglomerative || from_dendrogram) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "--hough can't be combined with --agglomerative or --from-dendrogram" << std::endl;
+            return EXIT_FAILURE;
+        }
+
         if ( boost::filesystem::is_directory(cloud_path) )
         {
             cloud_path += "/cloud.ply";
         }
 
+        if ( dendrogram_path.empty() )
+        {
+            std::string cloud_dir = boost::filesystem::path( cloud_path ).parent_path().string();
+            dendrogram_path = (cloud_dir.empty() ? std::string(".") : cloud_dir) + "/dendrogram.bin";
+        }
+
         if ( !boost::filesystem::exists(cloud_path) )
         {
             std::cerr << "[" << __func__ << "]: " << "cloud file does not exist! " << cloud_path << std::endl;
@@ -778,7 +1517,7 @@ Segmentation::segmentCli( int    argc
     // orientPoints
     if ( (EXIT_SUCCESS == err) && !isOriented )
     {
-        err = Segmentation::orientPoints<_PointPrimitiveT,_PrimitiveT>( points, generatorParams.scale, generatorParams.nn_K, verbose );
+        err = Segmentation::orientPoints<_PointPrimitiveT,_PrimitiveT>( points, generatorParams.scale, generatorParams.nn_K, verbose, orient_consistently );
         if ( err != EXIT_SUCCESS ) std::cerr << "[" << __func__ << "]: " << "orientPoints exited with error! Code: " << err << std::endl;
     } //...orientPoints
 
@@ -795,15 +1534,36 @@ Segmentation::segmentCli( int    argc
                                                                                    , generatorParams.angle_limit
                                                                                    , generatorParams.scale
                                                                                    , generatorParams.patch_spatial_weight );
-                err = Segmentation::patchify<_PrimitiveT>( initial_primitives    // tagged lines at GID with patch_id
-                                            , points                            // filled points with directions and tagged at GID with patch_id
-                                            , generatorParams.scale
-                                            , generatorParams.angles
-                                            , patchPatchDistanceFunctor
-                                            , generatorParams.nn_K
-                                            , verbose
-                                            , ((generatorParams.patch_population_limit > 0) ? generatorParams.patch_population_limit : 0)
-                                            );
+
+                // hierarchical grouping: build or load the dendrogram once, cut it at cut_threshold
+                segmentation::Dendrogram<_Scalar>        dendrogram;
+                segmentation::Dendrogram<_Scalar> const* p_dendrogram = NULL;
+                if ( from_dendrogram )
+                {
+                    err          = io::readDendrogram( dendrogram, dendrogram_path );
+                    p_dendrogram = &dendrogram;
+                }
+                else if ( agglomerative )
+                {
+                    err = Segmentation::agglomerate<_PrimitiveT>( dendrogram, points, patchPatchDistanceFunctor, generatorParams.nn_K, verbose );
+                    if ( EXIT_SUCCESS == err )
+                        err = io::writeDendrogram( dendrogram, dendrogram_path );
+                    p_dendrogram = &dendrogram;
+                }
+
+                if ( EXIT_SUCCESS == err )
+                    err = Segmentation::patchify<_PrimitiveT>( initial_primitives    // tagged lines at GID with patch_id
+                                                , points                            // filled points with directions and tagged at GID with patch_id
+                                                , generatorParams.scale
+                                                , generatorParams.angles
+                                                , patchPatchDistanceFunctor
+                                                , generatorParams.nn_K
+                                                , verbose
+                                                , ((generatorParams.patch_population_limit > 0) ? generatorParams.patch_population_limit : 0)
+                                                , p_dendrogram
+                                                , cut_threshold
+                                                , hough_votes
+                                                );
             }
                 break;
 
@@ -1,6 +1,8 @@
 #ifndef RAPTER_SOLVER_HPP
 #define RAPTER_SOLVER_HPP
 
+#include <random>
+#include <sstream>
 #include "Eigen/Sparse"
 
 #ifdef RAPTER_USE_PCL
@@ -15,9 +17,12 @@
 #include "rapter/util/util.hpp"                     // timestamp2Str
 
 #include "rapter/io/io.h"
+#include "rapter/io/checkpoint.hpp"               // SolverCheckpoint
 //#include "rapter/optimization/candidateGenerator.h" // generate()
 //#include "rapter/optimization/energyFunctors.h"     // PointLineDistanceFunctor,
 #include "rapter/optimization/problemSetup.h"         // everyPatchNeedsDirection()
+#include "rapter/optimization/energyEvaluator.h"      // EnergyEvaluator
+#include "rapter/optimization/lowerBound.h"           // LagrangianBound
 #include "rapter/processing/diagnostic.hpp"           // Diagnostic
 #include "rapter/processing/impl/angleUtil.hpp"
 
@@ -47,6 +52,10 @@ Solver::solve( int    argc
     std::string                           x0_path       = "";
     int                                   attemptCount  = 0;
     std::string                           energy_path        = "energy.csv";
+    unsigned int                          seed          = 123456;
+    bool                                  resume        = false;
+    std::string                           checkpoint_path;
+    int                                   bound_iter    = 200;
 
     // parse
     {
@@ -81,6 +90,15 @@ Solver::solve( int    argc
         pcl::console::parse_argument( argc, argv, "--bmode", bmode );
         pcl::console::parse_argument( argc, argv, "--rod"  , rel_out_path );
 
+        // starting point seed and snapshots
+        pcl::console::parse_argument( argc, argv, "--seed", seed );
+        checkpoint_path = project_path + "/solve.ckpt";
+        pcl::console::parse_argument( argc, argv, "--checkpoint", checkpoint_path );
+        if ( pcl::console::find_switch(argc,argv,"--no-checkpoint") )
+            checkpoint_path.clear();
+        resume = pcl::console::find_switch( argc, argv, "--resume" );
+        pcl::console::parse_argument( argc, argv, "--bound-iter", bound_iter );
+
         // X0
         if (pcl::console::parse_argument( argc, argv, "--x0", x0_path ) >= 0)
         {
@@ -106,6 +124,11 @@ Solver::solve( int    argc
                   << "\t[--verbose] " << "\n"
                   << "\t[--rod " << rel_out_path << "]\t\t Relative output directory\n"
                   << "\t[--x0 " << x0_path << "]\t Path to starting point sparse matrix\n"
+                  << "\t[--seed " << seed << "]\t Seed of the random starting point, if no --x0\n"
+                  << "\t[--checkpoint " << checkpoint_path << "]\t Snapshot path, removed after success\n"
+                  << "\t[--no-checkpoint]\n"
+                  << "\t[--resume]\t Continue from the snapshot, if it exists\n"
+                  << "\t[--bound-iter " << bound_iter << "]\t Lagrangian lower bound iterations to report the optimality gap, 0: off\n"
                   << "\t[--help, -h] "
                   << std::endl;
 
@@ -117,13 +140,39 @@ Solver::solve( int    argc
         } //...if valid_input
     } //...parse
 
+    // random stream of starting points, saved with every snapshot to be able to replay an attempt
+    typedef double OptScalar; // Mosek, and Bonmin uses double internally, so that's what we have to do...
+    std::mt19937                        rng( seed );
+    io::SolverCheckpoint<OptScalar>     ckpt;
+    bool                                resumed     = false, // a snapshot was loaded
+                                        ckptChecked = false; // snapshot compared to the problem, once it's read
+    if ( resume && !checkpoint_path.empty() )
+    {
+        if ( EXIT_SUCCESS == io::loadSolverCheckpoint(ckpt, checkpoint_path) )
+        {
+            resumed      = true;
+            attemptCount = ckpt.attempt;
+            if ( !ckpt.rngState.empty() )
+            {
+                std::istringstream iss( ckpt.rngState );
+                iss >> rng;
+            }
+            std::cout << "[" << __func__ << "]: " << "resuming from " << checkpoint_path << " at attempt " << attemptCount
+                      << (ckpt.done ? ", solution already found" : "") << std::endl;
+        }
+        else
+        {
+            std::cout << "[" << __func__ << "]: " << "no consistent snapshot at " << checkpoint_path << ", starting from scratch" << std::endl;
+            ckpt = io::SolverCheckpoint<OptScalar>();
+        }
+    } //...resume
+
     err = DO_RETRY; // flip to enter
     while ( (err == DO_RETRY) && (attemptCount < 2) )
     {
         err = EXIT_SUCCESS; // reset flag
 
         // select solver
-        typedef double OptScalar; // Mosek, and Bonmin uses double internally, so that's what we have to do...
         typedef qcqpcpp::OptProblem<OptScalar>  OptProblemT;
         typedef OptProblemT::SparseMatrix       SparseMatrix;
         OptProblemT *p_problem = NULL;
@@ -150,6 +199,20 @@ Solver::solve( int    argc
                 std::cerr << "[" << __func__ << "]: " << "Could not read problem, exiting" << std::endl;
         } //...problem.read()PrimitiveT
 
+        // check, that the snapshot belongs to this problem, start from scratch otherwise
+        if ( (EXIT_SUCCESS == err) && !ckptChecked )
+        {
+            if ( resumed && !ckpt.matchesProblem(*p_problem) )
+            {
+                std::cout << "[" << __func__ << "]: " << "ignoring snapshot " << checkpoint_path << ", starting from scratch" << std::endl;
+                ckpt         = io::SolverCheckpoint<OptScalar>();
+                attemptCount = 0;
+                rng.seed( seed );
+            }
+            ckpt.setProblem( *p_problem );
+            ckptChecked = true;
+        } //...check snapshot
+
         // problem.parametrize()
         {
             if ( max_time > 0 )
@@ -171,6 +234,23 @@ Solver::solve( int    argc
                     x0 = qcqpcpp::io::readSparseMatrix<OptScalar>( x0_path, 0 );
                     static_cast<qcqpcpp::BonminOpt<OptScalar>*>(p_problem)->setStartingPoint( x0 );
                 }
+                else if ( EXIT_SUCCESS == err )
+                {
+                    // seeded random starting point, so that a resumed attempt replays the same search
+                    std::ostringstream oss; oss << rng;
+                    ckpt.rngState = oss.str();
+
+                    OptProblemT::VectorX x0Dense( p_problem->getVarCount() );
+                    for ( size_t j = 0; j != p_problem->getVarCount(); ++j )
+                    {
+                        if (    (p_problem->getVarType(j) == OptProblemT::VAR_TYPE::INTEGER)
+                             || (p_problem->getVarType(j) == OptProblemT::VAR_TYPE::BINARY ) )
+                            x0Dense(j) = std::uniform_int_distribution<int>( p_problem->getVarLowerBound(j), p_problem->getVarUpperBound(j) )( rng );
+                        else
+                            x0Dense(j) = std::uniform_real_distribution<OptScalar>( p_problem->getVarLowerBound(j), p_problem->getVarUpperBound(j) )( rng );
+                    }
+                    p_problem->setStartingPointDense( x0Dense );
+                }
 
 #           endif // WITH_BONMIN
             }
@@ -190,13 +270,33 @@ Solver::solve( int    argc
             if ( verbose ) { std::cout << "[" << __func__ << "]: " << "problem update finished\n"; fflush(stdout); }
         } //...problem.update()
 
+        // lower bound, independent of the attempt
+        if ( (EXIT_SUCCESS == err) && (bound_iter > 0) && !std::isfinite(ckpt.lowerBound) )
+        {
+            LagrangianBound<OptScalar> bound( *p_problem );
+            ckpt.lowerBound = bound.compute( bound_iter );
+            std::cout << "[" << __func__ << "]: " << "lower bound " << ckpt.lowerBound
+                      << " from " << bound.getCoveringCount() << " covering rows, " << bound.getDirectionCount() << " directions"
+                      << ", dropped " << bound.getDroppedCount() << " constraints" << std::endl;
+        } //...lower bound
+
         // problem.optimize()
         if ( EXIT_SUCCESS == err )
         {
             // optimize
             std::vector<OptScalar> x_out;
-            if ( r == p_problem->getOkCode() )
+            if ( ckpt.done )
             {
+                // finished before the interruption, only the outputs need to be written
+                x_out = ckpt.incumbent;
+            }
+            else if ( r == p_problem->getOkCode() )
+            {
+                // snapshot before the attempt
+                ckpt.attempt = attemptCount;
+                if ( !checkpoint_path.empty() )
+                    io::saveSolverCheckpoint( ckpt, checkpoint_path );
+
                 // log
                 if ( verbose ) { std::cout << "[" << __func__ << "]: " << "calling problem optimize...\n"; fflush(stdout); }
 
@@ -209,6 +309,23 @@ Solver::solve( int    argc
                     std::cerr << "[" << __func__ << "]: " << "ooo...optimize didn't work with code " << r << std::endl; fflush(stderr);
                     err = r;
                 }
+
+                // snapshot of the incumbent
+                if ( (r == p_problem->getOkCode()) && x_out.size() )
+                {
+                    SparseMatrix xOut( x_out.size(), 1 );
+                    for ( size_t j = 0; j != x_out.size(); ++j )
+                        if ( x_out[j] != OptScalar(0.) )
+                            xOut.insert( j, 0 ) = x_out[j];
+
+                    ckpt.incumbent  = x_out;
+                    ckpt.upperBound = (xOut.transpose() * p_problem->getLinObjectivesMatrix()).eval().coeff(0,0)
+                                    + (xOut.transpose() * p_problem->getQuadraticObjectivesMatrix() * xOut).eval().coeff(0,0)
+                                    + p_problem->getObjectiveBias();
+                    ckpt.done       = std::accumulate( x_out.begin(), x_out.end(), 0 ) != 0;
+                    if ( !checkpoint_path.empty() )
+                        io::saveSolverCheckpoint( ckpt, checkpoint_path );
+                }
             } //...optimize
 
             if ( !x_out.size() || std::accumulate(x_out.begin(),x_out.end(),0) == 0 )
@@ -374,11 +491,22 @@ Solver::solve( int    argc
 
                     OptScalar dataC     = (xOut.transpose() * p_problem->getLinObjectivesMatrix()).eval().coeff(0,0);
                     OptScalar pairwiseC = (xOut.transpose() * p_problem->getQuadraticObjectivesMatrix() * xOut ).eval().coeff(0,0);
-                    std::cout << "E = " << dataC + pairwiseC << " = "
-                              << dataC << " (data) + " << pairwiseC << "(pw)"
+                    OptScalar biasC     = p_problem->getObjectiveBias(); // constant part, included in the lower bound too
+                    OptScalar energy    = dataC + pairwiseC + biasC;
+                    std::cout << "E = " << energy << " = "
+                              << dataC << " (data) + " << pairwiseC << "(pw) + " << biasC << " (bias)"
                               << std::endl;
+                    const bool bounded = std::isfinite( ckpt.lowerBound );
+                    if ( bounded )
+                        std::cout << "[" << __func__ << "]: " << "lower bound " << ckpt.lowerBound << ", gap " << energy - ckpt.lowerBound
+                                  << " (" << LagrangianBound<OptScalar>::relativeGap( energy, ckpt.lowerBound ) * 100. << "%)" << std::endl;
+
+                    // E,gap,data,pw,complexity; gap is left empty without a bound
                     std::ofstream fenergy( parent_path + "/" + energy_path, std::ofstream::out | std::ofstream::app );
-                    fenergy << dataC + pairwiseC << "," << dataC << "," << pairwiseC << "," << 0 << std::endl;
+                    fenergy << energy << ",";
+                    if ( bounded )
+                        fenergy << energy - ckpt.lowerBound;
+                    fenergy << "," << dataC << "," << pairwiseC << "," << 0 << std::endl;
                     fenergy.close();
                 } //...calcEnergy
             } //...if exit_success (solved)
@@ -388,6 +516,10 @@ Solver::solve( int    argc
         if ( p_problem ) { delete p_problem; p_problem = NULL; }
     } //...err == doRetry || exit_SUCCESS
 
+    // outputs are safe, snapshot is not needed anymore
+    if ( (EXIT_SUCCESS == err) && !checkpoint_path.empty() )
+        io::checkpoint::remove( checkpoint_path );
+
     return err;
 }
 
@@ -476,9 +608,10 @@ Solver::datafit( int    argc
     return err;
 } // ...Solver::datafit()
 
-//! \brief              Prints energy of solution in \p x using \p weights. Unused for now.
+//! \brief              Prints energy of solution in \p x using \p weights.
 //! \param[in] x        A solution to calculate the energy of.
 //! \param[in] weights  Problem weights used earlier. \todo Dump to disk together with solution.
+//! \sa                 \ref EnergyEvaluator for repeated evaluations and single variable changes.
 Eigen::Matrix<rapter::Scalar,3,1>
 Solver::checkSolution( std::vector<Scalar> const& x
                      , Solver::SparseMatrix const& linObj
@@ -486,44 +619,13 @@ Solver::checkSolution( std::vector<Scalar> const& x
                      , Solver::SparseMatrix const& /* A */
                      , Eigen::Matrix<Scalar,3,1> const& weights )
 {
-    Eigen::Matrix<Scalar,3,1> energy; energy.setZero();
-
-    SparseMatrix complexity( x.size(), 1 );
-    for ( size_t row = 0; row != x.size(); ++row )
-        complexity.insert( row, 0 ) = weights(2);
-
-    // X
-    SparseMatrix mx( x.size(), 1 );
-    for ( size_t i = 0; i != x.size(); ++i )
-        mx.insert( i, 0 ) = x[i];
-
-    SparseMatrix data   = linObj - complexity;
-
-    // qo
-    SparseMatrix e02 = mx.transpose() * linObj;
-    std::cout << "[" << __func__ << "]: " << "qo * x = " << e02.coeffRef(0,0) << std::endl; fflush(stdout);
-
-    // datacost
-    SparseMatrix e0 = (mx.transpose() * data);
-    energy(0) = e0.coeffRef(0,0);
-    //std::cout << "[" << __func__ << "]: " << "data: " << energy(0) << std::endl; fflush(stdout);
-
-    // Qo
-    SparseMatrix e1 = mx.transpose() * Qo * mx;
-    energy(1) = e1.coeffRef(0,0);
-    //std::cout << "[" << __func__ << "]: " << "x' * Qo * x = pw = " << energy(1) << std::endl; fflush(stdout);
-
-    // complexity
-    SparseMatrix e2 = mx.transpose() * complexity;
-    energy(2) = e2.coeffRef(0,0);
-    //std::cout << "[" << __func__ << "]: " << "complx = " << energy(2) << std::endl; fflush(stdout);
-    std::cout << "[" << __func__ << "]: " << std::setprecision(9) << energy(0) << " + " << energy(1) << " + " << energy(2) << " = " << energy.sum();
-    std::cout                             << std::setprecision(9) << weights(0) << " * " << energy(0)/weights(0)
-                                                                  << " + " << weights(1) << " * " << energy(1) / weights(1)
-                                                                  << " + " << weights(2) << " * " << energy(2) / weights(2)
-                                                                  << std::endl;
-
-    return energy;
+    EnergyEvaluator<Scalar> evaluator( linObj, Qo, weights(2) );
+    const EnergyEvaluator<Scalar>::Breakdown e = evaluator.evaluate( x );
+
+    std::cout << "[" << __func__ << "]: ";
+    evaluator.print( e, weights );
+
+    return Eigen::Matrix<Scalar,3,1>( e.data, e.pairwise, e.complexity );
 } //...checkSolution
 
 } // ... ns rapter
@@ -0,0 +1,79 @@
+#ifndef RAPTER_LOWERBOUND_H
+#define RAPTER_LOWERBOUND_H
+
+#include <vector>
+#include <limits>
+#include "rapter/simpleTypes.h" // LidT
+
+namespace rapter {
+
+    /*! \brief Lagrangian lower bound of a formulated selection problem, to report the optimality gap of a time-limited solve.
+     *
+     *         The problem is relaxed to a facility location problem, every step of which only lowers the optimum:
+     *          - Positive pairwise terms are dropped, negative ones are bounded by a linear term ( \f$ w x_i x_j \ge w x_i \f$ ), the diagonal is linear for binary variables.
+     *          - Covering rows ( \f$ \sum_j a_{rj} x_j \ge b_r, a_{rj} \ge 0, b_r > 0 \f$, i.e. "every patch needs a direction" ) are dualized with multipliers \f$ \lambda_r \ge 0 \f$.
+     *          - Direction rows ( \f$ d_k \sum_{i} x_i \ge \sum_{i} x_i \f$ ) are kept as implications \f$ x_i \le d_k \f$, so that a direction's complexity is paid once for all its members.
+     *          - Any other constraint is dropped.
+     *         For fixed multipliers the relaxation separates over the directions, and is solved in parallel.
+     *         The multipliers are improved by subgradient ascent, every iterate is a valid bound, the best one is kept.
+     *  \tparam _Scalar Concept: double, the precision of \ref qcqpcpp::OptProblem.
+     */
+    template <typename _Scalar>
+    class LagrangianBound
+    {
+        public:
+            typedef _Scalar Scalar;
+
+            /*! \brief Extracts the relaxation from a formulated problem.
+             *  \tparam _OptProblemT Concept: \ref qcqpcpp::OptProblem. Variables have to be bounded to [0,1].
+             */
+            template <class _OptProblemT>
+            explicit LagrangianBound( _OptProblemT const& problem );
+
+            //! \brief False, if the problem has variables not in [0,1]. \ref compute() returns -inf then.
+            inline bool isValid() const { return _valid; }
+
+            /*! \brief Runs subgradient ascent on the multipliers.
+             *  \param[in] maxIterations  Number of subgradient steps.
+             *  \param[in] upperBound     Objective of any feasible solution, used for the step length. If infinite, the all-ones solution is used.
+             *  \return                   Best lower bound found, -inf if \ref isValid() is false.
+             */
+            inline _Scalar compute( int const maxIterations = 200, _Scalar const upperBound = std::numeric_limits<_Scalar>::infinity() );
+
+            //! \brief Lagrangian value at \p lambdas. Fills the subgradient, if \p subgradient is not NULL.
+            inline _Scalar evaluate( std::vector<_Scalar> const& lambdas, std::vector<_Scalar> *subgradient = NULL ) const;
+
+            inline std::vector<_Scalar> const& getMultipliers() const { return _lambdas; }
+            inline LidT getCoveringCount()   const { return _rowStart.size() - 1; }
+            inline LidT getDirectionCount()  const { return _hubs.size(); }
+            inline LidT getDroppedCount()    const { return _droppedRows; }
+
+            //! \brief Relative optimality gap \f$ (ub - lb) / |ub| \f$.
+            static inline _Scalar relativeGap( _Scalar const upperBound, _Scalar const lowerBound );
+
+        protected:
+            typedef std::pair<LidT,_Scalar> EntryT; //!< \brief < variable id, coefficient >
+
+            std::vector<_Scalar>    _lin;           //!< \brief Linear costs after relaxing the quadratic objective.
+            _Scalar                 _bias;
+            _Scalar                 _allOnes;       //!< \brief Objective of the all-ones solution, fallback upper bound.
+
+            std::vector<LidT>       _rowStart;      //!< \brief CSR offsets of covering rows into _rowEntries.
+            std::vector<EntryT>     _rowEntries;
+            std::vector<_Scalar>    _rhs;           //!< \brief b_r of covering rows.
+            std::vector< std::vector<LidT> > _colRows;  //!< \brief Covering rows and coefficients of each variable, indices into _rowEntries.
+
+            std::vector<LidT>       _hubs;          //!< \brief Direction variables.
+            std::vector< std::vector<LidT> > _members; //!< \brief Variables implying each direction.
+            std::vector<LidT>       _free;          //!< \brief Variables neither direction, nor member.
+
+            std::vector<_Scalar>    _lambdas;
+            LidT                    _droppedRows;
+            bool                    _valid;
+    }; //...class LagrangianBound
+
+} //...namespace rapter
+
+#include "rapter/optimization/impl/lowerBound.hpp"
+
+#endif // RAPTER_LOWERBOUND_H
@@ -4,9 +4,12 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_set>
+#include <functional> // hash
 
 #include "qcqpcpp/optProblem.h"     // OptProblem
 #include "rapter/parameters.h"      // ProblemSetupParams
+#include "rapter/simpleTypes.h"     // LidT
 #include "rapter/util/pclUtil.h"    // PclCloudPtrT
 
 namespace rapter
@@ -19,6 +22,20 @@ namespace rapter
         //! \brief General problem type, most implementations require double, so it is fixed to double.
         typedef qcqpcpp::OptProblem<double> OptProblemT;
 
+        //! \brief Hashes a sorted list of variable ids, the signature of a covering constraint.
+        struct VarIdsHash
+        {
+            inline size_t operator()( std::vector<LidT> const& varIds ) const
+            {
+                size_t h = varIds.size();
+                for ( size_t i = 0; i != varIds.size(); ++i )
+                    h ^= std::hash<LidT>()( varIds[i] ) + size_t(0x9e3779b97f4a7c15ull) + (h << 6) + (h >> 2);
+                return h;
+            }
+        };
+        //! \brief Signatures of the covering constraints added to a problem, to skip duplicates.
+        typedef std::unordered_set< std::vector<LidT>, VarIdsHash > CoverSignatures;
+
         //! \brief              Adds constraints to \p problem so, that each patch (prims[i] that have the same _PrimitiveT::TAGS::GID) has at least one member j (prims[i][j]) selected.
         //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
         template < class _PointPrimitiveDistanceFunctor
@@ -38,7 +55,55 @@ namespace rapter
                                           , _AssocT              const& lids_varids
                                           , _WeightsT            const& /*weights*/
                                           , _Scalar              const  /*scale*/
-                                          , bool                 const  verbose = false );
+                                          , bool                 const  verbose     = false
+                                          , std::vector<char>    const* patchMask   = NULL
+                                          , CoverSignatures           * signatures  = NULL );
+
+        //! \brief              Adds constraints to \p problem so, that each point has at least one candidate selected, that explains it (is within \p scale of the point).
+        //!                     One constraint is added per unique set of explaining candidates.
+        //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+        template < class _PointPrimitiveDistanceFunctor
+                 , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+                 , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+                 , typename _Scalar
+                 , class _OptProblemT
+                 , class _PrimitiveContainerT
+                 , class _PointContainerT
+                 , class _AssocT
+                 , class _WeightsT
+                 >
+        static inline int
+        everyPointNeedsPatchConstraint( _OptProblemT              & problem
+                                      , _PrimitiveContainerT const& prims
+                                      , _PointContainerT     const& points
+                                      , _AssocT              const& lids_varids
+                                      , _WeightsT            const& /*weights*/
+                                      , _Scalar              const  scale
+                                      , bool                 const  verbose     = false
+                                      , std::vector<char>    const* pointMask   = NULL
+                                      , CoverSignatures           * signatures  = NULL );
+
+        //! \brief              Patch constraints for patches with at least \p patchPopLimit points, point constraints for the points of smaller patches.
+        //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+        template < class _PointPrimitiveDistanceFunctor
+                 , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+                 , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+                 , typename _Scalar
+                 , class _OptProblemT
+                 , class _PrimitiveContainerT
+                 , class _PointContainerT
+                 , class _AssocT
+                 , class _WeightsT
+                 >
+        static inline int
+        largePatchesNeedDirectionConstraint( _OptProblemT              & problem
+                                           , _PrimitiveContainerT const& prims
+                                           , _PointContainerT     const& points
+                                           , _AssocT              const& lids_varids
+                                           , _WeightsT            const& weights
+                                           , _Scalar              const  scale
+                                           , int                  const  patchPopLimit
+                                           , bool                 const  verbose = false );
 
         //! \brief              Adds unary costs to problem based on point to primitive associations.
         //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
@@ -61,6 +126,29 @@ namespace rapter
                                 , _Scalar              const  scale
                                 , _Scalar              const  freq_weight
                                 , bool                 const  verbose );
+
+        /*! \brief              Adds unary costs to problem based on the points within \p scale of each finite candidate, regardless of their patch assignment.
+         *                      The patch points farther than \p scale count as outliers with a truncated cost. Candidates are evaluated in parallel.
+         *  \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+         */
+        template < class _PointPrimitiveDistanceFunctor
+                 , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
+                 , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
+                 , typename _Scalar
+                 , class _OptProblemT
+                 , class _PrimitiveContainerT
+                 , class _PointContainerT
+                 , class _AssocT
+                 , class _WeightsT
+                 >
+        static inline int
+        bandBasedDataCost( _OptProblemT              & problem
+                         , _PrimitiveContainerT const& prims
+                         , _PointContainerT     const& points
+                         , _AssocT              const& lids_varids
+                         , _WeightsT            const& weights
+                         , _Scalar              const  scale
+                         , bool                 const  verbose );
     } //... namespace problemSetup
 
     //! \brief Class to formulate problem into an quadratic optimization problem.
@@ -78,6 +78,63 @@ namespace segmentation {
             _PrimitiveT _representative;
             _Scalar    _n;              //!< \brief How many points are averaged in _representative
     }; // ... struct Patch
+
+    /*! \brief Merge history of \ref Segmentation::agglomerate(). Leaves are the points, merge k creates node leafCount + k.
+     *         Heights are monotone (a merge is never lower than its children), so the patches of any threshold are the subtrees below it.
+     *  \tparam _Scalar Concept: float.
+     */
+    template <typename _Scalar>
+    struct Dendrogram
+    {
+        public:
+            struct Merge
+            {
+                LidT    left, right;    //!< \brief Node ids of the merged clusters.
+                _Scalar height;         //!< \brief Linkage value at the merge (max. with the children's heights).
+                LidT    size;           //!< \brief Point count of the new cluster.
+            };
+
+            Dendrogram() : leafCount( 0 ) {}
+
+            inline LidT getNodeCount() const { return leafCount + merges.size(); }
+
+            /*! \brief Labels the leaves by the clusters that exist at \p threshold. Linear in the number of nodes.
+             *  \param[out] labels     Cluster id for each leaf, numbered in order of first appearance.
+             *  \param[in]  threshold  Merges higher than this are undone.
+             *  \return                Number of clusters.
+             */
+            inline LidT cut( std::vector<LidT> &labels, _Scalar const threshold ) const
+            {
+                const LidT nodeCount = getNodeCount();
+                std::vector<LidT> parent( nodeCount, -1 );
+                for ( LidT k = 0; k != static_cast<LidT>(merges.size()); ++k )
+                    parent[ merges[k].left ] = parent[ merges[k].right ] = leafCount + k;
+
+                // topmost ancestor that is still merged at threshold, parents have higher ids than their children
+                std::vector<LidT> root( nodeCount );
+                for ( LidT node = nodeCount - 1; node >= 0; --node )
+                {
+                    const LidT p = parent[node];
+                    root[node] = ( (p >= 0) && (merges[p - leafCount].height <= threshold) ) ? root[p] : node;
+                }
+
+                std::vector<LidT> rootLabel( nodeCount, -1 );
+                LidT labelCount = 0;
+                labels.resize( leafCount );
+                for ( LidT leaf = 0; leaf != leafCount; ++leaf )
+                {
+                    LidT &label = rootLabel[ root[leaf] ];
+                    if ( label < 0 )
+                        label = labelCount++;
+                    labels[leaf] = label;
+                }
+
+                return labelCount;
+            } //...cut()
+
+            LidT                leafCount;  //!< \brief Number of points clustered.
+            std::vector<Merge>  merges;     //!< \brief In order of creation.
+    }; //...struct Dendrogram
 }
 
 class Segmentation
@@ -98,9 +155,10 @@ class Segmentation
         static int
         segmentCli( int argc, char** argv );
 
-        //! \param[in/out] points
-        //! \param[in]     scale    Fit radius
-        //! \param[in]     nn_K     Nearest neighbour count to fit primitive to.
+        //! \param[in/out] points      Gets the local fit directions.
+        //! \param[in]     scale       Fit radius
+        //! \param[in]     nn_K        Nearest neighbour count to fit primitive to.
+        //! \param[in]     consistent  Flip the directions to agree with their neighbours', see \ref processing::orientConsistently(). The fit neighbourhoods are reused.
         template < class     _PointPrimitiveT
                  , class     _PrimitiveT
                  , typename  _Scalar
@@ -110,7 +168,8 @@ class Segmentation
         orientPoints( _PointContainerT       &points
                     , _Scalar          const  scale
                     , int              const  nn_K
-                    , int              const  verbose );
+                    , int              const  verbose
+                    , bool             const  consistent = false );
 
         /*!
          * \brief patchify Groups unoriented points into oriented patches represented by a single primitive
@@ -124,6 +183,10 @@ class Segmentation
          * \param[in]  angles                    Desired angles to use for groupings.
          * \param[in]  patchPatchDistanceFunctor #regionGrow() uses the thresholds encoded to group points. The evalSpatial() function is used to assign orphan points.
          * \param[in]  nn_K                      Number of nearest neighbour points looked for in #regionGrow().
+         * \param[in]  dendrogram                Optional output of #agglomerate(). If given, the patches are cut from it instead of running #regionGrow().
+         * \param[in]  cutThreshold              Linkage threshold to cut \p dendrogram at. 1 corresponds to the thresholds of \p patchPatchDistanceFunctor.
+         * \param[in]  houghVotes                2D only. If positive, the patches are grouped by #houghGroup() with this peak threshold instead of #regionGrow(),
+         *                                       and patches on parallel lines share their direction id.
          */
         template <
                  class       _PrimitiveT
@@ -140,6 +203,9 @@ class Segmentation
                 , int                               const  nn_K
                 , int                               const  verbose
                 , size_t                            const  patchPopLimit
+                , segmentation::Dendrogram<_Scalar> const* dendrogram    = NULL
+                , _Scalar                           const  cutThreshold  = _Scalar(1.)
+                , LidT                              const  houghVotes    = 0
                 );
 
         /*! \brief                               Greedy region growing
@@ -176,6 +242,78 @@ class Segmentation
                   , bool                        const  verbose
                   );
 
+        /*! \brief Agglomerative clustering of oriented points by the nearest-neighbour-chain algorithm.
+         *         Clusters are only compared, if they are adjacent in the radius graph of the points (radius: spatial threshold of \p patchPatchDistanceFunctor, at most \p nn_K neighbours).
+         *         The linkage is \p patchPatchDistanceFunctor evaluated on the closest point pair of two clusters carrying the cluster representative directions,
+         *         aligned, so that unoriented normals can be grouped (single linkage in space, representative linkage in angle).
+         *         The full merge history is recorded, patches for a threshold can be cut from it by \ref segmentation::Dendrogram::cut(), or by #patchify().
+         *  \tparam _PatchPatchDistanceFunctorT Concept: \ref RepresentativeSqrPatchPatchDistanceFunctorT.
+         *  \param[out] dendrogram               Merge history, one leaf per point.
+         *  \param[in]  points                   Oriented points.
+         *  \param[in]  patchPatchDistanceFunctor Linkage and spatial neighbourhood size.
+         *  \param[in]  nn_K                     Maximum number of neighbours of a point in the adjacency graph.
+         */
+        template < class       _PrimitiveT
+                 , class       _PointContainerT
+                 , class       _PatchPatchDistanceFunctorT
+                 , typename    _Scalar              = typename _PrimitiveT::Scalar
+                 , class       _PointT              = typename _PointContainerT::value_type
+                 >
+        static int
+        agglomerate( segmentation::Dendrogram<_Scalar>      & dendrogram
+                   , _PointContainerT                  const& points
+                   , _PatchPatchDistanceFunctorT       const& patchPatchDistanceFunctor
+                   , int                               const  nn_K
+                   , bool                              const  verbose
+                   );
+
+        /*! \brief Groups the points by cutting \p dendrogram at \p threshold, and tags them by their group id.
+         *  \param[in,out] points       Points to tag at \p gid_tag_name.
+         *  \param[out]    groups_arg   One patch per cluster with aligned representative. Concept: vector< \ref segmentation::Patch >.
+         *  \return                     EXIT_FAILURE, if the dendrogram was built from a different number of points.
+         */
+        template < class       _PrimitiveT
+                 , class       _PointContainerT
+                 , class       _PatchesT
+                 , typename    _Scalar
+                 , class       _PointT              = typename _PointContainerT::value_type
+                 >
+        static int
+        cutDendrogram( _PointContainerT                       & points
+                     , _PatchesT                              & groups_arg
+                     , segmentation::Dendrogram<_Scalar> const& dendrogram
+                     , _Scalar                           const  threshold
+                     , GidT                              const  gid_tag_name );
+
+        /*! \brief Groups oriented 2D points by voting for lines in (theta, rho) space, no neighbourhood queries.
+         *         Bins are \p scale wide in rho and the angular threshold of \p patchPatchDistanceFunctor wide in theta. Local maxima of the
+         *         3x3 summed votes above \p minVotes are refit to their voters, and each point joins the closest line within both thresholds.
+         *         Collinear points are split to patches at gaps wider than the spatial threshold. Lines within the angular threshold form a family
+         *         with a common direction, which is written to the representatives, and seeded as a shared direction id.
+         *         Points without a line stay alone in their patch.
+         *  \param[in,out] points       Points to tag at \p gid_tag_name. Their directions are the local line directions, see #orientPoints().
+         *  \param[out]    groups_arg   One patch per line segment, and one per leftover point. Concept: vector< \ref segmentation::Patch >.
+         *  \param[out]    dirGids      Direction id for each patch in \p groups_arg: the id of the family's first patch, or its own id.
+         *  \param[in]     minVotes     Peak threshold on the 3x3 summed accumulator.
+         */
+        template < class       _PrimitiveT
+                 , class       _PointContainerT
+                 , class       _PatchPatchDistanceFunctorT
+                 , class       _PatchesT
+                 , typename    _Scalar              = typename _PrimitiveT::Scalar
+                 , class       _PointT              = typename _PointContainerT::value_type
+                 >
+        static int
+        houghGroup( _PointContainerT                 & points
+                  , _PatchesT                        & groups_arg
+                  , std::vector<DidT>                & dirGids
+                  , _Scalar                     const  scale
+                  , _PatchPatchDistanceFunctorT const& patchPatchDistanceFunctor
+                  , LidT                        const  minVotes
+                  , GidT                        const  gid_tag_name
+                  , bool                        const  verbose
+                  );
+
         /*! \brief  Fits a local direction to each point and it's neighourhood.
          *          Create local fits to local neighbourhoods, these will be the point orientations.
          *  \tparam PrimitiveContainerT Concept: vector< vector< LinePrimitive2/PlanePrimitive > >.
@@ -192,6 +330,7 @@ class Segmentation
                 , bool                 const  soft_radius
                 , std::vector<PidT>          * mapping
                 , int                    const  verbose
+                , std::vector< std::vector<int> > *neighbourhoods = NULL
                 );
     protected:
         template < class    _PointPrimitiveT
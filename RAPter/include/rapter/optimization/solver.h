@@ -35,7 +35,7 @@ class Solver
                  >
         static inline int datafit    ( int argc, char** argv );
 
-        /*! \brief Unused for now. */
+        /*! \brief Prints and returns the data, pairwise and complexity energy of \p x. \sa \ref EnergyEvaluator. */
         static inline Eigen::Matrix<rapter::Scalar,3,1> checkSolution( std::vector<Scalar>       const& x
                                                                   , SparseMatrix              const& qo
                                                                   , SparseMatrix              const& Qo
@@ -2,6 +2,7 @@
 #define RAPTER_PARAMETERS_H
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "Eigen/Dense"
@@ -201,6 +202,38 @@ namespace rapter {
         _Scalar spatial_threshold_mult = _Scalar( 2.5 );
 
         bool is3D;
+
+        //! \brief Snapshot path of \ref merging::iterativeMerge(). Empty: no checkpointing.
+        std::string checkpoint_path;
+
+        //! \brief A snapshot is written after every checkpoint_every-th merge iteration.
+        int checkpoint_every = 1;
+
+        //! \brief Continue from the snapshot at checkpoint_path, if there is a consistent one.
+        bool resume = false;
+    };
+
+    //! \brief Collection of parameters for \ref processing::polygonizeCli.
+    template <typename _Scalar>
+    struct PolygonizeParams : public CommonParams<_Scalar>
+    {
+        using CommonParams<_Scalar>::scale;
+
+        //! \brief Alpha radius of the concave hull is alpha_mult * scale.
+        _Scalar alpha_mult          = _Scalar( 2. );
+
+        //! \brief Points are thinned to one per (decimate_mult * scale) sized cell before the hull is computed. 0 disables thinning.
+        _Scalar decimate_mult       = _Scalar( 0.25 );
+
+        /*! \brief Multiplied by scale decides, whether a polygon reaches an intersection line, and how far it may overshoot it to be clipped.
+         *         Used in \ref processing::clipAlongIntersections(). */
+        _Scalar clip_dist_mult      = _Scalar( 2. );
+
+        //! \brief Planes closer to parallel than this angle (radians) are not clipped against each other.
+        _Scalar clip_min_angle      = _Scalar( 15. * M_PI / 180. );
+
+        //! \brief Clip adjacent polygons along their intersection lines.
+        bool    do_clip             = true;
     };
 
 }
@@ -45,62 +45,52 @@ namespace rapter
             return 0;
         }
 
-        // select inliers
-        std::vector<PidT> inliers;
-        inliers.reserve( cloud.size() );
-        const PidT stop_at = indices_arg ? indices_arg->size() : cloud.size();
+        // select inliers and track the extremal projections in one pass, without copying them
+        const Position line_dir = this->dir();
+        const PidT     stop_at  = indices_arg ? indices_arg->size() : cloud.size();
+        Position       p0, min_pnt, max_pnt;
+        Scalar         min_dist = 0.f, max_dist = 0.f;
+        PidT           inlierCount = 0;
         for ( PidT i = 0; i != stop_at; ++i )
         {
             const PidT pid = indices_arg ? (*indices_arg)[i] : i;
-            if ( this->getDistance( cloud[pid].template pos() ) < threshold )
-                inliers.push_back( pid );
-        }
-
-        // check size
-        if ( !inliers.size() )
-        {
-            std::cerr << "no inliers for primitive gid"
-                      << this->getTag( TAGS::GID ) << ", did "
-                      << this->getTag( TAGS::DIR_GID ) << std::endl;
-                      return EXIT_FAILURE;
-        }
-
-        // project cloud
-        std::vector<Position> on_line_cloud;
-        for ( UPidT pid_id = 0; pid_id != inliers.size(); ++pid_id )
-        {
-            const UPidT pid = inliers[ pid_id ];
-            on_line_cloud.push_back( this->projectPoint(cloud[pid].template pos()) );
-        }
+            if ( !(this->getDistance( cloud[pid].template pos() ) < threshold) )
+                continue;
 
+            const Position p1 = this->projectPoint( cloud[pid].template pos() );
+            if ( !inlierCount++ )
+            {
+                p0 = min_pnt = max_pnt = p1;
+                continue;
+            }
 
-        // select min-max inliier from projected cloud
-        Scalar min_dist = 0.f, max_dist = 0.f;
-        PidT     min_id   = 0  , max_id   = 0;
-        Position    p0       = on_line_cloud[0];
-        Position    line_dir = this->dir();
-
-        for ( size_t point_id = 1; point_id != on_line_cloud.size(); ++point_id )
-        {
-            Position const& p1   = on_line_cloud[ point_id ];
-            Position        p0p1 = p1-p0;
-            float           dist = p0p1.dot( p0 + line_dir );
+            Position p0p1 = p1-p0;
+            float    dist = p0p1.dot( p0 + line_dir );
             if ( dist < min_dist )
             {
                 min_dist = dist;
-                min_id   = point_id;
+                min_pnt  = p1;
             }
             else if ( dist > max_dist )
             {
                 max_dist = dist;
-                max_id   = point_id;
+                max_pnt  = p1;
             }
         }
 
+        // check size
+        if ( !inlierCount )
+        {
+            std::cerr << "no inliers for primitive gid"
+                      << this->getTag( TAGS::GID ) << ", did "
+                      << this->getTag( TAGS::DIR_GID ) << std::endl;
+                      return EXIT_FAILURE;
+        }
+
         // output
         minMax.resize( 2 );
-        minMax[0] = on_line_cloud[ min_id ];
-        minMax[1] = on_line_cloud[ max_id ];
+        minMax[0] = min_pnt;
+        minMax[1] = max_pnt;
 
         this->_extents.update( minMax );
 
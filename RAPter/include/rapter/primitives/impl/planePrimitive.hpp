@@ -143,102 +143,118 @@ namespace rapter
                                                      );
         }
 
-        Eigen::Matrix<Scalar,4,4> frame; // 3 major vectors as columns, and the fourth is the centroid
+        // frame and rotations in accumulation precision, point coordinates stay in storage precision
+        typedef Eigen::Matrix<AccumScalar,3,1> AccumPosition;
+        Eigen::Matrix<AccumScalar,4,4> frame; // 3 major vectors as columns, and the fourth is the centroid
         {
             processing::PCA<_IndicesContainerT>( frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, already full cloud
 
             if ( force_axis_aligned )
             {
                 // get the unit axis that is most perpendicular to the 3rd dimension of the frame
-                std::pair<Position,Scalar> dim3( Position::Zero(), Scalar(FLT_MAX) );
+                std::pair<AccumPosition,AccumScalar> dim3( AccumPosition::Zero(), AccumScalar(FLT_MAX) );
                 {
-                    Scalar tmp;
-                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( Position::UnitX() ))) < dim3.second ) { dim3.first = Position::UnitX(); dim3.second = tmp; }
-                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( Position::UnitY() ))) < dim3.second ) { dim3.first = Position::UnitY(); dim3.second = tmp; }
-                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( Position::UnitZ() ))) < dim3.second ) { dim3.first = Position::UnitZ(); dim3.second = tmp; }
+                    AccumScalar tmp;
+                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( AccumPosition::UnitX() ))) < dim3.second ) { dim3.first = AccumPosition::UnitX(); dim3.second = tmp; }
+                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( AccumPosition::UnitY() ))) < dim3.second ) { dim3.first = AccumPosition::UnitY(); dim3.second = tmp; }
+                    if ( (tmp=std::abs(frame.col(2).template head<3>().dot( AccumPosition::UnitZ() ))) < dim3.second ) { dim3.first = AccumPosition::UnitZ(); dim3.second = tmp; }
                 }
                 frame.col(0).head<3>() = frame.col(2).head<3>().cross( dim3.first             ).normalized();
                 frame.col(1).head<3>() = frame.col(2).head<3>().cross( frame.col(0).head<3>() ).normalized();
             }
-            else
+        } //...estimate frame
+
+        // centered coordinates, so that the caliper sweep only needs dot products instead of transformed copies of the cloud
+        std::vector<Position> centered( on_plane_cloud.size() );
+        {
+            const AccumPosition centroid = frame.block<3,1>(0,3);
+#           pragma omp parallel for num_threads(4)
+            for ( UPidT pid_id = 0; pid_id < on_plane_cloud.size(); ++pid_id )
+                centered[pid_id] = (on_plane_cloud[pid_id].template pos().template cast<AccumScalar>() - centroid).template cast<Scalar>();
+        }
+
+        // min and max of the centered cloud along three axes (the local frame of getMinMax3D( cloud2Local(frame) ))
+        auto localMinMax = [&centered]( Eigen::Matrix<AccumScalar,3,3> const& axes, Position &min_pt, Position &max_pt )
+        {
+            const Eigen::Matrix<Scalar,3,3> axesT = axes.transpose().template cast<Scalar>();
+            min_pt.setConstant(  FLT_MAX );
+            max_pt.setConstant( -FLT_MAX );
+            for ( UPidT pid_id = 0; pid_id != centered.size(); ++pid_id )
             {
+                const Position local = axesT * centered[pid_id];
+                min_pt = min_pt.cwiseMin( local );
+                max_pt = max_pt.cwiseMax( local );
+            }
+        };
+
+        if ( !force_axis_aligned )
+        {
 #if 1
-                Scalar step      = Scalar(1. * M_PI) / Scalar(180.);
-                Scalar limits[2] = { -Scalar(M_PI_4), Scalar(M_PI_4) };
-                for ( int it = 0; it != 2; ++it, step /= Scalar(5.) )
+            AccumScalar step      = AccumScalar(1. * M_PI) / AccumScalar(180.);
+            AccumScalar limits[2] = { -AccumScalar(M_PI_4), AccumScalar(M_PI_4) };
+            for ( int it = 0; it != 2; ++it, step /= AccumScalar(5.) )
+            {
+                std::pair <AccumScalar,Scalar> min_volume; // <ang, volume>
+                min_volume.first  = AccumScalar(-1.);
+                min_volume.second = Scalar(FLT_MAX);
+                int i = 0;
+                for ( AccumScalar ang = limits[0]; ang < limits[1]; ang += step, ++i )
                 {
-                    std::pair <Scalar,Scalar> min_volume; // <ang, volume>
-                    min_volume.first  = Scalar(-1.);
-                    min_volume.second = Scalar(FLT_MAX);
-                    int i = 0;
-                    for ( Scalar ang = limits[0]; ang < limits[1]; ang += step, ++i )
+                    // rotate frame around up_vector by ang
+                    Eigen::Matrix<AccumScalar,3,3> axes = frame.block<3,3>(0,0);
+                    Eigen::AngleAxis<AccumScalar> rot( ang, axes.col(2) );
+                    axes.col(0) = rot * axes.col(0);
+                    axes.col(1) = rot * axes.col(1);
+
+                    // calculate volume
+                    Position min_pt, max_pt;
+                    localMinMax( axes, min_pt, max_pt );
+
+                    Eigen::Vector3f diag    = max_pt - min_pt;
+
+                    //get location of minimum
+                    Eigen::MatrixXf::Index minRow, minCol;
+                    diag.minCoeff( &minRow, &minCol );
+                    float volume = 0.;
+                    if ( minRow == 1 )
+                        volume = diag(0) * diag(2);
+                    else if ( minRow )
+                        volume = diag(0) * diag(1);
+                    else
+                        volume = diag(1) * diag(2);
+                    // select min
+                    if ( volume < min_volume.second )
                     {
-                        //                std::cout << "rot by " << ang << ", step: " << step << std::endl;
-                        // rotated frame
-                        Eigen::Matrix4f tmp_frame = frame;
-
-                        // rotate frame around up_vector by ang
-                        Eigen::AngleAxisf rot( ang, tmp_frame.block<3,1>(0,2) );
-                        tmp_frame.block<3,1>(0,0) = rot * tmp_frame.block<3,1>(0,0);
-                        tmp_frame.block<3,1>(0,1) = rot * tmp_frame.block<3,1>(0,1);
-
-                        // calculate volume
-                        _PointContainerT local_cloud;
-                        processing::cloud2Local<_PointPrimitiveT,_IndicesContainerT>( local_cloud, tmp_frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, it's already a full cloud
-
-                        _PointPrimitiveT min_pt, max_pt;
-                        processing::getMinMax3D<_IndicesContainerT>( min_pt, max_pt, local_cloud, /* indices: */ NULL );
-
-                        Eigen::Vector3f diag    = max_pt.template pos() - min_pt.template pos();
-
-                        //get location of minimum
-                        Eigen::MatrixXf::Index minRow, minCol;
-                        diag.minCoeff( &minRow, &minCol );
-                        //                std::cout << "minRow: " << minRow << std::endl;
-                        float volume = 0.;
-                        if ( minRow == 1 )
-                            volume = diag(0) * diag(2);
-                        else if ( minRow )
-                            volume = diag(0) * diag(1);
-                        else
-                            volume = diag(1) * diag(2);
-                        // select min
-                        if ( volume < min_volume.second )
-                        {
-                            min_volume.first  = ang;
-                            min_volume.second = volume;
-                        }
-                    } // for caliper angles
-
-                    // selected apply rotation
-                    Eigen::AngleAxisf rot( min_volume.first, frame.block<3,1>(0,2) );
-                    frame.block<3,1>(0,0) = rot * frame.block<3,1>(0,0);
-                    frame.block<3,1>(0,1) = rot * frame.block<3,1>(0,1);
-
-                    // modify lookup around chosen angle for next iteration
-                    limits[0] = -step/2.f;
-                    limits[1] = limits[0] + step;
-                } //...for caliper levels
+                        min_volume.first  = ang;
+                        min_volume.second = volume;
+                    }
+                } // for caliper angles
+
+                // selected apply rotation
+                Eigen::AngleAxis<AccumScalar> rot( min_volume.first, AccumPosition(frame.block<3,1>(0,2)) );
+                frame.block<3,1>(0,0) = rot * frame.block<3,1>(0,0);
+                frame.block<3,1>(0,1) = rot * frame.block<3,1>(0,1);
+
+                // modify lookup around chosen angle for next iteration
+                limits[0] = -step/AccumScalar(2.);
+                limits[1] = limits[0] + step;
+            } //...for caliper levels
 #endif
-            } //calipers
-        } //...estimate frame
-
-        _PointContainerT local_cloud;
-        processing::cloud2Local<_PointPrimitiveT,_IndicesContainerT>( local_cloud, frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, it's already a full cloud
+        } //calipers
 
-        _PointPrimitiveT min_pt, max_pt;
-        processing::getMinMax3D<_IndicesContainerT>( min_pt, max_pt, local_cloud, /* indices: */ NULL );
+        Position min_pt, max_pt;
+        localMinMax( frame.block<3,3>(0,0), min_pt, max_pt );
 
         minMax.resize( 4 );
-        minMax[0]    = minMax[1] = min_pt.template pos();
-        minMax[1](1)             = max_pt.template pos()(1);
-        minMax[2]    = minMax[3] = max_pt.template pos();
-        minMax[3](1)             = min_pt.template pos()(1);
+        minMax[0]    = minMax[1] = min_pt;
+        minMax[1](1)             = max_pt(1);
+        minMax[2]    = minMax[3] = max_pt;
+        minMax[3](1)             = min_pt(1);
 
         for ( int d = 0; d != 4; ++d )
         {
             // to world
-            minMax[d] = (frame * (Eigen::Matrix<Scalar,4,1>() << minMax[d], Scalar(1)).finished()).template head<3>();
+            minMax[d] = (frame * (Eigen::Matrix<AccumScalar,4,1>() << minMax[d].template cast<AccumScalar>(), AccumScalar(1)).finished()).template head<3>().template cast<Scalar>();
         }
 
         this->_extents.update( minMax );
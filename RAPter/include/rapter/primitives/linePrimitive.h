@@ -28,6 +28,7 @@ namespace rapter
             typedef ::rapter::Primitive<2,6>   ParentT;
         public:
             typedef ParentT::Scalar         Scalar;
+            typedef ParentT::AccumScalar    AccumScalar;
             typedef ParentT::Position       Position;
             typedef ParentT::ExtremaT       ExtremaT;
 
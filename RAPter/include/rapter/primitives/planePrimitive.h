@@ -31,6 +31,7 @@ namespace rapter
         public:
             //enum { Dim = ParentT::Dim };
             typedef ParentT::Scalar Scalar;
+            typedef ParentT::AccumScalar AccumScalar;
             typedef std::vector<Eigen::Matrix<Scalar,3,1> > ExtentsT;
 
             // ____________________CONSTRUCT____________________
@@ -55,8 +55,9 @@ namespace rapter
       *  \tparam _EmbedSpaceDim Hack to know, if the embedding space is 2D or 3D. TODO: don't use smartgeometry::fitlinearprimitve in \ref Segment::fitLocal()
       *  \tparam _Dim           Length of internal vector storage. Should be able to fit any primitive.
       *  \tparam _Scalar        Internal data type. Concept: float.
+      *  \tparam _AccumScalar   Precision of sums over many points (e.g. in getExtent). Concept: double.
       */
-    template <int _EmbedSpaceDim, int _Dim, typename _Scalar = float>
+    template <int _EmbedSpaceDim, int _Dim, typename _Scalar = float, typename _AccumScalar = __AccumScalar>
     class Primitive : public ::rapter::Taggable<_Scalar>
     {
         public:
@@ -100,6 +101,7 @@ namespace rapter
 
             // ____________________TYPEDEFS____________________
             typedef _Scalar                      Scalar;     //!< Scalar typedef to reach from outside.
+            typedef _AccumScalar                 AccumScalar;//!< Accumulation precision typedef to reach from outside.
             enum {  Dim                        = _Dim };     //!< Standard typedef for _Dim template parameter.
             typedef Eigen::Matrix<Scalar,_Dim,1> VectorType; //!< Standard typedef of internal storage Eigen::Matrix.
             typedef Eigen::Matrix<Scalar,3,1>    Position;   //!< \brief Standard 3D point typedef.
@@ -285,12 +287,12 @@ namespace rapter
 //    };
 
 
-    template <int _EmbedSpaceDim, int _Dim, typename _Scalar>
-    const _Scalar Primitive<_EmbedSpaceDim, _Dim, _Scalar>::TAGS::GEN_ANGLE = _Scalar( 3. );
-    template <int _EmbedSpaceDim, int _Dim, typename _Scalar>
-    const _Scalar Primitive<_EmbedSpaceDim, _Dim, _Scalar>::GEN_ANGLE_VALUES::UNSET = Primitive<_EmbedSpaceDim, _Dim, _Scalar>::ParentT::TAG_UNSET;
-    template <int _EmbedSpaceDim, int _Dim, typename _Scalar>
-    const GidT Primitive<_EmbedSpaceDim, _Dim, _Scalar>::LONG_VALUES::UNSET = Primitive<_EmbedSpaceDim, _Dim, _Scalar>::ParentT::TAG_UNSET;
+    template <int _EmbedSpaceDim, int _Dim, typename _Scalar, typename _AccumScalar>
+    const _Scalar Primitive<_EmbedSpaceDim, _Dim, _Scalar, _AccumScalar>::TAGS::GEN_ANGLE = _Scalar( 3. );
+    template <int _EmbedSpaceDim, int _Dim, typename _Scalar, typename _AccumScalar>
+    const _Scalar Primitive<_EmbedSpaceDim, _Dim, _Scalar, _AccumScalar>::GEN_ANGLE_VALUES::UNSET = Primitive<_EmbedSpaceDim, _Dim, _Scalar, _AccumScalar>::ParentT::TAG_UNSET;
+    template <int _EmbedSpaceDim, int _Dim, typename _Scalar, typename _AccumScalar>
+    const GidT Primitive<_EmbedSpaceDim, _Dim, _Scalar, _AccumScalar>::LONG_VALUES::UNSET = Primitive<_EmbedSpaceDim, _Dim, _Scalar, _AccumScalar>::ParentT::TAG_UNSET;
 } //...ns rapter
 
 #endif // __AM__PRIMITIVE_HPP__
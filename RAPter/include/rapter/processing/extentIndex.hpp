@@ -0,0 +1,224 @@
+#ifndef RAPTER_EXTENTINDEX_HPP
+#define RAPTER_EXTENTINDEX_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include "Eigen/Dense"
+#include "Eigen/Geometry"  // AlignedBox
+#include "rapter/simpleTypes.h"
+
+namespace rapter {
+namespace processing {
+
+    /*! \brief Uniform hash grid over the bounding boxes of primitive extents, for "which primitives are near this point/primitive" queries.
+     *
+     *         Entries are identified by a caller chosen id (e.g. a linear index into a flattened (gid,lid) list), and stored by the axis aligned box
+     *         of their extrema (see \ref rapter::LinePrimitive::getExtent, \ref rapter::PlanePrimitive::getExtent).
+     *         A query returns every entry, whose box is not farther than the radius, in increasing id order.
+     *         Since a finite primitive lies inside the box of its extrema, the result is a superset of the primitives within the radius,
+     *         the caller has to run its exact distance test on it, but does not need to look at any other primitive.
+     *         Boxes spanning more than #MaxCellsPerEntry cells are not rasterized, they are kept in a list that every query scans.
+     *         Queries are const and can run in parallel, inserting and removing can not.
+     *  \tparam _Scalar Concept: float.
+     */
+    template <typename _Scalar>
+    class ExtentIndex
+    {
+        public:
+            typedef Eigen::Matrix<_Scalar,3,1>      Position;
+            typedef Eigen::AlignedBox<_Scalar,3>    BoxT;
+            enum { MaxCellsPerEntry = 64 };
+
+            //! \param[in] cellSize Cell edge length, usually the query radius or a few times the scale.
+            explicit ExtentIndex( _Scalar const cellSize ) : _cellSize( cellSize > _Scalar(0.) ? cellSize : _Scalar(1.) ) {}
+
+            /*! \brief Adds (or replaces) entry \p id, stored by the bounding box of \p extrema.
+             *  \param[in] extrema Concept: std::vector<Eigen::Matrix<_Scalar,3,1> >, the output of getExtent().
+             *  \param[in] margin  Grows the box, e.g. to absorb rounding of the caller's exact distance.
+             *  \return            False, if \p extrema is empty, nothing is stored then.
+             */
+            template <class _ExtremaT>
+            inline bool insert( LidT const id, _ExtremaT const& extrema, _Scalar const margin = _Scalar(0.) )
+            {
+                if ( !extrema.size() )
+                    return false;
+
+                BoxT box( extrema[0] );
+                for ( size_t i = 1; i != extrema.size(); ++i )
+                    box.extend( extrema[i] );
+                box.min().array() -= margin;
+                box.max().array() += margin;
+
+                return this->insertBox( id, box );
+            } //...insert()
+
+            //! \brief Adds (or replaces) entry \p id with \p box.
+            inline bool insertBox( LidT const id, BoxT const& box )
+            {
+                if ( this->contains(id) )
+                    this->remove( id );
+
+                _boxes[ id ] = box;
+                CellRange range = this->_range( box );
+                if ( range.count() > MaxCellsPerEntry )
+                    _large.push_back( id );
+                else
+                    for ( long long z = range.lo[2]; z <= range.hi[2]; ++z )
+                        for ( long long y = range.lo[1]; y <= range.hi[1]; ++y )
+                            for ( long long x = range.lo[0]; x <= range.hi[0]; ++x )
+                                _cells[ _key(x,y,z) ].push_back( id );
+
+                return true;
+            } //...insertBox()
+
+            //! \brief Removes entry \p id, e.g. after its primitive got merged away or refit. \return False, if \p id was not stored.
+            inline bool remove( LidT const id )
+            {
+                typename BoxMapT::iterator it = _boxes.find( id );
+                if ( it == _boxes.end() )
+                    return false;
+
+                CellRange range = this->_range( it->second );
+                if ( range.count() > MaxCellsPerEntry )
+                    _large.erase( std::find(_large.begin(), _large.end(), id) );
+                else
+                    for ( long long z = range.lo[2]; z <= range.hi[2]; ++z )
+                        for ( long long y = range.lo[1]; y <= range.hi[1]; ++y )
+                            for ( long long x = range.lo[0]; x <= range.hi[0]; ++x )
+                            {
+                                typename CellMapT::iterator cell = _cells.find( _key(x,y,z) );
+                                std::vector<LidT> &ids = cell->second;
+                                std::swap( *std::find(ids.begin(), ids.end(), id), ids.back() );
+                                ids.pop_back();
+                                if ( ids.empty() )
+                                    _cells.erase( cell );
+                            }
+                _boxes.erase( it );
+
+                return true;
+            } //...remove()
+
+            inline bool        contains( LidT const id ) const { return _boxes.find(id) != _boxes.end(); }
+            inline BoxT const& box     ( LidT const id ) const { return _boxes.at( id ); }
+            inline size_t      size    ()                const { return _boxes.size(); }
+            inline void        clear   ()                      { _boxes.clear(); _cells.clear(); _large.clear(); }
+
+            /*! \brief Entries whose box is closer than \p radius to \p box, sorted by id.
+             *  \param[out] ids Output, cleared first.
+             */
+            inline void queryBox( BoxT const& box, _Scalar const radius, std::vector<LidT> &ids ) const
+            {
+                ids.clear();
+
+                BoxT grown( box );
+                grown.min().array() -= radius;
+                grown.max().array() += radius;
+                CellRange range = this->_range( grown );
+
+                if ( range.count() > double(_cells.size()) )
+                {
+                    // visiting the cells would cost more than looking at every entry
+                    for ( typename BoxMapT::const_iterator it = _boxes.begin(); it != _boxes.end(); ++it )
+                        ids.push_back( it->first );
+                }
+                else
+                {
+                    for ( long long z = range.lo[2]; z <= range.hi[2]; ++z )
+                        for ( long long y = range.lo[1]; y <= range.hi[1]; ++y )
+                            for ( long long x = range.lo[0]; x <= range.hi[0]; ++x )
+                            {
+                                typename CellMapT::const_iterator cell = _cells.find( _key(x,y,z) );
+                                if ( cell != _cells.end() )
+                                    ids.insert( ids.end(), cell->second.begin(), cell->second.end() );
+                            }
+                    ids.insert( ids.end(), _large.begin(), _large.end() );
+                }
+
+                // boxes spanning several cells are found several times
+                std::sort( ids.begin(), ids.end() );
+                ids.erase( std::unique(ids.begin(), ids.end()), ids.end() );
+
+                const _Scalar sqrRadius = radius * radius;
+                ids.erase( std::remove_if( ids.begin(), ids.end(), [this,&box,sqrRadius]( LidT const id )
+                                           { return _boxes.find(id)->second.squaredExteriorDistance(box) > sqrRadius; } )
+                         , ids.end() );
+            } //...queryBox()
+
+            //! \brief Entries whose box is closer than \p radius to \p q, sorted by id.
+            template <class _Vec3T>
+            inline void queryPoint( _Vec3T const& q, _Scalar const radius, std::vector<LidT> &ids ) const
+            {
+                const Position p( q(0), q(1), q(2) );
+                this->queryBox( BoxT(p, p), radius, ids );
+            } //...queryPoint()
+
+            //! \brief Entries closer than \p radius to the stored entry \p id, without \p id itself, sorted by id.
+            inline void queryNeighbours( LidT const id, _Scalar const radius, std::vector<LidT> &ids ) const
+            {
+                this->queryBox( this->box(id), radius, ids );
+                ids.erase( std::remove(ids.begin(), ids.end(), id), ids.end() );
+            } //...queryNeighbours()
+
+            /*! \brief Batched \ref queryPoint(), in parallel.
+             *  \param[in]  positions Concept: std::vector<Eigen::Vector3f>.
+             *  \param[out] ids       ids[i] holds the entries near positions[i].
+             */
+            template <class _PositionContainerT>
+            inline void queryPoints( _PositionContainerT const& positions, _Scalar const radius, std::vector< std::vector<LidT> > &ids ) const
+            {
+                ids.resize( positions.size() );
+#               pragma omp parallel for schedule(dynamic,64)
+                for ( LidT i = 0; i < LidT(positions.size()); ++i )
+                    this->queryPoint( positions[i], radius, ids[i] );
+            } //...queryPoints()
+
+            //! \brief Batched \ref queryNeighbours(), in parallel. neighs[i] holds the entries near queries[i].
+            inline void queryNeighbours( std::vector<LidT> const& queries, _Scalar const radius, std::vector< std::vector<LidT> > &neighs ) const
+            {
+                neighs.resize( queries.size() );
+#               pragma omp parallel for schedule(dynamic,16)
+                for ( LidT i = 0; i < LidT(queries.size()); ++i )
+                    this->queryNeighbours( queries[i], radius, neighs[i] );
+            } //...queryNeighbours()
+
+        protected:
+            typedef std::unordered_map< LidT, BoxT >                  BoxMapT;
+            typedef std::unordered_map< unsigned long long, std::vector<LidT> > CellMapT;
+
+            //! \brief Inclusive cell coordinates covered by a box.
+            struct CellRange
+            {
+                long long lo[3], hi[3];
+                inline double count() const { return double(hi[0] - lo[0] + 1) * double(hi[1] - lo[1] + 1) * double(hi[2] - lo[2] + 1); }
+            };
+
+            inline CellRange _range( BoxT const& box ) const
+            {
+                CellRange range;
+                for ( int d = 0; d != 3; ++d )
+                {
+                    range.lo[d] = static_cast<long long>( std::floor(box.min()(d) / _cellSize) );
+                    range.hi[d] = static_cast<long long>( std::floor(box.max()(d) / _cellSize) );
+                }
+                return range;
+            } //..._range()
+
+            //! \brief Packs 21 bits of each cell coordinate, far cells may share a key, which only costs an extra box test.
+            static inline unsigned long long _key( long long const x, long long const y, long long const z )
+            {
+                const unsigned long long mask = (1ull << 21) - 1ull;
+                return (static_cast<unsigned long long>(x) & mask) | ((static_cast<unsigned long long>(y) & mask) << 21) | ((static_cast<unsigned long long>(z) & mask) << 42);
+            } //..._key()
+
+            _Scalar             _cellSize;
+            BoxMapT             _boxes;     //!< \brief Box of each entry.
+            CellMapT            _cells;     //!< \brief Entries overlapping each occupied cell.
+            std::vector<LidT>   _large;     //!< \brief Entries spanning more than MaxCellsPerEntry cells.
+    }; //...ExtentIndex
+
+} //...namespace processing
+} //...namespace rapter
+
+#endif // RAPTER_EXTENTINDEX_HPP
@@ -0,0 +1,235 @@
+#ifndef RAPTER_GRID2D_HPP
+#define RAPTER_GRID2D_HPP
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "Eigen/Dense"
+#include "Eigen/StdVector"
+#include "rapter/simpleTypes.h"
+
+namespace rapter {
+namespace processing {
+
+    /*! \brief Uniform grid over the xy plane for radius and k-nearest queries in 2D scenes.
+     *
+     *         A drop-in for pcl::search::KdTree<pcl::PointXYZ> in the 2D (line) pipeline: queries take pcl-like points (\c x, \c y, \c z members),
+     *         distances are the same float squared distances the kd-tree computes, and results are sorted by ( distance, index ) like FLANN sorts them.
+     *         Only flat inputs are accepted ( all z equal ), so the index stores packed 2D coordinates in cell order, and a single z for the whole cloud.
+     *  \tparam _Scalar Concept: float.
+     */
+    template <typename _Scalar>
+    class Grid2D
+    {
+        public:
+            typedef Eigen::Matrix<_Scalar,2,1>                                  Position2;
+            typedef std::vector<Position2, Eigen::aligned_allocator<Position2> > Positions2;
+
+            //! \param[in] sorted Sort the results of \ref radiusSearch() by distance. Same as the argument of the pcl::search::KdTree constructor.
+            Grid2D( bool const sorted = true ) : _cellSize( 0 ), _nx( 0 ), _ny( 0 ), _z( 0 ), _sorted( sorted ) {}
+
+            /*! \brief Builds the grid from a container of \ref rapter::PointPrimitive -s.
+             *  \param[in] points   Concept: std::vector<PointPrimitive>, with pos().
+             *  \param[in] cellSize Cell edge length, usually the search radius.
+             *  \return             False, if the points are not flat (z varies) or empty. The grid is unusable then, and the caller should fall back to a kd-tree.
+             */
+            template <class _PointContainerT>
+            inline bool setInputPoints( _PointContainerT const& points, _Scalar const cellSize )
+            {
+                const LidT N = points.size();
+                _xy.resize( N );
+                if ( !N )
+                    return this->_clear();
+                _z = points[0].template pos()(2);
+                for ( LidT pid = 0; pid != N; ++pid )
+                {
+                    if ( points[pid].template pos()(2) != _z )
+                        return this->_clear();
+                    _xy[pid] = points[pid].template pos().template head<2>();
+                }
+
+                return this->_build( cellSize );
+            } //...setInputPoints()
+
+            /*! \brief Builds the grid from a pcl point cloud.
+             *  \param[in] cloud    Concept: pcl::PointCloud<pcl::PointXYZ>::Ptr.
+             *  \param[in] cellSize Cell edge length, usually the search radius.
+             *  \return             False, if the points are not flat (z varies) or empty.
+             */
+            template <class _CloudPtrT>
+            inline bool setInputCloud( _CloudPtrT const& cloud, _Scalar const cellSize )
+            {
+                const LidT N = cloud->size();
+                _xy.resize( N );
+                if ( !N )
+                    return this->_clear();
+                _z = cloud->at(0).z;
+                for ( LidT pid = 0; pid != N; ++pid )
+                {
+                    if ( cloud->at(pid).z != _z )
+                        return this->_clear();
+                    _xy[pid] = Position2( cloud->at(pid).x, cloud->at(pid).y );
+                }
+
+                return this->_build( cellSize );
+            } //...setInputCloud()
+
+            inline bool isValid() const { return _nx > 0; }
+
+            /*! \brief Finds all points closer than \p radius to \p p. Same interface and output order as pcl::search::KdTree::radiusSearch().
+             *  \param[in]  p           Query point. Concept: pcl::PointXYZ.
+             *  \param[in]  radius      Search radius.
+             *  \param[out] k_indices   Point ids sorted by distance.
+             *  \param[out] k_sqr_dists Squared distances to \p p.
+             *  \param[in]  max_nn      Keep only this many closest ones. 0: all.
+             *  \return                 Number of neighbours found.
+             */
+            template <class _PointT>
+            inline int radiusSearch( _PointT const& p, double const radius, std::vector<int> &k_indices, std::vector<float> &k_sqr_dists, unsigned const max_nn = 0 ) const
+            {
+                const _Scalar sqrRadius = static_cast<_Scalar>( radius * radius );
+                const int     reach     = static_cast<int>( std::ceil(radius / _cellSize) );
+                std::vector< std::pair<_Scalar,int> > found;
+                this->_collect( found, p, this->_cellX(p.x), this->_cellY(p.y), reach, sqrRadius );
+
+                return _output( found, k_indices, k_sqr_dists, max_nn, _sorted || max_nn );
+            } //...radiusSearch()
+
+            /*! \brief Finds the \p K closest points to \p p. Same interface and output order as pcl::search::KdTree::nearestKSearch().
+             *         Rings of cells are added around the query cell until the K-th closest candidate is closer than the unvisited cells.
+             */
+            template <class _PointT>
+            inline int nearestKSearch( _PointT const& p, int const K, std::vector<int> &k_indices, std::vector<float> &k_sqr_dists ) const
+            {
+                std::vector< std::pair<_Scalar,int> > found;
+                if ( K <= 0 )
+                    return _output( found, k_indices, k_sqr_dists, 0 );
+
+                const int cx = this->_cellX( p.x ), cy = this->_cellY( p.y );
+                const int maxReach = std::max( _nx, _ny );
+                for ( int reach = 0; ; ++reach )
+                {
+                    found.clear();
+                    this->_collect( found, p, cx, cy, reach, std::numeric_limits<_Scalar>::max() );
+                    if ( reach >= maxReach )
+                        break;
+                    if ( static_cast<int>(found.size()) < K )
+                        continue;
+
+                    // points outside the visited square are at least reach * cellSize away
+                    std::nth_element( found.begin(), found.begin() + (K-1), found.end() );
+                    const _Scalar safe = reach * _cellSize;
+                    if ( found[K-1].first <= safe * safe )
+                        break;
+                }
+
+                return _output( found, k_indices, k_sqr_dists, K );
+            } //...nearestKSearch()
+
+        protected:
+            inline bool _clear() { _xy.clear(); _ids.clear(); _cellStart.clear(); _nx = _ny = 0; return false; }
+
+            //! \brief Counting-sorts the points into cells, and stores their coordinates in cell order.
+            inline bool _build( _Scalar cellSize )
+            {
+                const LidT N = _xy.size();
+                _min = _xy[0]; Position2 max = _xy[0];
+                for ( LidT pid = 1; pid != N; ++pid )
+                {
+                    _min = _min.cwiseMin( _xy[pid] );
+                    max  = max .cwiseMax( _xy[pid] );
+                }
+
+                // limit the number of cells to a few per point, a sparse cloud with a small radius would allocate too much otherwise
+                const Position2 extent = max - _min;
+                if ( !(cellSize > _Scalar(0.)) )
+                    cellSize = std::max( extent.maxCoeff(), _Scalar(1.) );
+                while ( (extent(0) / cellSize + 1.) * (extent(1) / cellSize + 1.) > 4. * N + 16. )
+                    cellSize *= _Scalar(2.);
+                _cellSize = cellSize;
+                _nx       = static_cast<int>( extent(0) / _cellSize ) + 1;
+                _ny       = static_cast<int>( extent(1) / _cellSize ) + 1;
+
+                std::vector<LidT> cellOf( N );
+                _cellStart.assign( _nx * _ny + 1, 0 );
+                for ( LidT pid = 0; pid != N; ++pid )
+                {
+                    cellOf[pid] = this->_cellY( _xy[pid](1) ) * _nx + this->_cellX( _xy[pid](0) );
+                    ++_cellStart[ cellOf[pid] + 1 ];
+                }
+                for ( size_t c = 1; c != _cellStart.size(); ++c )
+                    _cellStart[c] += _cellStart[c-1];
+
+                std::vector<LidT> fill( _cellStart.begin(), _cellStart.end() - 1 );
+                Positions2 sorted( N );
+                _ids.resize( N );
+                for ( LidT pid = 0; pid != N; ++pid )
+                {
+                    const LidT slot = fill[ cellOf[pid] ]++;
+                    _ids  [ slot ] = pid;
+                    sorted[ slot ] = _xy[pid];
+                }
+                _xy.swap( sorted );
+
+                return true;
+            } //..._build()
+
+            inline int _cellX( _Scalar const x ) const { return std::min( _nx - 1, std::max( 0, static_cast<int>(std::floor((x - _min(0)) / _cellSize)) ) ); }
+            inline int _cellY( _Scalar const y ) const { return std::min( _ny - 1, std::max( 0, static_cast<int>(std::floor((y - _min(1)) / _cellSize)) ) ); }
+
+            //! \brief Gathers points within \p reach cells of ( \p cx, \p cy ) that are not farther than \p sqrRadius. Distances are summed in x, y, z order, like FLANN does.
+            template <class _PointT>
+            inline void _collect( std::vector< std::pair<_Scalar,int> > &found, _PointT const& p, int const cx, int const cy, int const reach, _Scalar const sqrRadius ) const
+            {
+                const _Scalar dz  = p.z - _z;
+                const _Scalar dz2 = dz * dz;
+                const int x0 = std::max( 0, cx - reach ), x1 = std::min( _nx - 1, cx + reach );
+                const int y0 = std::max( 0, cy - reach ), y1 = std::min( _ny - 1, cy + reach );
+                for ( int y = y0; y <= y1; ++y )
+                {
+                    // cells of a row are contiguous
+                    const LidT stop = _cellStart[ y * _nx + x1 + 1 ];
+                    for ( LidT slot = _cellStart[ y * _nx + x0 ]; slot != stop; ++slot )
+                    {
+                        const _Scalar dx = p.x - _xy[slot](0);
+                        const _Scalar dy = p.y - _xy[slot](1);
+                        const _Scalar sqrDist = dx * dx + dy * dy + dz2;
+                        if ( sqrDist <= sqrRadius )
+                            found.push_back( std::pair<_Scalar,int>(sqrDist, static_cast<int>(_ids[slot])) );
+                    }
+                }
+            } //..._collect()
+
+            static inline int _output( std::vector< std::pair<_Scalar,int> > &found, std::vector<int> &k_indices, std::vector<float> &k_sqr_dists, unsigned const max_nn, bool const sort = true )
+            {
+                if ( sort )
+                    std::sort( found.begin(), found.end() );
+                if ( max_nn && found.size() > max_nn )
+                    found.resize( max_nn );
+
+                k_indices  .resize( found.size() );
+                k_sqr_dists.resize( found.size() );
+                for ( size_t i = 0; i != found.size(); ++i )
+                {
+                    k_indices  [i] = found[i].second;
+                    k_sqr_dists[i] = found[i].first;
+                }
+
+                return found.size();
+            } //..._output()
+
+            Positions2          _xy;        //!< \brief Point coordinates in cell order.
+            std::vector<LidT>   _ids;       //!< \brief Original point id of each entry in _xy.
+            std::vector<LidT>   _cellStart; //!< \brief Row-major cell offsets into _xy, one past the end at the back.
+            Position2           _min;       //!< \brief Lower corner of the grid.
+            _Scalar             _cellSize;
+            int                 _nx, _ny;
+            _Scalar             _z;         //!< \brief The common z of the input.
+            bool                _sorted;    //!< \brief Whether radiusSearch() sorts its output.
+    }; //...Grid2D
+
+} //...namespace processing
+} //...namespace rapter
+
+#endif // RAPTER_GRID2D_HPP
@@ -1,6 +1,8 @@
 #ifndef RAPTER_ANGLE_HPP
 #define RAPTER_ANGLE_HPP
 
+#include <cmath>
+
 namespace rapter {
 
     //template<typename Scalar, int Dim> inline Scalar
@@ -17,6 +19,17 @@ namespace rapter {
 
         return angle;
     }
+
+    /*! \brief Whether the unoriented directions \p v1 and \p v2 are not farther than an angle, i.e. \f$ \min(\alpha, \pi - \alpha) \le threshold \f$ of \ref angleInRad().
+     *         Compares the absolute cosine instead, so hot thresholding loops don't need atan2. Zero vectors pass, like they do with \ref angleInRad().
+     *  \param[in] cosThreshold Cosine of the threshold angle, which is at most pi/2.
+     */
+    template<typename Derived, typename DerivedB> inline bool
+    isAngleWithin( Derived const& v1, DerivedB const& v2, typename DerivedB::Scalar const cosThreshold )
+    {
+        return std::abs( v1.dot(v2) ) >= cosThreshold * std::sqrt( v1.squaredNorm() * v2.squaredNorm() );
+    }
+
     #if 0
     template<typename Scalar, int Dim> inline Scalar
     angleInRadSigned( Eigen::Matrix<Scalar,Dim,1> const& v1, Eigen::Matrix<Scalar,Dim,1> const& v2 )
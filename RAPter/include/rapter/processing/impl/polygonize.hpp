@@ -0,0 +1,332 @@
+#ifndef RAPTER_POLYGONIZE_HPP
+#define RAPTER_POLYGONIZE_HPP
+
+#include <set>
+#include <cmath>
+#include <limits>
+
+#include "pcl/point_types.h"
+#include "pcl/point_cloud.h"
+#include "pcl/surface/concave_hull.h"
+
+#include "rapter/processing/polygonize.h"
+#include "rapter/parameters.h"              // PolygonizeParams
+#include "rapter/util/parse.h"              // console::parse_argument
+#include "rapter/util/pclUtil.h"            // PclCloudT
+#include "rapter/util/containers.hpp"       // PrimitiveContainer
+#include "rapter/io/inputParser.hpp"        // parseInput
+#include "rapter/io/polygonIo.hpp"          // writePolygons
+#include "rapter/processing/util.hpp"       // getPopulations
+
+namespace rapter {
+namespace processing {
+
+    template <class _PrimitiveT, class _PointContainerT, class _PopulationsT, typename _Scalar>
+    inline LidT computeBoundaries( std::vector<PlanarPolygon<_Scalar> >       & polygons
+                                 , std::vector<_PrimitiveT const*>       const& prims
+                                 , _PointContainerT                      const& points
+                                 , _PopulationsT                         const& populations
+                                 , _Scalar                               const  alpha
+                                 , _Scalar                               const  decimation )
+    {
+        typedef PlanarPolygon<_Scalar>          PolygonT;
+        typedef typename PolygonT::Vertex2      Vertex2;
+        typedef typename PolygonT::Vertex3      Vertex3;
+        typedef pcl::PointCloud<pcl::PointXYZ>  HullCloudT;
+
+        polygons.clear();
+        polygons.resize( prims.size() );
+
+        LidT count = 0;
+#       pragma omp parallel for reduction(+:count) schedule(dynamic)
+        for ( LidT lid = 0; lid < static_cast<LidT>(prims.size()); ++lid )
+        {
+            _PrimitiveT const& plane = *prims[lid];
+            PolygonT         & poly  = polygons[lid];
+
+            // local frame
+            poly.gid    = plane.getTag( _PrimitiveT::TAGS::GID     );
+            poly.did    = plane.getTag( _PrimitiveT::TAGS::DIR_GID );
+            poly.normal = plane.dir().template cast<_Scalar>().normalized();
+            poly.origin = plane.pos().template cast<_Scalar>();
+            poly.u      = poly.normal.unitOrthogonal();
+            poly.v      = poly.normal.cross( poly.u );
+
+            typename _PopulationsT::const_iterator popIt = populations.find( poly.gid );
+            if ( (popIt == populations.end()) || (popIt->second.size() < 3) )
+                continue;
+
+            // project assigned points to the local frame, keep one per decimation cell
+            typename HullCloudT::Ptr cloud( new HullCloudT() );
+            cloud->reserve( popIt->second.size() );
+            std::set< std::pair<long,long> > cells;
+            for ( typename _PopulationsT::mapped_type::const_iterator pidIt = popIt->second.begin(); pidIt != popIt->second.end(); ++pidIt )
+            {
+                const Vertex2 x = poly.toLocal( points[*pidIt].template pos().template cast<_Scalar>() );
+                if ( decimation > _Scalar(0.) )
+                {
+                    const std::pair<long,long> cell( static_cast<long>(std::floor(x(0) / decimation))
+                                                   , static_cast<long>(std::floor(x(1) / decimation)) );
+                    if ( !cells.insert(cell).second )
+                        continue;
+                }
+                cloud->push_back( pcl::PointXYZ(x(0), x(1), 0.f) );
+            } //...for assigned points
+
+            if ( cloud->size() < 3 )
+                continue;
+
+            HullCloudT                  hull;
+            std::vector<pcl::Vertices>  hullPolygons;
+            // the qhull shipped with pcl is not reentrant
+#           pragma omp critical (POLYGONIZE_QHULL)
+            {
+                pcl::ConcaveHull<pcl::PointXYZ> concave_hull;
+                concave_hull.setAlpha     ( alpha );
+                concave_hull.setDimension ( 2     );
+                concave_hull.setInputCloud( cloud );
+                concave_hull.reconstruct  ( hull, hullPolygons );
+            }
+
+            if ( !hullPolygons.size() )
+                continue;
+
+            // keep the largest boundary, same as PlanePrimitive::getHull
+            size_t maxId = 0;
+            for ( size_t i = 1; i < hullPolygons.size(); ++i )
+                if ( hullPolygons[i].vertices.size() > hullPolygons[maxId].vertices.size() )
+                    maxId = i;
+
+            poly.vertices.reserve( hullPolygons[maxId].vertices.size() );
+            for ( std::vector<uint32_t>::const_iterator it = hullPolygons[maxId].vertices.begin(); it != hullPolygons[maxId].vertices.end(); ++it )
+                poly.vertices.push_back( Vertex2(hull.at(*it).x, hull.at(*it).y) );
+
+            if ( !poly.empty() )
+                ++count;
+        } //...for prims
+
+        return count;
+    } //...computeBoundaries()
+
+    namespace polygonize
+    {
+        //! \brief 2D cross product, signed distance of \p x from the line ( \p q, \p e ), if \p e is unit length.
+        template <typename _Vertex2>
+        inline typename _Vertex2::Scalar lineSide( _Vertex2 const& q, _Vertex2 const& e, _Vertex2 const& x )
+        {
+            return e(0) * (x(1) - q(1)) - e(1) * (x(0) - q(0));
+        }
+
+        /*! \brief Sutherland-Hodgman clip of a (possibly concave) polygon by the half-plane lineSide >= 0.
+         *  \param[in] sides Precomputed lineSide of each vertex.
+         */
+        template <class _VerticesT, typename _Scalar>
+        inline void clipHalfPlane( _VerticesT &out, _VerticesT const& in, std::vector<_Scalar> const& sides )
+        {
+            out.clear();
+            out.reserve( in.size() + 2 );
+            for ( size_t k = 0; k != in.size(); ++k )
+            {
+                const size_t prev = k ? k - 1 : in.size() - 1;
+                const _Scalar sc = sides[k], sp = sides[prev];
+                if ( sc >= _Scalar(0.) )
+                {
+                    if ( sp < _Scalar(0.) )
+                        out.push_back( in[prev] + (in[k] - in[prev]) * (sp / (sp - sc)) );
+                    out.push_back( in[k] );
+                }
+                else if ( sp >= _Scalar(0.) )
+                    out.push_back( in[prev] + (in[k] - in[prev]) * (sp / (sp - sc)) );
+            }
+        } //...clipHalfPlane()
+    } //...namespace polygonize
+
+    template <typename _Scalar>
+    inline LidT clipAlongIntersections( std::vector<PlanarPolygon<_Scalar> > & polygons
+                                      , _Scalar const clip_dist
+                                      , _Scalar const min_angle )
+    {
+        typedef PlanarPolygon<_Scalar>          PolygonT;
+        typedef typename PolygonT::Vertex2      Vertex2;
+        typedef typename PolygonT::Vertex3      Vertex3;
+        typedef typename PolygonT::VerticesT    VerticesT;
+
+        // neighbours are read from this snapshot, so the output does not depend on the order
+        const std::vector<PolygonT> original( polygons );
+        const _Scalar               minSin = std::sin( min_angle );
+
+        LidT clipCount = 0;
+#       pragma omp parallel for reduction(+:clipCount) schedule(dynamic)
+        for ( LidT i = 0; i < static_cast<LidT>(original.size()); ++i )
+        {
+            if ( original[i].empty() )
+                continue;
+
+            PolygonT        &poly = polygons[i];
+            VerticesT        clipped;
+            std::vector<_Scalar> sides;
+
+            for ( size_t j = 0; j != original.size(); ++j )
+            {
+                PolygonT const& other = original[j];
+                if ( (static_cast<LidT>(j) == i) || other.empty() || poly.empty() )
+                    continue;
+
+                // intersection line of the two planes
+                const Vertex3 d       = poly.normal.cross( other.normal );
+                const _Scalar dNorm2  = d.squaredNorm();
+                if ( dNorm2 < minSin * minSin )
+                    continue;
+
+                const _Scalar c0      = poly .normal.dot( poly .origin );
+                const _Scalar c1      = other.normal.dot( other.origin );
+                const Vertex3 p0      = ( c0 * other.normal.cross(d) + c1 * d.cross(poly.normal) ) / dNorm2;
+                const Vertex3 dUnit   = d / std::sqrt( dNorm2 );
+
+                // the other polygon has to reach the line, record its extent along the line
+                _Scalar otherMin = std::numeric_limits<_Scalar>::max(), otherMax = -std::numeric_limits<_Scalar>::max();
+                for ( typename VerticesT::const_iterator it = other.vertices.begin(); it != other.vertices.end(); ++it )
+                {
+                    const Vertex3 p   = other.toWorld( *it ) - p0;
+                    const _Scalar t   = p.dot( dUnit );
+                    if ( (p - t * dUnit).norm() < clip_dist )
+                    {
+                        otherMin = std::min( otherMin, t );
+                        otherMax = std::max( otherMax, t );
+                    }
+                }
+                if ( otherMin > otherMax )
+                    continue;
+
+                // line in the local frame of this polygon
+                const Vertex2 q = poly.toLocal( p0 );
+                const Vertex2 e = Vertex2( poly.u.dot(dUnit), poly.v.dot(dUnit) ).normalized();
+
+                sides.resize( poly.vertices.size() );
+                _Scalar posExt = _Scalar(0.), negExt = _Scalar(0.), thisMin = std::numeric_limits<_Scalar>::max(), thisMax = -std::numeric_limits<_Scalar>::max();
+                for ( size_t k = 0; k != poly.vertices.size(); ++k )
+                {
+                    sides[k] = polygonize::lineSide( q, e, poly.vertices[k] );
+                    posExt   = std::max( posExt,  sides[k] );
+                    negExt   = std::max( negExt, -sides[k] );
+                    if ( std::abs(sides[k]) < clip_dist )
+                    {
+                        const _Scalar t = (poly.vertices[k] - q).dot( e );
+                        thisMin = std::min( thisMin, t );
+                        thisMax = std::max( thisMax, t );
+                    }
+                }
+
+                // has to reach the line, and the two have to overlap along it
+                if ( (thisMin > thisMax) || (thisMax + clip_dist < otherMin) || (otherMax + clip_dist < thisMin) )
+                    continue;
+                // crosses the line with both sides: not an overshoot at a junction
+                if ( std::min(posExt, negExt) > clip_dist )
+                    continue;
+
+                // keep the larger side, make it positive
+                const _Scalar sign = (posExt >= negExt) ? _Scalar(1.) : _Scalar(-1.);
+                for ( size_t k = 0; k != sides.size(); ++k )
+                    sides[k] *= sign;
+
+                if ( std::min(posExt, negExt) > _Scalar(0.) )
+                {
+                    polygonize::clipHalfPlane( clipped, poly.vertices, sides );
+                    poly.vertices.swap( clipped );
+                    ++clipCount;
+                }
+
+                // snap vertices close to the line within the common span onto it
+                const _Scalar spanMin = std::max( thisMin, otherMin ) - clip_dist
+                            , spanMax = std::min( thisMax, otherMax ) + clip_dist;
+                for ( typename VerticesT::iterator it = poly.vertices.begin(); it != poly.vertices.end(); ++it )
+                {
+                    const _Scalar s = polygonize::lineSide( q, e, *it );
+                    const _Scalar t = (*it - q).dot( e );
+                    if ( (std::abs(s) < clip_dist) && (t >= spanMin) && (t <= spanMax) )
+                        *it = q + t * e;
+                }
+            } //...for neighbours
+        } //...for polygons
+
+        return clipCount;
+    } //...clipAlongIntersections()
+
+    template <class _PrimitiveContainerT, class _PointContainerT, class _PrimitiveT, class _PointPrimitiveT>
+    inline int polygonizeCli( int argc, char** argv )
+    {
+        typedef typename _PrimitiveContainerT::value_type   InnerPrimitiveContainerT;
+        typedef containers::PrimitiveContainer<_PrimitiveT> PrimitiveMapT;
+        typedef typename _PrimitiveT::Scalar                Scalar;
+        typedef PlanarPolygon<Scalar>                       PolygonT;
+
+        _PointContainerT            points;
+        PclCloudPtrT                pcl_cloud;
+        _PrimitiveContainerT        prims;
+        PrimitiveMapT               patches;
+        PolygonizeParams<Scalar>    params;
+        std::string                 out_path( "polygons.obj" );
+
+        bool valid_input = (EXIT_SUCCESS == rapter::parseInput<InnerPrimitiveContainerT,PclCloudT>(
+                                                points, pcl_cloud, prims, patches, params, argc, argv ));
+
+        rapter::console::parse_argument( argc, argv, "--alpha-mult"     , params.alpha_mult     );
+        rapter::console::parse_argument( argc, argv, "--decimate-mult"  , params.decimate_mult  );
+        rapter::console::parse_argument( argc, argv, "--clip-dist-mult" , params.clip_dist_mult );
+        if ( rapter::console::parse_argument( argc, argv, "--clip-min-angle", params.clip_min_angle ) >= 0 )
+            params.clip_min_angle *= M_PI / Scalar(180.);
+        if ( rapter::console::find_switch( argc, argv, "--no-clip" ) )
+            params.do_clip = false;
+        if ( rapter::console::parse_argument( argc, argv, "-o", out_path ) < 0 )
+            rapter::console::parse_argument( argc, argv, "--out", out_path );
+
+        if ( !valid_input || rapter::console::find_switch(argc,argv,"-h") || rapter::console::find_switch(argc,argv,"--help") )
+        {
+            std::cerr << "[" << __func__ << "]: " << "Usage: " << argv[0] << " --polygonize3D\n"
+                      << "\t--scale " << params.scale << "\n"
+                      << "\t--cloud cloud.ply\n"
+                      << "\t-p,--prims primitives.csv\n"
+                      << "\t-a,--assoc points_primitives.csv\n"
+                      << "\t[-o,--out " << out_path << "]\t\t .obj or .ply\n"
+                      << "\t[--alpha-mult " << params.alpha_mult << "]\t\t alpha radius of concave hull is alpha_mult * scale\n"
+                      << "\t[--decimate-mult " << params.decimate_mult << "]\t thin points to one per decimate_mult * scale cell, 0: off\n"
+                      << "\t[--clip-dist-mult " << params.clip_dist_mult << "]\t adjacency and maximum overshoot is clip_dist_mult * scale\n"
+                      << "\t[--clip-min-angle " << params.clip_min_angle * Scalar(180.) / M_PI << "]\t don't clip planes closer to parallel (degrees)\n"
+                      << "\t[--no-clip]\n"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // select output primitives
+        std::vector<_PrimitiveT const*> selected;
+        for ( typename PrimitiveMapT::ConstIterator it(patches); it.hasNext(); it.step() )
+        {
+            if ( it->getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL )
+                continue;
+            selected.push_back( &(*it) );
+        }
+
+        GidPidVectorMap populations;
+        processing::getPopulations( populations, points );
+
+        std::vector<PolygonT> polygons;
+        const LidT polyCount = computeBoundaries( polygons, selected, points, populations
+                                                , Scalar( params.alpha_mult    * params.scale )
+                                                , Scalar( params.decimate_mult * params.scale ) );
+        std::cout << "[" << __func__ << "]: " << "extracted " << polyCount << " polygons from " << selected.size() << " primitives" << std::endl;
+
+        if ( params.do_clip )
+        {
+            const LidT clipCount = clipAlongIntersections( polygons
+                                                         , Scalar( params.clip_dist_mult * params.scale )
+                                                         , params.clip_min_angle );
+            std::cout << "[" << __func__ << "]: " << "clipped " << clipCount << " times along intersection lines" << std::endl;
+        }
+
+        return io::writePolygons( polygons, out_path );
+    } //...polygonizeCli()
+
+} //...namespace processing
+} //...namespace rapter
+
+#endif // RAPTER_POLYGONIZE_HPP
@@ -7,10 +7,125 @@
 #include "rapter/util/containers.hpp"
 #include "rapter/util/impl/randUtil.hpp"
 #include <chrono>
+#include <random>     // mt19937, default_random_engine
+#include <algorithm>  // sort, shuffle
+#include <unordered_set>
 
 namespace rapter
 {
-    // Usage: .../Release/bin/toGlobFit --subsample-primitives 0.1 --pop-limit 100 --prims segments.csv --cloud cloud.ply -a points_segments.csv --scale 0.005
+    namespace processing
+    {
+        //! \brief Point ids grouped by their GID tag in CSR order, an index based replacement of \ref GidPidVectorMap for large clouds.
+        class PopulationIndex
+        {
+            public:
+                //! \brief Builds the index in two passes over \p points, the point ids of a population are ascending.
+                template <class _PointContainerT>
+                explicit PopulationIndex( _PointContainerT const& points )
+                {
+                    typedef typename _PointContainerT::value_type _PointPrimitiveT;
+                    const PidT pointCount = points.size();
+
+                    std::vector<GidT> pointGids( pointCount );
+#                   pragma omp parallel for
+                    for ( PidT pid = 0; pid < pointCount; ++pid )
+                        pointGids[pid] = points[pid].getTag( _PointPrimitiveT::TAGS::GID );
+
+                    // few distinct GIDs, collect them before sorting
+                    {
+                        std::unordered_set<GidT> unique;
+                        for ( PidT pid = 0; pid != pointCount; ++pid )
+                            if ( !pid || pointGids[pid] != pointGids[pid-1] )
+                                unique.insert( pointGids[pid] );
+                        _gids.assign( unique.begin(), unique.end() );
+                        std::sort( _gids.begin(), _gids.end() );
+                    }
+
+                    std::vector<LidT> popIds( pointCount );
+#                   pragma omp parallel for
+                    for ( PidT pid = 0; pid < pointCount; ++pid )
+                        popIds[pid] = this->find( pointGids[pid] );
+
+                    _start.assign( _gids.size() + 1, 0 );
+                    for ( PidT pid = 0; pid != pointCount; ++pid )
+                        ++_start[ popIds[pid] + 1 ];
+                    for ( size_t i = 0; i != _gids.size(); ++i )
+                        _start[i+1] += _start[i];
+
+                    _pids.resize( pointCount );
+                    std::vector<PidT> fill( _start.begin(), _start.end() - 1 );
+                    for ( PidT pid = 0; pid != pointCount; ++pid )
+                        _pids[ fill[popIds[pid]]++ ] = pid;
+                } //...PopulationIndex()
+
+                //! \brief Number of populations, including the unassigned one, if any.
+                inline LidT         size         ()                  const { return _gids.size(); }
+                inline PidT         getPointCount()                  const { return _pids.size(); }
+                inline GidT         getGid       ( LidT const popId ) const { return _gids[popId]; }
+                inline PidT         getPopulation( LidT const popId ) const { return _start[popId+1] - _start[popId]; }
+                inline PidT const*  begin        ( LidT const popId ) const { return _pids.data() + _start[popId]; }
+                inline PidT const*  end          ( LidT const popId ) const { return _pids.data() + _start[popId+1]; }
+
+                //! \brief Population id of \p gid, -1 if no point has it.
+                inline LidT find( GidT const gid ) const
+                {
+                    std::vector<GidT>::const_iterator it = std::lower_bound( _gids.begin(), _gids.end(), gid );
+                    return (it != _gids.end() && *it == gid) ? LidT(it - _gids.begin()) : LidT(-1);
+                }
+
+            protected:
+                std::vector<GidT> _gids;  //!< \brief Sorted unique GIDs.
+                std::vector<PidT> _start; //!< \brief Offsets of the populations into _pids.
+                std::vector<PidT> _pids;
+        }; //...class PopulationIndex
+
+        /*! \brief Keeps \p keepCounts[popId] random points of each population, in one parallel pass over the index.
+         *  \param[out] keepPoint  Non-zero for every kept point, sized to the point count of \p populations.
+         *  \param[in]  keepCounts How many points to keep from each population, clamped to the population size.
+         *  \param[in]  seed       Each population draws from its own generator seeded by \p seed and its GID, so the result does not depend on the thread count.
+         *  \return                Number of kept points.
+         */
+        inline PidT subsamplePopulations( std::vector<char>       & keepPoint
+                                        , PopulationIndex    const& populations
+                                        , std::vector<PidT>  const& keepCounts
+                                        , unsigned           const  seed )
+        {
+            keepPoint.assign( populations.getPointCount(), 0 );
+
+            PidT sum( 0 );
+#           pragma omp parallel for schedule(dynamic) reduction(+:sum)
+            for ( LidT popId = 0; popId < populations.size(); ++popId )
+            {
+                const PidT population = populations.getPopulation( popId );
+                const PidT keep       = std::min( keepCounts[popId], population );
+                if ( keep <= 0 )
+                    continue;
+
+                if ( keep == population )
+                    for ( PidT const* it = populations.begin(popId); it != populations.end(popId); ++it )
+                        keepPoint[ *it ] = 1;
+                else
+                {
+                    // partial Fisher-Yates: the first keep entries are a uniform sample
+                    std::vector<PidT> pids( populations.begin(popId), populations.end(popId) );
+                    std::mt19937 rng( seed ^ unsigned(populations.getGid(popId) * 2654435761u) );
+                    for ( PidT i = 0; i != keep; ++i )
+                    {
+                        std::swap( pids[i], pids[ i + PidT(rng() % unsigned(population - i)) ] );
+                        keepPoint[ pids[i] ] = 1;
+                    }
+                }
+                sum += keep;
+            }
+
+            return sum;
+        } //...subsamplePopulations()
+    } //...ns processing
+} //...ns rapter
+
+namespace rapter
+{
+    // Usage: .../Release/bin/toGlobFit --subsample-primitives 0.1 --pop-limit 100 [--compact] --prims segments.csv --cloud cloud.ply -a points_segments.csv --scale 0.005
     template < class _PrimitiveVectorT
              , class _PrimitiveMapT
              , class _PointContainerT
@@ -40,7 +155,7 @@ namespace rapter
         if ( rapter::console::parse_argument(argc,argv,"--subsample-primitives",ratio) < 0 || (ratio < FLT_EPSILON) )
         {
             std::cerr << "[" << __func__ << "]: " << "you need to provide subsample ratio after --subsample-primitives\n";
-            std::cout << "example: " << "--subsample-primitives 0.1 --prim-limit 200 --prim-random-ratio 0.5 --pop-limit 100 --prims segments.csv --cloud cloud.ply -a points_segments.csv --scale 0.005" << std::endl;
+            std::cout << "example: " << "--subsample-primitives 0.1 --prim-limit 200 --prim-random-ratio 0.5 --pop-limit 100 [--compact] --prims segments.csv --cloud cloud.ply -a points_segments.csv --scale 0.005" << std::endl;
             return EXIT_FAILURE;
         }
         int popLimit( 20 ); // don't cut planes less than this
@@ -53,95 +168,60 @@ namespace rapter
         rapter::console::parse_argument( argc,argv,"--prim-random-ratio", primRandRatio );
         std::cout << "[" << __func__ << "]: " << "keeping " << primLimit << " planes, change with \"--prim-limit k\"" << std::endl;
         std::cout << "[" << __func__ << "]: " << primRandRatio * 100.0 << "% will be random (--prim-random-ratio f), the rest picked in descending population (point count) order\n";
+        const bool compact = rapter::console::find_switch( argc, argv, "--compact" ); // write a cloud of the kept points only
 
         // fetch populations
-        rapter::GidPidVectorMap populations;
-        processing::getPopulations( populations, points );
-
-        //typedef typename GF2::GidPidVectorMap::value_type       Gid_PidVector_Pair;
-        typedef typename rapter::GidPidVectorMap::const_iterator   PopConstIterator;
-        typedef          std::pair<PidT, GidT>                  MultiMapPair;
-
-        /// sort by population
-        std::multimap< PidT, GidT > gidsBySize;         // key: #points in GId, value: { GId => [ pid0, pid1, ...] }
-        PidT                        sumCanBeCut ( 0 );  // sum of #points that belong to planes, that >popLimit
-        for ( PopConstIterator it = populations.begin(); it != populations.end(); ++it )
+        processing::PopulationIndex populations( points );
+        const LidT unsetId = populations.find( PointPrimitiveT::LONG_VALUES::UNSET );
+
+        /// sort by population, descending
+        std::vector< std::pair<PidT,LidT> > bySize;         // < #points in population, population id >
+        PidT                                sumCanBeCut ( 0 );  // sum of #points that belong to planes, that >popLimit
+        bySize.reserve( populations.size() );
+        for ( LidT popId = 0; popId != populations.size(); ++popId )
         {
-            if ( it->first == PrimitiveT::LONG_VALUES::UNSET )
+            if ( popId == unsetId )
                 continue;
             // read population
-            const PidT pop = it->second.size();
+            const PidT pop = populations.getPopulation( popId );
 
             // record
-            gidsBySize.insert( MultiMapPair(pop, it->first) );
+            bySize.push_back( std::make_pair(pop, popId) );
 
             // count, how many points we plan to cut from (not all, planes < popLimit we don't touch)
             if ( pop > popLimit )
                 sumCanBeCut += pop;
         } //...for populations
+        std::sort( bySize.begin(), bySize.end(), std::greater< std::pair<PidT,LidT> >() );
 
-
-        /// estimate per-plane-reduction
-        std::map<GidT,PidT> cutHowMuch;                             // how much each Gid has to be cut
-        std::set<GidT>      keepPrims;                              // which primitives are large enough to keep. Only used, if primLimit > 0
-        const PidT          targetCut( std::floor(Scalar(1.-ratio) * sumCanBeCut) ); // how many points we were instructed to cut
-        PidT                sumCut   ( 0 );                         // how many points we were plan       to cut (sanity check ~= targetCut)
-
-        // pick (1. - primRandRatio) primitives from the top, and the rest randomly
-        std::set<MultiMapPair> chosenGids;
+        // pick (1. - primRandRatio) primitives from the top, and the rest randomly, all if no limit
+        std::vector<char> keepPopulation( populations.size(), !primLimit );
+        if ( primLimit )
         {
-            ULidT largePrimDemand = std::floor( primLimit * (1. - primRandRatio) );
-            std::cout << "largePrimDemand " << largePrimDemand << ", primlimiT: " << primLimit << std::endl;
-
-            // iterate over all once
-            auto it = gidsBySize.rbegin();
-            // pick first k right away
-            for ( ; it != gidsBySize.rend() && (chosenGids.size() < largePrimDemand); ++it )
-                chosenGids.insert( *it );
-
-            // enlist the rest to pick randomly from
-            std::vector<MultiMapPair> gidMix; // contains the "small" primitives, to randomly sample from
-            for ( ; it != gidsBySize.rend(); ++it )
-                gidMix.push_back( *it );
-            std::cout << "gidMix.size(): " << gidMix.size() << ", " << chosenGids.size() << std::endl;
-
-            // shuffle the "small" primitives
-            shuffle( gidMix.begin(), gidMix.end(), std::default_random_engine(seed) );
-
-            // pick the first (primLimit-k) to fill chosen Gids
-            for ( auto gidMixIt = gidMix.begin(); gidMixIt != gidMix.end() && (chosenGids.size() < primLimit); ++gidMixIt )
-            {
-                chosenGids.insert( *gidMixIt );
-                std::cout << "chosenGids.size(): " << chosenGids.size() << std::endl;
-            }
-
+            const ULidT largePrimDemand = std::min( size_t(std::floor(primLimit * (1. - primRandRatio))), bySize.size() );
+            for ( ULidT i = 0; i != largePrimDemand; ++i )
+                keepPopulation[ bySize[i].second ] = 1;
+
+            // shuffle the "small" primitives, and pick the first (primLimit-k) to fill
+            std::shuffle( bySize.begin() + largePrimDemand, bySize.end(), std::default_random_engine(seed) );
+            for ( ULidT i = largePrimDemand; i < std::min(primLimit, bySize.size()); ++i )
+                keepPopulation[ bySize[i].second ] = 1;
         }
+        if ( unsetId >= 0 )
+            keepPopulation[ unsetId ] = 0;
 
-        // actually pick them, and subsample their population
-        LidT primId( 0 );
-        //for ( auto it = gidsBySize.rbegin(); it != gidsBySize.rend(); ++it, ++primId )
-        for ( auto it = chosenGids.begin(); it != chosenGids.end(); ++it, ++primId )
+        /// estimate per-plane-reduction
+        const PidT        targetCut( std::floor(Scalar(1.-ratio) * sumCanBeCut) ); // how many points we were instructed to cut
+        PidT              sumCut   ( 0 );                         // how many points we were plan       to cut (sanity check ~= targetCut)
+        std::vector<PidT> keepCounts( populations.size(), 0 );
+        for ( LidT popId = 0; popId != populations.size(); ++popId )
         {
-            const PidT population = it->first;
-            const GidT gid        = it->second;
-            //std::cout << "[#points:" << pop << "]: <gid," << gid << ">, #points:" << populations.at( it->second ).size() << std::endl;
-
-            // remove primitive, if
-            //  a. there's a primitive limit AND
-            //  b. already exceeded that limit OR
-            //  c. this is large primitive we randomly don't keep and leave space for a random one later: rand < primRandRatio
-            if ( primLimit && (keepPrims.size() >= primLimit) )
-            {
-                std::cerr << "[" << __func__ << "]: " << " too many primitives chosen..." << std::endl;
+            if ( !keepPopulation[popId] )
                 continue;
-            }
-            else
-            {
-                keepPrims.insert( gid );
-                std::cout << "keeping " << gid << "/" << gidsBySize.size() << ", keepPrims.size(): " << keepPrims.size() << std::endl;
-            }
 
             // don't cut points from too small planes
+            const PidT population = populations.getPopulation( popId );
+            keepCounts[popId] = population;
             if ( population < popLimit )
                 continue;
 
@@ -151,117 +231,45 @@ namespace rapter
             if ( population - localN < popLimit )
                 localN = population - popLimit;
 
-            if ( localN && (population - localN < popLimit) )
-                std::cerr << "[" << __func__ << "]: " << "warning, cutting a plane to become too small: "
-                          << population
-                          << " --> " << population - localN
-                          << " < " << popLimit
-                          << std::endl;
-            // record
-            if ( localN )
-            {
-                if ( cutHowMuch.find(gid) != cutHowMuch.end() )
-                    std::cerr << "[" << __func__ << "]: " << "warning, probably more planes in same Gid" << std::endl;
-                cutHowMuch[ gid ] = localN;
-            }
-
-            // sanity check
-            sumCut += localN;
-
-            // log
-            //std::cout << "localRat = " << population << "/" << sumCanBeCut << ": " << localRatio << "\t=> * " << targetCut << " = " << localN << std::endl;
+            keepCounts[popId] -= localN;
+            sumCut            += localN;
         } //...for planes to cut
 
         // log
-        std::cout << "[" << __func__ << "]: " << "cut " << sumCut << "/" << points.size() << " assignments == " << Scalar(sumCut)/Scalar(sumCanBeCut) * 100. << "%" << std::endl;
+        std::cout << "[" << __func__ << "]: " << "keeping " << std::count(keepPopulation.begin(), keepPopulation.end(), 1) << "/" << bySize.size() << " primitives, "
+                  << "cut " << sumCut << "/" << points.size() << " assignments == " << Scalar(sumCut)/Scalar(sumCanBeCut) * 100. << "%" << std::endl;
 
         /// do cut
+        std::vector<char> keepPoint;
+        const PidT sum = processing::subsamplePopulations( keepPoint, populations, keepCounts, seed );
+
+        // unassign the points of removed primitives and the cut ones
+#       pragma omp parallel for
+        for ( PidT pid = 0; pid < PidT(points.size()); ++pid )
+            if ( !keepPoint[pid] )
+                points[pid].setTag( PointPrimitiveT::TAGS::GID, PointPrimitiveT::LONG_VALUES::UNSET );
+
         _PrimitiveMapT out;
         for ( typename _PrimitiveMapT::Iterator it(primitives); it.hasNext(); it.step() )
         {
-            const GidT gid = it.getGid();
-
-            auto popIt = populations.find( gid );
-            if ( popIt == populations.end() )
+            const LidT popId = populations.find( it.getGid() );
+            if ( popId < 0 )
             {
-                std::cerr << "[" << __func__ << "]: " << " this shouldn't happen, population not found for gid " << gid << std::endl;
-                continue;
-            }
-            auto population = popIt->second; // copy, because we reshuffle it later
-
-            // (1) clear all point assignments, we delete the primitive
-            if ( primLimit && (keepPrims.find(gid) == keepPrims.end()) )
-            {
-                for ( auto pidIt = population.rbegin(); pidIt != population.rend() ; ++pidIt )
-                {
-                    if ( points.at( /* pid: */ *pidIt ).getTag( PointPrimitiveT::TAGS::GID ) != gid )
-                        std::cerr << "[" << __func__ << "]: " << "Point " << *pidIt << " is not actually assigned to plane (gid " << gid << "), should not happen" << std::endl;
-                    points.at( /* pid: */ *pidIt ).setTag( PointPrimitiveT::TAGS::GID, PointPrimitiveT::LONG_VALUES::UNSET );
-                }
+                std::cerr << "[" << __func__ << "]: " << " this shouldn't happen, population not found for gid " << it.getGid() << std::endl;
                 continue;
             }
 
             // store primitive
-            containers::add( out, gid, *it );
-            std::cout << "adding " << gid << ", now " << out.size() << std::endl;
-
-            // (2) just copy primitive to output, no assigned points to remove
-            auto const cutIt = cutHowMuch.find( gid );
-            if ( cutIt == cutHowMuch.end() )
-            {
-                continue;
-            }
-
-            // (3) keep, but remove some of the assigned points
-            const PidT cut = cutIt->second;
-
-            // estimate percentage of points that need to be cut from all of the points assigned to this primitive
-            Scalar  cutRatio( Scalar(cut) / Scalar( population.size()) );
-            // number of points to cut
-            PidT    toCut   ( std::ceil(cutRatio * Scalar(population.size())) );
-
-            // log/debug
-            if ( cutRatio < ratio * 0.01  || cutRatio > 1.01 ) std::cerr << "cutratio: " << cutRatio << std::endl;
-
-            // reorder assigned points to randomize
-            shuffle ( population.begin(), population.end(), std::default_random_engine(seed) );
-            // keep track of cut points
-            PidT cnt   = 0;
-            // iterate through shuffled, assigned points
-            for ( auto pidIt = population.rbegin(); pidIt != population.rend() && cnt != toCut; ++pidIt, ++cnt )
-            {
-                if ( points.at( /* pid: */ *pidIt ).getTag( PointPrimitiveT::TAGS::GID ) != gid )
-                    std::cerr << "[" << __func__ << "]: " << "Point " << *pidIt << " is not actually assigned to plane (gid " << gid << "), should not happen" << std::endl;
-                points.at( /* pid: */ *pidIt ).setTag( PointPrimitiveT::TAGS::GID, PointPrimitiveT::LONG_VALUES::UNSET );
-            }
+            if ( keepPopulation[popId] )
+                containers::add( out, it.getGid(), *it );
         } //...iterate primitives
 
-        // check
-        rapter::GidPidVectorMap populations2;
-        processing::getPopulations( populations2, points );
-        PidT                 sum(0);
-        for ( auto it = populations2.begin(); it != populations2.end(); ++it )
-        {
-            if ( it->first == PrimitiveT::LONG_VALUES::UNSET )
-                continue;
-
-            sum+= it->second.size();
-        }
         std::cout << "[" << __func__ << "]: "
                   << "Reduction: from " << points.size() << " points, and " << sumCanBeCut << " assignments --> "
                   << sum << " remaining assignments  == "
                   << Scalar(sum) / points.size() * 100. << "% points are active in the output, "
                   << Scalar(sum) / sumCanBeCut   * 100. << "% assignments remained" << std::endl;
 
-        for ( auto it = gidsBySize.begin(); it != gidsBySize.end(); ++it )
-        {
-            const PidT population = it->first;
-            //const GidT gid = it->second;
-            if ( population < popLimit )
-                continue;
-            //std::cout << "oldPop[" << gid << "]: " << populations[gid].size() << ", new: " << populations2[gid].size() << std::endl;
-        }
-
         // save
         std::string input_prims_path = parsePrimitivesPath(argc, argv);
         std::string outName = boost::filesystem::path( input_prims_path).stem().string();
@@ -272,6 +280,30 @@ namespace rapter
         rapter::io::writeAssociations<PointPrimitiveT>( points, ssAssoc.str() );
 
         std::cout << "[" << __func__ << "]: " << "results written to " << ssPrims.str() << "(#" << out.size() << ") and " << ssAssoc.str() << "\n";
+
+        // compact cloud of the kept points only, renumbered in input order
+        if ( compact )
+        {
+            std::vector<PidT> newPids( points.size(), 0 );
+            for ( size_t pid = 0; pid != points.size(); ++pid )
+                newPids[pid] = (pid ? newPids[pid-1] : 0) + (keepPoint[pid] ? 1 : 0);
+
+            _PointContainerT compactPoints;
+            compactPoints.resize( sum );
+#           pragma omp parallel for
+            for ( PidT pid = 0; pid < PidT(points.size()); ++pid )
+                if ( keepPoint[pid] )
+                {
+                    compactPoints[ newPids[pid] - 1 ] = points[pid];
+                    compactPoints[ newPids[pid] - 1 ].setTag( PointPrimitiveT::TAGS::PID, newPids[pid] - 1 );
+                }
+
+            std::stringstream ssCloud; ssCloud << "cloud_" << outName << ".sub_" << ratio << "_" << primLimit << ".ply";
+            std::stringstream ssCompactAssoc; ssCompactAssoc << "points_" << outName << ".sub_" << ratio << "_" << primLimit << ".compact.csv";
+            rapter::io::writePoints<PointPrimitiveT>( compactPoints, ssCloud.str() );
+            rapter::io::writeAssociations<PointPrimitiveT>( compactPoints, ssCompactAssoc.str() );
+            std::cout << "[" << __func__ << "]: " << "compact cloud written to " << ssCloud.str() << "(#" << compactPoints.size() << ") and " << ssCompactAssoc.str() << "\n";
+        }
         std::cout << "../runGlobfit.py -s " << params.scale << " -p " << ssPrims.str() << " -a " << ssAssoc.str() << "\n";
 
         return EXIT_SUCCESS;
@@ -0,0 +1,224 @@
+#ifndef RAPTER_ORIENTATION_HPP
+#define RAPTER_ORIENTATION_HPP
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include "rapter/simpleTypes.h"
+
+namespace rapter {
+namespace processing {
+
+    /*! \brief Undirected edge of a neighbourhood graph, see \ref boruvkaForest().
+     *  \tparam _Scalar Concept: float.
+     */
+    template <typename _Scalar>
+    struct WeightedEdge
+    {
+        LidT    v0, v1;
+        _Scalar w;
+
+        WeightedEdge( LidT v0_, LidT v1_, _Scalar w_ ) : v0( v0_ ), v1( v1_ ), w( w_ ) {}
+    }; //...struct WeightedEdge
+
+    /*! \brief Minimum spanning forest by Borůvka's algorithm.
+     *
+     *         Every round each vertex finds its lightest edge leaving its component in parallel, each component keeps the lightest of its vertices',
+     *         and the components are joined along them. Ties are broken by edge index, so the forest does not depend on the thread count,
+     *         and the rounds never close a cycle. The component count at least halves every round.
+     *  \param[in]  vertexCount Number of vertices, edges index into [0,vertexCount).
+     *  \param[in]  edges       Undirected edges, each listed once.
+     *  \param[out] forest      Indices into \p edges of the forest's edges.
+     *  \return                 Number of trees (connected components).
+     */
+    template <typename _Scalar>
+    inline LidT boruvkaForest( LidT const vertexCount, std::vector< WeightedEdge<_Scalar> > const& edges, std::vector<LidT> &forest )
+    {
+        forest.clear();
+
+        // incident edges of each vertex
+        std::vector<LidT> rowStart( vertexCount + 1, 0 ), incident( 2 * edges.size() );
+        for ( size_t e = 0; e != edges.size(); ++e )
+        {
+            ++rowStart[ edges[e].v0 + 1 ];
+            ++rowStart[ edges[e].v1 + 1 ];
+        }
+        for ( LidT v = 0; v != vertexCount; ++v )
+            rowStart[v+1] += rowStart[v];
+        {
+            std::vector<LidT> fill( rowStart.begin(), rowStart.end() - 1 );
+            for ( size_t e = 0; e != edges.size(); ++e )
+            {
+                incident[ fill[edges[e].v0]++ ] = e;
+                incident[ fill[edges[e].v1]++ ] = e;
+            }
+        }
+
+        // union-find with path halving
+        std::vector<LidT> parent( vertexCount );
+        for ( LidT v = 0; v != vertexCount; ++v )
+            parent[v] = v;
+        auto find = [&parent]( LidT v )
+        {
+            while ( parent[v] != v )
+                v = parent[v] = parent[ parent[v] ];
+            return v;
+        };
+
+        // strict order on edges: weight, then index
+        auto lighter = [&edges]( LidT const e0, LidT const e1 )
+        {
+            return (e1 < 0) || (edges[e0].w < edges[e1].w) || ((edges[e0].w == edges[e1].w) && (e0 < e1));
+        };
+
+        LidT trees = vertexCount;
+        std::vector<LidT> comp( vertexCount ), best( vertexCount ), compBest( vertexCount );
+        for ( bool joined = true; joined; )
+        {
+            joined = false;
+            for ( LidT v = 0; v != vertexCount; ++v )
+                comp[v] = find( v );
+
+            // lightest leaving edge per vertex
+#           pragma omp parallel for schedule(dynamic,256)
+            for ( LidT v = 0; v < vertexCount; ++v )
+            {
+                best[v] = -1;
+                for ( LidT k = rowStart[v]; k != rowStart[v+1]; ++k )
+                {
+                    const LidT e     = incident[k];
+                    const LidT other = edges[e].v0 == v ? edges[e].v1 : edges[e].v0;
+                    if ( comp[other] != comp[v] && lighter(e, best[v]) )
+                        best[v] = e;
+                }
+            }
+
+            // lightest leaving edge per component
+            std::fill( compBest.begin(), compBest.end(), LidT(-1) );
+            for ( LidT v = 0; v != vertexCount; ++v )
+                if ( best[v] >= 0 && lighter(best[v], compBest[comp[v]]) )
+                    compBest[ comp[v] ] = best[v];
+
+            for ( LidT c = 0; c != vertexCount; ++c )
+            {
+                if ( compBest[c] < 0 )
+                    continue;
+
+                // two components may pick the same edge
+                const LidT r0 = find( edges[compBest[c]].v0 ), r1 = find( edges[compBest[c]].v1 );
+                if ( r0 == r1 )
+                    continue;
+
+                parent[ std::max(r0,r1) ] = std::min( r0, r1 );
+                forest.push_back( compBest[c] );
+                --trees;
+                joined = true;
+            }
+        } //...rounds
+
+        return trees;
+    } //...boruvkaForest()
+
+    /*! \brief Flips the directions of points, so that neighbours agree in sign.
+     *
+     *         The neighbourhood graph is weighted by \f$ 1 - |n_i \cdot n_j| \f$, so that the orientation is propagated along the flattest paths first.
+     *         Its minimum spanning forest (see \ref boruvkaForest()) is traversed from the smallest point id of each tree, which keeps its sign,
+     *         and every point is flipped, if it disagrees with its parent.
+     *  \tparam _PointContainerT   Concept: std::vector< \ref rapter::PointPrimitive >, direction in coeffs().segment<3>(3).
+     *  \param[in,out] points      Points with unoriented directions, e.g. from \ref Segmentation::orientPoints().
+     *  \param[in]     neighs      Neighbour ids of each point, need not be symmetric. Concept: std::vector< std::vector<int> >.
+     *  \param[out]    flipCount   Optional, number of flipped directions.
+     *  \return                    Number of trees, i.e. orientation islands that were oriented independently.
+     */
+    template <typename _Scalar, class _PointContainerT, class _NeighbourhoodsT>
+    inline LidT orientConsistently( _PointContainerT &points, _NeighbourhoodsT const& neighs, LidT *flipCount = NULL )
+    {
+        typedef WeightedEdge<_Scalar> EdgeT;
+        const LidT N = points.size();
+
+        // each undirected edge once, from the lower id
+        std::vector< std::vector<EdgeT> > perPoint( N );
+#       pragma omp parallel for schedule(dynamic,256)
+        for ( LidT pid = 0; pid < std::min(N, LidT(neighs.size())); ++pid )
+        {
+            for ( size_t k = 0; k != neighs[pid].size(); ++k )
+            {
+                const LidT pid1 = neighs[pid][k];
+                if ( pid1 == pid )
+                    continue;
+                const _Scalar dot = std::abs( points[pid].template dir().dot(points[pid1].template dir()) )
+                                  / std::max( points[pid].template dir().norm() * points[pid1].template dir().norm(), std::numeric_limits<_Scalar>::min() );
+                perPoint[pid].push_back( EdgeT(std::min(pid,pid1), std::max(pid,pid1), _Scalar(1.) - std::min(dot, _Scalar(1.))) );
+            }
+        }
+
+        std::vector<EdgeT> edges;
+        for ( LidT pid = 0; pid != N; ++pid )
+            edges.insert( edges.end(), perPoint[pid].begin(), perPoint[pid].end() );
+        std::sort( edges.begin(), edges.end(), []( EdgeT const& a, EdgeT const& b ) { return (a.v0 < b.v0) || ((a.v0 == b.v0) && (a.v1 < b.v1)); } );
+        edges.erase( std::unique(edges.begin(), edges.end(), []( EdgeT const& a, EdgeT const& b ) { return (a.v0 == b.v0) && (a.v1 == b.v1); }), edges.end() );
+
+        std::vector<LidT> forest;
+        const LidT trees = boruvkaForest( N, edges, forest );
+
+        // forest adjacency
+        std::vector<LidT> rowStart( N + 1, 0 ), adjacent( 2 * forest.size() );
+        for ( size_t k = 0; k != forest.size(); ++k )
+        {
+            ++rowStart[ edges[forest[k]].v0 + 1 ];
+            ++rowStart[ edges[forest[k]].v1 + 1 ];
+        }
+        for ( LidT v = 0; v != N; ++v )
+            rowStart[v+1] += rowStart[v];
+        {
+            std::vector<LidT> fill( rowStart.begin(), rowStart.end() - 1 );
+            for ( size_t k = 0; k != forest.size(); ++k )
+            {
+                adjacent[ fill[edges[forest[k]].v0]++ ] = edges[forest[k]].v1;
+                adjacent[ fill[edges[forest[k]].v1]++ ] = edges[forest[k]].v0;
+            }
+        }
+
+        // propagate from the root of each tree
+        LidT flips = 0;
+        std::vector<char> visited( N, 0 );
+        std::vector<LidT> queue;
+        for ( LidT root = 0; root != N; ++root )
+        {
+            if ( visited[root] )
+                continue;
+
+            visited[root] = 1;
+            queue.assign( 1, root );
+            for ( size_t head = 0; head != queue.size(); ++head )
+            {
+                const LidT v = queue[head];
+                for ( LidT k = rowStart[v]; k != rowStart[v+1]; ++k )
+                {
+                    const LidT child = adjacent[k];
+                    if ( visited[child] )
+                        continue;
+                    visited[child] = 1;
+
+                    if ( points[v].template dir().dot(points[child].template dir()) < _Scalar(0.) )
+                    {
+                        points[child].coeffs().template segment<3>(3) *= _Scalar(-1.);
+                        ++flips;
+                    }
+                    queue.push_back( child );
+                }
+            }
+        } //...for roots
+
+        if ( flipCount )
+            *flipCount = flips;
+
+        return trees;
+    } //...orientConsistently()
+
+} //...namespace processing
+} //...namespace rapter
+
+#endif // RAPTER_ORIENTATION_HPP
@@ -0,0 +1,82 @@
+#ifndef RAPTER_POLYGONIZE_H
+#define RAPTER_POLYGONIZE_H
+
+#include <vector>
+#include "Eigen/Dense"
+#include "Eigen/StdVector"
+#include "rapter/simpleTypes.h"
+
+namespace rapter {
+namespace processing {
+
+    /*! \brief Boundary polygon of a finite plane. Vertices are stored in the 2D local frame of the plane ( \p origin, \p u, \p v ).
+     *  \tparam _Scalar Concept: float.
+     */
+    template <typename _Scalar>
+    struct PlanarPolygon
+    {
+            typedef Eigen::Matrix<_Scalar,2,1>                              Vertex2;
+            typedef Eigen::Matrix<_Scalar,3,1>                              Vertex3;
+            typedef std::vector<Vertex2, Eigen::aligned_allocator<Vertex2> > VerticesT;
+
+            PlanarPolygon() : gid( -1 ), did( -1 ) {}
+
+            //! \brief Converts a point in the plane's local frame to world coordinates.
+            inline Vertex3 toWorld( Vertex2 const& x ) const { return origin + x(0) * u + x(1) * v; }
+            //! \brief Projects a world point to the plane's local frame.
+            inline Vertex2 toLocal( Vertex3 const& p ) const { return Vertex2( u.dot(p - origin), v.dot(p - origin) ); }
+
+            inline bool    empty()                     const { return vertices.size() < 3; }
+
+            GidT      gid;      //!< \brief GID of the source primitive.
+            DidT      did;      //!< \brief Direction id of the source primitive.
+            Vertex3   origin;   //!< \brief Point on the plane, origin of the local frame.
+            Vertex3   u, v;     //!< \brief Orthonormal in-plane axes.
+            Vertex3   normal;   //!< \brief Unit plane normal ( u x v ).
+            VerticesT vertices; //!< \brief Ordered boundary in local ( u, v ) coordinates.
+    }; //...PlanarPolygon
+
+    /*! \brief Computes a concave (alpha-shape) boundary for each selected plane from its assigned points. Runs parallel over primitives.
+     *  \tparam _PrimitiveT         Concept: PlanePrimitive.
+     *  \tparam _PointContainerT    Concept: std::vector<PointPrimitive>.
+     *  \tparam _PopulationsT       Concept: GidPidVectorMap.
+     *  \param[out] polygons        One entry per input primitive, in the same order. Empty, if no boundary could be found.
+     *  \param[in]  prims           Selected primitives.
+     *  \param[in]  points          Points with GID tags assigned.
+     *  \param[in]  populations     Point ids for each GID.
+     *  \param[in]  alpha           Alpha radius of the concave hull.
+     *  \param[in]  decimation      Grid cell size to thin the points by before the hull is computed. 0 disables thinning.
+     *  \return                     Number of non-empty polygons.
+     */
+    template <class _PrimitiveT, class _PointContainerT, class _PopulationsT, typename _Scalar>
+    inline LidT computeBoundaries( std::vector<PlanarPolygon<_Scalar> >       & polygons
+                                 , std::vector<_PrimitiveT const*>       const& prims
+                                 , _PointContainerT                      const& points
+                                 , _PopulationsT                         const& populations
+                                 , _Scalar                               const  alpha
+                                 , _Scalar                               const  decimation );
+
+    /*! \brief Clips each polygon along the intersection lines with its adjacent, non-parallel neighbours.
+     *         A polygon is clipped, if both polygons reach the line, and it overshoots the line by less than \p clip_dist on one side.
+     *         Vertices closer than \p clip_dist to the line on the kept side are snapped to the line, so that neighbours share the edge.
+     *         Each polygon is clipped against the unclipped neighbours, so the result does not depend on the order. Runs parallel over polygons.
+     *  \param[in,out] polygons     Polygons from \ref computeBoundaries().
+     *  \param[in]     clip_dist    Maximum distance of a polygon from the line to be considered adjacent, and maximum overshoot to clip.
+     *  \param[in]     min_angle    Planes with smaller angle between them are not clipped against each other.
+     *  \return                     Number of clip operations performed.
+     */
+    template <typename _Scalar>
+    inline LidT clipAlongIntersections( std::vector<PlanarPolygon<_Scalar> > & polygons
+                                      , _Scalar const clip_dist
+                                      , _Scalar const min_angle );
+
+    /*! \brief Command line entry of polygon extraction. Reads primitives and associations, computes boundary polygons,
+     *         clips them at intersections, and writes an OBJ or PLY mesh.
+     */
+    template <class _PrimitiveContainerT, class _PointContainerT, class _PrimitiveT, class _PointPrimitiveT>
+    inline int polygonizeCli( int argc, char** argv );
+
+} //...namespace processing
+} //...namespace rapter
+
+#endif // RAPTER_POLYGONIZE_H
@@ -129,27 +129,32 @@ namespace rapter {
             return ret;
         } //...TransformPrimitivesMap
 
+        /*! \brief Computes the mean position of an [indexed] pointcloud.
+         *  \tparam _Scalar             Output precision.
+         *  \tparam _AccumScalar        Precision the positions are summed in. Concept: \ref rapter::AccumScalar.
+         */
         template < class _Scalar
                  , class _IndicesContainerT
                  , class _PointContainerT
+                 , class _AccumScalar = __AccumScalar
                  >
         inline Eigen::Matrix<_Scalar,3,1> getCentroid( _PointContainerT const& points, _IndicesContainerT const* indices = NULL )
         {
             const LidT N = indices ? indices->size() : points.size();
 
-            Eigen::Matrix<_Scalar,3,1> centroid( Eigen::Matrix<_Scalar,3,1>::Zero() );
+            Eigen::Matrix<_AccumScalar,3,1> centroid( Eigen::Matrix<_AccumScalar,3,1>::Zero() );
             for ( PidT pid_id = 0; pid_id != N; ++pid_id )
             {
                 const unsigned long pid = indices ? (*indices)[pid_id] : pid_id;
-                centroid += points[ pid ].template pos();
+                centroid += points[ pid ].template pos().template cast<_AccumScalar>();
             }
 
             if ( N )
-                centroid /= _Scalar( N );
+                centroid /= _AccumScalar( N );
             else
                 std::cout << "[" << __func__ << "]: " << "empty..." << std::endl;
 
-            return centroid;
+            return centroid.template cast<_Scalar>();
         }
 
         /*! \brief Computes [weighted] covariance matrix of [indexed] pointcloud.
@@ -158,6 +163,7 @@ namespace rapter {
          *  \tparam _Position           3D position. Concept: Eigen::Vector<_Scalar,3,1>.
          *  \tparam _IndicesContainerT  Contains indices to entries in points. Concept: std::vector< int >.
          *  \tparam _WeightsContainerT  Contains scalar weights to use for fitting. Concept: std::vector<_Scalar>.
+         *  \tparam _AccumScalar        Precision the outer products are summed in. Concept: \ref rapter::AccumScalar.
          *  \param[out] cov             Covariance matrix output.
          *  \param[in]  points          Pointcloud input.
          *  \param[in]  centroid        Precomputed centroid of cloud.
@@ -165,36 +171,40 @@ namespace rapter {
          *  \param[in]  weights         Optional weight matrix for weighted covariance matrix computation. Uniform weights are used, if left NULL.
          *  \return EXIT_SUCCESS;
          */
-        template <class _WeightsContainerT, class _IndicesContainerT, typename _Scalar, class _PointContainerT, typename _Position >
+        template <class _WeightsContainerT, class _IndicesContainerT, typename _Scalar, class _PointContainerT, typename _Position, typename _AccumScalar = __AccumScalar >
         inline int computeCovarianceMatrix( Eigen::Matrix<_Scalar,3,3> &cov
                                           , _PointContainerT      const& points
                                           , _Position             const& centroid
                                           , _IndicesContainerT    const* indices   = NULL
                                           , _WeightsContainerT    const* weights   = NULL )
         {
+            typedef Eigen::Matrix<_AccumScalar,3,1> AccumPosition;
             const LidT N = indices ? indices->size() : points.size();
 
-            cov.setZero();
-            _Scalar sumW( 0. );
+            Eigen::Matrix<_AccumScalar,3,3> accum( Eigen::Matrix<_AccumScalar,3,3>::Zero() );
+            const AccumPosition accumCentroid = centroid.template cast<_AccumScalar>();
+            _AccumScalar sumW( 0. );
             for ( LidT point_id = 0; point_id != N; ++point_id )
             {
                 const ULidT pid = indices ? (*indices)[point_id] : point_id;
-                _Position pos = points[ pid ].template pos() - centroid; // eigen expression template
+                AccumPosition pos = points[ pid ].template pos().template cast<_AccumScalar>() - accumCentroid;
 
                 if ( weights )
                 {
-                    cov   += pos * pos.transpose() * (*weights)[ point_id ];
-                    sumW  +=                         (*weights)[ point_id ];
+                    accum += pos * pos.transpose() * _AccumScalar( (*weights)[ point_id ] );
+                    sumW  +=                         _AccumScalar( (*weights)[ point_id ] );
                 }
                 else
                 {
-                    cov   += pos * pos.transpose();
+                    accum += pos * pos.transpose();
                 }
 
-                if ( weights && (sumW > _Scalar(0.)) )
-                    cov /= sumW;
+                if ( weights && (sumW > _AccumScalar(0.)) )
+                    accum /= sumW;
             } //...for all points
 
+            cov = accum.template cast<_Scalar>();
+
             return EXIT_SUCCESS;
         } //...computeCovarianceMatrix
 
@@ -341,6 +351,100 @@ namespace rapter {
         }
         
         
+        /*! \brief Tukey's biweight \f$ (x^2-1)^2, x = d / scale \f$ of a [signed] point-primitive distance, truncated to 0 beyond \p scale. */
+        template <typename _Scalar> inline _Scalar
+        biweight( _Scalar const dist, _Scalar const scale )
+        {
+            const _Scalar x = std::abs( dist ) / scale;
+            if ( !(x < _Scalar(1.)) )
+                return _Scalar(0.);
+
+            const _Scalar w = x * x - _Scalar(1.);
+            return w * w;
+        } //...biweight()
+
+        /*! \brief Weighted centroid and covariance of a pointcloud in a single streaming pass, without allocations.
+         *
+         *         The moments are accumulated relative to the first point in \p _AccumScalar,
+         *         so that \f$ cov = E[xx^T] - E[x]E[x]^T \f$ does not cancel out for clouds far from the origin.
+         *  \tparam _PositionFunctorT   Returns the position of the i-th point by value. Concept: std::function<Eigen::Vector3f(LidT)>.
+         *  \tparam _WeightFunctorT     Returns the weight of a position. Concept: std::function<float(Eigen::Vector3f)>.
+         *  \param[out] centroid        Weighted centroid. Untouched, if all weights are zero.
+         *  \param[out] cov             Weighted covariance. Untouched, if all weights are zero.
+         *  \return                     Sum of weights.
+         */
+        template <typename _AccumScalar, class _PositionFunctorT, class _WeightFunctorT> inline _AccumScalar
+        weightedMoments( Eigen::Matrix<_AccumScalar,3,1>      & centroid
+                       , Eigen::Matrix<_AccumScalar,3,3>      & cov
+                       , LidT                            const  N
+                       , _PositionFunctorT               const& position
+                       , _WeightFunctorT                 const& weight )
+        {
+            typedef Eigen::Matrix<_AccumScalar,3,1> AccumPosition;
+            if ( !N )
+                return _AccumScalar(0.);
+
+            const AccumPosition origin = position( 0 ).template cast<_AccumScalar>();
+
+            _AccumScalar  sumW( 0. ), xx( 0. ), xy( 0. ), xz( 0. ), yy( 0. ), yz( 0. ), zz( 0. );
+            AccumPosition sum( AccumPosition::Zero() );
+            for ( LidT point_id = 0; point_id != N; ++point_id )
+            {
+                const auto         pos = position( point_id ); // by value, might be an expression of the cloud otherwise
+                const _AccumScalar w = weight( pos );
+                if ( w == _AccumScalar(0.) )
+                    continue;
+
+                const AccumPosition d  = pos.template cast<_AccumScalar>() - origin;
+                const AccumPosition wd = w * d;
+                sumW += w;
+                sum  += wd;
+                xx   += wd(0) * d(0); xy += wd(0) * d(1); xz += wd(0) * d(2);
+                yy   += wd(1) * d(1); yz += wd(1) * d(2);
+                zz   += wd(2) * d(2);
+            }
+
+            if ( sumW > _AccumScalar(0.) )
+            {
+                const AccumPosition mean = sum / sumW;
+                cov << xx, xy, xz,
+                       xy, yy, yz,
+                       xz, yz, zz;
+                cov     /= sumW;
+                cov     -= mean * mean.transpose();
+                centroid = origin + mean;
+            }
+
+            return sumW;
+        } //...weightedMoments()
+
+        /*! \brief Closed-form eigen decomposition of a 3x3 covariance matrix, eigen values increasing.
+         *         Planar (2D) inputs, where the last row is zero, are solved as 2x2 problems.
+         */
+        template <typename _AccumScalar> inline void
+        symmetricEigenDirect( Eigen::Matrix<_AccumScalar,3,1>       & eigen_values
+                            , Eigen::Matrix<_AccumScalar,3,3>       & eigen_vectors
+                            , Eigen::Matrix<_AccumScalar,3,3> const & cov )
+        {
+            if ( cov(0,2) == _AccumScalar(0.) && cov(1,2) == _AccumScalar(0.) && cov(2,2) == _AccumScalar(0.) )
+            {
+                Eigen::SelfAdjointEigenSolver< Eigen::Matrix<_AccumScalar,2,2> > es;
+                es.computeDirect( cov.template topLeftCorner<2,2>() );
+
+                eigen_values << _AccumScalar(0.), es.eigenvalues()(0), es.eigenvalues()(1);
+                eigen_vectors.setZero();
+                eigen_vectors(2,0) = _AccumScalar(1.);
+                eigen_vectors.template block<2,2>(0,1) = es.eigenvectors();
+            }
+            else
+            {
+                Eigen::SelfAdjointEigenSolver< Eigen::Matrix<_AccumScalar,3,3> > es;
+                es.computeDirect( cov );
+                eigen_values  = es.eigenvalues();
+                eigen_vectors = es.eigenvectors();
+            }
+        } //...symmetricEigenDirect()
+
         /**
          * @brief fitLine               [Re]Fits 3D line to a [part of a] pointcloud.
          * @param[out] line             Output line, and possibly input line to refit, if \param start_from_input_line is true.
@@ -350,6 +454,7 @@ namespace rapter {
          * @param refit                 How many refit iterations. 0 means fit once, and refit 0 times, obviously (TODO to fix...).
          * @param initial_line          Use this line to calculate weights on the 0th iteration already.
          * @param fit_pos_only          Use this to refit only the position of the line or both position and orientation. Requires initial_line!=NULL
+         * @param dir_tolerance         Stop refitting early, when \f$ 1 - |cos| \f$ of the angle between consecutive directions falls below.
          */
         template <int rows, class PrimitiveT, class PointsT, typename Scalar> inline int
         fitLinearPrimitive( PrimitiveT                      & primitive
@@ -359,10 +464,13 @@ namespace rapter {
                             , int                             refit                 = 0
                             , PrimitiveT               const* initial_line          = NULL
                             , bool                            fit_pos_only          = false
-                            , bool                            debug                 = false )
+                            , bool                            debug                 = false
+                            , Scalar                          dir_tolerance         = Scalar(1e-6) )
         {
             //SG_STATIC_ASSERT( (rows == 4) || (rows == 6), smartgeometry_fit_linear_model_rows_not_4_or_6 );
-            typedef Eigen::Matrix<Scalar,3,1> Position;
+            typedef Eigen::Matrix<Scalar,3,1>            Position;
+            typedef Eigen::Matrix<__AccumScalar,3,1>     AccumPosition;
+            typedef Eigen::Matrix<__AccumScalar,3,3>     AccumMatrix;
 
             // number of points to take into account
             const PidT N = p_indices ? p_indices->size() : cloud.size();
@@ -379,127 +487,41 @@ namespace rapter {
             int iteration = 0; // track refit iterations
             do
             {
-                // LeastSquares weights
-                std::vector<Scalar> weights( N, 1.f );
-
-                // calculate weights, if value in "line" already meaningful
-                if ( initial_line || (iteration > 0) )
-                {
-                    // calculate distance from all points
-                    for ( PidT point_id = 0; point_id != N; ++point_id )
-                    {
-                        weights[point_id] = primitive.getDistance( cloud[ p_indices ? (*p_indices)[point_id] : point_id ].pos() );
-                    }
-
-                    // the farther away, the smaller weight -->
-                    // w_i = f( dist_i / scale ), dist_i < scale; f(x) = (x^2-1)^2
-                    for ( size_t wi = 0; wi != weights.size(); ++wi )
-                    {
-                        if ( weights[wi] < scale )
-                        {
-                            weights[wi] /= scale;                                               // x = dist_i / scale
-                            weights[wi] = (weights[wi] * weights[wi] - static_cast<Scalar>(1)); // x^2-1
-                            weights[wi] *= weights[wi];                                         // (x^2-1)^2
-                        }
-                        else
-                            weights[wi] = static_cast<Scalar>(0);                               // outside scale, truncated to 0
-
-                    }
-                }
-
-                // compute centroid of cloud or selected points
-                Position centroid( Position::Zero() );
-                Scalar sumW = 0;
-                for ( PidT point_id = 0; point_id != N; ++point_id )
-                {
-                    const unsigned long id = p_indices ? (*p_indices)[point_id] : point_id;
-                    centroid += cloud[ id ].pos() * weights[ point_id ];
-                    sumW     +=                     weights[ point_id ];
-                }
-                if ( sumW > Scalar(0.) )
-                    centroid /= sumW;
+                // calculate weights, if value in "line" already meaningful, otherwise LeastSquares
+                const bool   robust = initial_line || (iteration > 0);
+                AccumPosition centroid( AccumPosition::Zero() );
+                AccumMatrix   cov     ( AccumMatrix::Zero() );
+                const __AccumScalar sumW = weightedMoments( centroid, cov, N
+                                                          , [&]( PidT point_id ) -> Position { return cloud[ p_indices ? (*p_indices)[point_id] : point_id ].pos(); }
+                                                          , [&]( Position const& pos ) { return robust ? biweight( primitive.getDistance(pos), scale ) : Scalar(1.); } );
+
+                // all points outside scale, keep the previous fit
+                if ( !(sumW > __AccumScalar(0.)) )
+                    break;
 
                 if ( fit_pos_only )
                 {
-                    primitive = PrimitiveT(centroid.template head<3>(),
+                    primitive = PrimitiveT(centroid.template cast<Scalar>(),
                                            initial_line->dir());
                     continue; // we can stop now and go to next iteration
                 }
 
-                // compute neighbourhood covariance matrix
-                Eigen::Matrix<Scalar,3,3> cov( Eigen::Matrix<Scalar,3,3>::Zero() );
-                for ( PidT point_id = 0; point_id != N; ++point_id )
-                {
-                    const unsigned long id = p_indices ? (*p_indices)[point_id] : point_id;
-                    Position pos = cloud[ id ].template pos() - centroid; // eigen expression template
-                    cov   += pos * pos.transpose() * weights[ point_id ];
-                }                
-                cov /= sumW;
-
-                // debug
-                {
-                    Position centroid2( Position::Zero() );
-                    centroid2 = processing::getCentroid<Scalar>( cloud, p_indices );
-                    if ( debug ) std::cout << "centroids: " << centroid.transpose() << " vs. " << centroid2.transpose() << std::endl;
-
-                    Eigen::Matrix<Scalar,3,3> cov2( Eigen::Matrix<Scalar,3,3>::Zero() );
-                    computeCovarianceMatrix( cov2, cloud, centroid, p_indices, &weights );
-                    if ( debug ) std::cout << "[" << __func__ << "]: " << "cov:\n " << cov2 << "\ncov2:\n" << cov2 << std::endl;
-                }
-
-                // solve for neighbourhood biggest eigen value
-                Eigen::SelfAdjointEigenSolver< Eigen::Matrix<Scalar, 3, 3> > es;
-                es.compute( cov );
-
-
-#if 1
-                primitive = PrimitiveT( centroid, es.eigenvalues(), es.eigenvectors() );
-                //std::cout << "prim: " << primitive.toString() << std::endl;
-#else
-                if ( rows == 6 ) // line -> dir ==
-                {
-                    // get eigen vector for biggest eigen value
-                    const int max_eig_val_id = std::distance( es.eigenvalues().data(), std::max_element( es.eigenvalues().data(), es.eigenvalues().data()+3 ) );
-
-                    // output line
-                    primitive = PrimitiveT( centroid.template head<3>(),
-                                            es.eigenvectors().col(max_eig_val_id).normalized() );
-                }
-                else if ( rows == 4 ) // plane
-                {
-                    // get eigen vector for biggest eigen value
-                    const int min_eig_val_id = std::distance( es.eigenvalues().data(), std::min_element( es.eigenvalues().data(), es.eigenvalues().data()+3 ) );
-
-                    // output line
-                    primitive = PrimitiveT( centroid.template head<3>(),
-                                            es.eigenvectors().col(min_eig_val_id).normalized() );
-                }
-                else
-                    std::cerr << "[" << __func__ << "]: " << "lines(rows==6) or planes(rows==4), not rows == " << rows << std::endl;
-
-                std::cout << "prim_old: " << primitive.toString() << std::endl;
-#endif
-
-#if DEBUG_FITLINE
-                for ( int d = 0; d < 6; ++d )
-                {
-                    if ( primitive(d) != primitive(d) )
-                    {
-                        std::cerr << "centroid: \n" << centroid.transpose() << std::endl
-                                  << "cov\n: " << cov << std::endl
-                                  << "es.eigenvectors():\n" << es.eigenvectors() << std::endl;
-                    }
-                }
+                // closed-form eigen solve
+                AccumPosition eigen_values;
+                AccumMatrix   eigen_vectors;
+                symmetricEigenDirect( eigen_values, eigen_vectors, cov );
 
                 if ( debug )
-                {
-                    std::cout << "[" << __func__ << "]: " << line.transpose() << std::endl;
-                    std::cout << "[" << __func__ << "]: " << es.eigenvectors().col(0).transpose() << std::endl;
-                    std::cout << "[" << __func__ << "]: " << es.eigenvectors().col(1).transpose() << std::endl;
-                    std::cout << "[" << __func__ << "]: " << es.eigenvectors().col(2).transpose() << std::endl;
+                    std::cout << "[" << __func__ << "]: " << "sumW: " << sumW << ", centroid: " << centroid.transpose() << "\ncov:\n" << cov << std::endl;
 
-                }
-#endif
+                Position prevDir( Position::Zero() );
+                if ( robust )
+                    prevDir = primitive.dir();
+                primitive = PrimitiveT( centroid.template cast<Scalar>(), eigen_values.template cast<Scalar>(), eigen_vectors.template cast<Scalar>() );
+
+                // converged
+                if ( robust && (Scalar(1.) - std::abs(prevDir.dot(primitive.dir())) < dir_tolerance) )
+                    break;
             }
             while ( iteration++ < refit );
 
@@ -507,18 +529,13 @@ namespace rapter {
         } // ... fitline
         
         /*!
-         * @brief                           Get's a list of neighbours for each point in pointcloud/indices_arg, indices untested
-         * @param[out] neighbour_indices    List of list of neighbour indices. One list for each point in cloud.
-         * @param[in ] cloud                3D point cloud.
-         * @param[in ] indices_arg          Optional, if given, selects point from cloud (untested).
-         * @param[out] p_distances          Optional, neighbourhood squared distances arranged as neighbour_indices.
-         * @param[in ] K                    Maximum number of neighbours
-         * @param[in ] radius               Optional, maximum radius to look for K neighbours in
-         * @param[in ] soft_radius          Return K neighbours even if some outside radius
+         * @brief                           Same as below, but queries a prebuilt search structure, e.g. a \ref processing::Grid2D for 2D scenes.
+         * @tparam     _SearchT             Concept: pcl::search::KdTree<MyPointT>. Has to be built on the points selected by \p indices_arg.
          */
-        template <typename MyPointT>
+        template <typename MyPointT, class _SearchT>
         inline int
         getNeighbourhoodIndices( std::vector<std::vector<int> >                            & neighbour_indices
+                                , _SearchT                                            const& tree
                                 , boost::shared_ptr<pcl::PointCloud<MyPointT> >              cloud
                                 , std::vector<int>                                    const* indices_arg        = NULL
                                 , std::vector<std::vector<float> >                         * p_distances        = NULL
@@ -534,17 +551,6 @@ namespace rapter {
             neighbour_indices.resize( N );
             if ( p_distances )    p_distances->resize( N );
 
-            // create KdTree
-            typename pcl::search::KdTree<MyPointT>::Ptr tree( new pcl::search::KdTree<MyPointT> );
-            if ( indices_arg )
-            {
-                pcl::IndicesPtr indices_ptr( new std::vector<int>() );
-                *indices_ptr = *indices_arg; // copy indices
-                tree->setInputCloud( cloud, indices_ptr );
-            }
-            else
-                tree->setInputCloud( cloud );
-
             MyPointT            searchPoint;
             std::vector<float>  sqr_dists;
             PidT                found_points_count = 0;
@@ -556,15 +562,15 @@ namespace rapter {
 
                 // calculate neighbourhood indices
                 if ( doRadiusSearch )
-                    found_points_count = tree->radiusSearch  ( searchPoint, radius, neighbour_indices[pid], sqr_dists, /* all: */ 0 );
+                    found_points_count = tree.radiusSearch  ( searchPoint, radius, neighbour_indices[pid], sqr_dists, /* all: */ 0 );
                 else
-                    found_points_count = tree->nearestKSearch( searchPoint,      K, neighbour_indices[pid], sqr_dists    );
+                    found_points_count = tree.nearestKSearch( searchPoint,      K, neighbour_indices[pid], sqr_dists    );
 
                 if ( found_points_count > 1000 )
                     std::cerr << "[" << __func__ << "]: " << "[WARNING] Found too many neighbours(" << found_points_count << "), decrease scale!" << std::endl;
 
                 if ( (found_points_count <2 ) && (soft_radius) )
-                    found_points_count = tree->nearestKSearch( searchPoint,      3, neighbour_indices[pid], sqr_dists    );
+                    found_points_count = tree.nearestKSearch( searchPoint,      3, neighbour_indices[pid], sqr_dists    );
 
                 // output distances
                 if ( found_points_count > 0 )
@@ -586,7 +592,42 @@ namespace rapter {
             }
 
             return EXIT_SUCCESS;
-        }
+        } //...getNeighbourhoodIndices()
+
+        /*!
+         * @brief                           Get's a list of neighbours for each point in pointcloud/indices_arg, indices untested
+         * @param[out] neighbour_indices    List of list of neighbour indices. One list for each point in cloud.
+         * @param[in ] cloud                3D point cloud.
+         * @param[in ] indices_arg          Optional, if given, selects point from cloud (untested).
+         * @param[out] p_distances          Optional, neighbourhood squared distances arranged as neighbour_indices.
+         * @param[in ] K                    Maximum number of neighbours
+         * @param[in ] radius               Optional, maximum radius to look for K neighbours in
+         * @param[in ] soft_radius          Return K neighbours even if some outside radius
+         */
+        template <typename MyPointT>
+        inline int
+        getNeighbourhoodIndices( std::vector<std::vector<int> >                            & neighbour_indices
+                                , boost::shared_ptr<pcl::PointCloud<MyPointT> >              cloud
+                                , std::vector<int>                                    const* indices_arg        = NULL
+                                , std::vector<std::vector<float> >                         * p_distances        = NULL
+                                , int                                                        K                  = 15
+                                , float                                                      radius             = -1.f
+                                , bool                                                       soft_radius        = false
+                                )
+        {
+            // create KdTree
+            typename pcl::search::KdTree<MyPointT>::Ptr tree( new pcl::search::KdTree<MyPointT> );
+            if ( indices_arg )
+            {
+                pcl::IndicesPtr indices_ptr( new std::vector<int>() );
+                *indices_ptr = *indices_arg; // copy indices
+                tree->setInputCloud( cloud, indices_ptr );
+            }
+            else
+                tree->setInputCloud( cloud );
+
+            return getNeighbourhoodIndices( neighbour_indices, *tree, cloud, indices_arg, p_distances, K, radius, soft_radius );
+        } //...getNeighbourhoodIndices()
 
         /*! \brief Columnwise min for vectors. The Eigen implementation, that PCL calls successfully did not seem to work. Possibly an alignment issue.
          *  \tparam        Scalar Floating point precision. Concept: float.
@@ -691,7 +732,10 @@ namespace rapter {
             }; // > means biggest first
         }
 
-        template <class _IndicesContainerT, typename Scalar, class _PointContainerT> inline int
+        /*! \brief Sorted (decreasing) eigen decomposition of the covariance matrix of an [indexed] pointcloud.
+         *         Centroid, covariance and the eigen solve are computed in \p _AccumScalar, outputs are cast to \p Scalar.
+         */
+        template <class _IndicesContainerT, typename Scalar, class _PointContainerT, typename _AccumScalar = __AccumScalar> inline int
         eigenDecomposition( Eigen::Matrix<Scalar,3,1> & eigen_values
                           , Eigen::Matrix<Scalar,3,3> & eigen_vectors
                           , _PointContainerT     const& points
@@ -700,28 +744,28 @@ namespace rapter {
                           , Eigen::Matrix<Scalar,3,3> * out_covariance_arg  = NULL )
         {
 
-            Eigen::Matrix<Scalar,3,1> centroid = processing::getCentroid<Scalar>( points, indices );
-            Eigen::Matrix<Scalar,3,3> covariance;
+            Eigen::Matrix<_AccumScalar,3,1> centroid = processing::getCentroid<_AccumScalar, _IndicesContainerT, _PointContainerT, _AccumScalar>( points, indices );
+            Eigen::Matrix<_AccumScalar,3,3> covariance;
             processing::computeCovarianceMatrix< /* _WeightsContainerT */ std::vector<int>, _IndicesContainerT >( covariance, points, centroid, /* indices: */ indices, /* weights: */ NULL );
 
             // eigen decomposition
-            Eigen::SelfAdjointEigenSolver<Eigen::Matrix<Scalar,3,3> > eigen_solver( covariance, Eigen::ComputeEigenvectors );
+            Eigen::SelfAdjointEigenSolver<Eigen::Matrix<_AccumScalar,3,3> > eigen_solver( covariance, Eigen::ComputeEigenvectors );
 
             // sort in decreasing order
             {
-                typedef std::pair< Scalar, int > EigValEigVecIdT; //first: eigen value, second: id of eigen vector
+                typedef std::pair< _AccumScalar, int > EigValEigVecIdT; //first: eigen value, second: id of eigen vector
                 std::vector<EigValEigVecIdT> sorted( 3 );
                 sorted[0] = EigValEigVecIdT( eigen_solver.eigenvalues()(0), 0 );
                 sorted[1] = EigValEigVecIdT( eigen_solver.eigenvalues()(1), 1 );
                 sorted[2] = EigValEigVecIdT( eigen_solver.eigenvalues()(2), 2 );
                 std::sort( sorted.begin(), sorted.end(), pca::AbsDecrSortFunctor<EigValEigVecIdT>() );
 
-                eigen_values     (0) = sorted[0].first;
-                eigen_values     (1) = sorted[1].first;
-                eigen_values     (2) = sorted[2].first;
-                eigen_vectors.col(0) = eigen_solver.eigenvectors().col( sorted[0].second );
-                eigen_vectors.col(1) = eigen_solver.eigenvectors().col( sorted[1].second );
-                eigen_vectors.col(2) = eigen_solver.eigenvectors().col( sorted[2].second );
+                eigen_values     (0) = Scalar( sorted[0].first );
+                eigen_values     (1) = Scalar( sorted[1].first );
+                eigen_values     (2) = Scalar( sorted[2].first );
+                eigen_vectors.col(0) = eigen_solver.eigenvectors().col( sorted[0].second ).template cast<Scalar>();
+                eigen_vectors.col(1) = eigen_solver.eigenvectors().col( sorted[1].second ).template cast<Scalar>();
+                eigen_vectors.col(2) = eigen_solver.eigenvectors().col( sorted[2].second ).template cast<Scalar>();
             }
 
             if (    (std::abs(eigen_values(1)) > std::abs(eigen_values(0)) )
@@ -730,9 +774,9 @@ namespace rapter {
                 throw new std::runtime_error("eigen values not sorted decreasingly...");
 
             if ( out_centroid_arg )
-                *out_centroid_arg = centroid; // TODO: don't copy
+                *out_centroid_arg = centroid.template cast<Scalar>(); // TODO: don't copy
             if ( out_covariance_arg )
-                *out_covariance_arg = covariance; // TODO: don't copy
+                *out_covariance_arg = covariance.template cast<Scalar>(); // TODO: don't copy
 
             return EXIT_SUCCESS;
         }
@@ -743,24 +787,25 @@ namespace rapter {
          *  \tparam _PointContainerT    Concept: std::vector< \ref rapter::PointPrimitive >.
          *  \param[out] frame           Output 4x4 matrix, where the first 3 columns are the three axis of the local frame, and the 4th column is the centroid.
          *  \param[in]  points          Input pointcloud to perform PCA on.
+         *  \tparam _AccumScalar        Precision of the centroid, covariance and eigen solve. The points can be stored in lower precision. Concept: double.
          *  \param[in]  indices         Optional indices input to address points in the pointcloud.
          */
-        template <class _IndicesContainerT, typename Scalar, class _PointContainerT> inline int
+        template <class _IndicesContainerT, typename Scalar, class _PointContainerT, typename _AccumScalar = __AccumScalar> inline int
         PCA( Eigen::Matrix<Scalar,4,4> & frame,
              _PointContainerT     const& points,
              _IndicesContainerT        * indices = NULL )
 
         {
-            Eigen::Matrix<Scalar,3,1> centroid = processing::getCentroid<Scalar>( points, indices );
-            Eigen::Matrix<Scalar,3,3> covariance;
+            Eigen::Matrix<_AccumScalar,3,1> centroid = processing::getCentroid<_AccumScalar, _IndicesContainerT, _PointContainerT, _AccumScalar>( points, indices );
+            Eigen::Matrix<_AccumScalar,3,3> covariance;
             processing::computeCovarianceMatrix< /* _WeightsContainerT */ std::vector<int>, _IndicesContainerT >( covariance, points, centroid, /* indices: */ indices, /* weights: */ NULL );
 
             // eigen decomposition
-            Eigen::SelfAdjointEigenSolver<Eigen::Matrix<Scalar,3,3> > eigen_solver( covariance, Eigen::ComputeEigenvectors );
+            Eigen::SelfAdjointEigenSolver<Eigen::Matrix<_AccumScalar,3,3> > eigen_solver( covariance, Eigen::ComputeEigenvectors );
             // sort decreasing
-            Eigen::Matrix<Scalar,3,3> eigen_vectors = eigen_solver.eigenvectors();
+            Eigen::Matrix<_AccumScalar,3,3> eigen_vectors = eigen_solver.eigenvectors();
 
-            typedef std::pair<Scalar,Eigen::Matrix<Scalar,3,1> > PairT;
+            typedef std::pair<_AccumScalar,Eigen::Matrix<_AccumScalar,3,1> > PairT;
 
             std::vector<PairT> sorted( 3 );
             sorted[0] = PairT( eigen_solver.eigenvalues()(0), eigen_vectors.col(0) );
@@ -781,10 +826,10 @@ namespace rapter {
             }
 
             frame = Eigen::Matrix<Scalar,4,4>::Identity();
-            frame.template block<3,1>(0,0) = sorted[0].second; // biggest first
-            frame.template block<3,1>(0,1) = sorted[1].second;
-            frame.template block<3,1>(0,2) = sorted[2].second;
-            frame.template block<3,1>(0,3) = centroid.template head<3>();
+            frame.template block<3,1>(0,0) = sorted[0].second.template cast<Scalar>(); // biggest first
+            frame.template block<3,1>(0,1) = sorted[1].second.template cast<Scalar>();
+            frame.template block<3,1>(0,2) = sorted[2].second.template cast<Scalar>();
+            frame.template block<3,1>(0,3) = centroid.template head<3>().template cast<Scalar>();
 
             return EXIT_SUCCESS;
         }
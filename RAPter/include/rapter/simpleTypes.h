@@ -20,6 +20,7 @@ namespace rapter
     typedef std::pair<DidT,int>     DidAid; // <DirectionId, AngleId>
 
     typedef float __Scalar; // watch out, this is usually read from PointPrimitiveT::Scalar elsewhere
+    typedef double __AccumScalar; // sums over many points (centroids, covariances, data costs) are accumulated in this precision, storage stays __Scalar
 
     const double halfDeg = 0.00872664626; // half degree in radians, used to check generator equality
 
@@ -15,6 +15,7 @@ namespace rapter
     typedef rapter::PointPrimitive PointPrimitiveT;
     //typedef typename PointPrimitiveT::Scalar Scalar;
     typedef __Scalar Scalar;
+    typedef __AccumScalar AccumScalar; //!< \brief Accumulation precision of point-heavy loops, see \ref processing::PCA().
     //typedef PrimitiveVectorT< PointPrimitiveT > PointContainerT;
     typedef PointPrimitiveVector PointContainerT;
 
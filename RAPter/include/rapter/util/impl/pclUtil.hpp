@@ -8,6 +8,7 @@
 #include "pcl/point_cloud.h"
 #include "pcl/search/kdtree.h"
 #include <numeric>
+#include "rapter/processing/util.hpp" // weightedMoments(), symmetricEigenDirect()
 
 namespace rapter {
     namespace pclutil {
@@ -221,6 +222,7 @@ namespace smartgeometry {
          * @param p_indices             Indices to use from cloud. Can be NULL, in which case the whole cloud is used.
          * @param refit                 How many refit iterations. 0 means once, obviously (TODO to fix...).
          * @param start_from_input_line Assume, that \param line contains a meaningful input, and calculate weights on the 0th iteration already.
+         * @param dir_tolerance         Stop refitting early, when \f$ 1 - |cos| \f$ of the angle between consecutive directions (normals) falls below.
          */
         template <class PointsT, typename Scalar = float, int rows = 6, class _DerivedT = Eigen::Matrix<Scalar,4,1> > inline int
         fitLinearPrimitive( _DerivedT    & primitive // Eigen::Matrix<Scalar,rows,1>
@@ -231,7 +233,8 @@ namespace smartgeometry {
                             , bool                            start_from_input      = false
                             , Scalar                       (*pointPrimitiveDistanceFunc)(Eigen::Matrix<Scalar,3,1> const& pnt, Eigen::Matrix<Scalar,rows,1> const& primitive) = &(pointPrimitiveDistance<Scalar,rows>)
                             , Eigen::Matrix<Scalar,rows,1> (*    fromPointAndNormalFunc)(Eigen::Matrix<Scalar,3,1> const& pnt, Eigen::Matrix<Scalar,3   ,1> const& normal   ) = &(fromPointAndNormal<Scalar,rows>)
-                            , bool                            debug                 = false )
+                            , bool                            debug                 = false
+                            , Scalar                          dir_tolerance         = Scalar(1e-6) )
         {
             eigen_assert( (rows == 4) || (rows == 6) );
 
@@ -241,71 +244,52 @@ namespace smartgeometry {
             // skip, if not enought points found to fit to
             if ( N < 2 ) { std::cerr << "[" << __func__ << "]: " << "can't fit line to less then 2 points..." << std::endl; return EXIT_FAILURE; }
 
+            typedef Eigen::Matrix<Scalar,3,1>                    Position;
+            typedef Eigen::Matrix<rapter::__AccumScalar,3,1>     AccumPosition;
+            typedef Eigen::Matrix<rapter::__AccumScalar,3,3>     AccumMatrix;
+
             int iteration = 0; // track refit iterations
             do
             {
-                // LeastSquares weights
-                std::vector<Scalar> weights( N, 1.f );
-
-                // calculate weights, if value in "line" already meaningful
-                if ( start_from_input || (iteration > 0) )
-                {
-                    // calculate distance from all points
-                    for ( size_t point_id = 0; point_id != N; ++point_id )
-                    {
-                        // formula borrowed from PCL: (line_pt - point).cross3(line_dir).squaredNorm();
-                        Eigen::Matrix<Scalar,3,1> pnt = cloud[ p_indices ? (*p_indices)[point_id] : point_id ].getVector3fMap();
-                        weights[point_id] = pointPrimitiveDistanceFunc( pnt, primitive );
-                    }
-
-                    // the farther away, the smaller weight -->
-                    // w_i = f( dist_i / scale ), dist_i < scale; f(x) = (x^2-1)^2
-                    for ( size_t wi = 0; wi != weights.size(); ++wi )
-                    {
-                        if ( weights[wi] < scale )
-                        {
-                            weights[wi] /= scale;                                               // x = dist_i / scale
-                            weights[wi] = (weights[wi] * weights[wi] - static_cast<Scalar>(1)); // x^2-1
-                            weights[wi] *= weights[wi];                                         // (x^2-1)^2
-                        }
-                        else
-                            weights[wi] = static_cast<Scalar>(0);                               // outside scale, truncated to 0
-                    }
-                }
-
-                // compute centroid of cloud or selected points
-                Eigen::Matrix<Scalar,4,1> centroid;
-                smartgeometry::computeCentroid( centroid, cloud, p_indices );
-
-                // compute neighbourhood covariance matrix
-                Eigen::Matrix<Scalar,3,3> cov;
-                smartgeometry::computeCovarianceMatrix( cov, cloud, p_indices, &centroid, &weights ); // weights might be all 1-s
-
-                // solve for neighbourhood biggest eigen value
-                Eigen::SelfAdjointEigenSolver< Eigen::Matrix<Scalar, 3, 3> > es;
-                es.compute( cov );
-
-                if ( rows == 6 ) // line -> dir ==
+                // calculate weights, if value in "line" already meaningful, otherwise LeastSquares
+                const bool    robust = start_from_input || (iteration > 0);
+                AccumPosition centroid( AccumPosition::Zero() );
+                AccumMatrix   cov     ( AccumMatrix::Zero() );
+                const rapter::__AccumScalar sumW = rapter::processing::weightedMoments( centroid, cov, N
+                                                          , [&]( size_t point_id ) -> Position { return cloud[ p_indices ? (*p_indices)[point_id] : point_id ].getVector3fMap(); }
+                                                          , [&]( Position const& pnt ) { return robust ? rapter::processing::biweight( pointPrimitiveDistanceFunc(pnt, primitive), scale ) : Scalar(1.); } );
+
+                // all points outside scale, keep the previous fit
+                if ( !(sumW > rapter::__AccumScalar(0.)) )
+                    break;
+
+                // closed-form eigen solve, eigen values increasing
+                AccumPosition eigen_values;
+                AccumMatrix   eigen_vectors;
+                rapter::processing::symmetricEigenDirect( eigen_values, eigen_vectors, cov );
+
+                // line: direction, plane: normal
+                Position prevNormal( Position::Zero() );
+                if ( robust )
+                    prevNormal = (rows == 6) ? Position( primitive.template segment<3>(3) ) : Position( primitive.template head<3>() );
+
+                if ( rows == 6 ) // line -> dir == eigen vector of biggest eigen value
                 {
-                    // get eigen vector for biggest eigen value
-                    const int max_eig_val_id = std::distance( es.eigenvalues().data(), std::max_element( es.eigenvalues().data(), es.eigenvalues().data()+3 ) );
-
-                    // output line
-                    primitive = fromPointAndNormalFunc( centroid.template head<3>(),
-                                                        es.eigenvectors().col(max_eig_val_id).normalized() );
+                    primitive = fromPointAndNormalFunc( centroid.template cast<Scalar>(),
+                                                        eigen_vectors.col(2).template cast<Scalar>().normalized() );
                 }
-                else if ( rows == 4 ) // plane
+                else if ( rows == 4 ) // plane -> normal == eigen vector of smallest eigen value
                 {
-                    // get eigen vector for biggest eigen value
-                    const int min_eig_val_id = std::distance( es.eigenvalues().data(), std::min_element( es.eigenvalues().data(), es.eigenvalues().data()+3 ) );
-
-                    // output line
-                    primitive = fromPointAndNormalFunc( centroid.template head<3>(),
-                                                        es.eigenvectors().col(min_eig_val_id).normalized() );
+                    primitive = fromPointAndNormalFunc( centroid.template cast<Scalar>(),
+                                                        eigen_vectors.col(0).template cast<Scalar>().normalized() );
                 }
                 else
                     std::cerr << "[" << __func__ << "]: " << "lines(rows==6) or planes(rows==4), not rows == " << rows << std::endl;
 
+                // converged
+                const Position normal = (rows == 6) ? Position( primitive.template segment<3>(3) ) : Position( primitive.template head<3>() );
+                if ( robust && (Scalar(1.) - std::abs(prevNormal.dot(normal)) < dir_tolerance) )
+                    break;
             }
             while ( iteration++ < refit );
 
@@ -51,6 +51,12 @@ namespace console
         return (index - 1);
     }
 
+    template <typename T>
+    inline int parse_x_arguments (int argc, char** argv, const char* str, std::vector<T>& v)
+    {
+        return pcl::console::parse_x_arguments( argc, argv, str, v );
+    }
+
     inline int parse_x_arguments (int argc, char** argv, const char* str, std::vector<long>& v)
     {
       for (int i = 1; i < argc; ++i)
@@ -12,6 +12,9 @@ namespace rapter
     class SchnabelEnv
     {
         public:
+            //! \brief Normals and detector index of a cloud, shared by runs with different epsilons or minimum supports. Defined in schnabelEnv.cpp.
+            struct Cache;
+
             template <class PclCloudT, typename PrimitiveT, /*class PidGidT, */class PointContainerT >
             static inline int
             run( std::vector<PrimitiveT>    & planes
@@ -24,6 +27,10 @@ namespace rapter
                  , int show = 1
                  , bool extrude2D = false
                  , int pointMultiplier = 50
+                 , float epsilon = 0.f        //!< <= 0: detector default
+                 , float bitmapEpsilon = 0.f  //!< <= 0: detector default
+                 , size_t seed = 0            //!< 0: seeded by the time
+                 , Cache *cache = NULL
                  );
     };
 
@@ -0,0 +1,172 @@
+#!/usr/bin/python
+
+# Runs the RAPter pipeline (rapter.py) on many scenes at once, sharing the machine's cores and memory between them.
+#
+# Manifest: one scene per line, "<scene folder> [rapter.py options]", '#' starts a comment, e.g.
+#     scenes/room01  -s 0.01 --al 15 --pw 1
+#     scenes/room02  -s 0.02 --cloud cloud_sub.ply
+# Relative folders are relative to the manifest. Each scene runs in its folder, its output goes to <folder>/batch.log.
+#
+# Scheduling: scenes are started largest first (by point count, read from the ply header), and each gets
+# a share of the thread pool proportional to its size (OMP_NUM_THREADS). Threads and memory of a finished scene
+# go back to the pool, and are picked up by the next waiting scene, so small scenes fill the gaps left by large ones.
+# A scene only starts, if its predicted memory fits into what's left of the budget. The prediction is only used for
+# admission: address space (thread stacks, malloc arenas, Ipopt's workspace) is much larger than resident memory,
+# so limiting a scene to its prediction would make it fail with bad_alloc. --mem-cap <factor> limits each scene's
+# address space to factor x its prediction, to keep one runaway scene from taking down the batch. It's off by default.
+#
+# Threads: OMP_NUM_THREADS only reaches the loops, that don't fix their own thread count. The loops pinned with
+# num_threads(RAPTER_MAX_OMP_THREADS) (== 1, simpleTypes.h) run single threaded whatever the share is:
+# the point neighbourhoods and the spatial terms in problemSetup.hpp, region growing and orphan assignment in segmentation.hpp.
+
+from __future__ import print_function
+import argparse
+import os
+import sys          # exit
+import math         # ceil
+import time         # sleep, time
+import shlex        # split
+import resource     # setrlimit
+import subprocess   # Popen
+import multiprocessing # cpu_count
+
+class Scene:
+    def __init__( self, folder, options, args ):
+        self.folder  = folder
+        self.options = options
+        self.cloud   = "cloud.ply"
+        for i in range( len(options) - 1 ):
+            if options[i] in ("--cl", "--cloud"):
+                self.cloud = options[i+1]
+        self.points  = countPoints( os.path.join(folder, self.cloud) )
+        self.threads = int( max(1, min(args.threads, math.ceil(self.points / float(args.pointsPerThread)))) )
+        self.memory  = args.baseMem + self.points * args.bytesPerPoint
+        self.proc    = None
+        self.ret     = None
+        self.start   = 0.
+        self.end     = 0.
+
+def countPoints( cloudPath ):
+    """ Vertex count from the ply header, file size / 32 bytes, if it's not a ply. """
+    if not os.path.isfile(cloudPath):
+        return 0
+    with open( cloudPath, "rb" ) as f:
+        for line in f:
+            line = line.decode("ascii", "ignore").strip()
+            if line.startswith("element vertex"):
+                return int( line.split()[2] )
+            if line == "end_header" or len(line) > 256:
+                break
+    return os.path.getsize(cloudPath) // 32
+
+def readManifest( path, args ):
+    scenes = []
+    root   = os.path.dirname( os.path.abspath(path) )
+    with open( path ) as f:
+        for line in f:
+            tokens = shlex.split( line, comments=True )
+            if not tokens:
+                continue
+            folder = tokens[0] if os.path.isabs(tokens[0]) else os.path.join( root, tokens[0] )
+            if not os.path.isdir(folder):
+                print( "[readManifest]: skipping %s, not a folder" % folder )
+                continue
+            scenes.append( Scene(folder, tokens[1:], args) )
+    return scenes
+
+def memTotal():
+    """ Physical memory in bytes. """
+    return os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES")
+
+def launch( scene, threads, memLimit, args ):
+    env = dict( os.environ )
+    env["OMP_NUM_THREADS" ] = str( threads )
+    env["OMP_WAIT_POLICY" ] = "PASSIVE"  # idle OpenMP threads sleep instead of spinning on cores other scenes use
+    env["RAPTER_EXEC"     ] = args.rapterExec
+    cmd = [ sys.executable, args.pipeline, "--no-vis" ] + scene.options
+    print( "[launch]: %s (%d points, %d threads, %.1f GB predicted%s): %s" \
+           % (scene.folder, scene.points, threads, scene.memory / 1e9, \
+              (", %.1f GB cap" % (memLimit / 1e9)) if memLimit > 0 else "", " ".join(cmd)) )
+    if args.dry:
+        scene.ret = 0
+        return
+
+    def limitMemory():
+        if memLimit > 0:
+            resource.setrlimit( resource.RLIMIT_AS, (memLimit, memLimit) )
+
+    scene.start = time.time()
+    try:
+        log = open( os.path.join(scene.folder, "batch.log"), "w" )
+        try:
+            scene.proc = subprocess.Popen( cmd, cwd=scene.folder, env=env, stdout=log, stderr=subprocess.STDOUT, preexec_fn=limitMemory )
+        finally:
+            log.close()
+    except (OSError, IOError) as e:
+        # unwritable folder, or bad --pipeline: this scene failed, the others go on
+        print( "[launch]: could not start %s: %s" % (scene.folder, e) )
+        scene.proc = None
+        scene.ret  = -1
+        scene.end  = time.time()
+
+parser = argparse.ArgumentParser()
+parser.add_argument( "manifest", type=str, help="Scene list, one \"<folder> [rapter.py options]\" per line" )
+parser.add_argument( "-j", "--threads"     , dest="threads"        , type=int  , default=multiprocessing.cpu_count(), help="Size of the shared thread pool [cpu count]" )
+parser.add_argument( "--mem"               , dest="mem"            , type=float, default=memTotal() * 0.8 / 1e9, help="Memory budget of the whole batch in GB [80%% of RAM]" )
+parser.add_argument( "--points-per-thread" , dest="pointsPerThread", type=int  , default=50000, help="A scene gets one thread per this many points [50000]" )
+parser.add_argument( "--bytes-per-point"   , dest="bytesPerPoint"  , type=float, default=4000., help="Predicted memory per point in bytes [4000]" )
+parser.add_argument( "--base-mem"          , dest="baseMem"        , type=float, default=1.5e9, help="Predicted memory per scene on top of its points in bytes [1.5e9]" )
+parser.add_argument( "--mem-cap"           , dest="memCap"         , type=float, default=0.   , help="Limit the address space of a scene to this times its prediction, 0: no limit [0]" )
+parser.add_argument( "--pipeline"          , dest="pipeline"       , type=str  , default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "rapter.py"), help="Per scene driver [rapter.py next to this script]" )
+parser.add_argument( "--exec"              , dest="rapterExec"     , type=str  , default=os.environ.get("RAPTER_EXEC", ""), help="rapter executable, exported as RAPTER_EXEC to the driver" )
+parser.add_argument( "--dry", action="store_true", help="Show the schedule, but don't run." )
+args = parser.parse_args()
+
+scenes = readManifest( args.manifest, args )
+if not scenes:
+    print( "[batch]: no scenes in %s" % args.manifest )
+    sys.exit(1)
+
+# largest first: the long scenes start early, the short ones fill in around them
+waiting  = sorted( scenes, key=lambda s: s.points, reverse=True )
+running  = []
+freeThr  = args.threads
+freeMem  = args.mem * 1e9
+batchStart = time.time()
+while waiting or running:
+    # start every waiting scene that fits, in order, once the pool has threads left
+    started = True
+    while started and waiting and freeThr > 0:
+        started = False
+        for scene in waiting:
+            # a scene bigger than the budget runs alone
+            if scene.memory <= freeMem or not running:
+                threads = min( scene.threads, freeThr )
+                launch( scene, threads, int(scene.memory * args.memCap), args )
+                waiting.remove( scene )
+                # a scene that could not start keeps none of the pool
+                if scene.proc:
+                    scene.threads = threads
+                    freeThr -= threads
+                    freeMem -= scene.memory
+                    running.append( scene )
+                started = True
+                break
+
+    # return the resources of finished scenes to the pool
+    for scene in list(running):
+        scene.ret = scene.proc.poll()
+        if scene.ret is not None:
+            scene.end = time.time()
+            freeThr += scene.threads
+            freeMem += scene.memory
+            running.remove( scene )
+            print( "[batch]: %s finished with %d after %.1f s" % (scene.folder, scene.ret, scene.end - scene.start) )
+    if running:
+        time.sleep( 0.5 )
+
+failed = [ s for s in scenes if s.ret != 0 ]
+print( "[batch]: %d scenes in %.1f s, %d failed" % (len(scenes), time.time() - batchStart, len(failed)) )
+for scene in failed:
+    print( "\t%s, see %s" % (scene.folder, os.path.join(scene.folder, "batch.log")) )
+sys.exit( 1 if failed else 0 )
@@ -9,7 +9,7 @@ import subprocess   # Popen
 
 
 rapterRoot = "/home/bontius/workspace/RAPter/";
-rapterExec = os.path.join( rapterRoot, "RAPter", "build", "Release", "bin", "rapter" );
+rapterExec = os.environ.get( "RAPTER_EXEC" ) or os.path.join( rapterRoot, "RAPter", "build", "Release", "bin", "rapter" ); # batch.py sets RAPTER_EXEC
 
 def show( primitivesPath, associationsPath, title, args ):
     cmd = os.path.join("..","rapterVis --show%s --scale %f --pop-limit %d -p %s -a %s --cloud %s --title %s --angle-gens %s --use-tags --no-clusters --statuses -1,1 --no-pop --dir-colours --no-rel --no-scale --bg-colour 1.,1.,1. --no-rel" \
@@ -26,11 +26,12 @@ def call( cmd, dry = True, noExit = False ):
     else:
         print "RUN"
     if not dry:
-        ret = os.system(cmd) >> 8 # python thing
+        status = os.system(cmd)
+        ret    = (status >> 8) if not (status & 0x7f) else 128 + (status & 0x7f) # exit code, or 128 + signal, like the shell
         if ret != 0:
             if not noExit:
                 print("call returned error ", ret, ", aborting")
-                sys.exit()
+                sys.exit(ret)
         return ret
 
 def runRepr( rprPrims, rprAssoc, rprIter, args, angleGens, keepSingles ):
@@ -168,7 +169,7 @@ optionalGroup.add_argument( "-l"  , "--lines"      , dest="lines"        , actio
 
 runOptGroup = parser.add_argument_group('run options');
 runOptGroup.add_argument( "--dry", action="store_true"                 , help="Show the calls, but don't run." )
-runOptGroup.add_argument( "--no-vis", dest="noVis", action="store_false", default = False, help="Disable visualization (enabled by default)" )
+runOptGroup.add_argument( "--no-vis", dest="noVis", action="store_true", default = False, help="Disable visualization (enabled by default)" )
 
 optionalGroup.add_argument( "--pl", "--popLimit"   , dest="popLimit"     , type=int  , default=5   , help="Filters primitives having less than this many points assigned [3..100]")
 optionalGroup.add_argument( "--sp", "--spatial"    , dest="spatial"      , type=float,               help="Weight of spatial term [0.1, pw/10., pw/5., pw/2.]" )
@@ -1,4 +1,5 @@
 #include  <vector>
+#include  <fstream>
 
 #include "rapter/typedefs.h"
 #include "rapter/util/parse.h"    // console::parse_argument
@@ -363,15 +364,22 @@ inline int schnabelCli( int argc, char** argv )
     typename _PclCloudT::Ptr pcl_cloud;
     _PrimitiveContainerT     initial_primitives;
     PrimitiveMapT            patches;
-    int                      min_support_arg = 300;
+    std::vector<int>         minSupports;
+    std::vector<float>       epsilons( 1, 0.f ), bitmapEpsilons( 1, 0.f );
     int pointMultiplier = 50;
+    int seed            = 0;
+    std::string indexCachePath;
     rapter::console::parse_argument( argc, argv, "--point-mult", pointMultiplier);
+    rapter::console::parse_argument( argc, argv, "--seed", seed );
+    rapter::console::parse_argument( argc, argv, "--index-cache", indexCachePath );
+    bool sweepEps = rapter::console::parse_x_arguments( argc, argv, "--eps", epsilons ) >= 0;
+    sweepEps     |= rapter::console::parse_x_arguments( argc, argv, "--bitmap-eps", bitmapEpsilons ) >= 0;
 
     // parse
     {
         bool valid_input = !rapter::parseInput<_InnerPrimitiveContainerT,_PclCloudT>( points, pcl_cloud, initial_primitives, patches, params, argc, argv );
 
-        if ( (rapter::console::parse_argument( argc, argv, "--minsup", min_support_arg) < 0) )
+        if ( (rapter::console::parse_x_arguments( argc, argv, "--minsup", minSupports) < 0) || minSupports.empty() )
         {
             std::cerr << "[" << __func__ << "]: " << "--minsup required (300?)" << std::endl;
             valid_input = false;
@@ -386,7 +394,11 @@ inline int schnabelCli( int argc, char** argv )
                       << "\t -p,--prims " << /*input_prims_path <<*/ "\n"
                       << "\t -a,--assoc " << /*associations_path <<*/ "\n"
                       << "\t -sc,--scale " << params.scale << "\n"
-                      << "\t --minsup " << min_support_arg << "\n"
+                      << "\t --minsup 300[,500,...]\n"
+                      << "\t [--eps e0[,e1,...]]\t Schnabel epsilon, all combinations with --bitmap-eps and --minsup are run\n"
+                      << "\t [--bitmap-eps b0[,b1,...]]\t Schnabel bitmap epsilon\n"
+                      << "\t [--seed " << seed << "]\t Fixes the random draws, 0: seeded by the time\n"
+                      << "\t [--index-cache path]\t Loads and saves the detector's subsets and samples, only used with a seed\n"
                       << "\t --point-mult " << pointMultiplier << "]\t extrude2D add this many points for each input point\n"
                       << "\t Example: ../ransac --schnabel3D --scale 0.03 --cloud cloud.ply -p patches.csv -a points_primitives.csv"
                       << "\n";
@@ -419,89 +431,124 @@ inline int schnabelCli( int argc, char** argv )
         vptr->spinOnce(100);
     }
 
-    typedef std::map<rapter::PidT, rapter::GidT> PidGidT;
-     std::vector<rapter::PlanePrimitive> planes;
-     PidGidT                          pidGid;
-
-     err = rapter::SchnabelEnv::run<pcl::PointCloud<PclPointT> >( planes
-                               //, pidGid
-                               , outPoints
-                               , points
-                               , pcl_cloud
-                               , params.scale
-                               , min_support_arg
-                               , false
-                               , extrude2D
-                               , pointMultiplier
-                               );
-    if ( err != EXIT_SUCCESS )
-        std::cerr << "[" << __func__ << "]: " << "schnabel failed with " << err << std::endl;
-    PrimitiveMapT out_prims;
-    for ( size_t gid = 0; gid != planes.size(); ++gid )
+    // the normals, the subsets and the candidate samples don't depend on the settings, and are shared by the runs
+    rapter::SchnabelEnv::Cache cache;
+    if ( seed )
     {
-        rapter::containers::add( out_prims, gid, planes[gid] )
-                .setTag( PrimitiveT::TAGS::GID    , gid )
-                .setTag( PrimitiveT::TAGS::DIR_GID, gid );
-        std::cout << "added " << out_prims[gid].back().toString() << std::endl;
+        srand( seed ); // extrude2D
+        std::ifstream f( indexCachePath.c_str(), std::ios::binary );
+        if ( f.is_open() && cache.index.Load(f) )
+            std::cout << "[" << __func__ << "]: " << "read " << cache.index.PoolSize() << " samples from " << indexCachePath << std::endl;
+    }
 
-        if ( extrude2D )
+    const size_t runCount = minSupports.size() * epsilons.size() * bitmapEpsilons.size();
+    for ( size_t runId = 0; runId != runCount; ++runId )
+    {
+        const int   min_support_arg = minSupports   [ runId / (epsilons.size() * bitmapEpsilons.size()) ];
+        const float epsilon         = epsilons      [ (runId / bitmapEpsilons.size()) % epsilons.size() ];
+        const float bitmapEpsilon   = bitmapEpsilons[ runId % bitmapEpsilons.size() ];
+        outPoints.clear();
+
+        typedef std::map<rapter::PidT, rapter::GidT> PidGidT;
+         std::vector<rapter::PlanePrimitive> planes;
+         PidGidT                          pidGid;
+
+         err = rapter::SchnabelEnv::run<pcl::PointCloud<PclPointT> >( planes
+                                   //, pidGid
+                                   , outPoints
+                                   , points
+                                   , pcl_cloud
+                                   , params.scale
+                                   , min_support_arg
+                                   , false
+                                   , extrude2D
+                                   , pointMultiplier
+                                   , epsilon
+                                   , bitmapEpsilon
+                                   , seed
+                                   , &cache
+                                   );
+        if ( err != EXIT_SUCCESS )
+            std::cerr << "[" << __func__ << "]: " << "schnabel failed with " << err << std::endl;
+        PrimitiveMapT out_prims;
+        for ( size_t gid = 0; gid != planes.size(); ++gid )
         {
+            rapter::containers::add( out_prims, gid, planes[gid] )
+                    .setTag( PrimitiveT::TAGS::GID    , gid )
+                    .setTag( PrimitiveT::TAGS::DIR_GID, gid );
+            std::cout << "added " << out_prims[gid].back().toString() << std::endl;
 
+            if ( extrude2D )
+            {
+
+            }
         }
-    }
 
 
 
-//    for ( PidGidT::const_iterator it = pidGid.begin(); it != pidGid.end(); ++it )
-//    {
-//        points.at( it->first ).setTag( PointPrimitiveT::TAGS::GID, it->second );
-//    }
+    //    for ( PidGidT::const_iterator it = pidGid.begin(); it != pidGid.end(); ++it )
+    //    {
+    //        points.at( it->first ).setTag( PointPrimitiveT::TAGS::GID, it->second );
+    //    }
 #if 0
-    reassign( points, planes, params.scale );
+        reassign( points, planes, params.scale );
 
-    // debug assignments
-    pcl::PointXYZ pnt, plane_pnt;
-    for ( int pid = 0; pid != static_cast<int>(points.size()); ++pid )
-    {
-        if ( !(pid % 1000) )
+        // debug assignments
+        pcl::PointXYZ pnt, plane_pnt;
+        for ( int pid = 0; pid != static_cast<int>(points.size()); ++pid )
         {
-            char name[255];
-            sprintf( name, "pointarrow%06d", pid );
-            pnt.getVector3fMap() = points[pid].pos();
-            const int gid = points[pid].getTag( PointPrimitiveT::TAGS::GID );
-            plane_pnt.getVector3fMap() = out_prims[gid].at(0).pos();
-            vptr->addArrow( plane_pnt, pnt,  .1, .9, .5, false, name );
+            if ( !(pid % 1000) )
+            {
+                char name[255];
+                sprintf( name, "pointarrow%06d", pid );
+                pnt.getVector3fMap() = points[pid].pos();
+                const int gid = points[pid].getTag( PointPrimitiveT::TAGS::GID );
+                plane_pnt.getVector3fMap() = out_prims[gid].at(0).pos();
+                vptr->addArrow( plane_pnt, pnt,  .1, .9, .5, false, name );
+            }
         }
-    }
 
-//        for ( PidGidT::const_iterator it = pidGid.begin(); it != pidGid.end(); ++it )
-//        {
-//            points[it->first].setTag( PointPrimitiveT::TAGS::GID, it->second );
-//        }
-    for ( size_t i = 0; i != std::min(50UL,planes.size()); ++i )
-    {
-        char name[255];
-        sprintf( name, "plane%lu", i );
-        vptr->addPlane( *(planes[i].modelCoefficients()), planes[i]. pos()(0), planes[i]. pos()(1), planes[i]. pos()(2), name );
-    }
-    vptr->addCoordinateSystem(0.5);
-    vptr->spin();
+    //        for ( PidGidT::const_iterator it = pidGid.begin(); it != pidGid.end(); ++it )
+    //        {
+    //            points[it->first].setTag( PointPrimitiveT::TAGS::GID, it->second );
+    //        }
+        for ( size_t i = 0; i != std::min(50UL,planes.size()); ++i )
+        {
+            char name[255];
+            sprintf( name, "plane%lu", i );
+            vptr->addPlane( *(planes[i].modelCoefficients()), planes[i]. pos()(0), planes[i]. pos()(1), planes[i]. pos()(2), name );
+        }
+        vptr->addCoordinateSystem(0.5);
+        vptr->spin();
 #endif
 
-    char outPrimsPath[ 512 ], outAssocPath[512], outCloudPath[512];
-    sprintf( outPrimsPath, "./schnabel_minsup%d.primitives.csv", min_support_arg );
-    std::cout << " writing " << out_prims.size() << " primitives to " << outPrimsPath << std::endl;
-    rapter::io::savePrimitives<PrimitiveT,std::vector<rapter::PlanePrimitive>::const_iterator >( out_prims, std::string(outPrimsPath) );
+        char outPrefix[ 256 ], outPrimsPath[ 512 ], outAssocPath[512], outCloudPath[512];
+        if ( sweepEps )
+            sprintf( outPrefix, "./schnabel_minsup%d_eps%g_beps%g", min_support_arg, epsilon, bitmapEpsilon );
+        else
+            sprintf( outPrefix, "./schnabel_minsup%d", min_support_arg );
+        sprintf( outPrimsPath, "%s.primitives.csv", outPrefix );
+        std::cout << " writing " << out_prims.size() << " primitives to " << outPrimsPath << std::endl;
+        rapter::io::savePrimitives<PrimitiveT,std::vector<rapter::PlanePrimitive>::const_iterator >( out_prims, std::string(outPrimsPath) );
+
+        sprintf( outAssocPath, "%s.points_primitives.csv", outPrefix );
+        std::cout << " writing " << outPoints.size() << " assignments to " << outAssocPath << std::endl;
+        rapter::io::writeAssociations<PointPrimitiveT>( outPoints, outAssocPath );
+
+        sprintf( outCloudPath, "%s.cloud.ply", outPrefix );
+        std::cout << " writing " << outPoints.size() << " points to " << outCloudPath << std::endl;
+        rapter::io::writePoints<PointPrimitiveT>( outPoints, outCloudPath );
 
-    sprintf( outAssocPath, "./schnabel_minsup%d.points_primitives.csv", min_support_arg );
-    std::cout << " writing " << outPoints.size() << " assignments to " << outAssocPath << std::endl;
-    rapter::io::writeAssociations<PointPrimitiveT>( outPoints, outAssocPath );
+        std::cout << "../show.py -p " << outPrimsPath << " -a " << outAssocPath << " --cloud " << outCloudPath << " --scale " << params.scale << "\n";
 
-    sprintf( outCloudPath, "./schnabel_minsup%d.cloud.ply", min_support_arg );
-    std::cout << " writing " << outPoints.size() << " points to " << outCloudPath << std::endl;
-    rapter::io::writePoints<PointPrimitiveT>( outPoints, outCloudPath );
+    } //...for runs
 
-    std::cout << "../show.py -p " << outPrimsPath << " -a " << outAssocPath << " --cloud " << outCloudPath << " --scale " << params.scale << "\n";
+    if ( seed && !indexCachePath.empty() )
+    {
+        std::ofstream f( indexCachePath.c_str(), std::ios::binary );
+        if ( !f.is_open() || !cache.index.Save(f) )
+            std::cerr << "[" << __func__ << "]: " << "could not write " << indexCachePath << std::endl;
+    }
 
     return EXIT_SUCCESS;
 }
@@ -30,7 +30,7 @@ namespace rapter
 
         if ( !valid )
         {
-            std::cout << "Usage: " << argv[0] << " -p prims.csv -a points_prims.csv -c cloud.ply [-o out.gv] [-s scale] [--dids did0,did1]" << std::endl;
+            std::cout << "Usage: " << argv[0] << " -p prims.csv -a points_prims.csv -c cloud.ply [-o out.gv] [-s scale] [--dids did0,did1] [--svg] [--pdf] [--max-points N] (--svg, --pdf need -s)" << std::endl;
             return EXIT_FAILURE;
         }
 
@@ -73,12 +73,33 @@ namespace rapter
 
         bool drawOld = rapter::console::find_switch( argc, argv, "--old" );
         bool colourCloud = rapter::console::find_switch( argc, argv, "--colourCloud" );
+        bool drawSvg = rapter::console::find_switch( argc, argv, "--svg" );
+        bool drawPdf = rapter::console::find_switch( argc, argv, "--pdf" );
+        int  maxPoints = 0;
+        rapter::console::parse_argument( argc, argv, "--max-points", maxPoints ); // per patch, 0: all
 
         io::drawGraph( primsMap, points, outPath, drawOld, true, dids.size() ? &dids : NULL, pw, showClusters, edgeSources.size() ? &edgeSources : NULL );
 
         Scalar scale = 0.02f;
         if ( rapter::console::parse_argument( argc, argv, "-s", scale ) < 0 )
+        {
+            if ( drawSvg || drawPdf )
+            {
+                std::cerr << "[" << __func__ << "]: " << "can't do --svg or --pdf, need -s scale" << std::endl;
+                return EXIT_FAILURE;
+            }
             std::cerr << "[" << __func__ << "]: " << "can't do drawPs, need -s scale" << std::endl;
+        }
+        else if ( drawSvg || drawPdf )
+        {
+            // single file with points and primitives, written in parallel
+            int err = EXIT_SUCCESS;
+            if ( drawSvg )
+                err += io::drawVector( primsMap, points, outPath + ".svg", scale, writeNames, colourCloud, &dids, maxPoints, radius );
+            if ( drawPdf )
+                err += io::drawVector( primsMap, points, outPath + ".pdf", scale, writeNames, colourCloud, &dids, maxPoints, radius );
+            return err;
+        }
         else
         {
             io::drawPs( primsMap, points, outPath + ".ps", scale
@@ -14,6 +14,7 @@ int merge     ( int argc, char** argv ); // merge.cpp
 //int datafit   ( int argc, char** argv ); // datafit.cpp
 //int reassign  ( int argc, char** argv );
 int represent ( int argc, char** argv ); // represent.cpp
+int polygonize( int argc, char** argv ); // polygonize.cpp
 
 int main( int argc, char *argv[] )
 {
@@ -34,7 +35,8 @@ int main( int argc, char *argv[] )
                   << "\t--merge3D\n"
                   << "\t--datafit\n"
                   << "\t--corresp\n"
-                  << "\t--represent[3D]"
+                  << "\t--represent[3D]\n"
+                  << "\t--polygonize3D"
                   //<< "\t--show\n"
                   << std::endl;
 
@@ -99,6 +101,10 @@ int main( int argc, char *argv[] )
     {
         return represent( argc, argv );
     }
+    else if ( rapter::console::find_switch(argc,argv,"--polygonize") || rapter::console::find_switch(argc,argv,"--polygonize3D") )
+    {
+        return polygonize( argc, argv );
+    }
 //    else if ( rapter::console::find_switch(argc,argv,"--corresp") || rapter::console::find_switch(argc,argv,"--corresp3D") )
 //    {
 //        return corresp( argc, argv );
@@ -0,0 +1,20 @@
+#include "rapter/typedefs.h"                            // _3d::PrimitiveT
+#include "rapter/util/parse.h"                          // find_switch
+#include "rapter/processing/impl/polygonize.hpp"        // polygonizeCli
+#include "rapter/primitives/impl/planePrimitive.hpp"
+
+int polygonize( int argc, char** argv )
+{
+    if ( rapter::console::find_switch(argc,argv,"--polygonize3D") )
+    {
+        return rapter::processing::polygonizeCli< rapter::_3d::PrimitiveContainerT
+                                                , rapter::PointContainerT
+                                                , rapter::_3d::PrimitiveT
+                                                , rapter::PointPrimitiveT
+                                                >( argc, argv );
+    }
+    else
+        std::cerr << "[" << __func__ << "]: " << "polygon export is only implemented for planes, use --polygonize3D" << std::endl;
+
+    return EXIT_FAILURE;
+} //...polygonize()
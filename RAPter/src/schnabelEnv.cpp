@@ -19,6 +19,18 @@
 
 namespace rapter
 {
+    struct SchnabelEnv::Cache
+    {
+        Cache() : scale( 0.f ), extrude2D( false ), pointMultiplier( 0 ), inputSize( 0 ) {}
+
+        std::vector<schnabel::Point>                 points;          //!< Input order, with normals.
+        float                                        scale;
+        bool                                         extrude2D;
+        int                                          pointMultiplier;
+        size_t                                       inputSize;
+        schnabel::RansacShapeDetector::IndexCache    index;
+    }; //...struct Cache
+
     template <class PclCloudT, typename PrimitiveT, /*class PidGidT,*/ class PointContainerT >
     int SchnabelEnv::run( std::vector<PrimitiveT>          &planes
                           , PointContainerT &outPoints //PidGidT &pidGid
@@ -29,6 +41,10 @@ namespace rapter
                           , int show
                           , bool extrude2D
                           , int pointMultiplier
+                          , float epsilon
+                          , float bitmapEpsilon
+                          , size_t seed
+                          , Cache *cache
                           )
     {
         typedef typename PointContainerT::value_type PointPrimitiveT;
@@ -82,17 +98,39 @@ namespace rapter
         vptr->addCoordinateSystem( 0.1, "coordsys", 0 );
         vptr->setPointCloudRenderingProperties( pcl::visualization::PCL_VISUALIZER_POINT_SIZE, 4.f );
 
+        // the extruded points are random, reuse them along with their normals
+        const bool reuse = cache && cache->points.size()
+                           && cache->scale == scale && cache->extrude2D == extrude2D && cache->pointMultiplier == pointMultiplier
+                           && cache->inputSize == inCloud->size() && cache->points.size() == cloud->size();
+
         // Points
         //schnabel::Point pnts[ cloud->size() ];
-        schnabel::Point* pnts = new schnabel::Point[ cloud->size() ];
-        for ( size_t i = 0; i != cloud->size(); ++i )
+        schnabel::Point* pnts = NULL;
+        if ( !reuse )
         {
-            pnts[i] = schnabel::Point( Vec3f(cloud->at(i).x, cloud->at(i).y, cloud->at(i).z) );
+            pnts = new schnabel::Point[ cloud->size() ];
+            for ( size_t i = 0; i != cloud->size(); ++i )
+            {
+                pnts[i] = schnabel::Point( Vec3f(cloud->at(i).x, cloud->at(i).y, cloud->at(i).z) );
+            }
         }
-        schnabel::PointCloud pc( pnts, cloud->size() );
+        schnabel::PointCloud pc( reuse ? &cache->points[0] : pnts, cloud->size() );
 
         // Normals
-        pc.calcNormals( scale );
+        if ( reuse )
+            std::cout << "[" << __func__ << "]: " << "reusing " << cache->points.size() << " points and normals" << std::endl;
+        else
+        {
+            pc.calcNormals( scale );
+            if ( cache )
+            {
+                cache->points.assign( pc.begin(), pc.end() );
+                cache->scale           = scale;
+                cache->extrude2D       = extrude2D;
+                cache->pointMultiplier = pointMultiplier;
+                cache->inputSize       = inCloud->size();
+            }
+        }
         for ( size_t i = 0; i != cloud->size(); ++i )
         {
             // error check
@@ -135,6 +173,9 @@ namespace rapter
         // options (schnabel)
         schnabel::RansacShapeDetector::Options opt;
         opt.m_minSupport = min_support_arg;
+        if ( epsilon       > 0.f ) opt.m_epsilon       = epsilon;
+        if ( bitmapEpsilon > 0.f ) opt.m_bitmapEpsilon = bitmapEpsilon;
+        opt.m_seed       = seed;
         schnabel::RansacShapeDetector rsd( opt );
         rsd.Add( new schnabel::PlanePrimitiveShapeConstructor() );
 
@@ -144,7 +185,7 @@ namespace rapter
         std::vector< MiscLib::Vector< size_t > > outIndices;
         {
             std::cout << "starting..." << std::endl;
-            int ret = rsd.Detect( pc, 0, pc.size(), &shapes, &outShapeIndex, &outIndices );
+            int ret = rsd.Detect( pc, 0, pc.size(), &shapes, &outShapeIndex, &outIndices, cache ? &cache->index : NULL );
             std::cout << "detect returned " << ret << std::endl;
             std::cout << "shapes.size: " << shapes.size() << std::endl;
         }
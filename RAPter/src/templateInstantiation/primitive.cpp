@@ -2,6 +2,6 @@
 #include "rapter/primitives/primitive.h"
 
 template
-class rapter::Primitive<2,6, rapter::__Scalar>;
+class rapter::Primitive<2,6, rapter::__Scalar, rapter::__AccumScalar>;
 template
-class rapter::Primitive<3,6, rapter::__Scalar>;
+class rapter::Primitive<3,6, rapter::__Scalar, rapter::__AccumScalar>;
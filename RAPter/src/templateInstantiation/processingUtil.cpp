@@ -0,0 +1,51 @@
+#include "rapter/typedefs.h"
+#include "rapter/processing/util.hpp"
+
+// Mixed precision: points are stored in rapter::Scalar, sums over them are accumulated in rapter::AccumScalar.
+namespace rapter
+{
+    namespace templ_inst
+    {
+        typedef std::vector<PidT> IndicesContainerT;
+    }
+
+namespace processing
+{
+    template Eigen::Matrix<Scalar,3,1>
+    getCentroid< Scalar, templ_inst::IndicesContainerT, PointContainerT, AccumScalar >
+               ( PointContainerT const& points, templ_inst::IndicesContainerT const* indices );
+
+    template Eigen::Matrix<AccumScalar,3,1>
+    getCentroid< AccumScalar, templ_inst::IndicesContainerT, PointContainerT, AccumScalar >
+               ( PointContainerT const& points, templ_inst::IndicesContainerT const* indices );
+
+    template int
+    computeCovarianceMatrix< std::vector<int>, templ_inst::IndicesContainerT, AccumScalar, PointContainerT, Eigen::Matrix<AccumScalar,3,1>, AccumScalar >
+                           ( Eigen::Matrix<AccumScalar,3,3>          & cov
+                           , PointContainerT                    const& points
+                           , Eigen::Matrix<AccumScalar,3,1>     const& centroid
+                           , templ_inst::IndicesContainerT      const* indices
+                           , std::vector<int>                   const* weights );
+
+    template int
+    eigenDecomposition< templ_inst::IndicesContainerT, Scalar, PointContainerT, AccumScalar >
+                      ( Eigen::Matrix<Scalar,3,1>     & eigen_values
+                      , Eigen::Matrix<Scalar,3,3>     & eigen_vectors
+                      , PointContainerT          const& points
+                      , templ_inst::IndicesContainerT * indices
+                      , Eigen::Matrix<Scalar,3,1>     * out_centroid_arg
+                      , Eigen::Matrix<Scalar,3,3>     * out_covariance_arg );
+
+    template int
+    PCA< templ_inst::IndicesContainerT, Scalar, PointContainerT, AccumScalar >
+       ( Eigen::Matrix<Scalar,4,4>          & frame
+       , PointContainerT               const& points
+       , templ_inst::IndicesContainerT      * indices );
+
+    template int
+    PCA< templ_inst::IndicesContainerT, AccumScalar, PointContainerT, AccumScalar >
+       ( Eigen::Matrix<AccumScalar,4,4>     & frame
+       , PointContainerT               const& points
+       , templ_inst::IndicesContainerT      * indices );
+} //...ns processing
+} //...ns rapter
@@ -32,7 +32,8 @@ namespace rapter
                               ( rapter::PointContainerT       &points
                               , rapter::Scalar          const  scale
                               , int                  const  nn_K
-                              , int                  const  verbose );
+                              , int                  const  verbose
+                              , bool                 const  consistent );
 
     template int
     Segmentation::orientPoints< rapter::PointPrimitiveT
@@ -43,7 +44,8 @@ namespace rapter
                               ( rapter::PointContainerT       &points
                               , rapter::Scalar          const  scale
                               , int                  const  nn_K
-                              , int                  const  verbose );
+                              , int                  const  verbose
+                              , bool                 const  consistent );
 
 
     template int
@@ -61,6 +63,8 @@ namespace rapter
             , int                                      const  nn_K
             , int                                      const  verbose
             , size_t                                   const  patchPopLimit
+            , segmentation::Dendrogram<rapter::Scalar> const* dendrogram
+            , rapter::Scalar                           const  cutThreshold
             );
 
     template int
@@ -78,6 +82,8 @@ namespace rapter
                           , int                                      const  nn_K
                           , int                                      const  verbose
                           , size_t                                   const  patchPopLimit
+                          , segmentation::Dendrogram<rapter::Scalar> const* dendrogram
+                          , rapter::Scalar                           const  cutThreshold
                           );
 
     namespace segm_templinst
@@ -126,6 +132,33 @@ namespace rapter
                               , bool                        const  verbose
                               );
 
+    template int
+    Segmentation::agglomerate < rapter::_2d::PrimitiveT
+                              , rapter::PointContainerT
+                              , rapter::_2d::PatchPatchDistanceFunctorT
+                              , rapter::Scalar
+                              , rapter::PointPrimitiveT
+                              >
+                              ( segmentation::Dendrogram<rapter::Scalar>      & dendrogram
+                              , rapter::PointContainerT                  const& points
+                              , rapter::_2d::PatchPatchDistanceFunctorT  const& patchPatchDistanceFunctor
+                              , int                                      const  nn_K
+                              , bool                                     const  verbose
+                              );
+    template int
+    Segmentation::agglomerate < rapter::_3d::PrimitiveT
+                              , rapter::PointContainerT
+                              , rapter::_3d::PatchPatchDistanceFunctorT
+                              , rapter::Scalar
+                              , rapter::PointPrimitiveT
+                              >
+                              ( segmentation::Dendrogram<rapter::Scalar>      & dendrogram
+                              , rapter::PointContainerT                  const& points
+                              , rapter::_3d::PatchPatchDistanceFunctorT  const& patchPatchDistanceFunctor
+                              , int                                      const  nn_K
+                              , bool                                     const  verbose
+                              );
+
     template int
     Segmentation::fitLocal  ( rapter::_2d::InnerPrimitiveContainerT & lines
                             , pcl::PointCloud<pcl::PointXYZ>::Ptr const  cloud
@@ -135,6 +168,7 @@ namespace rapter
                             , bool                 const  soft_radius
                             , std::vector<PidT>         * mapping
                             , int                  const  verbose
+                            , std::vector< std::vector<int> > *neighbourhoods
                             );
 
     template int
@@ -146,6 +180,7 @@ namespace rapter
                             , bool                 const  soft_radius
                             , std::vector<PidT>         * mapping
                             , int                  const  verbose
+                            , std::vector< std::vector<int> > *neighbourhoods
                             );
 
     template int
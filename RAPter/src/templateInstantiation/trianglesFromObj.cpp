@@ -12,6 +12,6 @@ namespace rapter
     }
 
     template
-    int getTrianglesFromObj( templ_inst::TrianglesContainer & triangles, std::string const& meshPath, rapter::__Scalar minPlaneEdge );
+    int getTrianglesFromObj( templ_inst::TrianglesContainer & triangles, std::string const& meshPath, rapter::__Scalar minPlaneEdge, std::string const& cacheDir );
 
 }
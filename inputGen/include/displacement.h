@@ -4,6 +4,11 @@
 #include "primitive.h"
 #include <random>
 #include <chrono>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 
 namespace InputGen{
@@ -12,7 +17,27 @@ namespace InputGen{
         DISPLACEMENT_RANDOM_UNIFORM = 0,
         DISPLACEMENT_RANDOM_NORMAL  = 1,
         DISPLACEMENT_BIAS           = 2,
-        INVALID_KERNEL              = 3
+        DISPLACEMENT_SCANNER        = 3,
+        INVALID_KERNEL              = 4
+    };
+
+    /*!
+     * \brief Independent random streams over fixed-size blocks of samples
+     *
+     * Each block draws from its own engine, seeded from a kernel seed and the block id.
+     * Blocks can thus be processed by any thread, in any order, and give the same
+     * displacement whatever the number of threads.
+     */
+    struct BlockRandomStreams{
+        enum { BlockSize = 1024 };
+
+        static inline long nbBlocks(size_t nbSamples)
+        { return long((nbSamples + BlockSize - 1) / BlockSize); }
+
+        static inline std::mt19937 engine(unsigned int seed, long blockId){
+            std::seed_seq seq {seed, static_cast<unsigned int>(blockId)};
+            return std::mt19937(seq);
+        }
     };
 
     template <typename _Scalar, class _SampleContainer, class _PrimitiveContainer>
@@ -172,8 +197,75 @@ namespace InputGen{
     };
 
 
+    /*!
+     * \brief Noise model of a scanner located at sensor, in the plane of the scene
+     *
+     * Each sample is displaced by:
+     *  - range noise along the beam, growing with the range and the incidence angle,
+     *  - lateral noise across the beam, proportional to the footprint (range x divergence),
+     *  - outliers, moved uniformly along the beam with probability outlierRate,
+     *  - dropouts beyond grazingAngle with probability dropoutRate, flagged by a NaN
+     *    displacement (see Project::isSampleDropped),
+     *  - registration drift: samples are split in nbStations consecutive ranges, each
+     *    one misaligned by an accumulated random rigid motion around the sensor.
+     *
+     * Samples are processed in parallel, see BlockRandomStreams.
+     */
+    template <typename _Scalar, class _SampleContainer, class _PrimitiveContainer>
+    struct ScannerDisplacementKernel:
+            public AbstractDisplacementKernel<_Scalar, _SampleContainer, _PrimitiveContainer>{
+        typedef _Scalar Scalar;
+        typedef _SampleContainer    SampleContainer;
+        typedef _PrimitiveContainer PrimitiveContainer;
+        typedef typename PrimitiveContainer::value_type::vec vec;
+
+    private:
+        //! Seed used to generate the samples
+        unsigned int _seed;
+        std::mt19937 _generator;
+
+    public:
+        vec    sensor;
+        Scalar rangeSigma;       //! <\brief Std. dev. along the beam, at normal incidence and null range
+        Scalar rangeSigmaGrowth; //! <\brief Increase of the std. dev. along the beam per unit of range
+        Scalar beamDivergence;   //! <\brief Std. dev. across the beam per unit of range (radian)
+        Scalar outlierRate;
+        Scalar outlierRange;     //! <\brief Outliers are moved in [-outlierRange, outlierRange]
+        Scalar grazingAngle;     //! <\brief Incidence angle (radian) above which samples can be dropped
+        Scalar dropoutRate;
+        int    nbStations;
+        Scalar driftTranslation; //! <\brief Std. dev. of the translation between two stations
+        Scalar driftRotation;    //! <\brief Std. dev. of the rotation (radian) between two stations
+
+        inline ScannerDisplacementKernel() :
+            AbstractDisplacementKernel<_Scalar, _SampleContainer, _PrimitiveContainer>(
+                "Scanner",
+                DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER),
+            _seed( std::chrono::system_clock::now().time_since_epoch().count()),
+            _generator( _seed ),
+            sensor(vec::Zero()),
+            rangeSigma(0.001),
+            rangeSigmaGrowth(0.001),
+            beamDivergence(0.0005),
+            outlierRate(0),
+            outlierRange(0.1),
+            grazingAngle(M_PI/2.),
+            dropoutRate(0),
+            nbStations(1),
+            driftTranslation(0),
+            driftRotation(0)
+        {}
+
+        virtual void generateDisplacement(
+                typename PrimitiveContainer::value_type::vec* darray,
+                const SampleContainer& scontainer,
+                const PrimitiveContainer& pcontainer);
+    };
+
+
 #include "impl/biasdisplacement.hpp"
 #include "impl/randomdisplacement.hpp"
+#include "impl/scannerdisplacement.hpp"
 
 
 }
@@ -9,9 +9,19 @@ void RandomDisplacementKernel<_Scalar,_SampleContainer,_PrimitiveContainer, Numb
         const _PrimitiveContainer& pcontainer){
     typedef typename _PrimitiveContainer::value_type::vec vec;
 
-    for (typename SampleContainer::const_iterator it = scontainer.cbegin();
-         it != scontainer.cend(); it++, darray++){
-        *darray = (*it).normal*_distribution(_generator);
+    // new noise at each evaluation, reproducible from the kernel seed
+    const unsigned int seed = _generator();
+    const size_t nbSamples  = scontainer.size();
+    const long   nbBlocks   = BlockRandomStreams::nbBlocks(nbSamples);
+
+#pragma omp parallel for schedule(dynamic)
+    for (long blockId = 0; blockId < nbBlocks; blockId++){
+        std::mt19937 generator = BlockRandomStreams::engine(seed, blockId);
+        NumberDistribution distribution (_distribution);
+
+        const size_t end = std::min(nbSamples, size_t(blockId+1) * BlockRandomStreams::BlockSize);
+        for (size_t i = size_t(blockId) * BlockRandomStreams::BlockSize; i < end; i++)
+            darray[i] = scontainer[i].normal*distribution(generator);
     }
 }
 
@@ -0,0 +1,86 @@
+#ifndef SCANNERDISPLACEMENT_HPP
+#define SCANNERDISPLACEMENT_HPP
+
+
+template <typename _Scalar, class _SampleContainer, class _PrimitiveContainer>
+void ScannerDisplacementKernel<_Scalar,_SampleContainer,_PrimitiveContainer>::generateDisplacement(
+        typename _PrimitiveContainer::value_type::vec* darray,
+        const _SampleContainer& scontainer,
+        const _PrimitiveContainer& pcontainer){
+    // bound the range noise at grazing angles
+    const _Scalar minCosIncidence = 0.05;
+    const _Scalar cosGrazing      = std::cos(grazingAngle);
+    const _Scalar dropped         = std::numeric_limits<_Scalar>::quiet_NaN();
+
+    const unsigned int seed = _generator();
+    const size_t nbSamples  = scontainer.size();
+    const long   nbBlocks   = BlockRandomStreams::nbBlocks(nbSamples);
+    const int    stations   = std::max(1, nbStations);
+
+    // samples refer to primitives by uid
+    std::map<int, vec> normals;
+    for (typename PrimitiveContainer::const_iterator it = pcontainer.cbegin();
+         it != pcontainer.cend(); it++)
+        normals[(*it).uid()] = (*it).normal();
+
+    // random walk of the stations around the sensor, the first one is the reference
+    std::vector<_Scalar> angles (stations, _Scalar(0));
+    std::vector<vec, Eigen::aligned_allocator<vec> > offsets (stations, vec::Zero());
+    {
+        std::mt19937 generator = BlockRandomStreams::engine(seed, -1);
+        std::normal_distribution<_Scalar> distribution (_Scalar(0), _Scalar(1));
+        for (int s = 1; s < stations; s++){
+            angles [s] = angles [s-1] + driftRotation * distribution(generator);
+            offsets[s] = offsets[s-1] + driftTranslation * vec(distribution(generator),
+                                                                  distribution(generator),
+                                                                  _Scalar(0));
+        }
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (long blockId = 0; blockId < nbBlocks; blockId++){
+        std::mt19937 generator = BlockRandomStreams::engine(seed, blockId);
+        std::normal_distribution<_Scalar>       gaussian (_Scalar(0), _Scalar(1));
+        std::uniform_real_distribution<_Scalar> uniform  (_Scalar(0), _Scalar(1));
+
+        const size_t end = std::min(nbSamples, size_t(blockId+1) * BlockRandomStreams::BlockSize);
+        for (size_t i = size_t(blockId) * BlockRandomStreams::BlockSize; i < end; i++){
+            const vec& p = scontainer[i];
+
+            // registration drift
+            const int    s = int(i * stations / nbSamples);
+            const _Scalar c = std::cos(angles[s]), sn = std::sin(angles[s]);
+            const vec local = p - sensor;
+            vec d = vec(c*local(0) - sn*local(1), sn*local(0) + c*local(1), local(2)) - local + offsets[s];
+
+            const _Scalar range = local.norm();
+            if (range > _Scalar(0)){
+                const vec beam    = local / range;
+                const vec lateral = vec(-beam(1), beam(0), _Scalar(0));
+
+                _Scalar cosIncidence = _Scalar(1);
+                typename std::map<int, vec>::const_iterator nit = normals.find(scontainer[i].primitiveId);
+                if (nit != normals.end())
+                    cosIncidence = std::abs((*nit).second.normalized().dot(beam));
+
+                if (cosIncidence < cosGrazing && uniform(generator) < dropoutRate){
+                    darray[i] = vec::Constant(dropped);
+                    continue;
+                }
+
+                if (uniform(generator) < outlierRate)
+                    d += beam * (_Scalar(2) * uniform(generator) - _Scalar(1)) * outlierRange;
+                else{
+                    const _Scalar sigma = (rangeSigma + rangeSigmaGrowth * range) /
+                                          std::max(cosIncidence, minCosIncidence);
+                    d += beam    * (sigma * gaussian(generator));
+                    d += lateral * (range * beamDivergence * gaussian(generator));
+                }
+            }
+
+            darray[i] = d;
+        }
+    }
+}
+
+#endif // SCANNERDISPLACEMENT_HPP
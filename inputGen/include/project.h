@@ -142,6 +142,12 @@ public:
         return displ;
     }
 
+    //! \brief Samples dropped by a displacement kernel have a NaN displacement
+    inline bool isSampleDropped(int sampleId) const {
+        const Primitive::vec displ = computeTotalDisplacement(sampleId);
+        return (displ.array() != displ.array()).any();
+    }
+
     inline int nbDisplacementLayers() const { return _displ.size(); }
 };
 }
@@ -66,6 +66,22 @@ DisplacementFactory::loadkernels(QDomElement &root)
                 ui->_displacementParamRandomNormalStddevValue->setValue(kernelElement.attribute("distributionStdDev").toDouble());
                 break;
             }
+            case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER:
+            {
+                ui->_displacementParamScannerSensorXValue->setValue(kernelElement.attribute("sensorX").toDouble());
+                ui->_displacementParamScannerSensorYValue->setValue(kernelElement.attribute("sensorY").toDouble());
+                ui->_displacementParamScannerRangeSigmaValue->setValue(kernelElement.attribute("rangeSigma").toDouble());
+                ui->_displacementParamScannerRangeSigmaGrowthValue->setValue(kernelElement.attribute("rangeSigmaGrowth").toDouble());
+                ui->_displacementParamScannerBeamDivergenceValue->setValue(kernelElement.attribute("beamDivergence").toDouble());
+                ui->_displacementParamScannerOutlierRateValue->setValue(kernelElement.attribute("outlierRate").toDouble());
+                ui->_displacementParamScannerOutlierRangeValue->setValue(kernelElement.attribute("outlierRange").toDouble());
+                ui->_displacementParamScannerGrazingAngleValue->setValue(kernelElement.attribute("grazingAngle").toDouble() * 180. / M_PI);
+                ui->_displacementParamScannerDropoutRateValue->setValue(kernelElement.attribute("dropoutRate").toDouble());
+                ui->_displacementParamScannerNbStationsValue->setValue(kernelElement.attribute("nbStations").toInt());
+                ui->_displacementParamScannerDriftTranslationValue->setValue(kernelElement.attribute("driftTranslation").toDouble());
+                ui->_displacementParamScannerDriftRotationValue->setValue(kernelElement.attribute("driftRotation").toDouble() * 180. / M_PI);
+                break;
+            }
             default:
                 std::cerr << "Invalid kernel type " << kernelId << std::endl;
             };
@@ -142,6 +158,31 @@ DisplacementFactory::savekernels(QDomDocument &doc, QDomElement &root) const
                 kernelElement.setAttribute("distributionStdDev", QString::number( lkernel->distributionStdDev() ));
                 break;
             }
+            case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER:
+            {
+                InputGen::ScannerDisplacementKernel<S,SC,PC>* lkernel =
+                        dynamic_cast<InputGen::ScannerDisplacementKernel<S,SC,PC>*> (kernel);
+                if(lkernel == NULL) {
+                    std::cerr << "This should nerver happen... "
+                              << __FILE__ << " "
+                              << __LINE__ << std::endl;
+                    break;
+                }
+
+                kernelElement.setAttribute("sensorX",          QString::number( lkernel->sensor(0) ));
+                kernelElement.setAttribute("sensorY",          QString::number( lkernel->sensor(1) ));
+                kernelElement.setAttribute("rangeSigma",       QString::number( lkernel->rangeSigma ));
+                kernelElement.setAttribute("rangeSigmaGrowth", QString::number( lkernel->rangeSigmaGrowth ));
+                kernelElement.setAttribute("beamDivergence",   QString::number( lkernel->beamDivergence ));
+                kernelElement.setAttribute("outlierRate",      QString::number( lkernel->outlierRate ));
+                kernelElement.setAttribute("outlierRange",     QString::number( lkernel->outlierRange ));
+                kernelElement.setAttribute("grazingAngle",     QString::number( lkernel->grazingAngle ));
+                kernelElement.setAttribute("dropoutRate",      QString::number( lkernel->dropoutRate ));
+                kernelElement.setAttribute("nbStations",       QString::number( lkernel->nbStations ));
+                kernelElement.setAttribute("driftTranslation", QString::number( lkernel->driftTranslation ));
+                kernelElement.setAttribute("driftRotation",    QString::number( lkernel->driftRotation ));
+                break;
+            }
             }
 
             root.appendChild(kernelElement);
@@ -183,6 +224,9 @@ DisplacementFactory::addLayerTriggerred(){
     case InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_BIAS:
         kernel = new InputGen::BiasDisplacementKernel<Scalar,SampleContainer,PrimitiveContainer>;
         break;
+    case InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER:
+        kernel = new InputGen::ScannerDisplacementKernel<Scalar,SampleContainer,PrimitiveContainer>;
+        break;
     }
 
 
@@ -320,6 +364,51 @@ DisplacementFactory::configureFromUI(InputGen::Application::Project::Displacemen
 
         break;
     }
+    case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER:
+    {
+        InputGen::ScannerDisplacementKernel<S,SC,PC>* lkernel =
+                dynamic_cast<InputGen::ScannerDisplacementKernel<S,SC,PC>*> (kernel);
+        if(lkernel == NULL) {
+            std::cerr << "This should nerver happen... "
+                      << __FILE__ << " "
+                      << __LINE__ << std::endl;
+            break;
+        }
+
+        // angles are edited in degrees
+        const S grazingAngle  = ui->_displacementParamScannerGrazingAngleValue->value()  * M_PI / 180.;
+        const S driftRotation = ui->_displacementParamScannerDriftRotationValue->value() * M_PI / 180.;
+
+        // set parameters
+        if (lkernel->sensor(0)        != ui->_displacementParamScannerSensorXValue->value() ||
+            lkernel->sensor(1)        != ui->_displacementParamScannerSensorYValue->value() ||
+            lkernel->rangeSigma       != ui->_displacementParamScannerRangeSigmaValue->value() ||
+            lkernel->rangeSigmaGrowth != ui->_displacementParamScannerRangeSigmaGrowthValue->value() ||
+            lkernel->beamDivergence   != ui->_displacementParamScannerBeamDivergenceValue->value() ||
+            lkernel->outlierRate      != ui->_displacementParamScannerOutlierRateValue->value() ||
+            lkernel->outlierRange     != ui->_displacementParamScannerOutlierRangeValue->value() ||
+            lkernel->grazingAngle     != grazingAngle ||
+            lkernel->dropoutRate      != ui->_displacementParamScannerDropoutRateValue->value() ||
+            lkernel->nbStations       != ui->_displacementParamScannerNbStationsValue->value() ||
+            lkernel->driftTranslation != ui->_displacementParamScannerDriftTranslationValue->value() ||
+            lkernel->driftRotation    != driftRotation){
+            needUpdate = true;
+            lkernel->sensor(0)        = ui->_displacementParamScannerSensorXValue->value();
+            lkernel->sensor(1)        = ui->_displacementParamScannerSensorYValue->value();
+            lkernel->rangeSigma       = ui->_displacementParamScannerRangeSigmaValue->value();
+            lkernel->rangeSigmaGrowth = ui->_displacementParamScannerRangeSigmaGrowthValue->value();
+            lkernel->beamDivergence   = ui->_displacementParamScannerBeamDivergenceValue->value();
+            lkernel->outlierRate      = ui->_displacementParamScannerOutlierRateValue->value();
+            lkernel->outlierRange     = ui->_displacementParamScannerOutlierRangeValue->value();
+            lkernel->grazingAngle     = grazingAngle;
+            lkernel->dropoutRate      = ui->_displacementParamScannerDropoutRateValue->value();
+            lkernel->nbStations       = ui->_displacementParamScannerNbStationsValue->value();
+            lkernel->driftTranslation = ui->_displacementParamScannerDriftTranslationValue->value();
+            lkernel->driftRotation    = driftRotation;
+        }
+
+        break;
+    }
     }
 
     return needUpdate;
@@ -341,6 +430,7 @@ DisplacementFactory::currentLayerChanged(){
         ui->_displacementParamBiasGroup->hide();
         ui->_displacementParamRandomUniformGroup->hide();
         ui->_displacementParamRandomNormalGroup->hide();
+        ui->_displacementParamScannerGroup->hide();
     }
 
     if (_project == NULL) return;
@@ -366,6 +456,7 @@ DisplacementFactory::currentLayerChanged(){
         ui->_displacementParamBiasGroup->show();
         ui->_displacementParamRandomUniformGroup->hide();
         ui->_displacementParamRandomNormalGroup->hide();
+        ui->_displacementParamScannerGroup->hide();
         break;
     }
     case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_RANDOM_UNIFORM:
@@ -385,6 +476,7 @@ DisplacementFactory::currentLayerChanged(){
         ui->_displacementParamBiasGroup->hide();
         ui->_displacementParamRandomUniformGroup->show();
         ui->_displacementParamRandomNormalGroup->hide();
+        ui->_displacementParamScannerGroup->hide();
         break;
     }
     case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_RANDOM_NORMAL:
@@ -404,6 +496,37 @@ DisplacementFactory::currentLayerChanged(){
         ui->_displacementParamBiasGroup->hide();
         ui->_displacementParamRandomUniformGroup->hide();
         ui->_displacementParamRandomNormalGroup->show();
+        ui->_displacementParamScannerGroup->hide();
+        break;
+    }
+    case::InputGen::DISPLACEMENT_KERNEL_TYPE::DISPLACEMENT_SCANNER:
+    {
+        InputGen::ScannerDisplacementKernel<S,SC,PC>* lkernel =
+                dynamic_cast<InputGen::ScannerDisplacementKernel<S,SC,PC>*> (kernel);
+        if(lkernel == NULL) {
+            std::cerr << "This should nerver happen... "
+                      << __FILE__ << " "
+                      << __LINE__ << std::endl;
+            return;
+        }
+
+        ui->_displacementParamScannerSensorXValue->setValue(lkernel->sensor(0));
+        ui->_displacementParamScannerSensorYValue->setValue(lkernel->sensor(1));
+        ui->_displacementParamScannerRangeSigmaValue->setValue(lkernel->rangeSigma);
+        ui->_displacementParamScannerRangeSigmaGrowthValue->setValue(lkernel->rangeSigmaGrowth);
+        ui->_displacementParamScannerBeamDivergenceValue->setValue(lkernel->beamDivergence);
+        ui->_displacementParamScannerOutlierRateValue->setValue(lkernel->outlierRate);
+        ui->_displacementParamScannerOutlierRangeValue->setValue(lkernel->outlierRange);
+        ui->_displacementParamScannerGrazingAngleValue->setValue(lkernel->grazingAngle * 180. / M_PI);
+        ui->_displacementParamScannerDropoutRateValue->setValue(lkernel->dropoutRate);
+        ui->_displacementParamScannerNbStationsValue->setValue(lkernel->nbStations);
+        ui->_displacementParamScannerDriftTranslationValue->setValue(lkernel->driftTranslation);
+        ui->_displacementParamScannerDriftRotationValue->setValue(lkernel->driftRotation * 180. / M_PI);
+
+        ui->_displacementParamBiasGroup->hide();
+        ui->_displacementParamRandomUniformGroup->hide();
+        ui->_displacementParamRandomNormalGroup->hide();
+        ui->_displacementParamScannerGroup->show();
         break;
     }
     }
@@ -637,10 +637,12 @@ void MainWindow::writeAssignement(QString path){
         out << "#Describes point to primitive assignation" << endl;
         out << "#pointId,primitiveId,orientationId" << endl;
 
-        unsigned int sampleId = 0;
+        // dropped samples are not exported, ids are contiguous
+        unsigned int sampleId = 0, pointId = 0;
         for(InputGen::Application::SampleSet::const_iterator it = _project->samples.begin();
             it != _project->samples.end(); it++, sampleId++){
-            out << sampleId << "," << (*it).primitiveId << ",-1" << endl;
+            if (_project->isSampleDropped(sampleId)) continue;
+            out << pointId++ << "," << (*it).primitiveId << ",-1" << endl;
         }
         outfile.close();
     }
@@ -661,10 +663,14 @@ void MainWindow::writeSamples(QString path){
 
         QTextStream out(&outfile);
 
+        unsigned int nbPoints = 0;
+        for(unsigned int sampleId = 0; sampleId != _project->samples.size(); sampleId++)
+            if (! _project->isSampleDropped(sampleId)) nbPoints++;
+
         out << "ply\n"
             << "format ascii 1.0\n"
             << "comment Generated by InputGen\n"
-            << "element vertex " << _project->samples.size() << "\n"
+            << "element vertex " << nbPoints << "\n"
             << "property float x\n"
             << "property float y\n"
             << "property float z\n"
@@ -676,6 +682,7 @@ void MainWindow::writeSamples(QString path){
         unsigned int sampleId = 0;
         for(InputGen::Application::SampleSet::const_iterator it = _project->samples.begin();
             it != _project->samples.end(); it++, sampleId++){
+            if (_project->isSampleDropped(sampleId)) continue;
             InputGen::Application::Primitive::vec pos =
                     ((*it) + _project->computeTotalDisplacement(sampleId));
             out << pos(0) << " "
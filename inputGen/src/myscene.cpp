@@ -110,6 +110,7 @@ MyScene::drawBackground(QPainter *painter, const QRectF &rect){
         InputGen::Application::SampleSet::const_iterator it;
         int sampleId = 0;
         for(it = _project->samples.begin(); it != _project->samples.end(); it++, sampleId++){
+            if (_project->isSampleDropped(sampleId)) continue;
             InputGen::Application::GLDisplayFunctor<Scalar>::displayVertex(
                         ((*it) + _project->computeTotalDisplacement(sampleId)).eval().data());
         }